@@ -0,0 +1,233 @@
+/**
+ * @file llframestats_libtest.cpp
+ * @brief Summary and comparison of frame stats logs
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+#include "linden_common.h"
+
+#include "llframestats_libtest.h"
+
+// Linden library includes
+#include "llformat.h"
+#include "llframestatslog.h"
+
+// system libraries
+#include <iostream>
+#include <string>
+#include <vector>
+
+// doc string provided when invoking the program with --help
+static const char USAGE[] = "\n"
+"usage:\tllframestats_libtest [options] <log> [<other log>]\n"
+"\n"
+"Reads frame stats logs written by the viewer when RenderFrameStatsLog is\n"
+"set (frame_stats-*.llfs in the logs folder). With one log, prints the\n"
+"mean and percentiles of every counter. With two, compares the second\n"
+"log against the first, counter by counter, matched by name.\n"
+"\n"
+" -h, --help\n"
+"        Print this help\n"
+" -f, --field <text>\n"
+"        Only counters whose name contains text, e.g. draw_infos or _us.\n"
+" -a, --all\n"
+"        Include counters that are zero in every frame.\n"
+" -t, --threshold <percent>\n"
+"        When comparing, only show counters whose mean or 90th percentile\n"
+"        moved by more than percent, and exit with 1 if any of them grew.\n"
+"        Default is 0, show everything and always exit with 0.\n"
+"\n";
+
+namespace
+{
+
+struct Options
+{
+    std::string mField;
+    bool mAll = false;
+    F32 mThreshold = 0.f;
+};
+
+bool load_log(const std::string& filename, LLFrameStatsLog& log)
+{
+    std::string error;
+    if (!log.load(filename, error))
+    {
+        std::cout << filename << ": " << error << std::endl;
+        return false;
+    }
+    std::cout << filename << ": " << log.getFrameCount() << " frames, " << log.getFields().size() << " counters" << std::endl;
+    return true;
+}
+
+bool wanted(const std::string& name, const LLFrameStatsLog::Summary& summary, const Options& options)
+{
+    return (options.mField.empty() || name.find(options.mField) != std::string::npos) &&
+           (options.mAll || summary.mMax > 0);
+}
+
+// percent change, 0 when both are 0
+F64 change(F64 base, F64 test)
+{
+    if (base == 0.0)
+    {
+        return test == 0.0 ? 0.0 : 100.0;
+    }
+    return (test - base) * 100.0 / base;
+}
+
+void summarize(const LLFrameStatsLog& log, const Options& options)
+{
+    std::cout << llformat("%-44s %10s %8s %8s %8s %8s", "counter", "mean", "p50", "p90", "p99", "max") << std::endl;
+    for (size_t i = 0; i < log.getFields().size(); ++i)
+    {
+        const LLFrameStatsLog::Summary summary = log.summarize(i);
+        if (wanted(log.getFields()[i], summary, options))
+        {
+            std::cout << llformat("%-44s %10.1f %8u %8u %8u %8u", log.getFields()[i].c_str(), summary.mMean,
+                                  summary.mP50, summary.mP90, summary.mP99, summary.mMax) << std::endl;
+        }
+    }
+}
+
+// true if a counter grew past the threshold
+bool compare(const LLFrameStatsLog& base, const LLFrameStatsLog& test, const Options& options)
+{
+    bool grew = false;
+    std::cout << llformat("%-44s %10s %10s %8s %9s %9s %8s", "counter", "base mean", "test mean", "change",
+                          "base p90", "test p90", "change") << std::endl;
+    for (size_t i = 0; i < test.getFields().size(); ++i)
+    {
+        const std::string& name = test.getFields()[i];
+        const S32 base_field = base.findField(name);
+        const LLFrameStatsLog::Summary test_summary = test.summarize(i);
+        if (base_field < 0)
+        {
+            if (wanted(name, test_summary, options))
+            {
+                std::cout << llformat("%-44s %10s %10.1f", name.c_str(), "-", test_summary.mMean) << std::endl;
+            }
+            continue;
+        }
+
+        const LLFrameStatsLog::Summary base_summary = base.summarize(base_field);
+        if (!wanted(name, base_summary, options) && !wanted(name, test_summary, options))
+        {
+            continue;
+        }
+
+        const F64 mean_change = change(base_summary.mMean, test_summary.mMean);
+        const F64 p90_change = change(base_summary.mP90, test_summary.mP90);
+        if (options.mThreshold > 0.f)
+        {
+            if (fabs(mean_change) <= options.mThreshold && fabs(p90_change) <= options.mThreshold)
+            {
+                continue;
+            }
+            grew = grew || mean_change > options.mThreshold || p90_change > options.mThreshold;
+        }
+
+        std::cout << llformat("%-44s %10.1f %10.1f %+7.1f%% %9u %9u %+7.1f%%", name.c_str(), base_summary.mMean,
+                              test_summary.mMean, mean_change, base_summary.mP90, test_summary.mP90, p90_change)
+                  << std::endl;
+    }
+
+    for (const std::string& name : base.getFields())
+    {
+        if (test.findField(name) < 0 && (options.mField.empty() || name.find(options.mField) != std::string::npos))
+        {
+            std::cout << llformat("%-44s %10s", name.c_str(), "only in base") << std::endl;
+        }
+    }
+    return grew;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    std::vector<std::string> files;
+
+    // Analyze command line arguments
+    for (int arg = 1; arg < argc; ++arg)
+    {
+        bool has_value = (arg + 1) < argc && argv[arg + 1][0] != '-';
+        if (!strcmp(argv[arg], "--help") || !strcmp(argv[arg], "-h"))
+        {
+            // Send the usage to standard out
+            std::cout << USAGE << std::endl;
+            return 0;
+        }
+        else if (!strcmp(argv[arg], "--field") || !strcmp(argv[arg], "-f"))
+        {
+            if (has_value)
+            {
+                options.mField = argv[++arg];
+            }
+        }
+        else if (!strcmp(argv[arg], "--all") || !strcmp(argv[arg], "-a"))
+        {
+            options.mAll = true;
+        }
+        else if (!strcmp(argv[arg], "--threshold") || !strcmp(argv[arg], "-t"))
+        {
+            if (has_value)
+            {
+                options.mThreshold = llmax((F32)atof(argv[++arg]), 0.f);
+            }
+            else
+            {
+                std::cout << "No valid --threshold argument given, default (0) will be used" << std::endl;
+            }
+        }
+        else if (argv[arg][0] != '-')
+        {
+            files.push_back(argv[arg]);
+        }
+    }
+
+    if (files.empty() || files.size() > 2)
+    {
+        std::cout << USAGE << std::endl;
+        return 1;
+    }
+
+    LLFrameStatsLog base;
+    if (!load_log(files[0], base))
+    {
+        return 1;
+    }
+
+    if (files.size() == 1)
+    {
+        summarize(base, options);
+        return 0;
+    }
+
+    LLFrameStatsLog test;
+    if (!load_log(files[1], test))
+    {
+        return 1;
+    }
+    return compare(base, test, options) ? 1 : 0;
+}
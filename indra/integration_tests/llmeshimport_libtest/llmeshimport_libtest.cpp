@@ -0,0 +1,272 @@
+/**
+ * @file llmeshimport_libtest.cpp
+ * @brief Headless benchmark of the parallel COLLADA mesh import
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+#include "linden_common.h"
+#include "llpointer.h"
+#include "lltimer.h"
+
+#include "llmeshimport_libtest.h"
+
+// Linden library includes
+#include "llapr.h"
+#include "lldaeloader.h"
+#include "lldir.h"
+#include "lldiriterator.h"
+#include "llmodel.h"
+
+// system libraries
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// doc string provided when invoking the program with --help
+static const char USAGE[] = "\n"
+"usage:\tllmeshimport_libtest [options] <dir>\n"
+"\n"
+"Loads every COLLADA (.dae) file in <dir> the way the upload floater does,\n"
+"first on the loader thread only and then with its \"MeshImport\" thread pool,\n"
+"checks that both loads give the same models in the same order\n"
+"and reports the load time of each file and the speedup.\n"
+"\n"
+" -h, --help\n"
+"        Print this help\n"
+" -t, --threads <n>\n"
+"        Width of the \"MeshImport\" pool. Default picks from the core count.\n"
+" -n, --iterations <n>\n"
+"        Loads of each file per mode, the fastest is reported. Default is 1.\n"
+"\n";
+
+namespace
+{
+
+struct LoadResult
+{
+    bool mLoaded = false;
+    U32 mModels = 0;
+    U32 mFaces = 0;
+    U32 mTriangles = 0;
+    U64 mHash = 0;      // labels, materials and geometry in load order
+    F64 mSeconds = 0.0;
+};
+
+// FNV-1a
+void hash_bytes(U64& hash, const void* data, size_t size)
+{
+    const U8* bytes = (const U8*)data;
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ULL;
+    }
+}
+
+LoadResult load_dae(const std::string& filename)
+{
+    JointTransformMap joint_transforms;
+    JointNameSet joints_from_nodes;
+    JointMap joint_aliases;
+    LODSuffixArray lod_suffix;
+
+    LLDAELoader loader(
+        filename,
+        LLModel::LOD_HIGH,
+        [](LLModelLoader::scene&, LLModelLoader::model_list&, S32, void*) {},
+        [](const std::string&, void*) -> LLJoint* { return nullptr; },
+        [](LLImportMaterial&, void*) -> U32 { return 0; },
+        [](U32, void*) {},
+        nullptr,
+        joint_transforms,
+        joints_from_nodes,
+        joint_aliases,
+        110,    // LLSkinningUtil::getMaxJointCount()
+        256,
+        0,
+        false,
+        lod_suffix);
+
+    LoadResult result;
+    F64 start = LLTimer::getTotalSeconds().value();
+    result.mLoaded = loader.OpenFile(filename);
+    result.mSeconds = LLTimer::getTotalSeconds().value() - start;
+
+    result.mHash = 0xcbf29ce484222325ULL;
+    for (const LLPointer<LLModel>& model : loader.mModelList)
+    {
+        result.mModels++;
+        hash_bytes(result.mHash, model->mLabel.data(), model->mLabel.size());
+        for (const std::string& material : model->mMaterialList)
+        {
+            hash_bytes(result.mHash, material.data(), material.size());
+        }
+        for (S32 i = 0; i < model->getNumVolumeFaces(); ++i)
+        {
+            const LLVolumeFace& face = model->getVolumeFace(i);
+            result.mFaces++;
+            result.mTriangles += face.mNumIndices / 3;
+            hash_bytes(result.mHash, face.mPositions, face.mNumVertices * sizeof(LLVector4a));
+            hash_bytes(result.mHash, face.mIndices, face.mNumIndices * sizeof(U16));
+        }
+    }
+    return result;
+}
+
+LoadResult load_best(const std::string& filename, S32 iterations)
+{
+    LoadResult best = load_dae(filename);
+    for (S32 iter = 1; iter < iterations; ++iter)
+    {
+        LoadResult result = load_dae(filename);
+        if (result.mSeconds < best.mSeconds)
+        {
+            best = result;
+        }
+    }
+    return best;
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv)
+{
+    std::string dae_dir;
+    S32 threads = 0;
+    S32 iterations = 1;
+
+    // Analyze command line arguments
+    for (int arg = 1; arg < argc; ++arg)
+    {
+        bool has_value = (arg + 1) < argc && argv[arg + 1][0] != '-';
+        if (!strcmp(argv[arg], "--help") || !strcmp(argv[arg], "-h"))
+        {
+            // Send the usage to standard out
+            std::cout << USAGE << std::endl;
+            return 0;
+        }
+        else if (!strcmp(argv[arg], "--threads") || !strcmp(argv[arg], "-t"))
+        {
+            if (has_value)
+            {
+                threads = llclamp(atoi(argv[++arg]), 1, 64);
+            }
+        }
+        else if (!strcmp(argv[arg], "--iterations") || !strcmp(argv[arg], "-n"))
+        {
+            if (has_value)
+            {
+                iterations = llclamp(atoi(argv[++arg]), 1, 100);
+            }
+            else
+            {
+                std::cout << "No valid --iterations argument given, default (1) will be used" << std::endl;
+            }
+        }
+        else if (argv[arg][0] != '-')
+        {
+            dae_dir = argv[arg];
+        }
+    }
+
+    if (dae_dir.empty())
+    {
+        std::cout << USAGE << std::endl;
+        return 1;
+    }
+
+    if (threads <= 0)
+    {
+        threads = llclamp((S32)std::thread::hardware_concurrency() - 1, 1, 16);
+    }
+
+    // Init the APR, the DAE loader reads through it
+    ll_init_apr();
+
+    std::vector<std::string> files;
+    {
+        LLDirIterator iter(dae_dir, "*.dae");
+        std::string name;
+        while (iter.next(name))
+        {
+            files.push_back(dae_dir + gDirUtilp->getDirDelimiter() + name);
+        }
+    }
+
+    // Serial loads first, then over the import pool
+    std::vector<LoadResult> serial;
+    LLModelLoader::sImportThreads = 0;
+    for (const std::string& file : files)
+    {
+        serial.push_back(load_best(file, iterations));
+    }
+
+    std::vector<LoadResult> parallel;
+    LLModelLoader::sImportThreads = threads;
+    for (const std::string& file : files)
+    {
+        parallel.push_back(load_best(file, iterations));
+    }
+
+    std::cout << "File                            models   triangles   serial ms   " << threads << "+1 threads ms   speedup   same" << std::endl;
+
+    bool ok = true;
+    F64 serial_total = 0.0;
+    F64 parallel_total = 0.0;
+    for (size_t i = 0; i < files.size(); ++i)
+    {
+        const LoadResult& a = serial[i];
+        const LoadResult& b = parallel[i];
+        const bool same = a.mLoaded == b.mLoaded && a.mModels == b.mModels && a.mFaces == b.mFaces && a.mHash == b.mHash;
+        ok = ok && same;
+        serial_total += a.mSeconds;
+        parallel_total += b.mSeconds;
+
+        std::cout << llformat("%-30s %8u %11u %11.1f %16.1f %9.2f   %s",
+                              gDirUtilp->getBaseFileName(files[i], true).substr(0, 30).c_str(),
+                              a.mModels,
+                              a.mTriangles,
+                              a.mSeconds * 1000.0,
+                              b.mSeconds * 1000.0,
+                              b.mSeconds > 0.0 ? a.mSeconds / b.mSeconds : 0.0,
+                              same ? "yes" : "NO")
+                  << std::endl;
+    }
+
+    std::cout << std::endl;
+    std::cout << llformat("%u files, serial %.1f ms, parallel %.1f ms, speedup %.2f",
+                          (U32)files.size(),
+                          serial_total * 1000.0,
+                          parallel_total * 1000.0,
+                          parallel_total > 0.0 ? serial_total / parallel_total : 0.0)
+              << std::endl;
+
+    ll_cleanup_apr();
+
+    if (!ok)
+    {
+        std::cout << std::endl << "Serial and parallel loads differ" << std::endl;
+        return 1;
+    }
+    return 0;
+}
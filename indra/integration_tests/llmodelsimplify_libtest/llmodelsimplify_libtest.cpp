@@ -0,0 +1,363 @@
+/**
+ * @file llmodelsimplify_libtest.cpp
+ * @brief Headless driver for LLModelSimplifier over DAE files and mesh assets
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+#include "linden_common.h"
+#include "llpointer.h"
+#include "lltimer.h"
+
+#include "llmodelsimplify_libtest.h"
+
+// Linden library includes
+#include "llapr.h"
+#include "lldaeloader.h"
+#include "lldir.h"
+#include "lldiriterator.h"
+#include "llfile.h"
+#include "llmodel.h"
+#include "llmodelsimplifier.h"
+#include "llsd.h"
+#include "llsdserialize.h"
+#include "lluuid.h"
+
+// system libraries
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+// doc string provided when invoking the program with --help
+static const char USAGE[] = "\n"
+"usage:\tllmodelsimplify_libtest [options]\n"
+"\n"
+"Generates the low, lowest and medium levels of detail and a physics mesh\n"
+"for every model of a collection, first one face at a time on a single\n"
+"thread and then with LLModelSimplifier, and reports the time of both,\n"
+"the speedup and the triangle count of each level.\n"
+"\n"
+" -h, --help\n"
+"        Print this help\n"
+" -d, --dae <dir>\n"
+"        Directory of COLLADA (.dae) files.\n"
+" -m, --mesh <dir>\n"
+"        Directory of mesh asset files (as served by the mesh capability).\n"
+"        The high_lod of each file is used as the source model.\n"
+" -t, --threads <n>\n"
+"        Simplifier worker threads. Default picks from the core count.\n"
+" -n, --iterations <n>\n"
+"        Runs of each version. Default is 3.\n"
+"\n";
+
+namespace
+{
+
+typedef std::vector<LLPointer<LLModel> > model_vector;
+
+const char* LOD_NAMES[LLModel::NUM_LODS] = { "lowest", "low", "medium", "high", "physics" };
+
+U32 count_triangles(const LLModel* model)
+{
+    U32 triangles = 0;
+    for (S32 i = 0; i < model->getNumVolumeFaces(); ++i)
+    {
+        triangles += model->getVolumeFace(i).mNumIndices / 3;
+    }
+    return triangles;
+}
+
+void add_dae(model_vector& models, const std::string& filename)
+{
+    JointTransformMap joint_transforms;
+    JointNameSet joints_from_nodes;
+    JointMap joint_aliases;
+    LODSuffixArray lod_suffix;
+
+    LLDAELoader loader(
+        filename,
+        LLModel::LOD_HIGH,
+        [](LLModelLoader::scene&, LLModelLoader::model_list&, S32, void*) {},
+        [](const std::string&, void*) -> LLJoint* { return nullptr; },
+        [](LLImportMaterial&, void*) -> U32 { return 0; },
+        [](U32, void*) {},
+        nullptr,
+        joint_transforms,
+        joints_from_nodes,
+        joint_aliases,
+        110,    // LLSkinningUtil::getMaxJointCount()
+        256,
+        0,
+        false,
+        lod_suffix);
+
+    if (!loader.OpenFile(filename))
+    {
+        std::cout << "Failed to load " << filename << std::endl;
+        return;
+    }
+
+    for (LLPointer<LLModel>& model : loader.mModelList)
+    {
+        if (model.notNull() && model->getNumVolumeFaces() > 0)
+        {
+            models.push_back(model);
+        }
+    }
+}
+
+bool add_mesh(model_vector& models, const std::string& filename)
+{
+    llifstream file(filename.c_str(), std::ios::in | std::ios::binary);
+    if (!file.is_open())
+    {
+        return false;
+    }
+    std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (data.empty())
+    {
+        return false;
+    }
+
+    llssize data_size = data.size();
+    llssize deprecated_size = 0;
+    char* result_ptr = strip_deprecated_header(data.data(), data_size, &deprecated_size);
+
+    std::istringstream stream(std::string(result_ptr, data_size));
+    LLSD header;
+    if (!LLSDSerialize::fromBinary(header, stream, data_size) || !header.isMap() || !header.has("high_lod"))
+    {
+        std::cout << "Not a mesh asset: " << filename << std::endl;
+        return false;
+    }
+    const llssize header_size = deprecated_size + (llssize)stream.tellg();
+    const llssize offset = header_size + header["high_lod"]["offset"].asInteger();
+    const S32 size = header["high_lod"]["size"].asInteger();
+    if (offset < 0 || size <= 0 || offset + size > (llssize)data.size())
+    {
+        return false;
+    }
+
+    LLVolumeParams params;
+    params.setType(LL_PCODE_PROFILE_SQUARE, LL_PCODE_PATH_LINE);
+    params.setSculptID(LLUUID::generateNewID(), LL_SCULPT_TYPE_MESH);
+
+    LLPointer<LLModel> model = new LLModel(params, 0.f);
+    if (!model->unpackVolumeFaces((U8*)data.data() + offset, size) || !model->getNumVolumeFaces())
+    {
+        return false;
+    }
+    model->mLabel = gDirUtilp->getBaseFileName(filename, true);
+    models.push_back(model);
+    return true;
+}
+
+void add_files(model_vector& models, const std::string& dirname, bool dae)
+{
+    LLDirIterator iter(dirname, dae ? "*.dae" : "*");
+    std::string name;
+    S32 files = 0;
+    const size_t first = models.size();
+    while (iter.next(name))
+    {
+        const std::string filename = dirname + gDirUtilp->getDirDelimiter() + name;
+        if (dae)
+        {
+            add_dae(models, filename);
+            files++;
+        }
+        else if (add_mesh(models, filename))
+        {
+            files++;
+        }
+    }
+    std::cout << "Loaded " << models.size() - first << " models from " << files << " files in " << dirname << std::endl;
+}
+
+// What LLModelPreview does today, one model, level and face after the other
+F64 run_serial(const model_vector& models, const LLModelSimplifier::Targets& targets)
+{
+    LLVolumeFace scratch;
+    F64 start = LLTimer::getTotalSeconds().value();
+    for (const LLPointer<LLModel>& model : models)
+    {
+        for (S32 lod = 0; lod < LLModel::NUM_LODS; ++lod)
+        {
+            const F32 ratio = targets.mRatio[lod];
+            if (ratio <= 0.f || ratio >= 1.f)
+            {
+                continue;
+            }
+            for (S32 i = 0; i < model->getNumVolumeFaces(); ++i)
+            {
+                LLModelSimplifier::simplifyFace(model->getVolumeFace(i), scratch, 1.f / ratio, targets.mErrorThreshold,
+                                                lod == LLModel::LOD_PHYSICS ? LLModelSimplifier::SIMPLIFY_SLOPPY
+                                                                            : LLModelSimplifier::SIMPLIFY_FULL);
+            }
+        }
+    }
+    return LLTimer::getTotalSeconds().value() - start;
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv)
+{
+    std::string dae_dir;
+    std::string mesh_dir;
+    S32 threads = 0;
+    S32 iterations = 3;
+
+    // Analyze command line arguments
+    for (int arg = 1; arg < argc; ++arg)
+    {
+        bool has_value = (arg + 1) < argc && argv[arg + 1][0] != '-';
+        if (!strcmp(argv[arg], "--help") || !strcmp(argv[arg], "-h"))
+        {
+            // Send the usage to standard out
+            std::cout << USAGE << std::endl;
+            return 0;
+        }
+        else if (!strcmp(argv[arg], "--dae") || !strcmp(argv[arg], "-d"))
+        {
+            if (has_value)
+            {
+                dae_dir = argv[++arg];
+            }
+        }
+        else if (!strcmp(argv[arg], "--mesh") || !strcmp(argv[arg], "-m"))
+        {
+            if (has_value)
+            {
+                mesh_dir = argv[++arg];
+            }
+        }
+        else if (!strcmp(argv[arg], "--threads") || !strcmp(argv[arg], "-t"))
+        {
+            if (has_value)
+            {
+                threads = llclamp(atoi(argv[++arg]), 1, 64);
+            }
+        }
+        else if (!strcmp(argv[arg], "--iterations") || !strcmp(argv[arg], "-n"))
+        {
+            if (has_value)
+            {
+                iterations = llclamp(atoi(argv[++arg]), 1, 1000);
+            }
+            else
+            {
+                std::cout << "No valid --iterations argument given, default (3) will be used" << std::endl;
+            }
+        }
+    }
+
+    if (dae_dir.empty() && mesh_dir.empty())
+    {
+        std::cout << "Nothing to simplify, use --dae or --mesh" << std::endl;
+        std::cout << USAGE << std::endl;
+        return 1;
+    }
+
+    // Init the APR, the DAE loader reads through it
+    ll_init_apr();
+
+    model_vector models;
+    if (!dae_dir.empty())
+    {
+        add_files(models, dae_dir, true);
+    }
+    if (!mesh_dir.empty())
+    {
+        add_files(models, mesh_dir, false);
+    }
+    if (models.empty())
+    {
+        std::cout << "No models loaded" << std::endl;
+        return 1;
+    }
+
+    U32 source_triangles = 0;
+    S32 faces = 0;
+    for (const LLPointer<LLModel>& model : models)
+    {
+        source_triangles += count_triangles(model);
+        faces += model->getNumVolumeFaces();
+    }
+    std::cout << models.size() << " models, " << faces << " faces, " << source_triangles << " triangles" << std::endl;
+
+    LLModelSimplifier::Targets targets;
+    // Leave the high level alone, it's the source
+    targets.mRatio[LLModel::LOD_HIGH] = 0.f;
+
+    std::vector<LLModelSimplifier::Result> results;
+    F64 serial = 0.0;
+    F64 parallel = 0.0;
+    {
+        LLModelSimplifier simplifier("MeshSimplifyTest", threads);
+        for (S32 iter = 0; iter < iterations; ++iter)
+        {
+            serial += run_serial(models, targets);
+
+            F64 start = LLTimer::getTotalSeconds().value();
+            simplifier.simplify(models, targets, results);
+            parallel += LLTimer::getTotalSeconds().value() - start;
+        }
+    }
+
+    std::cout << std::endl;
+    U32 failed = 0;
+    for (const LLModelSimplifier::Result& result : results)
+    {
+        failed += result.mFailedFaces;
+    }
+
+    std::cout << "Level       triangles" << std::endl;
+    for (S32 lod = 0; lod < LLModel::NUM_LODS; ++lod)
+    {
+        if (targets.mRatio[lod] <= 0.f)
+        {
+            continue;
+        }
+        U32 triangles = 0;
+        for (const LLModelSimplifier::Result& result : results)
+        {
+            if (result.mLOD[lod].notNull())
+            {
+                triangles += count_triangles(result.mLOD[lod]);
+            }
+        }
+        std::cout << llformat("%-9s %11u", LOD_NAMES[lod], triangles) << std::endl;
+    }
+    std::cout << failed << " faces could not be simplified" << std::endl;
+
+    std::cout << std::endl;
+    std::cout << llformat("serial %.1f ms, simplifier %.1f ms, speedup %.2f",
+                          serial * 1000.0 / iterations,
+                          parallel * 1000.0 / iterations,
+                          parallel > 0.0 ? serial / parallel : 0.0)
+              << std::endl;
+
+    models.clear();
+    results.clear();
+    ll_cleanup_apr();
+    return 0;
+}
@@ -0,0 +1,418 @@
+/**
+ * @file lloctree_libtest.cpp
+ * @brief Benchmark of pooled against unpooled LLOctreeRoot
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+#include "linden_common.h"
+#include "lltimer.h"
+
+#include "lloctree_libtest.h"
+
+// Linden library includes
+#include "lloctree.h"
+
+// system libraries
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+// doc string provided when invoking the program with --help
+static const char USAGE[] = "\n"
+"usage:\tlloctree_libtest [options]\n"
+"\n"
+"Inserts a region's worth of synthetic elements into an LLOctreeRoot with\n"
+"nodes allocated one by one and into one with pooled nodes, traverses both\n"
+"trees fully and with a sphere cull, then removes every element in random\n"
+"order. Reports the time of each phase, the memory of the nodes and\n"
+"whether both trees came out the same.\n"
+"\n"
+" -h, --help\n"
+"        Print this help\n"
+" -e, --elements <n>\n"
+"        Elements in the tree. Default is 1000000.\n"
+" -n, --iterations <n>\n"
+"        Runs of each tree, the fastest of each phase is reported.\n"
+"        Default is 3.\n"
+" -c, --capacity <n>\n"
+"        gOctreeMaxCapacity. Default is 128, as OctreeMaxNodeCapacity.\n"
+"\n";
+
+namespace
+{
+
+class BenchElement
+{
+public:
+    BenchElement(const LLVector4a& pos, F32 radius)
+    :   mNode(NULL),
+        mBinIndex(-1),
+        mRadius(radius)
+    {
+        mPosition = pos;
+    }
+
+    const LLVector4a& getPositionGroup() const  { return mPosition; }
+    F32 getBinRadius() const                    { return mRadius; }
+    S32 getBinIndex() const                     { return mBinIndex; }
+    void setBinIndex(S32 index)                 { mBinIndex = index; }
+
+    // Set by BenchListener, the viewer finds it through the entry's group
+    LLOctreeNode<BenchElement, BenchElement*>* mNode;
+
+private:
+    LL_ALIGN_16(LLVector4a mPosition);
+    S32 mBinIndex;
+    F32 mRadius;
+};
+
+typedef LLOctreeNode<BenchElement, BenchElement*> bench_node_t;
+typedef LLOctreeRoot<BenchElement, BenchElement*> bench_root_t;
+
+// On every node like the viewer's groups, remembers where elements went
+class BenchListener : public LLOctreeListener<BenchElement, BenchElement*>
+{
+public:
+    void handleInsertion(const LLTreeNode<BenchElement>* node, BenchElement* data) override
+    {
+        data->mNode = (bench_node_t*)node;
+    }
+
+    void handleRemoval(const LLTreeNode<BenchElement>* node, BenchElement* data) override
+    {
+        data->mNode = NULL;
+    }
+
+    void handleDestruction(const LLTreeNode<BenchElement>* node) override { }
+    void handleStateChange(const LLTreeNode<BenchElement>* node) override { }
+
+    void handleChildAddition(const bench_node_t* parent, bench_node_t* child) override
+    {
+        child->addListener(this);
+    }
+
+    void handleChildRemoval(const bench_node_t* parent, const bench_node_t* child) override { }
+};
+
+// Touches every node and element, like a rebound or debug pass
+class FullTraveler : public LLOctreeTraveler<BenchElement, BenchElement*>
+{
+public:
+    void visit(const bench_node_t* node) override
+    {
+        mNodes++;
+        for (bench_node_t::const_element_iter i = node->getDataBegin(); i != node->getDataEnd(); ++i)
+        {
+            mSum += (*i)->getBinRadius();
+        }
+        if (node->getElementCount() > 0)
+        {
+            mChecksum = mChecksum * 31 + node->getElementCount();
+        }
+    }
+
+    U32 mNodes = 0;
+    F32 mSum = 0.f;
+    U64 mChecksum = 0;
+};
+
+// Skips what's outside a sphere, like a frustum cull
+class SphereTraveler : public LLOctreeTraveler<BenchElement, BenchElement*>
+{
+public:
+    SphereTraveler(const LLVector4a& center, F32 radius)
+    :   mRadius2(radius * radius)
+    {
+        mCenter = center;
+    }
+
+    void traverse(const bench_node_t* node) override
+    {
+        LLVector4a delta;
+        delta.setSub(mCenter, node->getCenter());
+        delta.setAbs(delta);
+        delta.sub(node->getSize());
+        delta.setMax(delta, LLVector4a::getZero());
+        if (delta.dot3(delta).getF32() > mRadius2)
+        {
+            return;
+        }
+        LLOctreeTraveler<BenchElement, BenchElement*>::traverse(node);
+    }
+
+    void visit(const bench_node_t* node) override
+    {
+        mElements += node->getElementCount();
+    }
+
+    U32 mElements = 0;
+
+private:
+    LL_ALIGN_16(LLVector4a mCenter);
+    F32 mRadius2;
+};
+
+// Node memory of a tree, pooled nodes are counted with their pool
+class MemoryTraveler : public LLOctreeTraveler<BenchElement, BenchElement*>
+{
+public:
+    void visit(const bench_node_t* node) override
+    {
+        mNodes++;
+        if (!node->isPooled())
+        {
+            mHeapNodes++;
+        }
+        if (node->getElementCount() > 4)
+        {
+            mSpilledBytes += node->getElementCount() * sizeof(BenchElement*);
+        }
+    }
+
+    U32 mNodes = 0;
+    U32 mHeapNodes = 0;
+    size_t mSpilledBytes = 0;
+};
+
+struct PhaseTimes
+{
+    F64 mInsert = 1e30;
+    F64 mTraverse = 1e30;
+    F64 mCull = 1e30;
+    F64 mRemove = 1e30;
+
+    void keepBest(const PhaseTimes& other)
+    {
+        mInsert = llmin(mInsert, other.mInsert);
+        mTraverse = llmin(mTraverse, other.mTraverse);
+        mCull = llmin(mCull, other.mCull);
+        mRemove = llmin(mRemove, other.mRemove);
+    }
+};
+
+struct RunResult
+{
+    PhaseTimes mTimes;
+    U32 mNodes = 0;
+    U64 mChecksum = 0;
+    U32 mCulled = 0;
+    size_t mBytes = 0;
+    bool mEmptied = false;
+};
+
+F64 now()
+{
+    return LLTimer::getTotalSeconds().value();
+}
+
+RunResult run_tree(bool pooled, std::vector<BenchElement>& elements, const std::vector<U32>& removal_order,
+                   const std::vector<LLVector4a>& cull_centers)
+{
+    RunResult result;
+    std::unique_ptr<bench_root_t> root(new bench_root_t(LLVector4a(128.f, 128.f, 64.f), LLVector4a(1.f, 1.f, 1.f), NULL, pooled));
+    root->addListener(new BenchListener());
+
+    F64 start = now();
+    for (BenchElement& element : elements)
+    {
+        root->insert(&element);
+    }
+    result.mTimes.mInsert = now() - start;
+
+    start = now();
+    FullTraveler full;
+    full.traverse(root.get());
+    result.mTimes.mTraverse = now() - start;
+    result.mNodes = full.mNodes;
+    result.mChecksum = full.mChecksum;
+
+    start = now();
+    for (const LLVector4a& center : cull_centers)
+    {
+        SphereTraveler cull(center, 64.f);
+        cull.traverse(root.get());
+        result.mCulled += cull.mElements;
+    }
+    result.mTimes.mCull = now() - start;
+
+    MemoryTraveler memory;
+    memory.traverse(root.get());
+    result.mBytes = memory.mHeapNodes * sizeof(bench_node_t) + memory.mSpilledBytes;
+    if (root->getNodePool())
+    {
+        result.mBytes += root->getNodePool()->getAllocatedBytes();
+    }
+
+    start = now();
+    for (U32 index : removal_order)
+    {
+        BenchElement* element = &elements[index];
+        element->mNode->remove(element);
+    }
+    result.mTimes.mRemove = now() - start;
+    result.mEmptied = root->getChildCount() == 0 && root->getElementCount() == 0;
+
+    return result;
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv)
+{
+    S32 element_count = 1000000;
+    S32 iterations = 3;
+    S32 capacity = 128;
+
+    // Analyze command line arguments
+    for (int arg = 1; arg < argc; ++arg)
+    {
+        bool has_value = (arg + 1) < argc && argv[arg + 1][0] != '-';
+        if (!strcmp(argv[arg], "--help") || !strcmp(argv[arg], "-h"))
+        {
+            // Send the usage to standard out
+            std::cout << USAGE << std::endl;
+            return 0;
+        }
+        else if (!strcmp(argv[arg], "--elements") || !strcmp(argv[arg], "-e"))
+        {
+            if (has_value)
+            {
+                element_count = llclamp(atoi(argv[++arg]), 1, 100000000);
+            }
+        }
+        else if (!strcmp(argv[arg], "--iterations") || !strcmp(argv[arg], "-n"))
+        {
+            if (has_value)
+            {
+                iterations = llclamp(atoi(argv[++arg]), 1, 1000);
+            }
+            else
+            {
+                std::cout << "No valid --iterations argument given, default (3) will be used" << std::endl;
+            }
+        }
+        else if (!strcmp(argv[arg], "--capacity") || !strcmp(argv[arg], "-c"))
+        {
+            if (has_value)
+            {
+                capacity = llclamp(atoi(argv[++arg]), 1, 4096);
+            }
+        }
+    }
+
+    gOctreeMaxCapacity = capacity;
+    gOctreeMinSize = 0.01f;
+
+    // A region: mostly small objects near the ground, some tall ones and
+    // a few large ones, clustered around build sites
+    std::mt19937 rng(20240601);
+    std::uniform_real_distribution<F32> ground(0.f, 256.f);
+    std::normal_distribution<F32> spread(0.f, 12.f);
+    std::exponential_distribution<F32> height(1.f / 30.f);
+    std::lognormal_distribution<F32> radius(-0.5f, 1.f);
+
+    std::vector<LLVector4a> sites(64);
+    for (LLVector4a& site : sites)
+    {
+        site.set(ground(rng), ground(rng), 20.f + height(rng), 0.f);
+    }
+
+    std::vector<BenchElement> elements;
+    elements.reserve(element_count);
+    for (S32 i = 0; i < element_count; ++i)
+    {
+        LLVector4a pos;
+        if (i % 4)
+        {
+            const LLVector4a& site = sites[rng() % sites.size()];
+            pos.set(site[0] + spread(rng), site[1] + spread(rng), site[2] + spread(rng) * 0.5f, 0.f);
+        }
+        else
+        {
+            pos.set(ground(rng), ground(rng), height(rng), 0.f);
+        }
+        elements.emplace_back(pos, llclamp(radius(rng), 0.01f, 64.f));
+    }
+
+    std::vector<U32> removal_order(element_count);
+    for (S32 i = 0; i < element_count; ++i)
+    {
+        removal_order[i] = i;
+    }
+    std::shuffle(removal_order.begin(), removal_order.end(), rng);
+
+    std::vector<LLVector4a> cull_centers(256);
+    for (LLVector4a& center : cull_centers)
+    {
+        center.set(ground(rng), ground(rng), height(rng), 0.f);
+    }
+
+    std::cout << element_count << " elements, node capacity " << capacity << ", node size " << sizeof(bench_node_t)
+              << " bytes, block size " << bench_root_t::node_pool::blockBytes() << " bytes" << std::endl;
+
+    // Alternate the trees so neither always runs on a warm heap
+    PhaseTimes heap_best;
+    PhaseTimes pooled_best;
+    RunResult heap;
+    RunResult pooled;
+    for (S32 iter = 0; iter < iterations; ++iter)
+    {
+        heap = run_tree(false, elements, removal_order, cull_centers);
+        heap_best.keepBest(heap.mTimes);
+
+        pooled = run_tree(true, elements, removal_order, cull_centers);
+        pooled_best.keepBest(pooled.mTimes);
+    }
+
+    std::cout << std::endl;
+    std::cout << "Phase                    heap ms    pooled ms    speedup" << std::endl;
+    const char* names[] = { "insert", "full traversal", "256 sphere culls", "remove" };
+    const F64 heap_times[] = { heap_best.mInsert, heap_best.mTraverse, heap_best.mCull, heap_best.mRemove };
+    const F64 pooled_times[] = { pooled_best.mInsert, pooled_best.mTraverse, pooled_best.mCull, pooled_best.mRemove };
+    for (S32 i = 0; i < 4; ++i)
+    {
+        std::cout << llformat("%-20s %11.1f %12.1f %10.2f",
+                              names[i],
+                              heap_times[i] * 1000.0,
+                              pooled_times[i] * 1000.0,
+                              pooled_times[i] > 0.0 ? heap_times[i] / pooled_times[i] : 0.0)
+                  << std::endl;
+    }
+
+    std::cout << std::endl;
+    std::cout << llformat("nodes %u, node memory heap %.1f MB, pooled %.1f MB",
+                          heap.mNodes,
+                          heap.mBytes / (1024.0 * 1024.0),
+                          pooled.mBytes / (1024.0 * 1024.0))
+              << std::endl;
+
+    const bool same = heap.mNodes == pooled.mNodes && heap.mChecksum == pooled.mChecksum && heap.mCulled == pooled.mCulled;
+    const bool emptied = heap.mEmptied && pooled.mEmptied;
+    if (!same || !emptied)
+    {
+        std::cout << std::endl << (same ? "Trees weren't emptied by removal" : "Pooled and heap trees differ") << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,275 @@
+/**
+ * @file llrendersort_libtest.cpp
+ * @brief Benchmark of render map sorting on packed keys
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+#include "linden_common.h"
+#include "lltimer.h"
+
+#include "llrendersort_libtest.h"
+
+// Linden library includes
+#include "llradixsort.h"
+
+// system libraries
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// doc string provided when invoking the program with --help
+static const char USAGE[] = "\n"
+"usage:\tllrendersort_libtest [options]\n"
+"\n"
+"Builds a synthetic render map, draw calls pushed spatial group by spatial\n"
+"group as LLPipeline::postSort() does, each with a shader, material,\n"
+"vertex buffer and texture. Sorts it with a comparator that reads that\n"
+"state through the draw calls, and with a radix sort on keys packed like\n"
+"LLDrawInfo::updateSortKey(). Reports the time of each sort and the state\n"
+"changes a draw pool would make walking each order.\n"
+"\n"
+" -h, --help\n"
+"        Print this help\n"
+" -d, --draws <n>\n"
+"        Draw calls in the render map. Default is 20000.\n"
+" -n, --iterations <n>\n"
+"        Sorts of each kind, the fastest is reported. Default is 20.\n"
+"\n";
+
+namespace
+{
+
+// Stand-in for the state an LLDrawInfo refers to
+struct BenchState
+{
+    U32 mId;
+};
+
+struct BenchDraw
+{
+    U32 mShader;
+    const BenchState* mMaterial;
+    const BenchState* mTexture;
+    const BenchState* mBuffer;
+    U64 mSortKey;
+};
+
+// Same layout as LLDrawInfo::updateSortKey(), without the matrix palette
+U64 pack_key(const BenchDraw& draw)
+{
+    const U64 shader = llmin(draw.mShader, (U32)0x3F);
+    return (shader << 46) |
+           (ll_sort_key_bits((U64)(uintptr_t)draw.mMaterial, 16) << 30) |
+           (ll_sort_key_bits((U64)(uintptr_t)draw.mBuffer, 16) << 14) |
+           ll_sort_key_bits((U64)(uintptr_t)draw.mTexture, 14);
+}
+
+// What a comparator functor over LLPointer<LLDrawInfo> does
+struct CompareDrawState
+{
+    bool operator()(const BenchDraw* lhs, const BenchDraw* rhs) const
+    {
+        if (lhs->mShader != rhs->mShader)
+        {
+            return lhs->mShader < rhs->mShader;
+        }
+        if (lhs->mMaterial != rhs->mMaterial)
+        {
+            return lhs->mMaterial < rhs->mMaterial;
+        }
+        if (lhs->mBuffer != rhs->mBuffer)
+        {
+            return lhs->mBuffer < rhs->mBuffer;
+        }
+        return lhs->mTexture < rhs->mTexture;
+    }
+};
+
+struct StateChanges
+{
+    U32 mShader = 0;
+    U32 mMaterial = 0;
+    U32 mTexture = 0;
+    U32 mBuffer = 0;
+};
+
+StateChanges count_changes(const std::vector<BenchDraw*>& order)
+{
+    StateChanges changes;
+    const BenchDraw* last = NULL;
+    for (const BenchDraw* draw : order)
+    {
+        changes.mShader += !last || last->mShader != draw->mShader;
+        changes.mMaterial += !last || last->mMaterial != draw->mMaterial;
+        changes.mTexture += !last || last->mTexture != draw->mTexture;
+        changes.mBuffer += !last || last->mBuffer != draw->mBuffer;
+        last = draw;
+    }
+    return changes;
+}
+
+void print_changes(const char* name, const StateChanges& changes)
+{
+    std::cout << llformat("%-12s %8u %9u %8u %8u", name, changes.mShader, changes.mMaterial, changes.mTexture, changes.mBuffer)
+              << std::endl;
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv)
+{
+    S32 draw_count = 20000;
+    S32 iterations = 20;
+
+    // Analyze command line arguments
+    for (int arg = 1; arg < argc; ++arg)
+    {
+        bool has_value = (arg + 1) < argc && argv[arg + 1][0] != '-';
+        if (!strcmp(argv[arg], "--help") || !strcmp(argv[arg], "-h"))
+        {
+            // Send the usage to standard out
+            std::cout << USAGE << std::endl;
+            return 0;
+        }
+        else if (!strcmp(argv[arg], "--draws") || !strcmp(argv[arg], "-d"))
+        {
+            if (has_value)
+            {
+                draw_count = llclamp(atoi(argv[++arg]), 1, 10000000);
+            }
+        }
+        else if (!strcmp(argv[arg], "--iterations") || !strcmp(argv[arg], "-n"))
+        {
+            if (has_value)
+            {
+                iterations = llclamp(atoi(argv[++arg]), 1, 1000);
+            }
+            else
+            {
+                std::cout << "No valid --iterations argument given, default (20) will be used" << std::endl;
+            }
+        }
+    }
+
+    // A scene: textures and materials reused across many objects, a few
+    // popular ones much more than the rest, and each spatial group with
+    // its own vertex buffers
+    std::mt19937 rng(20240601);
+    const U32 texture_count = llmax(draw_count / 10, 1);
+    const U32 material_count = llmax(draw_count / 60, 1);
+    std::vector<BenchState> textures(texture_count);
+    std::vector<BenchState> materials(material_count);
+    std::vector<BenchState> buffers(draw_count);
+    std::geometric_distribution<U32> popular(0.002);
+    std::uniform_int_distribution<U32> shader(0, 15);
+    std::uniform_int_distribution<U32> group_size(4, 40);
+    std::uniform_int_distribution<U32> percent(0, 99);
+
+    std::vector<BenchDraw> draws(draw_count);
+    U32 buffer = 0;
+    for (S32 i = 0; i < draw_count; )
+    {
+        // one spatial group, up to 3 buffers
+        const U32 size = llmin(group_size(rng), (U32)(draw_count - i));
+        const U32 first_buffer = buffer;
+        buffer += 1 + size / 16;
+        for (U32 j = 0; j < size; ++j, ++i)
+        {
+            BenchDraw& draw = draws[i];
+            const bool has_material = percent(rng) < 30;
+            draw.mShader = has_material ? shader(rng) : 0xFFFFFFFF;
+            draw.mMaterial = has_material ? &materials[popular(rng) % material_count] : NULL;
+            draw.mTexture = &textures[popular(rng) % texture_count];
+            draw.mBuffer = &buffers[first_buffer + j / 16];
+            draw.mSortKey = pack_key(draw);
+        }
+    }
+
+    // pushed group by group, but scattered in memory like heap allocated
+    // draw infos
+    std::vector<U32> slots(draw_count);
+    for (S32 i = 0; i < draw_count; ++i)
+    {
+        slots[i] = i;
+    }
+    std::shuffle(slots.begin(), slots.end(), rng);
+    std::vector<BenchDraw> scattered(draw_count);
+    std::vector<BenchDraw*> pushed(draw_count);
+    for (S32 i = 0; i < draw_count; ++i)
+    {
+        scattered[slots[i]] = draws[i];
+        pushed[i] = &scattered[slots[i]];
+    }
+
+    std::vector<BenchDraw*> compared;
+    std::vector<BenchDraw*> radixed;
+    std::vector<LLRadixSortItem<BenchDraw*> > items(draw_count);
+    std::vector<LLRadixSortItem<BenchDraw*> > scratch(draw_count);
+
+    F64 compare_time = 1.e10;
+    F64 radix_time = 1.e10;
+    for (S32 iter = 0; iter < iterations; ++iter)
+    {
+        compared = pushed;
+        F64 start = LLTimer::getTotalSeconds().value();
+        std::sort(compared.begin(), compared.end(), CompareDrawState());
+        compare_time = llmin(compare_time, LLTimer::getTotalSeconds().value() - start);
+
+        radixed = pushed;
+        start = LLTimer::getTotalSeconds().value();
+        for (S32 i = 0; i < draw_count; ++i)
+        {
+            items[i].mKey = radixed[i]->mSortKey;
+            items[i].mValue = radixed[i];
+        }
+        ll_radix_sort(items.data(), scratch.data(), draw_count);
+        for (S32 i = 0; i < draw_count; ++i)
+        {
+            radixed[i] = items[i].mValue;
+        }
+        radix_time = llmin(radix_time, LLTimer::getTotalSeconds().value() - start);
+    }
+
+    std::cout << draw_count << " draws, " << texture_count << " textures, " << material_count << " materials, "
+              << buffer << " vertex buffers" << std::endl << std::endl;
+    std::cout << llformat("comparator sort %8.3f ms", compare_time * 1000.0) << std::endl;
+    std::cout << llformat("radix sort      %8.3f ms (%.2fx)", radix_time * 1000.0,
+                          radix_time > 0.0 ? compare_time / radix_time : 0.0) << std::endl << std::endl;
+
+    std::cout << "Order          shader  material  texture   buffer" << std::endl;
+    print_changes("pushed", count_changes(pushed));
+    print_changes("comparator", count_changes(compared));
+    print_changes("radix", count_changes(radixed));
+
+    // keys only hash the state, two textures whose bits collide may
+    // interleave, so check the key order only
+    for (S32 i = 1; i < draw_count; ++i)
+    {
+        if (radixed[i - 1]->mSortKey > radixed[i]->mSortKey)
+        {
+            std::cout << std::endl << "Radix sort out of order at " << i << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,743 @@
+/**
+ * @file lltexturepipeline_libtest.cpp
+ * @brief Headless benchmark of the texture fetch, cache, decode and create stages
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+#include "linden_common.h"
+#include "llpointer.h"
+#include "lltimer.h"
+
+#include "lltexturepipeline_libtest.h"
+
+// Linden library includes
+#include "llapr.h"
+#include "llcleanup.h"
+#include "lldir.h"
+#include "llfile.h"
+#include "llimage.h"
+#include "llimagej2c.h"
+#include "llimageworker.h"
+#include "llmemory.h"
+#include "llmutex.h"
+#include "lluuid.h"
+
+// llcorehttp library includes
+#include "httpcommon.h"
+#include "httprequest.h"
+#include "httphandler.h"
+#include "httpresponse.h"
+#include "httpoptions.h"
+#include "httpheaders.h"
+#include "bufferarray.h"
+#include "llhttpconstants.h"
+
+#include <curl/curl.h>
+
+// system libraries
+#include <algorithm>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <vector>
+
+// doc string provided when invoking the program with --help
+static const char USAGE[] = "\n"
+"usage:\tlltexturepipeline_libtest [options] --replay <file>\n"
+"\n"
+"Replays a list of texture requests through the same stages the viewer's\n"
+"texture pipeline uses (HTTP fetch, cache, J2C decode on the ImageDecode\n"
+"thread pool, CPU side texture creation) without a GL context, and reports\n"
+"per stage latency percentiles and overall throughput.\n"
+"\n"
+" -h, --help\n"
+"        Print this help\n"
+" -r, --replay <file>\n"
+"        Request list, one texture per line: <uuid> [discard_level]\n"
+" -c, --cache <dir>\n"
+"        Cache directory holding <uuid>.j2c files. Requests found there are\n"
+"        read from disk instead of being fetched.\n"
+" -u, --url <format>\n"
+"        printf-style URL format used to fetch cache misses over HTTP,\n"
+"        e.g. http://localhost:8000/?texture_id=%s\n"
+"        Without it, cache misses are counted as failures.\n"
+" -w, --write-cache\n"
+"        Write textures fetched over HTTP into the cache directory, so a\n"
+"        later run can replay the same list from disk.\n"
+" -d, --discard_level <n>\n"
+"        Discard level for lines that don't give one. Default is 0.\n"
+" -n, --concurrency <n>\n"
+"        Maximum number of textures in flight. Default is 32.\n"
+" -o, --output <file>\n"
+"        Write per texture stage times (ms) as CSV.\n"
+"\n";
+
+namespace
+{
+
+enum EStage
+{
+    STAGE_FETCH = 0,
+    STAGE_CACHE,
+    STAGE_DECODE,
+    STAGE_CREATE,
+    STAGE_TOTAL,
+    STAGE_COUNT
+};
+
+const char* STAGE_NAMES[STAGE_COUNT] = { "fetch", "cache", "decode", "create", "total" };
+
+// The viewer sizes its first request to the header cache record
+constexpr S32 HEADER_REQUEST_SIZE = FIRST_PACKET_SIZE;
+
+F64 now_seconds()
+{
+    return LLTimer::getTotalSeconds().value();
+}
+
+struct TextureRequest
+{
+    LLUUID mID;
+    S32 mDiscard = 0;
+    LLPointer<LLImageJ2C> mImage;
+    S32 mWanted = 0;                    // bytes needed for mDiscard, 0 until header is known
+    F64 mStart = 0.0;
+    F64 mStageStart = 0.0;
+    F64 mStageTime[STAGE_COUNT] = { -1.0, -1.0, -1.0, -1.0, -1.0 };
+    S32 mWidth = 0;
+    S32 mHeight = 0;
+    bool mFailed = false;
+};
+
+class TexturePipeline : public LLCore::HttpHandler
+{
+public:
+    class DecodeResponder : public LLImageDecodeThread::Responder
+    {
+    public:
+        DecodeResponder(TexturePipeline* pipeline, size_t index)
+            : mPipeline(pipeline), mIndex(index)
+        {}
+
+        // Threads:  ImageDecode pool
+        virtual void completed(bool success, const std::string& error_message, LLImageRaw* raw, LLImageRaw* aux, U32 request_id)
+        {
+            mPipeline->decodeDone(mIndex, success, raw);
+        }
+
+    private:
+        TexturePipeline* mPipeline;
+        size_t mIndex;
+    };
+
+    TexturePipeline()
+        : mHttpRequest(NULL),
+          mDecoder(NULL),
+          mConcurrency(32),
+          mWriteCache(false),
+          mNext(0),
+          mInFlight(0),
+          mCompleted(0),
+          mBytesFetched(0),
+          mBytesRead(0),
+          mPixelsCreated(0)
+    {}
+
+    bool loadReplay(const std::string& filename, S32 default_discard);
+
+    void start();
+    bool update();              // Returns true when all requests are done
+    void report(F64 elapsed);
+    void writeCsv(const std::string& filename);
+
+    virtual void onCompleted(LLCore::HttpHandle handle, LLCore::HttpResponse* response);
+    void decodeDone(size_t index, bool success, LLImageRaw* raw);
+
+public:
+    std::string mCacheDir;
+    std::string mUrlFormat;
+    LLCore::HttpRequest* mHttpRequest;
+    LLCore::HttpOptions::ptr_t mHttpOptions;
+    LLCore::HttpHeaders::ptr_t mHttpHeaders;
+    LLImageDecodeThread* mDecoder;
+    S32 mConcurrency;
+    bool mWriteCache;
+
+private:
+    std::string cacheFileName(const LLUUID& id) const;
+    void issue(size_t index);
+    bool readFromCache(size_t index);
+    bool requestRange(size_t index, S32 offset, S32 length);
+    void writeToCache(size_t index);
+    void postDecode(size_t index);
+    void create(size_t index, LLPointer<LLImageRaw> raw);
+    void finish(size_t index, bool failed);
+
+    typedef std::map<LLCore::HttpHandle, size_t> handle_map_t;
+    typedef std::pair<size_t, LLPointer<LLImageRaw> > decoded_t;
+
+    std::vector<TextureRequest> mRequests;
+    handle_map_t mHandles;
+    size_t mNext;
+    S32 mInFlight;
+    size_t mCompleted;
+    U64 mBytesFetched;
+    U64 mBytesRead;
+    U64 mPixelsCreated;
+
+    LLMutex mDecodedMutex;
+    std::deque<decoded_t> mDecoded;                                     // mDecodedMutex
+};
+
+void no_op_deletor(LLCore::HttpHandler*)
+{
+}
+
+bool TexturePipeline::loadReplay(const std::string& filename, S32 default_discard)
+{
+    std::ifstream in(filename.c_str());
+    if (!in)
+    {
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(in, line))
+    {
+        std::istringstream fields(line);
+        std::string uuid;
+        fields >> uuid;
+        if (uuid.empty() || uuid[0] == '#' || !LLUUID::validate(uuid))
+        {
+            continue;
+        }
+
+        TextureRequest request;
+        request.mID.set(uuid);
+        if (!(fields >> request.mDiscard))
+        {
+            request.mDiscard = default_discard;
+        }
+        request.mDiscard = llclamp(request.mDiscard, 0, MAX_DISCARD_LEVEL);
+        mRequests.push_back(request);
+    }
+    return !mRequests.empty();
+}
+
+std::string TexturePipeline::cacheFileName(const LLUUID& id) const
+{
+    return mCacheDir + gDirUtilp->getDirDelimiter() + id.asString() + ".j2c";
+}
+
+void TexturePipeline::start()
+{
+    while (mInFlight < mConcurrency && mNext < mRequests.size())
+    {
+        issue(mNext++);
+    }
+}
+
+void TexturePipeline::issue(size_t index)
+{
+    TextureRequest& request = mRequests[index];
+    request.mStart = now_seconds();
+    request.mImage = new LLImageJ2C;
+    ++mInFlight;
+
+    if (!mCacheDir.empty() && LLFile::isfile(cacheFileName(request.mID)))
+    {
+        if (readFromCache(index))
+        {
+            postDecode(index);
+        }
+        else
+        {
+            finish(index, true);
+        }
+    }
+    else if (!mUrlFormat.empty() && mHttpRequest)
+    {
+        // Header first unless the whole file is wanted, as the viewer
+        // does for textures whose dimensions it doesn't know yet.
+        request.mStageStart = request.mStart;
+        if (!requestRange(index, 0, request.mDiscard == 0 ? 0 : HEADER_REQUEST_SIZE))
+        {
+            finish(index, true);
+        }
+    }
+    else
+    {
+        finish(index, true);
+    }
+}
+
+bool TexturePipeline::readFromCache(size_t index)
+{
+    TextureRequest& request = mRequests[index];
+    std::string filename = cacheFileName(request.mID);
+
+    F64 start = now_seconds();
+    if (!request.mImage->load(filename, HEADER_REQUEST_SIZE))
+    {
+        return false;
+    }
+    S32 wanted = request.mDiscard == 0 ? 0 : request.mImage->calcDataSize(request.mDiscard);
+    if (wanted == 0 || wanted > request.mImage->getDataSize())
+    {
+        request.mImage = new LLImageJ2C;
+        if (!request.mImage->load(filename, wanted))
+        {
+            return false;
+        }
+    }
+    request.mStageTime[STAGE_CACHE] = now_seconds() - start;
+    mBytesRead += request.mImage->getDataSize();
+    return true;
+}
+
+bool TexturePipeline::requestRange(size_t index, S32 offset, S32 length)
+{
+    char url[1024];
+    snprintf(url, sizeof(url), mUrlFormat.c_str(), mRequests[index].mID.asString().c_str());
+
+    LLCore::HttpHandle handle;
+    if (offset || length)
+    {
+        handle = mHttpRequest->requestGetByteRange(LLCore::HttpRequest::DEFAULT_POLICY_ID, url, offset, length,
+                                                   mHttpOptions, mHttpHeaders, LLCore::HttpHandler::ptr_t(this, no_op_deletor));
+    }
+    else
+    {
+        handle = mHttpRequest->requestGet(LLCore::HttpRequest::DEFAULT_POLICY_ID, url,
+                                          mHttpOptions, mHttpHeaders, LLCore::HttpHandler::ptr_t(this, no_op_deletor));
+    }
+    if (LLCORE_HTTP_HANDLE_INVALID == handle)
+    {
+        std::cout << "Failed to queue HTTP request: " << mHttpRequest->getStatus().toString() << std::endl;
+        return false;
+    }
+    mHandles[handle] = index;
+    return true;
+}
+
+void TexturePipeline::onCompleted(LLCore::HttpHandle handle, LLCore::HttpResponse* response)
+{
+    handle_map_t::iterator it = mHandles.find(handle);
+    if (it == mHandles.end())
+    {
+        return;
+    }
+    size_t index = it->second;
+    mHandles.erase(it);
+    TextureRequest& request = mRequests[index];
+
+    LLCore::HttpStatus status = response->getStatus();
+    LLCore::BufferArray* body = response->getBody();
+    static const LLCore::HttpStatus partial_content(HTTP_PARTIAL_CONTENT);
+    if (!status || !body || !body->size())
+    {
+        std::cout << request.mID << ": fetch failed: " << status.toString() << std::endl;
+        finish(index, true);
+        return;
+    }
+
+    // A server that ignores Range: sends the whole file, which
+    // satisfies any discard level.
+    bool whole_file = (status != partial_content);
+    if (whole_file && request.mImage->getDataSize())
+    {
+        request.mImage = new LLImageJ2C;
+    }
+
+    size_t size = body->size();
+    U8* data = (U8*)ll_aligned_malloc_16(size);
+    body->read(0, data, size);
+    request.mImage->appendData(data, (S32)size);
+    mBytesFetched += size;
+
+    if (!request.mImage->updateData())
+    {
+        std::cout << request.mID << ": bad j2c data: " << request.mImage->getLastError() << std::endl;
+        finish(index, true);
+        return;
+    }
+
+    if (!whole_file && !request.mWanted)
+    {
+        request.mWanted = request.mImage->calcDataSize(request.mDiscard);
+        S32 have = request.mImage->getDataSize();
+        if (request.mWanted > have && size >= (size_t)HEADER_REQUEST_SIZE)
+        {
+            // Second round trip for the body up to the wanted discard level
+            if (!requestRange(index, have, request.mWanted - have))
+            {
+                finish(index, true);
+            }
+            return;
+        }
+    }
+
+    request.mStageTime[STAGE_FETCH] = now_seconds() - request.mStageStart;
+    if (mWriteCache && !mCacheDir.empty())
+    {
+        writeToCache(index);
+    }
+    postDecode(index);
+}
+
+void TexturePipeline::writeToCache(size_t index)
+{
+    TextureRequest& request = mRequests[index];
+
+    F64 start = now_seconds();
+    LLFILE* file = LLFile::fopen(cacheFileName(request.mID), "wb");
+    if (file)
+    {
+        fwrite(request.mImage->getData(), 1, request.mImage->getDataSize(), file);
+        fclose(file);
+        request.mStageTime[STAGE_CACHE] = now_seconds() - start;
+    }
+}
+
+void TexturePipeline::postDecode(size_t index)
+{
+    TextureRequest& request = mRequests[index];
+    request.mStageStart = now_seconds();
+    if (!mDecoder->decodeImage(request.mImage.get(), request.mDiscard, false, new DecodeResponder(this, index)))
+    {
+        finish(index, true);
+    }
+}
+
+void TexturePipeline::decodeDone(size_t index, bool success, LLImageRaw* raw)
+{
+    LLMutexLock lock(&mDecodedMutex);
+    mDecoded.push_back(decoded_t(index, success ? raw : NULL));
+}
+
+void TexturePipeline::create(size_t index, LLPointer<LLImageRaw> raw)
+{
+    TextureRequest& request = mRequests[index];
+
+    // The CPU side of LLViewerFetchedTexture::preCreateTexture() and
+    // LLImageGL::createGLTexture(): power of two sizing and the alpha
+    // check that picks the upload format.  GL upload itself is not timed.
+    F64 start = now_seconds();
+    raw->biasedScaleToPowerOfTwo(MAX_IMAGE_SIZE);
+    raw->optimizeAwayAlpha();
+    request.mStageTime[STAGE_CREATE] = now_seconds() - start;
+
+    request.mWidth = raw->getWidth();
+    request.mHeight = raw->getHeight();
+    mPixelsCreated += (U64)request.mWidth * request.mHeight;
+}
+
+void TexturePipeline::finish(size_t index, bool failed)
+{
+    TextureRequest& request = mRequests[index];
+    request.mFailed = failed;
+    request.mStageTime[STAGE_TOTAL] = now_seconds() - request.mStart;
+    request.mImage = NULL;
+    --mInFlight;
+    ++mCompleted;
+}
+
+bool TexturePipeline::update()
+{
+    std::deque<decoded_t> decoded;
+    {
+        LLMutexLock lock(&mDecodedMutex);
+        decoded.swap(mDecoded);
+    }
+
+    for (decoded_t& item : decoded)
+    {
+        TextureRequest& request = mRequests[item.first];
+        request.mStageTime[STAGE_DECODE] = now_seconds() - request.mStageStart;
+        if (item.second.notNull())
+        {
+            create(item.first, item.second);
+            finish(item.first, false);
+        }
+        else
+        {
+            std::cout << request.mID << ": decode failed" << std::endl;
+            finish(item.first, true);
+        }
+    }
+
+    start();
+    return mCompleted == mRequests.size();
+}
+
+void TexturePipeline::report(F64 elapsed)
+{
+    size_t failures = 0;
+    for (const TextureRequest& request : mRequests)
+    {
+        failures += request.mFailed ? 1 : 0;
+    }
+
+    std::cout << "Textures: " << mRequests.size() << "  Failed: " << failures
+              << "  Concurrency: " << mConcurrency << std::endl;
+    std::cout << std::endl;
+    std::cout << "Stage     count      p50 ms      p90 ms      p99 ms      max ms" << std::endl;
+
+    for (S32 stage = 0; stage < STAGE_COUNT; ++stage)
+    {
+        std::vector<F64> times;
+        times.reserve(mRequests.size());
+        for (const TextureRequest& request : mRequests)
+        {
+            if (!request.mFailed && request.mStageTime[stage] >= 0.0)
+            {
+                times.push_back(request.mStageTime[stage] * 1000.0);
+            }
+        }
+        if (times.empty())
+        {
+            std::cout << llformat("%-8s %6d", STAGE_NAMES[stage], 0) << std::endl;
+            continue;
+        }
+
+        std::sort(times.begin(), times.end());
+        auto percentile = [&times](F64 p)
+        {
+            size_t rank = (size_t)llceil(p * times.size()) - 1;
+            return times[llclamp(rank, (size_t)0, times.size() - 1)];
+        };
+        std::cout << llformat("%-8s %6d %11.2f %11.2f %11.2f %11.2f",
+                              STAGE_NAMES[stage], (S32)times.size(),
+                              percentile(0.50), percentile(0.90), percentile(0.99), times.back())
+                  << std::endl;
+    }
+
+    std::cout << std::endl;
+    if (elapsed > 0.0)
+    {
+        const F64 done = (F64)(mRequests.size() - failures);
+        std::cout << llformat("Wall time: %.2f s  Throughput: %.1f textures/s  Fetched: %.2f MB/s  Read: %.2f MB/s  Created: %.1f Mpixel/s",
+                              elapsed,
+                              done / elapsed,
+                              mBytesFetched / (1024.0 * 1024.0) / elapsed,
+                              mBytesRead / (1024.0 * 1024.0) / elapsed,
+                              mPixelsCreated / 1000000.0 / elapsed)
+                  << std::endl;
+    }
+}
+
+void TexturePipeline::writeCsv(const std::string& filename)
+{
+    std::ofstream out(filename.c_str());
+    out << "uuid,discard,width,height,failed";
+    for (S32 stage = 0; stage < STAGE_COUNT; ++stage)
+    {
+        out << "," << STAGE_NAMES[stage] << "_ms";
+    }
+    out << std::endl;
+
+    for (const TextureRequest& request : mRequests)
+    {
+        out << request.mID << "," << request.mDiscard << "," << request.mWidth << "," << request.mHeight
+            << "," << (request.mFailed ? 1 : 0);
+        for (S32 stage = 0; stage < STAGE_COUNT; ++stage)
+        {
+            out << ",";
+            if (request.mStageTime[stage] >= 0.0)
+            {
+                out << llformat("%.3f", request.mStageTime[stage] * 1000.0);
+            }
+        }
+        out << std::endl;
+    }
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv)
+{
+    std::string replay_file;
+    std::string output_file;
+    S32 default_discard = 0;
+    TexturePipeline pipeline;
+
+    // Analyze command line arguments
+    for (int arg = 1; arg < argc; ++arg)
+    {
+        bool has_value = (arg + 1) < argc && argv[arg + 1][0] != '-';
+        if (!strcmp(argv[arg], "--help") || !strcmp(argv[arg], "-h"))
+        {
+            // Send the usage to standard out
+            std::cout << USAGE << std::endl;
+            return 0;
+        }
+        else if (!strcmp(argv[arg], "--replay") || !strcmp(argv[arg], "-r"))
+        {
+            if (has_value)
+            {
+                replay_file = argv[++arg];
+            }
+        }
+        else if (!strcmp(argv[arg], "--cache") || !strcmp(argv[arg], "-c"))
+        {
+            if (has_value)
+            {
+                pipeline.mCacheDir = argv[++arg];
+            }
+        }
+        else if (!strcmp(argv[arg], "--url") || !strcmp(argv[arg], "-u"))
+        {
+            if (has_value)
+            {
+                pipeline.mUrlFormat = argv[++arg];
+            }
+        }
+        else if (!strcmp(argv[arg], "--write-cache") || !strcmp(argv[arg], "-w"))
+        {
+            pipeline.mWriteCache = true;
+        }
+        else if (!strcmp(argv[arg], "--discard_level") || !strcmp(argv[arg], "-d"))
+        {
+            if (has_value)
+            {
+                default_discard = llclamp(atoi(argv[++arg]), 0, MAX_DISCARD_LEVEL);
+            }
+            else
+            {
+                std::cout << "No valid --discard_level argument given, discard_level ignored" << std::endl;
+            }
+        }
+        else if (!strcmp(argv[arg], "--concurrency") || !strcmp(argv[arg], "-n"))
+        {
+            if (has_value)
+            {
+                pipeline.mConcurrency = llclamp(atoi(argv[++arg]), 1, 1000);
+            }
+            else
+            {
+                std::cout << "No valid --concurrency argument given, default (32) will be used" << std::endl;
+            }
+        }
+        else if (!strcmp(argv[arg], "--output") || !strcmp(argv[arg], "-o"))
+        {
+            if (has_value)
+            {
+                output_file = argv[++arg];
+            }
+        }
+    }
+
+    // Check arguments consistency. Exit with proper message if inconsistent.
+    if (replay_file.empty())
+    {
+        std::cout << "No replay file, nothing to do -> exit" << std::endl;
+        return 0;
+    }
+    if (pipeline.mCacheDir.empty() && pipeline.mUrlFormat.empty())
+    {
+        std::cout << "Need a cache directory (-c) or a URL format (-u) to get texture data from -> exit" << std::endl;
+        return 1;
+    }
+    if (pipeline.mWriteCache && pipeline.mCacheDir.empty())
+    {
+        std::cout << "--write-cache needs a cache directory (-c) -> exit" << std::endl;
+        return 1;
+    }
+
+    // Init whatever is necessary
+    ll_init_apr();
+    LLImage::initClass();
+
+    if (!pipeline.loadReplay(replay_file, default_discard))
+    {
+        std::cout << "No texture requests found in " << replay_file << " -> exit" << std::endl;
+        return 1;
+    }
+
+    if (!pipeline.mUrlFormat.empty())
+    {
+        curl_global_init(CURL_GLOBAL_ALL);
+        LLCore::HttpRequest::createService();
+        LLCore::HttpRequest::setStaticPolicyOption(LLCore::HttpRequest::PO_CONNECTION_LIMIT,
+                                                   LLCore::HttpRequest::DEFAULT_POLICY_ID,
+                                                   pipeline.mConcurrency,
+                                                   NULL);
+        LLCore::HttpRequest::setStaticPolicyOption(LLCore::HttpRequest::PO_PER_HOST_CONNECTION_LIMIT,
+                                                   LLCore::HttpRequest::DEFAULT_POLICY_ID,
+                                                   pipeline.mConcurrency,
+                                                   NULL);
+        LLCore::HttpRequest::startThread();
+
+        pipeline.mHttpRequest = new LLCore::HttpRequest();
+        pipeline.mHttpOptions = LLCore::HttpOptions::ptr_t(new LLCore::HttpOptions());
+        pipeline.mHttpOptions->setRetries(3);
+        pipeline.mHttpOptions->setUseRetryAfter(true);
+        pipeline.mHttpHeaders = LLCore::HttpHeaders::ptr_t(new LLCore::HttpHeaders());
+        pipeline.mHttpHeaders->append(HTTP_OUT_HEADER_ACCEPT, HTTP_CONTENT_IMAGE_X_J2C);
+    }
+
+    pipeline.mDecoder = new LLImageDecodeThread();
+
+    // Run it
+    F64 start = LLTimer::getTotalSeconds().value();
+    pipeline.start();
+    while (!pipeline.update())
+    {
+        if (pipeline.mHttpRequest)
+        {
+            pipeline.mHttpRequest->update(0);
+        }
+        ms_sleep(1);
+    }
+    F64 elapsed = LLTimer::getTotalSeconds().value() - start;
+
+    // Report
+    pipeline.report(elapsed);
+    if (!output_file.empty())
+    {
+        pipeline.writeCsv(output_file);
+        std::cout << "Per texture stage times written to " << output_file << std::endl;
+    }
+
+    // Cleanup and exit
+    pipeline.mDecoder->shutdown();
+    delete pipeline.mDecoder;
+    pipeline.mDecoder = NULL;
+
+    if (pipeline.mHttpRequest)
+    {
+        pipeline.mHttpRequest->requestStopThread(LLCore::HttpHandler::ptr_t());
+        ms_sleep(1000);
+        pipeline.mHttpOptions.reset();
+        pipeline.mHttpHeaders.reset();
+        delete pipeline.mHttpRequest;
+        pipeline.mHttpRequest = NULL;
+        LLCore::HttpRequest::destroyService();
+        curl_global_cleanup();
+    }
+
+    SUBSYSTEM_CLEANUP(LLImage);
+
+    return 0;
+}
@@ -0,0 +1,502 @@
+/**
+ * @file llvolumebvh_libtest.cpp
+ * @brief Benchmark of LLVolumeBVH against LLVolumeOctree for volume face raycasts
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+#include "linden_common.h"
+#include "llpointer.h"
+#include "lltimer.h"
+
+#include "llvolumebvh_libtest.h"
+
+// Linden library includes
+#include "lldir.h"
+#include "lldiriterator.h"
+#include "llfile.h"
+#include "llsd.h"
+#include "llsdserialize.h"
+#include "llvolume.h"
+#include "llvolumebvh.h"
+#include "llvolumeoctree.h"
+#include "lluuid.h"
+
+// system libraries
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <vector>
+
+// Octree settings, normally set by the viewer from OctreeMaxNodeCapacity
+// and OctreeMinimumNodeSize
+extern U32 gOctreeMaxCapacity;
+extern F32 gOctreeMinSize;
+
+// doc string provided when invoking the program with --help
+static const char USAGE[] = "\n"
+"usage:\tllvolumebvh_libtest [options]\n"
+"\n"
+"Builds an LLVolumeOctree and an LLVolumeBVH for every face of the standard\n"
+"prim shapes at every level of detail, and optionally of a corpus of mesh\n"
+"assets, then casts the same random segments through both. Reports build\n"
+"time, memory, ray throughput and the number of rays where the closest hit\n"
+"differs.\n"
+"\n"
+" -h, --help\n"
+"        Print this help\n"
+" -m, --mesh <dir>\n"
+"        Directory of mesh asset files (as served by the mesh capability).\n"
+"        Every LOD found in each file is decoded and added to the corpus.\n"
+" -n, --iterations <n>\n"
+"        Builds and ray passes per structure. Default is 10.\n"
+" -r, --rays <n>\n"
+"        Segments cast per face and pass. Default is 64.\n"
+"\n";
+
+namespace
+{
+
+// LLVolumeLODGroup detail scales
+const F32 DETAIL_SCALES[] = { 1.f, 1.5f, 2.5f, 4.f };
+
+const char* MESH_LOD_NAMES[] = { "lowest_lod", "low_lod", "medium_lod", "high_lod" };
+
+// The octree culls with LLLineSegmentBoxIntersect and the BVH with its own
+// slab test, a hit grazing a node boundary may be found by only one of them
+constexpr F32 MAX_MISMATCH_RATE = 0.001f;
+
+struct Segment
+{
+    LLVector4a mStart;
+    LLVector4a mDir;
+};
+
+struct FaceSet
+{
+    std::string mName;
+    std::vector<LLPointer<LLVolume> > mVolumes;
+    U32 mFaces = 0;
+    U32 mTriangles = 0;
+
+    void add(LLVolume* volume)
+    {
+        mVolumes.push_back(volume);
+        for (S32 i = 0; i < volume->getNumVolumeFaces(); ++i)
+        {
+            const LLVolumeFace& face = volume->getVolumeFace(i);
+            if (usable(face))
+            {
+                mFaces++;
+                mTriangles += face.mNumIndices / 3;
+            }
+        }
+    }
+
+    static bool usable(const LLVolumeFace& face)
+    {
+        return face.mNumVertices > 0 && face.mNumIndices >= 3 && face.mPositions && face.mIndices;
+    }
+};
+
+// Node and triangle storage of a built octree
+class OctreeMemory : public LLOctreeTraveler<LLVolumeTriangle, LLVolumeTriangle*>
+{
+public:
+    size_t mBytes = 0;
+
+    void visit(const LLOctreeNode<LLVolumeTriangle, LLVolumeTriangle*>* node) override
+    {
+        mBytes += sizeof(LLOctreeNode<LLVolumeTriangle, LLVolumeTriangle*>) + sizeof(LLVolumeOctreeListener)
+                  + node->getElementCount() * sizeof(LLVolumeTriangle*);
+    }
+};
+
+// Segments from random points around the face extents to random points
+// around them on the other side, most cross the face and some miss it
+void make_segments(const LLVolumeFace& face, S32 count, std::mt19937& rng, std::vector<Segment>& segments)
+{
+    LLVector4a center, size;
+    center.setAdd(face.mExtents[0], face.mExtents[1]);
+    center.mul(0.5f);
+    size.setSub(face.mExtents[1], face.mExtents[0]);
+    size.mul(0.75f);
+
+    std::uniform_real_distribution<F32> unit(-1.f, 1.f);
+    for (S32 i = 0; i < count; ++i)
+    {
+        LLVector4a offset(unit(rng), unit(rng), unit(rng));
+        offset.normalize3fast();
+        offset.mul(size.getLength3().getF32() + 0.01f);
+
+        LLVector4a jitter(unit(rng), unit(rng), unit(rng));
+        jitter.mul(size);
+
+        Segment& segment = segments.emplace_back();
+        segment.mStart.setAdd(center, offset);
+        LLVector4a end;
+        end.setSub(center, offset);
+        end.add(jitter);
+        segment.mDir.setSub(end, segment.mStart);
+    }
+}
+
+struct Results
+{
+    F64 mOctreeBuild = 0.0;
+    F64 mBVHBuild = 0.0;
+    F64 mBVHRefit = 0.0;
+    F64 mOctreeRays = 0.0;
+    F64 mBVHRays = 0.0;
+    size_t mOctreeBytes = 0;
+    size_t mBVHBytes = 0;
+    U32 mRays = 0;
+    U32 mHits = 0;
+    U32 mMismatches = 0;
+};
+
+void run(FaceSet& set, S32 iterations, S32 rays_per_face, Results& results)
+{
+    std::mt19937 rng(1234);
+
+    std::vector<LLVolumeFace*> faces;
+    std::vector<std::vector<Segment> > segments;
+    for (const LLPointer<LLVolume>& volume : set.mVolumes)
+    {
+        for (S32 i = 0; i < volume->getNumVolumeFaces(); ++i)
+        {
+            LLVolumeFace& face = volume->getVolumeFace(i);
+            if (FaceSet::usable(face))
+            {
+                faces.push_back(&face);
+                make_segments(face, rays_per_face, rng, segments.emplace_back());
+            }
+        }
+    }
+
+    std::vector<LLVolumeBVH> bvhs(faces.size());
+
+    for (S32 iter = 0; iter < iterations; ++iter)
+    {
+        F64 start = LLTimer::getTotalSeconds().value();
+        for (LLVolumeFace* face : faces)
+        {
+            face->destroyOctree();
+            face->createOctree();
+        }
+        results.mOctreeBuild += LLTimer::getTotalSeconds().value() - start;
+
+        start = LLTimer::getTotalSeconds().value();
+        for (size_t f = 0; f < faces.size(); ++f)
+        {
+            bvhs[f].build(faces[f]->mPositions, faces[f]->mIndices, faces[f]->mNumIndices / 3);
+        }
+        results.mBVHBuild += LLTimer::getTotalSeconds().value() - start;
+
+        start = LLTimer::getTotalSeconds().value();
+        for (size_t f = 0; f < faces.size(); ++f)
+        {
+            bvhs[f].refit(faces[f]->mPositions, faces[f]->mIndices);
+        }
+        results.mBVHRefit += LLTimer::getTotalSeconds().value() - start;
+    }
+
+    for (size_t f = 0; f < faces.size(); ++f)
+    {
+        OctreeMemory memory;
+        memory.traverse(faces[f]->getOctree());
+        results.mOctreeBytes += memory.mBytes + (faces[f]->mNumIndices / 3) * sizeof(LLVolumeTriangle);
+        results.mBVHBytes += bvhs[f].getMemoryUsage();
+    }
+
+    // closest t per ray from the octree, checked against the BVH below
+    std::vector<F32> octree_t;
+    for (S32 iter = 0; iter < iterations; ++iter)
+    {
+        octree_t.clear();
+        F64 start = LLTimer::getTotalSeconds().value();
+        for (size_t f = 0; f < faces.size(); ++f)
+        {
+            for (const Segment& segment : segments[f])
+            {
+                F32 closest_t = 2.f;
+                LLOctreeTriangleRayIntersect intersect(segment.mStart, segment.mDir, faces[f], &closest_t,
+                                                       nullptr, nullptr, nullptr, nullptr);
+                intersect.traverse(faces[f]->getOctree());
+                octree_t.push_back(intersect.mHitFace ? closest_t : 2.f);
+            }
+        }
+        results.mOctreeRays += LLTimer::getTotalSeconds().value() - start;
+    }
+
+    for (S32 iter = 0; iter < iterations; ++iter)
+    {
+        const bool check = iter == 0;
+        U32 ray = 0;
+        F64 start = LLTimer::getTotalSeconds().value();
+        for (size_t f = 0; f < faces.size(); ++f)
+        {
+            for (const Segment& segment : segments[f])
+            {
+                F32 closest_t = 2.f;
+                F32 a, b;
+                S32 tri = bvhs[f].intersect(faces[f]->mPositions, faces[f]->mIndices, segment.mStart, segment.mDir,
+                                            closest_t, a, b);
+                if (check)
+                {
+                    const F32 bvh_t = tri >= 0 ? closest_t : 2.f;
+                    results.mRays++;
+                    results.mHits += tri >= 0 ? 1 : 0;
+                    if (fabsf(bvh_t - octree_t[ray]) > 1.e-6f)
+                    {
+                        results.mMismatches++;
+                    }
+                }
+                ray++;
+            }
+        }
+        results.mBVHRays += LLTimer::getTotalSeconds().value() - start;
+    }
+
+    for (LLVolumeFace* face : faces)
+    {
+        face->destroyOctree();
+    }
+}
+
+void add_prims(FaceSet& set)
+{
+    struct PrimShape
+    {
+        U8 mProfile;
+        U8 mPath;
+        F32 mHollow;
+        F32 mRatioY;
+    };
+
+    // The shapes of the build floater's create palette, plus a hollow
+    // box for the hollow cap and inner side paths
+    const PrimShape shapes[] = {
+        { LL_PCODE_PROFILE_SQUARE,      LL_PCODE_PATH_LINE,   0.f,  1.f  }, // box
+        { LL_PCODE_PROFILE_SQUARE,      LL_PCODE_PATH_LINE,   0.5f, 1.f  }, // hollow box
+        { LL_PCODE_PROFILE_CIRCLE,      LL_PCODE_PATH_LINE,   0.f,  1.f  }, // cylinder
+        { LL_PCODE_PROFILE_EQUALTRI,    LL_PCODE_PATH_LINE,   0.f,  1.f  }, // prism
+        { LL_PCODE_PROFILE_CIRCLE_HALF, LL_PCODE_PATH_CIRCLE, 0.f,  1.f  }, // sphere
+        { LL_PCODE_PROFILE_CIRCLE,      LL_PCODE_PATH_CIRCLE, 0.f,  0.25f }, // torus
+        { LL_PCODE_PROFILE_SQUARE,      LL_PCODE_PATH_CIRCLE, 0.f,  0.25f }, // tube
+        { LL_PCODE_PROFILE_EQUALTRI,    LL_PCODE_PATH_CIRCLE, 0.f,  0.25f }, // ring
+    };
+
+    for (const PrimShape& shape : shapes)
+    {
+        LLVolumeParams params;
+        params.setType(shape.mProfile, shape.mPath);
+        params.setBeginAndEndS(0.f, 1.f);
+        params.setBeginAndEndT(0.f, 1.f);
+        params.setRatio(1.f, shape.mRatioY);
+        params.setShear(0.f, 0.f);
+        params.setHollow(shape.mHollow);
+
+        for (F32 detail : DETAIL_SCALES)
+        {
+            set.add(new LLVolume(params, detail));
+        }
+    }
+}
+
+// Decode every LOD of one mesh asset file, returns the number of LODs added
+S32 add_mesh(FaceSet& set, const std::string& filename)
+{
+    llifstream file(filename.c_str(), std::ios::in | std::ios::binary);
+    if (!file.is_open())
+    {
+        return 0;
+    }
+    std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (data.empty())
+    {
+        return 0;
+    }
+
+    llssize data_size = data.size();
+    llssize deprecated_size = 0;
+    char* result_ptr = strip_deprecated_header(data.data(), data_size, &deprecated_size);
+
+    std::istringstream stream(std::string(result_ptr, data_size));
+    LLSD header;
+    if (!LLSDSerialize::fromBinary(header, stream, data_size) || !header.isMap())
+    {
+        std::cout << "Not a mesh asset: " << filename << std::endl;
+        return 0;
+    }
+    const llssize header_size = deprecated_size + (llssize)stream.tellg();
+
+    LLVolumeParams params;
+    params.setType(LL_PCODE_PROFILE_SQUARE, LL_PCODE_PATH_LINE);
+    params.setSculptID(LLUUID::generateNewID(), LL_SCULPT_TYPE_MESH);
+
+    S32 added = 0;
+    for (S32 lod = 0; lod < LL_ARRAY_SIZE(MESH_LOD_NAMES); ++lod)
+    {
+        const char* lod_name = MESH_LOD_NAMES[lod];
+        if (!header.has(lod_name))
+        {
+            continue;
+        }
+        const llssize offset = header_size + header[lod_name]["offset"].asInteger();
+        const S32 size = header[lod_name]["size"].asInteger();
+        if (offset < 0 || size <= 0 || offset + size > (llssize)data.size())
+        {
+            continue;
+        }
+
+        LLPointer<LLVolume> volume = new LLVolume(params, DETAIL_SCALES[lod]);
+        if (volume->unpackVolumeFaces((U8*)data.data() + offset, size))
+        {
+            set.add(volume);
+            added++;
+        }
+    }
+    return added;
+}
+
+void add_meshes(FaceSet& set, const std::string& dirname)
+{
+    LLDirIterator iter(dirname, "*");
+    std::string name;
+    S32 files = 0;
+    S32 lods = 0;
+    while (iter.next(name))
+    {
+        S32 added = add_mesh(set, dirname + gDirUtilp->getDirDelimiter() + name);
+        files += added > 0 ? 1 : 0;
+        lods += added;
+    }
+    std::cout << "Decoded " << lods << " LODs from " << files << " mesh assets in " << dirname << std::endl;
+}
+
+bool report(FaceSet& set, S32 iterations, S32 rays_per_face)
+{
+    std::cout << std::endl;
+    std::cout << set.mName << ": " << set.mVolumes.size() << " volumes, " << set.mFaces << " faces, "
+              << set.mTriangles << " triangles" << std::endl;
+    if (!set.mFaces)
+    {
+        return true;
+    }
+
+    Results results;
+    run(set, iterations, rays_per_face, results);
+
+    const F64 rays = (F64)results.mRays * iterations;
+    std::cout << "Structure   build ms   refit ms   memory KB   Mrays/s" << std::endl;
+    std::cout << llformat("%-9s %10.2f %10s %11.1f %9.2f",
+                          "octree",
+                          results.mOctreeBuild * 1000.0 / iterations,
+                          "-",
+                          results.mOctreeBytes / 1024.0,
+                          results.mOctreeRays > 0.0 ? rays / results.mOctreeRays / 1000000.0 : 0.0)
+              << std::endl;
+    std::cout << llformat("%-9s %10.2f %10.2f %11.1f %9.2f",
+                          "bvh",
+                          results.mBVHBuild * 1000.0 / iterations,
+                          results.mBVHRefit * 1000.0 / iterations,
+                          results.mBVHBytes / 1024.0,
+                          results.mBVHRays > 0.0 ? rays / results.mBVHRays / 1000000.0 : 0.0)
+              << std::endl;
+    std::cout << results.mRays << " rays, " << results.mHits << " hits, "
+              << results.mMismatches << " with a different closest hit" << std::endl;
+
+    return results.mMismatches <= results.mRays * MAX_MISMATCH_RATE;
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv)
+{
+    std::string mesh_dir;
+    S32 iterations = 10;
+    S32 rays_per_face = 64;
+
+    // Analyze command line arguments
+    for (int arg = 1; arg < argc; ++arg)
+    {
+        bool has_value = (arg + 1) < argc && argv[arg + 1][0] != '-';
+        if (!strcmp(argv[arg], "--help") || !strcmp(argv[arg], "-h"))
+        {
+            // Send the usage to standard out
+            std::cout << USAGE << std::endl;
+            return 0;
+        }
+        else if (!strcmp(argv[arg], "--mesh") || !strcmp(argv[arg], "-m"))
+        {
+            if (has_value)
+            {
+                mesh_dir = argv[++arg];
+            }
+        }
+        else if (!strcmp(argv[arg], "--iterations") || !strcmp(argv[arg], "-n"))
+        {
+            if (has_value)
+            {
+                iterations = llclamp(atoi(argv[++arg]), 1, 100000);
+            }
+            else
+            {
+                std::cout << "No valid --iterations argument given, default (10) will be used" << std::endl;
+            }
+        }
+        else if (!strcmp(argv[arg], "--rays") || !strcmp(argv[arg], "-r"))
+        {
+            if (has_value)
+            {
+                rays_per_face = llclamp(atoi(argv[++arg]), 1, 100000);
+            }
+            else
+            {
+                std::cout << "No valid --rays argument given, default (64) will be used" << std::endl;
+            }
+        }
+    }
+
+    gOctreeMaxCapacity = 128;
+    gOctreeMinSize = 0.01f;
+
+    FaceSet prims;
+    prims.mName = "Prims";
+    add_prims(prims);
+    bool ok = report(prims, iterations, rays_per_face);
+
+    if (!mesh_dir.empty())
+    {
+        FaceSet meshes;
+        meshes.mName = "Meshes";
+        add_meshes(meshes, mesh_dir);
+        ok = report(meshes, iterations, rays_per_face) && ok;
+    }
+
+    if (!ok)
+    {
+        std::cout << std::endl << "Octree and BVH disagree on too many rays" << std::endl;
+        return 1;
+    }
+    return 0;
+}
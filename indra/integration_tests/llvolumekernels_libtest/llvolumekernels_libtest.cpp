@@ -0,0 +1,591 @@
+/**
+ * @file llvolumekernels_libtest.cpp
+ * @brief Microbenchmark of the batched LLVolumeFace and LLFace vertex kernels
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+#include "linden_common.h"
+#include "llpointer.h"
+#include "lltimer.h"
+
+#include "llvolumekernels_libtest.h"
+
+// Linden library includes
+#include "llalignedarray.h"
+#include "lldir.h"
+#include "lldiriterator.h"
+#include "llfile.h"
+#include "llmath.h"
+#include "llmatrix4a.h"
+#include "llsd.h"
+#include "llsdserialize.h"
+#include "llvolume.h"
+#include "llvolumekernels.h"
+#include "lluuid.h"
+#include "m4math.h"
+#include "v2math.h"
+
+// system libraries
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+// doc string provided when invoking the program with --help
+static const char USAGE[] = "\n"
+"usage:\tllvolumekernels_libtest [options]\n"
+"\n"
+"Runs the batched and scalar versions of the LLVolumeFace triangle normal,\n"
+"tangent and extents kernels, and of the position, normal and texture\n"
+"coordinate transforms of LLFace::getGeometryVolume() (into plain buffers,\n"
+"no GL needed), over the standard prim shapes at every level of detail,\n"
+"and optionally over a corpus of mesh assets. Checks that both versions\n"
+"agree and reports time per kernel and speedup.\n"
+"\n"
+" -h, --help\n"
+"        Print this help\n"
+" -m, --mesh <dir>\n"
+"        Directory of mesh asset files (as served by the mesh capability).\n"
+"        Every LOD found in each file is decoded and added to the corpus.\n"
+" -n, --iterations <n>\n"
+"        Passes over the corpus per kernel. Default is 50.\n"
+"\n";
+
+namespace
+{
+
+// LLVolumeLODGroup detail scales
+const F32 DETAIL_SCALES[] = { 1.f, 1.5f, 2.5f, 4.f };
+
+const char* MESH_LOD_NAMES[] = { "lowest_lod", "low_lod", "medium_lod", "high_lod" };
+
+// Tangents go through a reciprocal square root estimate, allow for
+// a different rounding of it
+constexpr F32 TANGENT_TOLERANCE = 1.e-3f;
+
+struct FaceSet
+{
+    std::string mName;
+    std::vector<LLPointer<LLVolume> > mVolumes;
+    U32 mFaces = 0;
+    U32 mTriangles = 0;
+    U32 mVertices = 0;
+
+    void add(LLVolume* volume)
+    {
+        mVolumes.push_back(volume);
+        for (S32 i = 0; i < volume->getNumVolumeFaces(); ++i)
+        {
+            const LLVolumeFace& face = volume->getVolumeFace(i);
+            if (face.mNumVertices > 0 && face.mNumIndices >= 3)
+            {
+                mFaces++;
+                mTriangles += face.mNumIndices / 3;
+                mVertices += face.mNumVertices;
+            }
+        }
+    }
+};
+
+enum EKernel
+{
+    KERNEL_NORMALS = 0,
+    KERNEL_TANGENTS,
+    KERNEL_EXTENTS,
+    KERNEL_POSITIONS,
+    KERNEL_ROTATE,
+    KERNEL_TEXCOORDS,
+    KERNEL_PLANAR,
+    KERNEL_COUNT
+};
+
+const char* KERNEL_NAMES[KERNEL_COUNT] = { "normals", "tangents", "extents", "positions", "rotate", "texcoords", "planar" };
+
+// Stand-ins for the render matrices and texture entry of a face
+struct FaceTransforms
+{
+    FaceTransforms()
+    {
+        LLMatrix4 mat(0.3f, 0.2f, 1.1f, LLVector4(12.f, 200.f, 30.f, 1.f));
+        mat.mMatrix[VX][VX] *= 2.f;
+        mat.mMatrix[VZ][VZ] *= 0.5f;
+        mVertex.loadu(mat);
+        // rotate() ignores the translation row
+        mNormal = mVertex;
+
+        S32 index = 3;
+        memcpy(&mTextureIndex, &index, sizeof(F32));
+
+        const F32 rotation = 0.7f;
+        mTexture.setRotateScaleOffset(cosf(rotation), sinf(rotation), 0.25f, -0.1f, 3.f, 2.f);
+        mScale.set(2.f, 3.f, 0.5f);
+    }
+
+    LLMatrix4a mVertex;
+    LLMatrix4a mNormal;
+    F32 mTextureIndex;
+    LLTexCoordTransform mTexture;
+    LLVector4a mScale;
+};
+
+// Scratch output large enough for any face
+struct Scratch
+{
+    LLAlignedArray<LLVector4a, 64> mOutput;
+    LLAlignedArray<LLVector4a, 64> mReference;
+};
+
+bool usable(const LLVolumeFace& face)
+{
+    return face.mNumVertices > 0 && face.mNumIndices >= 3 && face.mTexCoords;
+}
+
+void run_kernel(EKernel kernel, bool batched, const LLVolumeFace& face, LLVector4a* out)
+{
+    static const FaceTransforms xforms;
+
+    const U32 triangles = face.mNumIndices / 3;
+    const U32 vertices = face.mNumVertices;
+    LLVector2* tc_out = reinterpret_cast<LLVector2*>(out);
+    switch (kernel)
+    {
+    case KERNEL_NORMALS:
+        if (batched)
+        {
+            LLCalculateTriangleNormals(face.mPositions, face.mIndices, triangles, out);
+        }
+        else
+        {
+            LLCalculateTriangleNormalsScalar(face.mPositions, face.mIndices, triangles, out);
+        }
+        break;
+    case KERNEL_TANGENTS:
+        if (batched)
+        {
+            LLCalculateTangentArray(face.mNumVertices, face.mPositions, face.mNormals, face.mTexCoords,
+                                    triangles, face.mIndices, out);
+        }
+        else
+        {
+            LLCalculateTangentArrayScalar(face.mNumVertices, face.mPositions, face.mNormals, face.mTexCoords,
+                                          triangles, face.mIndices, out);
+        }
+        break;
+    case KERNEL_EXTENTS:
+        if (batched)
+        {
+            LLCalculateExtents(face.mPositions, face.mNumVertices, out[0], out[1]);
+        }
+        else
+        {
+            LLCalculateExtentsScalar(face.mPositions, face.mNumVertices, out[0], out[1]);
+        }
+        break;
+    case KERNEL_POSITIONS:
+        if (batched)
+        {
+            LLTransformPositions(xforms.mVertex, face.mPositions, vertices, xforms.mTextureIndex, out);
+        }
+        else
+        {
+            LLTransformPositionsScalar(xforms.mVertex, face.mPositions, vertices, xforms.mTextureIndex, out);
+        }
+        break;
+    case KERNEL_ROTATE:
+        if (batched)
+        {
+            LLRotateVectors(xforms.mNormal, face.mNormals, vertices, false, out);
+        }
+        else
+        {
+            LLRotateVectorsScalar(xforms.mNormal, face.mNormals, vertices, false, out);
+        }
+        break;
+    case KERNEL_TEXCOORDS:
+        if (batched)
+        {
+            LLTransformTexCoords(xforms.mTexture, face.mTexCoords, vertices, tc_out);
+        }
+        else
+        {
+            LLTransformTexCoordsScalar(xforms.mTexture, face.mTexCoords, vertices, tc_out);
+        }
+        break;
+    case KERNEL_PLANAR:
+        if (batched)
+        {
+            LLPlanarTexCoords(xforms.mTexture, face.mPositions, face.mNormals, xforms.mScale, vertices, tc_out);
+        }
+        else
+        {
+            LLPlanarTexCoordsScalar(xforms.mTexture, face.mPositions, face.mNormals, xforms.mScale, vertices, tc_out);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+S32 output_count(EKernel kernel, const LLVolumeFace& face)
+{
+    switch (kernel)
+    {
+    case KERNEL_NORMALS:    return face.mNumIndices / 3;
+    case KERNEL_TANGENTS:
+    case KERNEL_POSITIONS:
+    case KERNEL_ROTATE:     return face.mNumVertices;
+    case KERNEL_TEXCOORDS:
+    case KERNEL_PLANAR:     return (face.mNumVertices + 1) / 2; // two per vector
+    default:                return 2;
+    }
+}
+
+// Returns the number of mismatched outputs
+U32 verify(const FaceSet& set, EKernel kernel, Scratch& scratch)
+{
+    U32 mismatches = 0;
+    for (const LLPointer<LLVolume>& volume : set.mVolumes)
+    {
+        for (S32 i = 0; i < volume->getNumVolumeFaces(); ++i)
+        {
+            const LLVolumeFace& face = volume->getVolumeFace(i);
+            if (!usable(face))
+            {
+                continue;
+            }
+
+            const S32 count = output_count(kernel, face);
+            scratch.mOutput.resize(count);
+            scratch.mReference.resize(count);
+            // an odd texture coordinate count leaves the last half unwritten
+            memset((void*)scratch.mOutput.mArray, 0, count * sizeof(LLVector4a));
+            memset((void*)scratch.mReference.mArray, 0, count * sizeof(LLVector4a));
+            run_kernel(kernel, true, face, scratch.mOutput.mArray);
+            run_kernel(kernel, false, face, scratch.mReference.mArray);
+
+            const F32 tolerance = kernel == KERNEL_TANGENTS ? TANGENT_TOLERANCE : 0.f;
+            for (S32 j = 0; j < count; ++j)
+            {
+                const F32* a = scratch.mOutput[j].getF32ptr();
+                const F32* b = scratch.mReference[j].getF32ptr();
+                const S32 components = kernel == KERNEL_NORMALS || kernel == KERNEL_EXTENTS ? 3 : 4;
+                for (S32 c = 0; c < components; ++c)
+                {
+                    if (fabsf(a[c] - b[c]) > tolerance * llmax(1.f, fabsf(b[c])))
+                    {
+                        mismatches++;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+    return mismatches;
+}
+
+F64 time_kernel(const FaceSet& set, EKernel kernel, bool batched, S32 iterations, Scratch& scratch)
+{
+    F64 start = LLTimer::getTotalSeconds().value();
+    for (S32 iter = 0; iter < iterations; ++iter)
+    {
+        for (const LLPointer<LLVolume>& volume : set.mVolumes)
+        {
+            for (S32 i = 0; i < volume->getNumVolumeFaces(); ++i)
+            {
+                const LLVolumeFace& face = volume->getVolumeFace(i);
+                if (usable(face))
+                {
+                    scratch.mOutput.resize(output_count(kernel, face));
+                    run_kernel(kernel, batched, face, scratch.mOutput.mArray);
+                }
+            }
+        }
+    }
+    return LLTimer::getTotalSeconds().value() - start;
+}
+
+void add_prims(FaceSet& set)
+{
+    struct PrimShape
+    {
+        U8 mProfile;
+        U8 mPath;
+        F32 mHollow;
+        F32 mRatioY;
+    };
+
+    // The shapes of the build floater's create palette, plus a hollow
+    // box for the hollow cap and inner side paths
+    const PrimShape shapes[] = {
+        { LL_PCODE_PROFILE_SQUARE,      LL_PCODE_PATH_LINE,   0.f,  1.f  }, // box
+        { LL_PCODE_PROFILE_SQUARE,      LL_PCODE_PATH_LINE,   0.5f, 1.f  }, // hollow box
+        { LL_PCODE_PROFILE_CIRCLE,      LL_PCODE_PATH_LINE,   0.f,  1.f  }, // cylinder
+        { LL_PCODE_PROFILE_EQUALTRI,    LL_PCODE_PATH_LINE,   0.f,  1.f  }, // prism
+        { LL_PCODE_PROFILE_CIRCLE_HALF, LL_PCODE_PATH_CIRCLE, 0.f,  1.f  }, // sphere
+        { LL_PCODE_PROFILE_CIRCLE,      LL_PCODE_PATH_CIRCLE, 0.f,  0.25f }, // torus
+        { LL_PCODE_PROFILE_SQUARE,      LL_PCODE_PATH_CIRCLE, 0.f,  0.25f }, // tube
+        { LL_PCODE_PROFILE_EQUALTRI,    LL_PCODE_PATH_CIRCLE, 0.f,  0.25f }, // ring
+    };
+
+    for (const PrimShape& shape : shapes)
+    {
+        LLVolumeParams params;
+        params.setType(shape.mProfile, shape.mPath);
+        params.setBeginAndEndS(0.f, 1.f);
+        params.setBeginAndEndT(0.f, 1.f);
+        params.setRatio(1.f, shape.mRatioY);
+        params.setShear(0.f, 0.f);
+        params.setHollow(shape.mHollow);
+
+        for (F32 detail : DETAIL_SCALES)
+        {
+            set.add(new LLVolume(params, detail));
+        }
+    }
+}
+
+// The precomputed texture transforms against the per-vertex math they
+// replace in LLFace::getGeometryVolume(), returns the number of mismatches
+U32 verify_texture_transforms()
+{
+    // Rounding differs, by a few ulps of the largest term
+    constexpr F32 TOLERANCE = 1.e-5f;
+
+    U32 mismatches = 0;
+    for (S32 i = 0; i < 64; ++i)
+    {
+        const F32 rotation = i * 0.3f;
+        const F32 cos_ang = cosf(rotation);
+        const F32 sin_ang = sinf(rotation);
+        const F32 offset_s = (i % 7) * 0.15f - 0.5f;
+        const F32 offset_t = (i % 5) * 0.2f - 0.4f;
+        const F32 repeat_s = 0.25f + (i % 9);
+        const F32 repeat_t = -1.f + (i % 4);
+
+        LLTexCoordTransform xform;
+        xform.setRotateScaleOffset(cos_ang, sin_ang, offset_s, offset_t, repeat_s, repeat_t);
+
+        LLMatrix4 mat(rotation, 0.5f * rotation, 0.f, LLVector4(offset_s, offset_t, 0.f, 1.f));
+        LLTexCoordTransform xform_mat;
+        xform_mat.setMatrix(mat);
+
+        for (S32 j = 0; j < 16; ++j)
+        {
+            const LLVector2 tc((j % 4) * 0.5f - 0.25f, (j / 4) * 0.4f);
+
+            // xform() in llface.cpp
+            F32 s = tc.mV[0] - 0.5f;
+            F32 t = tc.mV[1] - 0.5f;
+            LLVector2 expected((s * cos_ang + t * sin_ang) * repeat_s + (offset_s + 0.5f),
+                               (-s * sin_ang + t * cos_ang) * repeat_t + (offset_t + 0.5f));
+            LLVector2 result(tc);
+            xform.transform(result);
+            const F32 scale = llmax(1.f, fabsf(repeat_s), fabsf(repeat_t));
+            if (fabsf(result.mV[0] - expected.mV[0]) > TOLERANCE * scale ||
+                fabsf(result.mV[1] - expected.mV[1]) > TOLERANCE * scale)
+            {
+                mismatches++;
+            }
+
+            // texture animation matrix
+            LLVector3 tmp(tc.mV[0], tc.mV[1], 0.f);
+            tmp = tmp * mat;
+            result = tc;
+            xform_mat.transform(result);
+            if (result.mV[0] != tmp.mV[0] || result.mV[1] != tmp.mV[1])
+            {
+                mismatches++;
+            }
+        }
+    }
+    return mismatches;
+}
+
+// Decode every LOD of one mesh asset file, returns the number of LODs added
+S32 add_mesh(FaceSet& set, const std::string& filename)
+{
+    llifstream file(filename.c_str(), std::ios::in | std::ios::binary);
+    if (!file.is_open())
+    {
+        return 0;
+    }
+    std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (data.empty())
+    {
+        return 0;
+    }
+
+    llssize data_size = data.size();
+    llssize deprecated_size = 0;
+    char* result_ptr = strip_deprecated_header(data.data(), data_size, &deprecated_size);
+
+    std::istringstream stream(std::string(result_ptr, data_size));
+    LLSD header;
+    if (!LLSDSerialize::fromBinary(header, stream, data_size) || !header.isMap())
+    {
+        std::cout << "Not a mesh asset: " << filename << std::endl;
+        return 0;
+    }
+    const llssize header_size = deprecated_size + (llssize)stream.tellg();
+
+    LLVolumeParams params;
+    params.setType(LL_PCODE_PROFILE_SQUARE, LL_PCODE_PATH_LINE);
+    params.setSculptID(LLUUID::generateNewID(), LL_SCULPT_TYPE_MESH);
+
+    S32 added = 0;
+    for (S32 lod = 0; lod < LL_ARRAY_SIZE(MESH_LOD_NAMES); ++lod)
+    {
+        const char* lod_name = MESH_LOD_NAMES[lod];
+        if (!header.has(lod_name))
+        {
+            continue;
+        }
+        const llssize offset = header_size + header[lod_name]["offset"].asInteger();
+        const S32 size = header[lod_name]["size"].asInteger();
+        if (offset < 0 || size <= 0 || offset + size > (llssize)data.size())
+        {
+            continue;
+        }
+
+        LLPointer<LLVolume> volume = new LLVolume(params, DETAIL_SCALES[lod]);
+        if (volume->unpackVolumeFaces((U8*)data.data() + offset, size))
+        {
+            set.add(volume);
+            added++;
+        }
+    }
+    return added;
+}
+
+void add_meshes(FaceSet& set, const std::string& dirname)
+{
+    LLDirIterator iter(dirname, "*");
+    std::string name;
+    S32 files = 0;
+    S32 lods = 0;
+    while (iter.next(name))
+    {
+        S32 added = add_mesh(set, dirname + gDirUtilp->getDirDelimiter() + name);
+        files += added > 0 ? 1 : 0;
+        lods += added;
+    }
+    std::cout << "Decoded " << lods << " LODs from " << files << " mesh assets in " << dirname << std::endl;
+}
+
+bool report(const FaceSet& set, S32 iterations)
+{
+    std::cout << std::endl;
+    std::cout << set.mName << ": " << set.mVolumes.size() << " volumes, " << set.mFaces << " faces, "
+              << set.mTriangles << " triangles, " << set.mVertices << " vertices" << std::endl;
+    if (!set.mFaces)
+    {
+        return true;
+    }
+
+    std::cout << "Kernel      scalar ms   batched ms   speedup   Mtri/s   mismatches" << std::endl;
+
+    bool ok = true;
+    Scratch scratch;
+    for (S32 k = 0; k < KERNEL_COUNT; ++k)
+    {
+        EKernel kernel = (EKernel)k;
+        U32 mismatches = verify(set, kernel, scratch);
+        ok = ok && mismatches == 0;
+
+        // warm up, then time
+        time_kernel(set, kernel, false, 1, scratch);
+        F64 scalar = time_kernel(set, kernel, false, iterations, scratch);
+        time_kernel(set, kernel, true, 1, scratch);
+        F64 batched = time_kernel(set, kernel, true, iterations, scratch);
+
+        std::cout << llformat("%-9s %11.2f %12.2f %9.2f %8.1f %12u",
+                              KERNEL_NAMES[k],
+                              scalar * 1000.0 / iterations,
+                              batched * 1000.0 / iterations,
+                              batched > 0.0 ? scalar / batched : 0.0,
+                              batched > 0.0 ? set.mTriangles * (F64)iterations / batched / 1000000.0 : 0.0,
+                              mismatches)
+                  << std::endl;
+    }
+    return ok;
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv)
+{
+    std::string mesh_dir;
+    S32 iterations = 50;
+
+    // Analyze command line arguments
+    for (int arg = 1; arg < argc; ++arg)
+    {
+        bool has_value = (arg + 1) < argc && argv[arg + 1][0] != '-';
+        if (!strcmp(argv[arg], "--help") || !strcmp(argv[arg], "-h"))
+        {
+            // Send the usage to standard out
+            std::cout << USAGE << std::endl;
+            return 0;
+        }
+        else if (!strcmp(argv[arg], "--mesh") || !strcmp(argv[arg], "-m"))
+        {
+            if (has_value)
+            {
+                mesh_dir = argv[++arg];
+            }
+        }
+        else if (!strcmp(argv[arg], "--iterations") || !strcmp(argv[arg], "-n"))
+        {
+            if (has_value)
+            {
+                iterations = llclamp(atoi(argv[++arg]), 1, 100000);
+            }
+            else
+            {
+                std::cout << "No valid --iterations argument given, default (50) will be used" << std::endl;
+            }
+        }
+    }
+
+    U32 mismatches = verify_texture_transforms();
+    std::cout << "Texture transforms: " << mismatches << " mismatches" << std::endl;
+    bool ok = mismatches == 0;
+
+    FaceSet prims;
+    prims.mName = "Prims";
+    add_prims(prims);
+    ok = report(prims, iterations) && ok;
+
+    if (!mesh_dir.empty())
+    {
+        FaceSet meshes;
+        meshes.mName = "Meshes";
+        add_meshes(meshes, mesh_dir);
+        ok = report(meshes, iterations) && ok;
+    }
+
+    if (!ok)
+    {
+        std::cout << std::endl << "Batched and scalar kernels disagree" << std::endl;
+        return 1;
+    }
+    return 0;
+}
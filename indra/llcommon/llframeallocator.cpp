@@ -0,0 +1,121 @@
+/**
+ * @file llframeallocator.cpp
+ * @brief Linear allocator for memory that only lives for a frame or two
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llframeallocator.h"
+#include "lltrace.h"
+
+static LLTrace::SampleStatHandle<F64Kilobytes> sFrameArenaUsed("frame_arena_used", "frame allocator bytes used by the last frame");
+
+LLFrameAllocator::LLFrameAllocator(size_t block_size)
+:   mCurrent(0),
+    mBlockSize(block_size),
+    mHighWater(0)
+{
+    addBlock(mArenas[0], mBlockSize);
+    addBlock(mArenas[1], mBlockSize);
+}
+
+LLFrameAllocator::~LLFrameAllocator()
+{
+    for (Arena& arena : mArenas)
+    {
+        for (Block& block : arena.mBlocks)
+        {
+            ll_aligned_free<64>(block.mData);
+        }
+    }
+}
+
+void* LLFrameAllocator::allocate(size_t size, size_t alignment)
+{
+    llassert(alignment && alignment <= 64 && (alignment & (alignment - 1)) == 0);
+
+    Arena& arena = mArenas[mCurrent];
+    size_t offset = (arena.mOffset + alignment - 1) & ~(alignment - 1);
+    if (offset + size > arena.mBlocks.back().mSize)
+    {
+        // blocks start 64 byte aligned, so a fresh one needs no padding
+        addBlock(arena, llmax(mBlockSize, size));
+        offset = 0;
+    }
+
+    arena.mUsed += offset - arena.mOffset + size;
+    arena.mOffset = offset + size;
+    return arena.mBlocks.back().mData + offset;
+}
+
+void LLFrameAllocator::nextFrame()
+{
+    const size_t used = mArenas[mCurrent].mUsed;
+    mHighWater = llmax(mHighWater, used);
+    LLTrace::sample(sFrameArenaUsed, F64Kilobytes((F64)used / 1024.0));
+
+    mCurrent = 1 - mCurrent;
+    recycle(mArenas[mCurrent]);
+}
+
+size_t LLFrameAllocator::getReservedBytes() const
+{
+    size_t bytes = 0;
+    for (const Arena& arena : mArenas)
+    {
+        for (const Block& block : arena.mBlocks)
+        {
+            bytes += block.mSize;
+        }
+    }
+    return bytes;
+}
+
+void LLFrameAllocator::addBlock(Arena& arena, size_t size)
+{
+    Block block;
+    block.mData = (U8*)ll_aligned_malloc<64>(size);
+    block.mSize = size;
+    arena.mBlocks.push_back(block);
+    arena.mOffset = 0;
+}
+
+void LLFrameAllocator::recycle(Arena& arena)
+{
+    if (arena.mBlocks.size() > 1)
+    {
+        // one block as big as the whole chain covers the same frame next time
+        size_t size = 0;
+        for (Block& block : arena.mBlocks)
+        {
+            size += block.mSize;
+            ll_aligned_free<64>(block.mData);
+        }
+        arena.mBlocks.clear();
+        addBlock(arena, size);
+    }
+
+    arena.mOffset = 0;
+    arena.mUsed = 0;
+}
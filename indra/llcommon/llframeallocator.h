@@ -0,0 +1,140 @@
+/**
+ * @file llframeallocator.h
+ * @brief Linear allocator for memory that only lives for a frame or two
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+#ifndef LL_LLFRAMEALLOCATOR_H
+#define LL_LLFRAMEALLOCATOR_H
+
+#include "llsingleton.h"
+#include "llmemory.h"
+
+#include <list>
+#include <vector>
+
+//
+// Bump allocator for the temporaries of culling and render list
+// construction.  Nothing is freed on its own: nextFrame() recycles the
+// arena of the frame before last, so memory handed out during frame N is
+// good until frame N+2 begins.  Main thread only.
+//
+// Blocks an arena had to chain on during a busy frame are merged into one
+// when the arena is recycled, so steady state costs no heap calls at all.
+//
+class LL_COMMON_API LLFrameAllocator : public LLSimpleton<LLFrameAllocator>
+{
+public:
+    static const size_t DEFAULT_BLOCK_SIZE = 256 * 1024;
+
+    LLFrameAllocator(size_t block_size = DEFAULT_BLOCK_SIZE);
+    ~LLFrameAllocator();
+
+    // alignment must be a power of two no larger than 64
+    void* allocate(size_t size, size_t alignment = 16);
+
+    // Start a new frame, recycling the arena of the frame before last
+    void nextFrame();
+
+    // Bytes handed out so far this frame, padding included
+    size_t getFrameBytes() const { return mArenas[mCurrent].mUsed; }
+
+    // Most bytes any frame has used
+    size_t getHighWater() const { return mHighWater; }
+
+    // Bytes reserved by both arenas
+    size_t getReservedBytes() const;
+
+private:
+    struct Block
+    {
+        U8* mData;
+        size_t mSize;
+    };
+
+    struct Arena
+    {
+        std::vector<Block> mBlocks;
+        size_t mOffset = 0; // into mBlocks.back()
+        size_t mUsed = 0;
+    };
+
+    void addBlock(Arena& arena, size_t size);
+    void recycle(Arena& arena);
+
+    Arena mArenas[2];
+    U32 mCurrent;
+    size_t mBlockSize;
+    size_t mHighWater;
+};
+
+// STL allocator over the frame arena.  deallocate() does nothing, so only
+// use it for containers that die before the frame after next.  Without a
+// LLFrameAllocator instance (tools, tests) it falls back to the heap.
+template <class T>
+class LLFrameSTLAllocator
+{
+public:
+    typedef T value_type;
+
+    LLFrameSTLAllocator() : mArena(LLFrameAllocator::getInstance()) { }
+    LLFrameSTLAllocator(LLFrameAllocator* arena) : mArena(arena) { }
+
+    template <class U>
+    LLFrameSTLAllocator(const LLFrameSTLAllocator<U>& other) : mArena(other.getArena()) { }
+
+    T* allocate(size_t count)
+    {
+        if (mArena)
+        {
+            return (T*)mArena->allocate(count * sizeof(T), alignof(T) > 16 ? alignof(T) : 16);
+        }
+        return (T*)ll_aligned_malloc<64>(count * sizeof(T));
+    }
+
+    void deallocate(T* ptr, size_t count)
+    {
+        if (!mArena)
+        {
+            ll_aligned_free<64>(ptr);
+        }
+    }
+
+    LLFrameAllocator* getArena() const { return mArena; }
+
+    template <class U>
+    bool operator==(const LLFrameSTLAllocator<U>& other) const { return mArena == other.getArena(); }
+
+    template <class U>
+    bool operator!=(const LLFrameSTLAllocator<U>& other) const { return mArena != other.getArena(); }
+
+private:
+    LLFrameAllocator* mArena;
+};
+
+template <class T>
+using ll_frame_vector_t = std::vector<T, LLFrameSTLAllocator<T> >;
+
+template <class T>
+using ll_frame_list_t = std::list<T, LLFrameSTLAllocator<T> >;
+
+#endif // LL_LLFRAMEALLOCATOR_H
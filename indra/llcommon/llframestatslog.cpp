@@ -0,0 +1,282 @@
+/**
+ * @file llframestatslog.cpp
+ * @brief Compact binary log of per-frame counters
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llframestatslog.h"
+#include "llformat.h"
+
+#include <algorithm>
+
+namespace
+{
+    const U8 MAGIC[4] = { 'L', 'L', 'F', 'S' };
+
+    // Buffered frames are written out past this
+    const size_t FLUSH_SIZE = 64 * 1024;
+
+    void put_u32(std::vector<U8>& out, U32 value)
+    {
+        for (U32 i = 0; i < 4; ++i)
+        {
+            out.push_back((U8)(value >> (i * 8)));
+        }
+    }
+
+    void put_varint(std::vector<U8>& out, U32 value)
+    {
+        while (value >= 0x80)
+        {
+            out.push_back((U8)(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back((U8)value);
+    }
+
+    bool get_u32(const U8*& in, const U8* end, U32& value)
+    {
+        if (end - in < 4)
+        {
+            return false;
+        }
+        value = in[0] | (in[1] << 8) | (in[2] << 16) | ((U32)in[3] << 24);
+        in += 4;
+        return true;
+    }
+
+    bool get_varint(const U8*& in, const U8* end, U32& value)
+    {
+        value = 0;
+        for (U32 shift = 0; shift < 35 && in < end; shift += 7)
+        {
+            const U8 byte = *in++;
+            value |= (U32)(byte & 0x7F) << shift;
+            if (!(byte & 0x80))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+}
+
+//============================================================================
+// LLFrameStatsWriter
+
+LLFrameStatsWriter::LLFrameStatsWriter()
+:   mFile(NULL),
+    mFieldCount(0),
+    mFrameCount(0)
+{
+}
+
+LLFrameStatsWriter::~LLFrameStatsWriter()
+{
+    close();
+}
+
+bool LLFrameStatsWriter::open(const std::string& filename, const std::vector<std::string>& fields)
+{
+    close();
+
+    mFile = LLFile::fopen(filename, "wb");
+    if (!mFile)
+    {
+        return false;
+    }
+
+    mFieldCount = fields.size();
+    mFrameCount = 0;
+    mBuffer.assign(MAGIC, MAGIC + 4);
+    put_u32(mBuffer, LLFrameStatsLog::VERSION);
+    put_u32(mBuffer, (U32)mFieldCount);
+    for (const std::string& field : fields)
+    {
+        const U8 length = (U8)llmin(field.size(), (size_t)255);
+        mBuffer.push_back(length);
+        mBuffer.insert(mBuffer.end(), field.begin(), field.begin() + length);
+    }
+    flush();
+    return mFile != NULL;
+}
+
+void LLFrameStatsWriter::close()
+{
+    if (mFile)
+    {
+        flush();
+        LLFile::close(mFile);
+        mFile = NULL;
+    }
+}
+
+void LLFrameStatsWriter::writeFrame(const U32* values)
+{
+    if (!mFile)
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < mFieldCount; ++i)
+    {
+        put_varint(mBuffer, values[i]);
+    }
+    mFrameCount++;
+
+    if (mBuffer.size() >= FLUSH_SIZE)
+    {
+        flush();
+    }
+}
+
+void LLFrameStatsWriter::flush()
+{
+    if (!mBuffer.empty() && fwrite(mBuffer.data(), 1, mBuffer.size(), mFile) != mBuffer.size())
+    {
+        LL_WARNS() << "Failed to write frame stats, closing the log" << LL_ENDL;
+        LLFile::close(mFile);
+        mFile = NULL;
+    }
+    mBuffer.clear();
+}
+
+//============================================================================
+// LLFrameStatsLog
+
+bool LLFrameStatsLog::load(const std::string& filename, std::string& error)
+{
+    const std::string data = LLFile::getContents(filename);
+    if (data.empty())
+    {
+        error = "could not read " + filename;
+        return false;
+    }
+    return parse((const U8*)data.data(), data.size(), error);
+}
+
+bool LLFrameStatsLog::parse(const U8* data, size_t size, std::string& error)
+{
+    mFields.clear();
+    mValues.clear();
+
+    const U8* in = data;
+    const U8* end = data + size;
+    U32 version = 0;
+    U32 field_count = 0;
+    if (size < 4 || memcmp(in, MAGIC, 4) != 0)
+    {
+        error = "not a frame stats log";
+        return false;
+    }
+    in += 4;
+    if (!get_u32(in, end, version) || !get_u32(in, end, field_count))
+    {
+        error = "truncated header";
+        return false;
+    }
+    if (version != VERSION)
+    {
+        error = llformat("unsupported version %u", version);
+        return false;
+    }
+
+    for (U32 i = 0; i < field_count; ++i)
+    {
+        if (in >= end || end - in < 1 + *in)
+        {
+            error = "truncated field names";
+            mFields.clear();
+            return false;
+        }
+        const U8 length = *in++;
+        mFields.emplace_back((const char*)in, length);
+        in += length;
+    }
+
+    std::vector<U32> frame(field_count);
+    while (in < end && field_count)
+    {
+        for (U32 i = 0; i < field_count; ++i)
+        {
+            if (!get_varint(in, end, frame[i]))
+            {
+                return true;
+            }
+        }
+        mValues.insert(mValues.end(), frame.begin(), frame.end());
+    }
+    return true;
+}
+
+S32 LLFrameStatsLog::findField(const std::string& name) const
+{
+    for (size_t i = 0; i < mFields.size(); ++i)
+    {
+        if (mFields[i] == name)
+        {
+            return (S32)i;
+        }
+    }
+    return -1;
+}
+
+size_t LLFrameStatsLog::getFrameCount() const
+{
+    return mFields.empty() ? 0 : mValues.size() / mFields.size();
+}
+
+LLFrameStatsLog::Summary LLFrameStatsLog::summarize(size_t field) const
+{
+    Summary summary;
+    const size_t count = getFrameCount();
+    if (!count)
+    {
+        return summary;
+    }
+
+    std::vector<U32> sorted(count);
+    F64 total = 0.0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        sorted[i] = getValue(i, field);
+        total += sorted[i];
+    }
+    std::sort(sorted.begin(), sorted.end());
+
+    auto percentile = [&](U32 p)
+    {
+        const size_t rank = (count * p + 99) / 100;
+        return sorted[llmax(rank, (size_t)1) - 1];
+    };
+
+    summary.mMin = sorted.front();
+    summary.mMax = sorted.back();
+    summary.mMean = total / count;
+    summary.mP50 = percentile(50);
+    summary.mP90 = percentile(90);
+    summary.mP99 = percentile(99);
+    return summary;
+}
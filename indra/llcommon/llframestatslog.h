@@ -0,0 +1,104 @@
+/**
+ * @file llframestatslog.h
+ * @brief Compact binary log of per-frame counters
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+#ifndef LL_LLFRAMESTATSLOG_H
+#define LL_LLFRAMESTATSLOG_H
+
+#include "llfile.h"
+
+#include <string>
+#include <vector>
+
+//
+// A frame stats log holds one row of U32 counters per frame under named
+// columns, so logs from different builds can be compared field by field
+// even when fields were added or dropped in between.
+//
+// Layout: the 4 byte magic "LLFS", a U32 version and a U32 field count,
+// then each field name as a U8 length and its characters.  Frames follow
+// back to back, each value as a LEB128 varint since most counts are small.
+// Integers are little endian.
+//
+
+class LL_COMMON_API LLFrameStatsWriter
+{
+public:
+    LLFrameStatsWriter();
+    ~LLFrameStatsWriter();
+
+    // Starts a new log, false if the file could not be created
+    bool open(const std::string& filename, const std::vector<std::string>& fields);
+    void close();
+    bool isOpen() const { return mFile != NULL; }
+
+    // values holds one counter per field
+    void writeFrame(const U32* values);
+
+    U32 getFrameCount() const { return mFrameCount; }
+
+private:
+    void flush();
+
+    LLFILE* mFile;
+    std::vector<U8> mBuffer;
+    size_t mFieldCount;
+    U32 mFrameCount;
+};
+
+class LL_COMMON_API LLFrameStatsLog
+{
+public:
+    static const U32 VERSION = 1;
+
+    struct Summary
+    {
+        U32 mMin = 0;
+        U32 mMax = 0;
+        F64 mMean = 0.0;
+        U32 mP50 = 0;
+        U32 mP90 = 0;
+        U32 mP99 = 0;
+    };
+
+    // false with a reason in error if filename is not a frame stats log.
+    // A frame cut short at the end, as left by a crash, is dropped.
+    bool load(const std::string& filename, std::string& error);
+    bool parse(const U8* data, size_t size, std::string& error);
+
+    const std::vector<std::string>& getFields() const { return mFields; }
+    S32 findField(const std::string& name) const;
+
+    size_t getFrameCount() const;
+    U32 getValue(size_t frame, size_t field) const { return mValues[frame * mFields.size() + field]; }
+
+    // Nearest rank percentiles of one field over all frames
+    Summary summarize(size_t field) const;
+
+private:
+    std::vector<std::string> mFields;
+    std::vector<U32> mValues; // frame major
+};
+
+#endif // LL_LLFRAMESTATSLOG_H
@@ -0,0 +1,129 @@
+/**
+ * @file llparallelfor.cpp
+ * @brief Split a loop over a thread pool and wait for it
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llparallelfor.h"
+#include "threadpool.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+
+namespace
+{
+    std::unique_ptr<LL::ThreadPool> sParallelPool;
+
+    struct ParallelBatch
+    {
+        const std::function<void(size_t)>* mFunc = nullptr;
+        size_t mCount = 0;
+        std::atomic<size_t> mNext { 0 };
+        std::atomic<size_t> mDone { 0 };
+
+        std::mutex mMutex;
+        std::condition_variable mDoneCondition;
+
+        // Take jobs until none are left
+        void run()
+        {
+            for (size_t i = mNext++; i < mCount; i = mNext++)
+            {
+                (*mFunc)(i);
+                if (++mDone == mCount)
+                {
+                    std::lock_guard<std::mutex> lock(mMutex);
+                    mDoneCondition.notify_all();
+                }
+            }
+        }
+    };
+}
+
+void ll_parallel_for(LL::ThreadPool* pool, size_t count, const std::function<void(size_t)>& func)
+{
+    LL_PROFILE_ZONE_SCOPED;
+
+    if (count < 2 || !pool)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            func(i);
+        }
+        return;
+    }
+
+    // The batch outlives this call if a helper starts after the calling
+    // thread already took the last job, it then only reads mNext and mCount
+    auto batch = std::make_shared<ParallelBatch>();
+    batch->mFunc = &func;
+    batch->mCount = count;
+
+    const size_t helpers = llmin(pool->getWidth(), count - 1);
+    for (size_t i = 0; i < helpers; ++i)
+    {
+        if (!pool->getQueue().post([batch]() { batch->run(); }))
+        {
+            // pool is shutting down, do the rest here
+            break;
+        }
+    }
+
+    batch->run();
+
+    // at most one job per helper is still in flight
+    std::unique_lock<std::mutex> lock(batch->mMutex);
+    batch->mDoneCondition.wait(lock, [&]() { return batch->mDone == count; });
+}
+
+void ll_init_parallel_pool(S32 threads)
+{
+    if (!sParallelPool)
+    {
+        // "ThreadPoolSizes" overrides threads
+        sParallelPool = std::make_unique<LL::ThreadPool>("ParallelFor", llmax(threads, 1));
+        sParallelPool->start();
+    }
+}
+
+void ll_close_parallel_pool()
+{
+    if (sParallelPool)
+    {
+        sParallelPool->close();
+    }
+}
+
+void ll_cleanup_parallel_pool()
+{
+    sParallelPool.reset();
+}
+
+LL::ThreadPool* ll_parallel_pool()
+{
+    return sParallelPool.get();
+}
@@ -0,0 +1,48 @@
+/**
+ * @file llparallelfor.h
+ * @brief Split a loop over a thread pool and wait for it
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+#ifndef LL_LLPARALLELFOR_H
+#define LL_LLPARALLELFOR_H
+
+#include "threadpool_fwd.h"
+
+#include <functional>
+
+// Run func(0) to func(count - 1) on pool, the calling thread takes jobs
+// too.  Jobs are taken in index order, so put the long ones first.
+// Returns once all of them are done; func is never called after that, so
+// it may refer to the caller's locals.  No pool runs them all here.
+LL_COMMON_API void ll_parallel_for(LL::ThreadPool* pool, size_t count, const std::function<void(size_t)>& func);
+
+// The pool the main thread splits its own per-frame work over (rigged
+// skinning, cull frustum checks, geometry fills, render map sorts) and
+// waits on right away.  Long or background work belongs elsewhere, it
+// would stall the frame of whoever comes next.  Null until started.
+LL_COMMON_API void ll_init_parallel_pool(S32 threads);
+LL_COMMON_API void ll_close_parallel_pool();
+LL_COMMON_API void ll_cleanup_parallel_pool();
+LL_COMMON_API LL::ThreadPool* ll_parallel_pool();
+
+#endif // LL_LLPARALLELFOR_H
@@ -0,0 +1,124 @@
+/**
+ * @file llradixsort.h
+ * @brief Radix sort of values on packed 64 bit keys
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+#ifndef LL_LLRADIXSORT_H
+#define LL_LLRADIXSORT_H
+
+#include <cstring>
+
+//
+// Sorting on a key computed ahead of time, instead of with a comparator
+// that chases pointers on every comparison.  Keys are usually several
+// fields packed high to low, see ll_sort_key_bits().
+//
+
+template <class VALUE>
+struct LLRadixSortItem
+{
+    U64 mKey;
+    VALUE mValue;
+};
+
+// Spread a pointer or id over bits bits, for packing into a sort key.
+// Equal inputs give equal bits, which is all a key needs to group them;
+// zero (a null pointer) stays zero and sorts first.
+inline U64 ll_sort_key_bits(U64 value, U32 bits)
+{
+    return bits ? (value * 0x9E3779B97F4A7C15ULL) >> (64 - bits) : 0;
+}
+
+// Stable sort of count items on mKey, least significant byte first.
+// scratch must hold count items.  Bytes where every key agrees are
+// skipped, so keys that leave their high fields empty cost fewer passes.
+template <class VALUE>
+void ll_radix_sort(LLRadixSortItem<VALUE>* items, LLRadixSortItem<VALUE>* scratch, size_t count)
+{
+    typedef LLRadixSortItem<VALUE> item_t;
+
+    // Below this an insertion sort is cheaper than clearing the histograms
+    const size_t SMALL_COUNT = 64;
+    if (count < SMALL_COUNT)
+    {
+        for (size_t i = 1; i < count; ++i)
+        {
+            item_t item = items[i];
+            size_t j = i;
+            for (; j > 0 && items[j - 1].mKey > item.mKey; --j)
+            {
+                items[j] = items[j - 1];
+            }
+            items[j] = item;
+        }
+        return;
+    }
+
+    // One read of the keys fills the histograms of all eight bytes
+    U32 histograms[8][256];
+    memset(histograms, 0, sizeof(histograms));
+    for (size_t i = 0; i < count; ++i)
+    {
+        const U64 key = items[i].mKey;
+        for (U32 b = 0; b < 8; ++b)
+        {
+            histograms[b][(key >> (b * 8)) & 0xFF]++;
+        }
+    }
+
+    item_t* src = items;
+    item_t* dst = scratch;
+    for (U32 b = 0; b < 8; ++b)
+    {
+        U32* histogram = histograms[b];
+        if (histogram[(src[0].mKey >> (b * 8)) & 0xFF] == count)
+        {
+            continue;
+        }
+
+        // counts to starting offsets
+        U32 offset = 0;
+        for (U32 d = 0; d < 256; ++d)
+        {
+            const U32 n = histogram[d];
+            histogram[d] = offset;
+            offset += n;
+        }
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            dst[histogram[(src[i].mKey >> (b * 8)) & 0xFF]++] = src[i];
+        }
+
+        item_t* tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+
+    if (src != items)
+    {
+        memcpy((void*)items, (const void*)src, count * sizeof(item_t));
+    }
+}
+
+#endif // LL_LLRADIXSORT_H
@@ -55,7 +55,6 @@
 
 // File constants
 static const size_t MAX_HDR_LEN = 20;
-static const S32 UNZIP_LLSD_MAX_DEPTH = 96;
 static const char LEGACY_NON_HEADER[] = "<llsd>";
 const std::string LLSD_BINARY_HEADER("LLSD/Binary");
 const std::string LLSD_XML_HEADER("LLSD/XML");
@@ -1296,6 +1295,202 @@ bool LLSDBinaryParser::parseString(
     return true;
 }
 
+/**
+ * LLSDBinaryReader
+ */
+LLSDBinaryReader::LLSDBinaryReader(const U8* data, llssize size)
+    : mCur(data),
+      mEnd(data + size),
+      mFailed(false)
+{
+}
+
+char LLSDBinaryReader::peek() const
+{
+    return (!mFailed && mCur < mEnd) ? (char)*mCur : 0;
+}
+
+bool LLSDBinaryReader::beginMap(U32& count)
+{
+    return expect('{') && readU32(count);
+}
+
+bool LLSDBinaryReader::endMap()
+{
+    return expect('}');
+}
+
+bool LLSDBinaryReader::beginArray(U32& count)
+{
+    return expect('[') && readU32(count);
+}
+
+bool LLSDBinaryReader::endArray()
+{
+    return expect(']');
+}
+
+bool LLSDBinaryReader::readKey(std::string_view& key)
+{
+    U32 size = 0;
+    if (!expect('k') || !readU32(size))
+    {
+        return false;
+    }
+    const U8* start = mCur;
+    if (!skipBytes(size))
+    {
+        return false;
+    }
+    key = std::string_view((const char*)start, size);
+    return true;
+}
+
+bool LLSDBinaryReader::readBinary(const U8*& data, U32& size)
+{
+    if (!expect('b') || !readU32(size))
+    {
+        return false;
+    }
+    data = mCur;
+    return skipBytes(size);
+}
+
+bool LLSDBinaryReader::readReal(F64& value)
+{
+    switch (peek())
+    {
+    case 'r':
+    {
+        ++mCur;
+        if (mEnd - mCur < (llssize)sizeof(F64))
+        {
+            return fail();
+        }
+        F64 real_nbo = 0.0;
+        memcpy(&real_nbo, mCur, sizeof(F64));
+        mCur += sizeof(F64);
+        value = ll_ntohd(real_nbo);
+        return true;
+    }
+    case 'i':
+    {
+        ++mCur;
+        U32 value_nbo = 0;
+        if (!readU32(value_nbo))
+        {
+            return false;
+        }
+        value = (F64)(S32)value_nbo;
+        return true;
+    }
+    default:
+        return fail();
+    }
+}
+
+bool LLSDBinaryReader::skip()
+{
+    return skipValue(UNZIP_LLSD_MAX_DEPTH);
+}
+
+bool LLSDBinaryReader::skipValue(S32 max_depth)
+{
+    char c = peek();
+    if (!c || max_depth == 0)
+    {
+        return fail();
+    }
+    ++mCur;
+
+    U32 count = 0;
+    switch (c)
+    {
+    case '!':
+    case '0':
+    case '1':
+        return true;
+    case 'i':
+        return skipBytes(sizeof(U32));
+    case 'r':
+    case 'd':
+        return skipBytes(sizeof(F64));
+    case 'u':
+        return skipBytes(UUID_BYTES);
+    case 's':
+    case 'l':
+    case 'b':
+        return readU32(count) && skipBytes(count);
+    case '{':
+    {
+        if (!readU32(count))
+        {
+            return false;
+        }
+        for (U32 i = 0; i < count; ++i)
+        {
+            std::string_view key;
+            if (!readKey(key) || !skipValue(max_depth - 1))
+            {
+                return false;
+            }
+        }
+        return expect('}');
+    }
+    case '[':
+    {
+        if (!readU32(count))
+        {
+            return false;
+        }
+        for (U32 i = 0; i < count; ++i)
+        {
+            if (!skipValue(max_depth - 1))
+            {
+                return false;
+            }
+        }
+        return expect(']');
+    }
+    default:
+        // includes notation style strings, see class description
+        return fail();
+    }
+}
+
+bool LLSDBinaryReader::skipBytes(U32 count)
+{
+    if (mFailed || mEnd - mCur < (llssize)count)
+    {
+        return fail();
+    }
+    mCur += count;
+    return true;
+}
+
+bool LLSDBinaryReader::readU32(U32& value)
+{
+    U32 value_nbo = 0;
+    const U8* start = mCur;
+    if (!skipBytes(sizeof(U32)))
+    {
+        return false;
+    }
+    memcpy(&value_nbo, start, sizeof(U32));
+    value = ntohl(value_nbo);
+    return true;
+}
+
+bool LLSDBinaryReader::expect(char c)
+{
+    if (peek() != c)
+    {
+        return fail();
+    }
+    ++mCur;
+    return true;
+}
+
 
 /**
  * LLSDFormatter
@@ -2252,20 +2447,86 @@ LLUZipHelper::EZipRresult LLUZipHelper::unzip_llsd(LLSD& data, std::istream& is,
     return unzip_llsd(data, in.get(), size);
 }
 
+namespace
+{
+    // Inflate target of LLUZipHelper::unzip_to_buffer(), one per thread
+    class LLUnzipBuffer
+    {
+    public:
+        ~LLUnzipBuffer() { free(mData); }
+
+        U8* data() const { return mData; }
+        size_t capacity() const { return mCapacity; }
+
+        bool reserve(size_t size)
+        {
+            if (size <= mCapacity)
+            {
+                return true;
+            }
+            U8* data = (U8*)realloc(mData, size);
+            if (!data)
+            {
+                return false;
+            }
+            mData = data;
+            mCapacity = size;
+            return true;
+        }
+
+        void release()
+        {
+            free(mData);
+            mData = nullptr;
+            mCapacity = 0;
+        }
+
+    private:
+        U8* mData = nullptr;
+        size_t mCapacity = 0;
+    };
+}
+
 LLUZipHelper::EZipRresult LLUZipHelper::unzip_llsd(LLSD& data, const U8* in, S32 size)
 {
-    U8* result = NULL;
+    const U8* result = nullptr;
     llssize cur_size = 0;
-    z_stream strm;
+    EZipRresult ret = unzip_to_buffer(in, size, result, cur_size);
+    if (ret != ZR_OK)
+    {
+        return ret;
+    }
+
+    //result now points to the decompressed LLSD block
+    boost::iostreams::stream<boost::iostreams::array_source> istrm((const char*)result, cur_size);
+
+    if (!LLSDSerialize::fromBinary(data, istrm, cur_size, UNZIP_LLSD_MAX_DEPTH))
+    {
+        return ZR_PARSE_ERROR;
+    }
 
-    constexpr U32 CHUNK = 1024 * 512;
+    return ZR_OK;
+}
+
+LLUZipHelper::EZipRresult LLUZipHelper::unzip_to_buffer(const U8* in, S32 size, const U8*& out, llssize& out_size)
+{
+    // Mesh and material blocks usually inflate to a few hundred KB.  Give
+    // back what a rare huge one left behind instead of keeping it for the
+    // life of the thread.
+    constexpr size_t MIN_BUFFER_SIZE = 1024 * 512;
+    constexpr size_t MAX_KEPT_BUFFER_SIZE = 1024 * 1024 * 8;
 
-    static thread_local std::unique_ptr<U8[]> out;
-    if (!out)
+    static thread_local LLUnzipBuffer buffer;
+    if (buffer.capacity() > MAX_KEPT_BUFFER_SIZE)
+    {
+        buffer.release();
+    }
+    if (!buffer.reserve(llmax(MIN_BUFFER_SIZE, (size_t)size * 4)))
     {
-        out = std::unique_ptr<U8[]>(new(std::nothrow) U8[CHUNK]);
+        return ZR_MEM_ERROR;
     }
 
+    z_stream strm;
     strm.zalloc = Z_NULL;
     strm.zfree = Z_NULL;
     strm.opaque = Z_NULL;
@@ -2273,89 +2534,53 @@ LLUZipHelper::EZipRresult LLUZipHelper::unzip_llsd(LLSD& data, const U8* in, S32
     strm.next_in = const_cast<U8*>(in);
 
     S32 ret = inflateInit(&strm);
+    if (ret != Z_OK)
+    {
+        return ret == Z_MEM_ERROR ? ZR_MEM_ERROR : ZR_DATA_ERROR;
+    }
 
+    size_t cur_size = 0;
     do
     {
-        strm.avail_out = CHUNK;
-        strm.next_out = out.get();
+        if (cur_size == buffer.capacity() && !buffer.reserve(buffer.capacity() * 2))
+        {
+            inflateEnd(&strm);
+            return ZR_MEM_ERROR;
+        }
+        // inflate directly into the buffer, no intermediate chunk
+        strm.next_out = buffer.data() + cur_size;
+        strm.avail_out = (uInt)llmin(buffer.capacity() - cur_size, (size_t)U32_MAX);
         ret = inflate(&strm, Z_NO_FLUSH);
         switch (ret)
         {
         case Z_NEED_DICT:
         case Z_DATA_ERROR:
-        {
             inflateEnd(&strm);
-            // free(result);
-            if( result )
-                free(result);
             return ZR_DATA_ERROR;
-        }
         case Z_STREAM_ERROR:
         case Z_BUF_ERROR:
-        {
             inflateEnd(&strm);
-            free(result);
             return ZR_BUFFER_ERROR;
-        }
-
         case Z_MEM_ERROR:
-        {
-            inflateEnd(&strm);
-            // free(result);
-            if( result )
-                free(result);
-            return ZR_MEM_ERROR;
-        }
-        }
-
-        U32 have = CHUNK-strm.avail_out;
-
-        U8* new_result = (U8*)realloc(result, cur_size + have);
-        if (new_result == NULL)
-        {
             inflateEnd(&strm);
-            if (result)
-            {
-                free(result);
-            }
             return ZR_MEM_ERROR;
         }
-        result = new_result;
-        memcpy(result+cur_size, out.get(), have);
-        cur_size += have;
-
-    } while (ret == Z_OK && ret != Z_STREAM_END);
+        cur_size = strm.next_out - buffer.data();
+    } while (ret == Z_OK);
 
     inflateEnd(&strm);
 
     if (ret != Z_STREAM_END)
     {
-        // free(result);
-        if( result )
-            free(result);
         return ZR_DATA_ERROR;
     }
 
-    //result now points to the decompressed LLSD block
-    {
-        char* result_ptr = strip_deprecated_header((char*)result, cur_size);
-
-        boost::iostreams::stream<boost::iostreams::array_source> istrm(result_ptr, cur_size);
-
-        if (!LLSDSerialize::fromBinary(data, istrm, cur_size, UNZIP_LLSD_MAX_DEPTH))
-        {
-            // free(result);
-            if( result )
-                free(result);
-            return ZR_PARSE_ERROR;
-        }
-    }
-
-    // free(result);
-    if( result )
-        free(result);
+    llssize result_size = cur_size;
+    out = (const U8*)strip_deprecated_header((char*)buffer.data(), result_size);
+    out_size = result_size;
     return ZR_OK;
 }
+
 //This unzip function will only work with a gzip header and trailer - while the contents
 //of the actual compressed data is the same for either format (gzip vs zlib ), the headers
 //and trailers are different for the formats.
@@ -409,6 +409,69 @@ private:
 };
 
 
+/**
+ * @class LLSDBinaryReader
+ * @brief Walks binary formatted LLSD in place, without building an LLSD.
+ *
+ * For hot paths that only need a few known fields out of a large
+ * document, such as the geometry arrays of a mesh asset. Binary values
+ * and map keys point into the buffer being read, so it has to outlive
+ * them. Notation style delimited strings are not supported and fail the
+ * read, callers are expected to fall back to LLSDBinaryParser then.
+ *
+ * Every method returns false, and the reader stays failed, once the data
+ * does not match what was asked for.
+ */
+class LL_COMMON_API LLSDBinaryReader
+{
+public:
+    LLSDBinaryReader(const U8* data, llssize size);
+
+    /**
+     * @brief Type character of the next value, '{', '[', 'b', 'r' and so
+     * on.  Returns 0 at the end of the data or after a failure.
+     */
+    char peek() const;
+    bool failed() const { return mFailed; }
+
+    /**
+     * @brief Enter a map or an array and get its declared element count.
+     *
+     * Map elements are a readKey() followed by the value.  The matching
+     * endMap() or endArray() is expected after count elements.
+     */
+    bool beginMap(U32& count);
+    bool endMap();
+    bool beginArray(U32& count);
+    bool endArray();
+
+    bool readKey(std::string_view& key);
+    bool readBinary(const U8*& data, U32& size);
+
+    /**
+     * @brief Read a real, integers are converted the way LLSD::asReal()
+     * does.
+     */
+    bool readReal(F64& value);
+
+    /**
+     * @brief Skip over the next value and everything nested in it.
+     */
+    bool skip();
+
+private:
+    bool skipValue(S32 max_depth);
+    bool skipBytes(U32 count);
+    bool readU32(U32& value);
+    bool expect(char c);
+    bool fail() { mFailed = true; return false; }
+
+    const U8* mCur;
+    const U8* mEnd;
+    bool mFailed;
+};
+
+
 /**
  * @class LLSDFormatter
  * @brief Abstract base class for formatting LLSD.
@@ -848,6 +911,10 @@ public:
     }
 };
 
+// Nesting limit for LLSD unpacked from zipped blocks, most of which come
+// from the network
+constexpr S32 UNZIP_LLSD_MAX_DEPTH = 96;
+
 class LL_COMMON_API LLUZipHelper : public LLRefCount
 {
 public:
@@ -864,6 +931,12 @@ public:
     // return OK or reason for failure
     static EZipRresult unzip_llsd(LLSD& data, std::istream& is, S32 size);
     static EZipRresult unzip_llsd(LLSD& data, const U8* in, S32 size);
+
+    // Inflate into a buffer owned by the calling thread, skipping the
+    // deprecated binary header if present.  out stays valid until the
+    // next unzip on the same thread.  Use with LLSDBinaryReader to avoid
+    // building an LLSD out of large blocks.
+    static EZipRresult unzip_to_buffer(const U8* in, S32 size, const U8*& out, llssize& out_size);
 };
 
 //dirty little zip functions -- yell at davep
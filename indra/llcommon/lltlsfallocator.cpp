@@ -0,0 +1,366 @@
+/**
+ * @file lltlsfallocator.cpp
+ * @brief Two level segregated fit allocator for ranges of an external buffer
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "lltlsfallocator.h"
+
+#include <bit>
+
+LLTLSFAllocator::LLTLSFAllocator(U32 capacity, U32 granularity)
+:   mFLBitmap(0),
+    mCapacity(capacity & ~(granularity - 1)),
+    mGranularity(granularity),
+    mGranularityLog2(std::countr_zero(granularity)),
+    mUsed(0),
+    mAllocationCount(0)
+{
+    llassert(granularity && (granularity & (granularity - 1)) == 0);
+
+    for (U32 fl = 0; fl < FL_COUNT; ++fl)
+    {
+        mSLBitmap[fl] = 0;
+        for (U32 sl = 0; sl < SL_COUNT; ++sl)
+        {
+            mFreeHeads[fl][sl] = NONE;
+        }
+    }
+
+    if (mCapacity)
+    {
+        // one free range covering everything, which stays the first in
+        // address order for the life of the allocator
+        U32 index = newBlock();
+        Block& block = mBlocks[index];
+        block.mOffset = 0;
+        block.mSize = mCapacity;
+        insertFree(index);
+    }
+}
+
+// Size class of a free range: sizes below SL_COUNT granules get a class
+// each, above that each power of two is split into SL_COUNT classes.
+void LLTLSFAllocator::mapping(U32 size, U32& fl, U32& sl) const
+{
+    const U32 units = size >> mGranularityLog2;
+    if (units < SL_COUNT)
+    {
+        fl = 0;
+        sl = units;
+    }
+    else
+    {
+        const U32 msb = std::bit_width(units) - 1;
+        sl = (units >> (msb - SL_LOG2)) - SL_COUNT;
+        fl = msb - SL_LOG2 + 1;
+    }
+}
+
+U32 LLTLSFAllocator::findFree(U32 size) const
+{
+    // round up to the next class boundary so that any range in the class
+    // found is big enough
+    U64 units = size >> mGranularityLog2;
+    if (units >= SL_COUNT)
+    {
+        const U32 msb = std::bit_width(units) - 1;
+        units += (1ULL << (msb - SL_LOG2)) - 1;
+        units &= ~((1ULL << (msb - SL_LOG2)) - 1);
+        if (units > (mCapacity >> mGranularityLog2))
+        {
+            return NONE;
+        }
+    }
+
+    U32 fl, sl;
+    mapping((U32)(units << mGranularityLog2), fl, sl);
+
+    U32 sl_map = mSLBitmap[fl] & (~0U << sl);
+    if (!sl_map)
+    {
+        const U32 fl_map = fl + 1 < FL_COUNT ? mFLBitmap & (~0U << (fl + 1)) : 0;
+        if (!fl_map)
+        {
+            return NONE;
+        }
+        fl = std::countr_zero(fl_map);
+        sl_map = mSLBitmap[fl];
+    }
+    sl = std::countr_zero(sl_map);
+    return mFreeHeads[fl][sl];
+}
+
+U32 LLTLSFAllocator::newBlock()
+{
+    U32 index;
+    if (!mUnusedBlocks.empty())
+    {
+        index = mUnusedBlocks.back();
+        mUnusedBlocks.pop_back();
+    }
+    else
+    {
+        index = (U32)mBlocks.size();
+        mBlocks.emplace_back();
+    }
+
+    Block& block = mBlocks[index];
+    block.mOffset = 0;
+    block.mSize = 0;
+    block.mPrevPhys = NONE;
+    block.mNextPhys = NONE;
+    block.mPrevFree = NONE;
+    block.mNextFree = NONE;
+    block.mFree = false;
+    return index;
+}
+
+void LLTLSFAllocator::insertFree(U32 index)
+{
+    Block& block = mBlocks[index];
+    U32 fl, sl;
+    mapping(block.mSize, fl, sl);
+
+    block.mFree = true;
+    block.mPrevFree = NONE;
+    block.mNextFree = mFreeHeads[fl][sl];
+    if (block.mNextFree != NONE)
+    {
+        mBlocks[block.mNextFree].mPrevFree = index;
+    }
+    mFreeHeads[fl][sl] = index;
+    mFLBitmap |= 1U << fl;
+    mSLBitmap[fl] |= 1U << sl;
+}
+
+void LLTLSFAllocator::removeFree(U32 index)
+{
+    Block& block = mBlocks[index];
+    U32 fl, sl;
+    mapping(block.mSize, fl, sl);
+
+    if (block.mPrevFree != NONE)
+    {
+        mBlocks[block.mPrevFree].mNextFree = block.mNextFree;
+    }
+    else
+    {
+        mFreeHeads[fl][sl] = block.mNextFree;
+        if (block.mNextFree == NONE)
+        {
+            mSLBitmap[fl] &= ~(1U << sl);
+            if (!mSLBitmap[fl])
+            {
+                mFLBitmap &= ~(1U << fl);
+            }
+        }
+    }
+    if (block.mNextFree != NONE)
+    {
+        mBlocks[block.mNextFree].mPrevFree = block.mPrevFree;
+    }
+
+    block.mFree = false;
+    block.mPrevFree = NONE;
+    block.mNextFree = NONE;
+}
+
+LLTLSFAllocator::handle_t LLTLSFAllocator::allocate(U32 size)
+{
+    size = llmax(size, mGranularity);
+    if (size > mCapacity)
+    {
+        return INVALID_HANDLE;
+    }
+    size = (size + mGranularity - 1) & ~(mGranularity - 1);
+
+    const U32 index = findFree(size);
+    if (index == NONE)
+    {
+        return INVALID_HANDLE;
+    }
+    removeFree(index);
+
+    // give the tail back
+    if (mBlocks[index].mSize > size)
+    {
+        const U32 rest = newBlock();
+        Block& block = mBlocks[index];
+        Block& tail = mBlocks[rest];
+        tail.mOffset = block.mOffset + size;
+        tail.mSize = block.mSize - size;
+        tail.mPrevPhys = index;
+        tail.mNextPhys = block.mNextPhys;
+        if (tail.mNextPhys != NONE)
+        {
+            mBlocks[tail.mNextPhys].mPrevPhys = rest;
+        }
+        block.mNextPhys = rest;
+        block.mSize = size;
+        insertFree(rest);
+    }
+
+    mUsed += mBlocks[index].mSize;
+    mAllocationCount++;
+    return index;
+}
+
+void LLTLSFAllocator::free(handle_t handle)
+{
+    llassert(handle < mBlocks.size() && !mBlocks[handle].mFree && mBlocks[handle].mSize);
+
+    U32 index = handle;
+    llassert(mUsed >= mBlocks[index].mSize);
+    mUsed -= mBlocks[index].mSize;
+    mAllocationCount--;
+
+    // merge with the following range
+    const U32 next = mBlocks[index].mNextPhys;
+    if (next != NONE && mBlocks[next].mFree)
+    {
+        removeFree(next);
+        Block& block = mBlocks[index];
+        block.mSize += mBlocks[next].mSize;
+        block.mNextPhys = mBlocks[next].mNextPhys;
+        if (block.mNextPhys != NONE)
+        {
+            mBlocks[block.mNextPhys].mPrevPhys = index;
+        }
+        mBlocks[next].mSize = 0;
+        mUnusedBlocks.push_back(next);
+    }
+
+    // and the preceding one
+    const U32 prev = mBlocks[index].mPrevPhys;
+    if (prev != NONE && mBlocks[prev].mFree)
+    {
+        removeFree(prev);
+        Block& block = mBlocks[prev];
+        block.mSize += mBlocks[index].mSize;
+        block.mNextPhys = mBlocks[index].mNextPhys;
+        if (block.mNextPhys != NONE)
+        {
+            mBlocks[block.mNextPhys].mPrevPhys = prev;
+        }
+        mBlocks[index].mSize = 0;
+        mUnusedBlocks.push_back(index);
+        index = prev;
+    }
+
+    insertFree(index);
+}
+
+U32 LLTLSFAllocator::getLargestFreeBlock() const
+{
+    if (!mFLBitmap)
+    {
+        return 0;
+    }
+
+    // every range in the highest occupied class beats every other range
+    const U32 fl = std::bit_width(mFLBitmap) - 1;
+    const U32 sl = std::bit_width(mSLBitmap[fl]) - 1;
+    U32 largest = 0;
+    for (U32 index = mFreeHeads[fl][sl]; index != NONE; index = mBlocks[index].mNextFree)
+    {
+        largest = llmax(largest, mBlocks[index].mSize);
+    }
+    return largest;
+}
+
+bool LLTLSFAllocator::validate() const
+{
+    if (!mCapacity)
+    {
+        return mBlocks.empty() && !mFLBitmap;
+    }
+
+    U32 offset = 0;
+    U32 used = 0;
+    U32 allocations = 0;
+    U32 free_blocks = 0;
+    U32 prev = NONE;
+    for (U32 index = 0; index != NONE; index = mBlocks[index].mNextPhys)
+    {
+        const Block& block = mBlocks[index];
+        if (block.mOffset != offset || !block.mSize || block.mPrevPhys != prev ||
+            (block.mSize & (mGranularity - 1)))
+        {
+            return false;
+        }
+        if (block.mFree)
+        {
+            // neighbours should have been merged
+            if (prev != NONE && mBlocks[prev].mFree)
+            {
+                return false;
+            }
+            free_blocks++;
+        }
+        else
+        {
+            used += block.mSize;
+            allocations++;
+        }
+        offset += block.mSize;
+        prev = index;
+    }
+    if (offset != mCapacity || used != mUsed || allocations != mAllocationCount)
+    {
+        return false;
+    }
+
+    // every free range is listed under its own class, and only there
+    U32 listed = 0;
+    for (U32 fl = 0; fl < FL_COUNT; ++fl)
+    {
+        if (((mFLBitmap >> fl) & 1) != (mSLBitmap[fl] != 0))
+        {
+            return false;
+        }
+        for (U32 sl = 0; sl < SL_COUNT; ++sl)
+        {
+            if (((mSLBitmap[fl] >> sl) & 1) != (mFreeHeads[fl][sl] != NONE))
+            {
+                return false;
+            }
+            U32 prev_free = NONE;
+            for (U32 index = mFreeHeads[fl][sl]; index != NONE; index = mBlocks[index].mNextFree)
+            {
+                const Block& block = mBlocks[index];
+                U32 block_fl, block_sl;
+                mapping(block.mSize, block_fl, block_sl);
+                if (!block.mFree || block.mPrevFree != prev_free || block_fl != fl || block_sl != sl)
+                {
+                    return false;
+                }
+                prev_free = index;
+                listed++;
+            }
+        }
+    }
+    return listed == free_blocks;
+}
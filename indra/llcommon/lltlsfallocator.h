@@ -0,0 +1,106 @@
+/**
+ * @file lltlsfallocator.h
+ * @brief Two level segregated fit allocator for ranges of an external buffer
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+#ifndef LL_LLTLSFALLOCATOR_H
+#define LL_LLTLSFALLOCATOR_H
+
+#include <vector>
+
+//
+// Hands out byte ranges of a buffer it never touches, such as a GL buffer
+// object, so all bookkeeping is kept on the side.  Allocation and free are
+// constant time: free ranges are kept in lists by size class, found
+// through two levels of bitmaps, and neighbouring free ranges are merged
+// as soon as they meet.  Sizes and offsets are multiples of the
+// granularity.  Not thread safe.
+//
+class LL_COMMON_API LLTLSFAllocator
+{
+public:
+    typedef U32 handle_t;
+    static const handle_t INVALID_HANDLE = 0xFFFFFFFF;
+
+    // granularity must be a power of two
+    LLTLSFAllocator(U32 capacity, U32 granularity = 16);
+
+    // INVALID_HANDLE when no free range is big enough
+    handle_t allocate(U32 size);
+    void free(handle_t handle);
+
+    U32 getOffset(handle_t handle) const { return mBlocks[handle].mOffset; }
+
+    // Size of the range, rounded up to the granularity
+    U32 getSize(handle_t handle) const { return mBlocks[handle].mSize; }
+
+    U32 getCapacity() const { return mCapacity; }
+    U32 getUsedBytes() const { return mUsed; }
+    U32 getFreeBytes() const { return mCapacity - mUsed; }
+    U32 getAllocationCount() const { return mAllocationCount; }
+    bool isEmpty() const { return mAllocationCount == 0; }
+
+    // Biggest range that could be allocated right now
+    U32 getLargestFreeBlock() const;
+
+    // Walks every range checking the bookkeeping, for tests
+    bool validate() const;
+
+private:
+    static const U32 SL_LOG2 = 4;
+    static const U32 SL_COUNT = 1 << SL_LOG2;
+    static const U32 FL_COUNT = 29;
+    static const U32 NONE = 0xFFFFFFFF;
+
+    struct Block
+    {
+        U32 mOffset;
+        U32 mSize;
+        U32 mPrevPhys;
+        U32 mNextPhys;
+        U32 mPrevFree;
+        U32 mNextFree;
+        bool mFree;
+    };
+
+    void mapping(U32 size, U32& fl, U32& sl) const;
+    U32 findFree(U32 size) const;
+    U32 newBlock();
+    void insertFree(U32 index);
+    void removeFree(U32 index);
+
+    std::vector<Block> mBlocks;
+    std::vector<U32> mUnusedBlocks;
+
+    U32 mFLBitmap;
+    U32 mSLBitmap[FL_COUNT];
+    U32 mFreeHeads[FL_COUNT][SL_COUNT];
+
+    U32 mCapacity;
+    U32 mGranularity;
+    U32 mGranularityLog2;
+    U32 mUsed;
+    U32 mAllocationCount;
+};
+
+#endif // LL_LLTLSFALLOCATOR_H
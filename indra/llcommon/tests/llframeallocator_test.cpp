@@ -0,0 +1,156 @@
+/**
+ * @file   llframeallocator_test.cpp
+ * @brief  Test for llframeallocator.h
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../test/lltut.h"
+
+#include "../llframeallocator.h"
+
+namespace tut
+{
+    struct LLFrameAllocatorData
+    {
+    };
+
+    typedef test_group<LLFrameAllocatorData> factory;
+    typedef factory::object object;
+}
+
+namespace
+{
+    tut::factory llframeallocator_test_factory("LLFrameAllocator");
+}
+
+namespace tut
+{
+    template<> template<>
+    void object::test<1>()
+    {
+        //
+        // aligned, and a frame's memory survives the next frame
+        //
+        LLFrameAllocator allocator(4096);
+
+        U32* first = (U32*)allocator.allocate(100 * sizeof(U32), 4);
+        for (U32 i = 0; i < 100; ++i)
+        {
+            first[i] = i;
+        }
+        void* odd = allocator.allocate(3, 1);
+        void* aligned = allocator.allocate(64, 64);
+        ensure("no overlap", (U8*)odd >= (U8*)(first + 100));
+        ensure_equals("aligned", (size_t)aligned & 63, (size_t)0);
+        const size_t frame_bytes = allocator.getFrameBytes();
+        ensure("padding counted", frame_bytes >= 400 + 3 + 64);
+
+        allocator.nextFrame();
+        ensure_equals("new frame empty", allocator.getFrameBytes(), (size_t)0);
+        ensure_equals("high water", allocator.getHighWater(), frame_bytes);
+
+        U32* second = (U32*)allocator.allocate(100 * sizeof(U32), 4);
+        for (U32 i = 0; i < 100; ++i)
+        {
+            second[i] = 1000 + i;
+        }
+        bool intact = true;
+        for (U32 i = 0; i < 100; ++i)
+        {
+            intact = intact && first[i] == i;
+        }
+        ensure("last frame intact", intact);
+
+        // the frame after next reuses the first frame's memory
+        allocator.nextFrame();
+        ensure("recycled", allocator.allocate(100 * sizeof(U32), 4) == first);
+    }
+
+    template<> template<>
+    void object::test<2>()
+    {
+        //
+        // a busy frame chains blocks, and its arena merges them on reuse
+        //
+        LLFrameAllocator allocator(1024);
+        const size_t start = allocator.getReservedBytes();
+
+        for (U32 i = 0; i < 20; ++i)
+        {
+            allocator.allocate(300);
+        }
+        allocator.allocate(5000);
+        const size_t busy = allocator.getReservedBytes();
+        ensure("chained", busy > start);
+
+        allocator.nextFrame();
+        allocator.nextFrame();
+        ensure_equals("nothing freed", allocator.getReservedBytes(), busy);
+
+        // the same frame again fits in the merged block
+        U8* base = (U8*)allocator.allocate(300);
+        for (U32 i = 1; i < 20; ++i)
+        {
+            allocator.allocate(300);
+        }
+        U8* last = (U8*)allocator.allocate(5000);
+        ensure_equals("no new blocks", allocator.getReservedBytes(), busy);
+        ensure("one block", last > base && last < base + busy);
+    }
+
+    template<> template<>
+    void object::test<3>()
+    {
+        //
+        // STL containers, on the arena and on the heap without one
+        //
+        LLFrameAllocator allocator(1024);
+        {
+            LLFrameSTLAllocator<F32> floats(&allocator);
+            LLFrameSTLAllocator<S32> ints(&allocator);
+            ll_frame_vector_t<F32> vec(floats);
+            ll_frame_list_t<S32> list(ints);
+            for (S32 i = 0; i < 1000; ++i)
+            {
+                vec.push_back((F32)i);
+                list.push_back(i);
+            }
+            ensure_equals("vector size", vec.size(), (size_t)1000);
+            ensure_equals("vector contents", vec[999], 999.f);
+            ensure_equals("list front", list.front(), 0);
+            ensure_equals("list back", list.back(), 999);
+            ensure("from the arena", allocator.getFrameBytes() > 1000 * sizeof(F32));
+        }
+
+        const size_t used = allocator.getFrameBytes();
+        {
+            LLFrameSTLAllocator<F32> no_arena(NULL);
+            ll_frame_vector_t<F32> heap(no_arena);
+            heap.resize(5000, 1.f);
+            ensure_equals("heap contents", heap[4999], 1.f);
+        }
+        ensure_equals("heap fallback", allocator.getFrameBytes(), used);
+    }
+}
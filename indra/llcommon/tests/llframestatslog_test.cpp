@@ -0,0 +1,165 @@
+/**
+ * @file   llframestatslog_test.cpp
+ * @brief  Test for llframestatslog.h
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../test/lltut.h"
+#include "../test/namedtempfile.h"
+
+#include "../llframestatslog.h"
+
+namespace
+{
+    // Written over a temp file, so the log is read back from disk
+    std::string write_log(const std::string& path, const std::vector<std::string>& fields, const std::vector<U32>& values)
+    {
+        LLFrameStatsWriter writer;
+        if (writer.open(path, fields))
+        {
+            for (size_t i = 0; i + fields.size() <= values.size(); i += fields.size())
+            {
+                writer.writeFrame(&values[i]);
+            }
+            writer.close();
+        }
+        return LLFile::getContents(path);
+    }
+}
+
+namespace tut
+{
+    struct LLFrameStatsLogData
+    {
+        LLFrameStatsLogData()
+        :   mFile("llfs", "")
+        {
+        }
+
+        NamedTempFile mFile;
+    };
+
+    typedef test_group<LLFrameStatsLogData> factory;
+    typedef factory::object object;
+}
+
+namespace
+{
+    tut::factory llframestatslog_test_factory("LLFrameStatsLog");
+}
+
+namespace tut
+{
+    template<> template<>
+    void object::test<1>()
+    {
+        //
+        // frames read back as written, small and large counts alike
+        //
+        std::vector<std::string> fields = { "frame_us", "visible_groups", "draw_infos:PASS_SIMPLE" };
+        std::vector<U32> values;
+        for (U32 i = 0; i < 5000; ++i)
+        {
+            values.push_back(16000 + i);
+            values.push_back(i % 3);
+            values.push_back(i == 4999 ? 0xFFFFFFFF : i * 977);
+        }
+        const std::string data = write_log(mFile.getName(), fields, values);
+        ensure("compact", data.size() < values.size() * sizeof(U32));
+
+        LLFrameStatsLog log;
+        std::string error;
+        ensure("loads", log.load(mFile.getName(), error));
+        ensure("fields", log.getFields() == fields);
+        ensure_equals("find field", log.findField("draw_infos:PASS_SIMPLE"), 2);
+        ensure_equals("missing field", log.findField("texture_binds"), -1);
+        ensure_equals("frames", log.getFrameCount(), (size_t)5000);
+
+        bool same = true;
+        for (size_t i = 0; i < 5000; ++i)
+        {
+            for (size_t j = 0; j < 3; ++j)
+            {
+                same = same && log.getValue(i, j) == values[i * 3 + j];
+            }
+        }
+        ensure("values", same);
+    }
+
+    template<> template<>
+    void object::test<2>()
+    {
+        //
+        // a frame cut short is dropped, anything else is refused
+        //
+        std::vector<std::string> fields = { "a", "b" };
+        std::vector<U32> values = { 1, 2, 300, 400, 70000, 80000 };
+        std::string data = write_log(mFile.getName(), fields, values);
+
+        LLFrameStatsLog log;
+        std::string error;
+        ensure("truncated frame", log.parse((const U8*)data.data(), data.size() - 1, error));
+        ensure_equals("whole frames kept", log.getFrameCount(), (size_t)2);
+        ensure_equals("last whole frame", log.getValue(1, 1), 400U);
+
+        ensure("truncated header", !log.parse((const U8*)data.data(), 10, error));
+        ensure_equals("no fields", log.getFields().size(), (size_t)0);
+
+        std::string bad_magic = data;
+        bad_magic[0] = 'X';
+        ensure("bad magic", !log.parse((const U8*)bad_magic.data(), bad_magic.size(), error));
+
+        std::string bad_version = data;
+        bad_version[4] = 99;
+        ensure("bad version", !log.parse((const U8*)bad_version.data(), bad_version.size(), error));
+        ensure("reason given", !error.empty());
+    }
+
+    template<> template<>
+    void object::test<3>()
+    {
+        //
+        // nearest rank percentiles
+        //
+        std::vector<std::string> fields = { "cull_us" };
+        std::vector<U32> values;
+        for (U32 i = 100; i > 0; --i)
+        {
+            values.push_back(i);
+        }
+        write_log(mFile.getName(), fields, values);
+
+        LLFrameStatsLog log;
+        std::string error;
+        ensure("loads", log.load(mFile.getName(), error));
+        LLFrameStatsLog::Summary summary = log.summarize(0);
+        ensure_equals("min", summary.mMin, 1U);
+        ensure_equals("max", summary.mMax, 100U);
+        ensure_equals("mean", summary.mMean, 50.5);
+        ensure_equals("p50", summary.mP50, 50U);
+        ensure_equals("p90", summary.mP90, 90U);
+        ensure_equals("p99", summary.mP99, 99U);
+    }
+}
@@ -0,0 +1,140 @@
+/**
+ * @file   llparallelfor_test.cpp
+ * @brief  Test for llparallelfor.h
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../test/lltut.h"
+
+#include "../llparallelfor.h"
+#include "../threadpool.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace tut
+{
+    struct LLParallelForData
+    {
+        LLParallelForData()
+        :   mPool("ParallelForTest", 3)
+        {
+            mPool.start();
+        }
+
+        ~LLParallelForData()
+        {
+            mPool.close();
+        }
+
+        LL::ThreadPool mPool;
+    };
+
+    typedef test_group<LLParallelForData> factory;
+    typedef factory::object object;
+}
+
+namespace
+{
+    tut::factory llparallelfor_test_factory("LLParallelFor");
+}
+
+namespace tut
+{
+    template<> template<>
+    void object::test<1>()
+    {
+        //
+        // every job runs once and is done by the time the call returns
+        //
+        bool once = true;
+        for (size_t round = 0; round < 50; ++round)
+        {
+            const size_t count = 1 + round * 37;
+            std::vector<std::atomic<U32> > calls(count);
+            for (auto& call : calls)
+            {
+                call = 0;
+            }
+
+            ll_parallel_for(&mPool, count, [&](size_t i) { ++calls[i]; });
+
+            for (auto& call : calls)
+            {
+                once = once && call == 1;
+            }
+        }
+        ensure("each job once", once);
+    }
+
+    template<> template<>
+    void object::test<2>()
+    {
+        //
+        // without a pool, everything runs here in order
+        //
+        const std::thread::id caller = std::this_thread::get_id();
+        std::vector<size_t> order;
+        bool here = true;
+        ll_parallel_for(nullptr, 100, [&](size_t i)
+        {
+            here = here && std::this_thread::get_id() == caller;
+            order.push_back(i);
+        });
+
+        ensure("on the calling thread", here);
+        ensure_equals("all of them", order.size(), (size_t)100);
+        bool in_order = true;
+        for (size_t i = 0; i < order.size(); ++i)
+        {
+            in_order = in_order && order[i] == i;
+        }
+        ensure("in order", in_order);
+
+        size_t none = 0;
+        ll_parallel_for(&mPool, 0, [&](size_t) { ++none; });
+        ensure_equals("no jobs", none, (size_t)0);
+    }
+
+    template<> template<>
+    void object::test<3>()
+    {
+        //
+        // the pool does take jobs when the caller is busy
+        //
+        const std::thread::id caller = std::this_thread::get_id();
+        std::atomic<U32> elsewhere { 0 };
+        ll_parallel_for(&mPool, 8, [&](size_t)
+        {
+            if (std::this_thread::get_id() != caller)
+            {
+                ++elsewhere;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        });
+        ensure("helpers took jobs", elsewhere > 0);
+    }
+}
@@ -0,0 +1,134 @@
+/**
+ * @file   llradixsort_test.cpp
+ * @brief  Test for llradixsort.h against std::stable_sort
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+#include "../test/lltut.h"
+
+#include "../llradixsort.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace
+{
+    typedef LLRadixSortItem<U32> item_t;
+
+    // Radix sort a copy of items and compare with std::stable_sort, the
+    // values are the original positions so stability shows
+    bool sorts_like_stable_sort(std::vector<item_t> items)
+    {
+        for (U32 i = 0; i < items.size(); ++i)
+        {
+            items[i].mValue = i;
+        }
+
+        std::vector<item_t> expected = items;
+        std::stable_sort(expected.begin(), expected.end(),
+                         [](const item_t& a, const item_t& b) { return a.mKey < b.mKey; });
+
+        std::vector<item_t> scratch(items.size());
+        ll_radix_sort(items.data(), scratch.data(), items.size());
+
+        for (size_t i = 0; i < items.size(); ++i)
+        {
+            if (items[i].mKey != expected[i].mKey || items[i].mValue != expected[i].mValue)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::vector<item_t> random_items(size_t count, U64 key_mask, std::mt19937_64& rng)
+    {
+        std::vector<item_t> items(count);
+        for (item_t& item : items)
+        {
+            item.mKey = rng() & key_mask;
+        }
+        return items;
+    }
+}
+
+namespace tut
+{
+    struct radixsort
+    {
+    };
+
+    typedef test_group<radixsort> radixsort_t;
+    typedef radixsort_t::object radixsort_object_t;
+    tut::radixsort_t tut_radixsort("LLRadixSort");
+
+    template<> template<>
+    void radixsort_object_t::test<1>()
+    {
+        //
+        // full width keys, with counts on both sides of the insertion
+        // sort cutoff
+        //
+        std::mt19937_64 rng(17);
+        for (size_t count : { 0, 1, 2, 63, 64, 65, 1000, 20000 })
+        {
+            ensure("random keys", sorts_like_stable_sort(random_items(count, ~0ULL, rng)));
+        }
+    }
+
+    template<> template<>
+    void radixsort_object_t::test<2>()
+    {
+        //
+        // few distinct keys, and keys using only some bytes, where passes
+        // get skipped (an odd number of passes ends in the scratch buffer)
+        //
+        std::mt19937_64 rng(23);
+        ensure("few keys", sorts_like_stable_sort(random_items(5000, 0x3, rng)));
+        ensure("one byte", sorts_like_stable_sort(random_items(5000, 0xFF00000000ULL, rng)));
+        ensure("two bytes", sorts_like_stable_sort(random_items(5000, 0xFF000000FF00ULL, rng)));
+        ensure("three bytes", sorts_like_stable_sort(random_items(5000, 0xFF00FF00FF000000ULL, rng)));
+        ensure("all equal", sorts_like_stable_sort(random_items(5000, 0, rng)));
+
+        std::vector<item_t> sorted = random_items(5000, ~0ULL, rng);
+        std::sort(sorted.begin(), sorted.end(), [](const item_t& a, const item_t& b) { return a.mKey < b.mKey; });
+        ensure("already sorted", sorts_like_stable_sort(sorted));
+        std::reverse(sorted.begin(), sorted.end());
+        ensure("reversed", sorts_like_stable_sort(sorted));
+    }
+
+    template<> template<>
+    void radixsort_object_t::test<3>()
+    {
+        //
+        // packed key fields keep their order, null stays first
+        //
+        ensure_equals("null", ll_sort_key_bits(0, 16), 0ULL);
+        ensure_equals("no bits", ll_sort_key_bits(12345, 0), 0ULL);
+        ensure("fits", ll_sort_key_bits(~0ULL, 12) < (1ULL << 12));
+        ensure_equals("same input", ll_sort_key_bits(0xdeadbeef, 16), ll_sort_key_bits(0xdeadbeef, 16));
+        ensure("spreads neighbours", ll_sort_key_bits(0x1000, 16) != ll_sort_key_bits(0x1010, 16));
+    }
+}
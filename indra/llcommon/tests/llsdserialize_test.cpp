@@ -1584,12 +1584,85 @@ namespace tut
             1);
     }
 
-/*
     template<> template<>
     void TestLLSDBinaryParsingObject::test<11>()
     {
+        set_test_name("LLSDBinaryReader over unzip_to_buffer()");
+
+        LLSD::Binary positions(6 * 3);
+        for (size_t i = 0; i < positions.size(); ++i)
+        {
+            positions[i] = (U8)i;
+        }
+        LLSD face;
+        face["Position"] = positions;
+        face["PositionDomain"]["Min"] = llsd::array(-1.5, 0, 2);
+        face["Skipped"] = llsd::array("text", LLUUID::generateNewID(), LLSD::Date(), 7);
+        LLSD mdl = llsd::array(face, face);
+
+        std::string zipped = zip_llsd(mdl);
+        ensure("zip", !zipped.empty());
+
+        LLSD unzipped;
+        ensure_equals("unzip_llsd",
+                      LLUZipHelper::unzip_llsd(unzipped, (const U8*)zipped.data(), (S32)zipped.size()),
+                      LLUZipHelper::ZR_OK);
+        ensure_equals("unzip_llsd result", unzipped, mdl);
+
+        const U8* data = nullptr;
+        llssize size = 0;
+        ensure_equals("unzip_to_buffer",
+                      LLUZipHelper::unzip_to_buffer((const U8*)zipped.data(), (S32)zipped.size(), data, size),
+                      LLUZipHelper::ZR_OK);
+
+        LLSDBinaryReader reader(data, size);
+        U32 face_count = 0;
+        ensure("array", reader.beginArray(face_count));
+        ensure_equals("face count", face_count, 2U);
+        for (U32 i = 0; i < face_count; ++i)
+        {
+            U32 field_count = 0;
+            ensure("map", reader.beginMap(field_count));
+            ensure_equals("field count", field_count, 3U);
+            for (U32 j = 0; j < field_count; ++j)
+            {
+                std::string_view key;
+                ensure("key", reader.readKey(key));
+                if (key == "Position")
+                {
+                    const U8* binary = nullptr;
+                    U32 binary_size = 0;
+                    ensure("binary", reader.readBinary(binary, binary_size));
+                    ensure_equals("binary size", binary_size, (U32)positions.size());
+                    ensure("binary data", memcmp(binary, positions.data(), binary_size) == 0);
+                }
+                else if (key == "PositionDomain")
+                {
+                    U32 count = 0;
+                    std::string_view min_key;
+                    ensure("domain", reader.beginMap(count) && reader.readKey(min_key) && reader.beginArray(count));
+                    ensure_equals("domain key", std::string(min_key), "Min");
+                    F64 values[3];
+                    ensure("reals", reader.readReal(values[0]) && reader.readReal(values[1]) && reader.readReal(values[2]));
+                    ensure_equals("real", values[0], -1.5);
+                    ensure_equals("integer as real", values[1], 0.0);
+                    ensure("domain end", reader.endArray() && reader.endMap());
+                }
+                else
+                {
+                    ensure("skip", reader.skip());
+                }
+            }
+            ensure("map end", reader.endMap());
+        }
+        ensure("array end", reader.endArray());
+        ensure_equals("consumed", reader.peek(), '\0');
+        ensure("not failed", !reader.failed());
+
+        // a truncated block fails instead of reading past the end
+        LLSDBinaryReader truncated(data, size - 1);
+        ensure("truncated", !truncated.skip() && truncated.failed());
     }
-*/
 
    /**
      * @class TestLLSDCrossCompatible
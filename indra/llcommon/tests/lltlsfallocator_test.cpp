@@ -0,0 +1,189 @@
+/**
+ * @file   lltlsfallocator_test.cpp
+ * @brief  Test for lltlsfallocator.h
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../test/lltut.h"
+
+#include "../lltlsfallocator.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace
+{
+    // true if no two allocations share a byte
+    bool disjoint(const LLTLSFAllocator& allocator, const std::vector<LLTLSFAllocator::handle_t>& handles)
+    {
+        std::vector<std::pair<U32, U32> > ranges;
+        for (LLTLSFAllocator::handle_t handle : handles)
+        {
+            ranges.emplace_back(allocator.getOffset(handle), allocator.getSize(handle));
+        }
+        std::sort(ranges.begin(), ranges.end());
+        for (size_t i = 1; i < ranges.size(); ++i)
+        {
+            if (ranges[i - 1].first + ranges[i - 1].second > ranges[i].first)
+            {
+                return false;
+            }
+        }
+        return ranges.empty() || ranges.back().first + ranges.back().second <= allocator.getCapacity();
+    }
+}
+
+namespace tut
+{
+    struct LLTLSFAllocatorData
+    {
+    };
+
+    typedef test_group<LLTLSFAllocatorData> factory;
+    typedef factory::object object;
+}
+
+namespace
+{
+    tut::factory lltlsfallocator_test_factory("LLTLSFAllocator");
+}
+
+namespace tut
+{
+    template<> template<>
+    void object::test<1>()
+    {
+        //
+        // ranges are rounded to the granularity and merge back when freed
+        //
+        LLTLSFAllocator allocator(1024 * 1024, 16);
+        ensure_equals("capacity", allocator.getCapacity(), 1024U * 1024U);
+        ensure_equals("all free", allocator.getLargestFreeBlock(), 1024U * 1024U);
+
+        std::vector<LLTLSFAllocator::handle_t> handles;
+        const U32 sizes[] = { 1, 16, 17, 100, 4000, 65536, 3, 250000 };
+        for (U32 size : sizes)
+        {
+            LLTLSFAllocator::handle_t handle = allocator.allocate(size);
+            ensure("allocated", handle != LLTLSFAllocator::INVALID_HANDLE);
+            ensure("aligned", allocator.getOffset(handle) % 16 == 0);
+            ensure("big enough", allocator.getSize(handle) >= size && allocator.getSize(handle) < size + 16);
+            handles.push_back(handle);
+        }
+        ensure("disjoint", disjoint(allocator, handles));
+        ensure_equals("count", allocator.getAllocationCount(), 8U);
+        ensure("valid", allocator.validate());
+
+        // free every other one, then the rest
+        for (size_t i = 0; i < handles.size(); i += 2)
+        {
+            allocator.free(handles[i]);
+        }
+        ensure("valid after holes", allocator.validate());
+        for (size_t i = 1; i < handles.size(); i += 2)
+        {
+            allocator.free(handles[i]);
+        }
+        ensure("valid when empty", allocator.validate());
+        ensure("empty", allocator.isEmpty());
+        ensure_equals("nothing used", allocator.getUsedBytes(), 0U);
+        ensure_equals("merged", allocator.getLargestFreeBlock(), 1024U * 1024U);
+    }
+
+    template<> template<>
+    void object::test<2>()
+    {
+        //
+        // a full allocator refuses, and a freed range is found again
+        //
+        LLTLSFAllocator allocator(64 * 1024, 16);
+        std::vector<LLTLSFAllocator::handle_t> handles;
+        for (U32 i = 0; i < 64; ++i)
+        {
+            handles.push_back(allocator.allocate(1024));
+            ensure("fits", handles.back() != LLTLSFAllocator::INVALID_HANDLE);
+        }
+        ensure_equals("full", allocator.getFreeBytes(), 0U);
+        ensure("refused when full", allocator.allocate(16) == LLTLSFAllocator::INVALID_HANDLE);
+
+        const U32 offset = allocator.getOffset(handles[10]);
+        allocator.free(handles[10]);
+        ensure("larger than the hole", allocator.allocate(1040) == LLTLSFAllocator::INVALID_HANDLE);
+        handles[10] = allocator.allocate(1000);
+        ensure("fits the hole", handles[10] != LLTLSFAllocator::INVALID_HANDLE);
+        ensure_equals("same place", allocator.getOffset(handles[10]), offset);
+
+        ensure("larger than capacity", allocator.allocate(128 * 1024) == LLTLSFAllocator::INVALID_HANDLE);
+        ensure("valid", allocator.validate());
+    }
+
+    template<> template<>
+    void object::test<3>()
+    {
+        //
+        // random churn keeps the bookkeeping straight
+        //
+        LLTLSFAllocator allocator(8 * 1024 * 1024, 16);
+        std::vector<LLTLSFAllocator::handle_t> handles;
+        U32 seed = 12345;
+        auto next = [&seed]() { seed = seed * 1664525 + 1013904223; return seed >> 8; };
+
+        bool valid = true;
+        for (U32 i = 0; i < 20000; ++i)
+        {
+            if (handles.empty() || next() % 3)
+            {
+                // mostly small, with the odd big one
+                const U32 size = next() % 8 ? next() % 4096 + 1 : next() % (512 * 1024) + 1;
+                LLTLSFAllocator::handle_t handle = allocator.allocate(size);
+                if (handle != LLTLSFAllocator::INVALID_HANDLE)
+                {
+                    handles.push_back(handle);
+                }
+            }
+            else
+            {
+                const size_t which = next() % handles.size();
+                allocator.free(handles[which]);
+                handles[which] = handles.back();
+                handles.pop_back();
+            }
+
+            if (i % 1000 == 0)
+            {
+                valid = valid && allocator.validate() && disjoint(allocator, handles);
+            }
+        }
+        ensure("valid under churn", valid);
+        ensure_equals("count", allocator.getAllocationCount(), (U32)handles.size());
+
+        for (LLTLSFAllocator::handle_t handle : handles)
+        {
+            allocator.free(handle);
+        }
+        ensure("valid when empty", allocator.validate());
+        ensure_equals("merged", allocator.getLargestFreeBlock(), allocator.getCapacity());
+    }
+}
@@ -153,6 +153,10 @@ constexpr int HTTP_CONNECTION_LIMIT_MAX = 256;
 constexpr long HTTP_PIPELINING_DEFAULT = 0L;
 constexpr long HTTP_PIPELINING_MAX = 20L;
 
+// HTTP/2 multiplexing limits (streams per connection)
+constexpr long HTTP_HTTP2_STREAMS_DEFAULT = 0L;
+constexpr long HTTP_HTTP2_STREAMS_MAX = 256L;
+
 // Miscellaneous defaults
 constexpr bool HTTP_USE_RETRY_AFTER_DEFAULT = true;
 constexpr long HTTP_THROTTLE_RATE_DEFAULT = 0L;
@@ -166,6 +170,11 @@ constexpr int HTTP_SERVICE_LOOP_SLEEP_NORMAL_MS = 2;
 // Block allocation size (a tuning parameter) is found
 // in bufferarray.h.
 
+// Largest Content-Length for which a response body is
+// received into a single right-sized block.  Beyond this,
+// bodies are accumulated in BLOCK_ALLOC_SIZE chunks.
+constexpr long long HTTP_BODY_RESERVE_MAX = 64LL * 1024 * 1024;
+
 }  // end namespace LLCore
 
 #endif  // _LLCORE_HTTP_INTERNAL_H_
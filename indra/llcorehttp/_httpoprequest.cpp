@@ -731,7 +731,21 @@ HttpStatus HttpOpRequest::prepareRequest(HttpService * service)
     {
         xfer_timeout = timeout;
     }
-    if (cpolicy.mPipelining > 1L)
+    if (cpolicy.mHttp2Streams > 0L)
+    {
+        // Multiplexed streams share a connection the same way pipelined
+        // requests do, so give transfers the same extra room.  Unlike
+        // pipelining, a slow stream doesn't hold up the ones behind it.
+        xfer_timeout *= 2L;
+
+        // Ask for HTTP/2 on https: and fall back to HTTP/1.1 if the
+        // server won't negotiate it.  Waiting on an existing connection
+        // to learn whether it multiplexes is what keeps the connection
+        // count down when a burst of requests starts at once.
+        check_curl_easy_setopt(mCurlHandle, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+        check_curl_easy_setopt(mCurlHandle, CURLOPT_PIPEWAIT, 1L);
+    }
+    else if (cpolicy.mPipelining > 1L)
     {
         // Pipelining affects both connection and transfer timeout values.
         // Requests that are added to a pipeling immediately have completed
@@ -806,6 +820,17 @@ size_t HttpOpRequest::writeCallback(void * data, size_t size, size_t nmemb, void
     if (! op->mReplyBody)
     {
         op->mReplyBody = new BufferArray();
+
+        // First write of the body.  If the server told us how big it
+        // is, get one right-sized block so consumers can take the body
+        // with BufferArray::detachContiguous() rather than copying it.
+        curl_off_t content_length(-1);
+        if (CURLE_OK == curl_easy_getinfo(op->mCurlHandle, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &content_length)
+            && content_length > 0
+            && content_length <= HTTP_BODY_RESERVE_MAX)
+        {
+            op->mReplyBody->reserve(size_t(content_length));
+        }
     }
     const size_t req_size(size * nmemb);
     const size_t write_size(op->mReplyBody->append(static_cast<char *>(data), req_size));
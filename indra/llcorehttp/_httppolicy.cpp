@@ -249,10 +249,16 @@ HttpService::ELoopSpeed HttpPolicy::processReadyQueue()
         }
 
         int active(transport.getActiveCountInClass(policy_class));
-        int active_limit(state.mOptions.mPipelining > 1L
-                         ? (state.mOptions.mPerHostConnectionLimit
-                            * state.mOptions.mPipelining)
-                         : state.mOptions.mConnectionLimit);
+        int active_limit(state.mOptions.mConnectionLimit);
+        if (state.mOptions.mHttp2Streams > 0L)
+        {
+            // Multiplexed, in-flight limit is streams across the per-host connections
+            active_limit = state.mOptions.mPerHostConnectionLimit * state.mOptions.mHttp2Streams;
+        }
+        else if (state.mOptions.mPipelining > 1L)
+        {
+            active_limit = state.mOptions.mPerHostConnectionLimit * state.mOptions.mPipelining;
+        }
         int needed(active_limit - active);      // Expect negatives here
 
         if (needed > 0)
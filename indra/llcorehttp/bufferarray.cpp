@@ -31,7 +31,8 @@
 
 // BufferArray is a list of chunks, each a BufferArray::Block, of contiguous
 // data presented as a single array.  Chunks are at least BufferArray::BLOCK_ALLOC_SIZE
-// in length and can be larger.  Any chunk may be partially filled or even
+// in length and can be larger, except those made by reserve() which are sized
+// to what the caller expects.  Any chunk may be partially filled or even
 // empty.
 //
 // The BufferArray itself is sharable as a RefCounted entity.  As shared
@@ -54,31 +55,26 @@ class BufferArray::Block
 public:
     ~Block();
 
-    void operator delete(void *);
-    void operator delete(void *, size_t len);
-
 protected:
-    Block(size_t len);
+    Block(size_t len, char * data);
 
     Block(const Block &);                       // Not defined
     void operator=(const Block &);              // Not defined
 
-    // Allocate the block with the additional space for the
-    // buffered data at the end of the object.
-    void * operator new(size_t len, size_t addl_len);
-
 public:
-    // Only public entry to get a block.
+    // Only public entry to get a block.  Data area is 16-byte
+    // aligned and allocated separately from the block so that
+    // it can be handed off to callers (see detach()).
     static Block * alloc(size_t len);
 
+    // Gives up ownership of the data area.  Block is left with
+    // no storage and is only good for deletion.
+    char * detach();
+
 public:
     size_t mUsed;
     size_t mAlloced;
-
-    // *NOTE:  Must be last member of the object.  We'll
-    // overallocate as requested via operator new and index
-    // into the array at will.
-    char mData[1];
+    char * mData;
 };
 
 
@@ -177,6 +173,7 @@ void * BufferArray::appendBufferAlloc(size_t len)
         mBlocks.reserve(mBlocks.size() + 5);
     }
     Block * block = Block::alloc((std::max)(BLOCK_ALLOC_SIZE, len));
+    memset(block->mData, 0, len);
     block->mUsed = len;
     mBlocks.push_back(block);
     mLen += len;
@@ -184,6 +181,97 @@ void * BufferArray::appendBufferAlloc(size_t len)
 }
 
 
+bool BufferArray::reserve(size_t len)
+{
+    if (! len)
+    {
+        return false;
+    }
+
+    if (! mBlocks.empty())
+    {
+        const Block & last(*mBlocks.back());
+        if (last.mAlloced - last.mUsed >= len)
+        {
+            // Already fits
+            return true;
+        }
+    }
+
+    if (mBlocks.size() >= mBlocks.capacity())
+    {
+        mBlocks.reserve(mBlocks.size() + 5);
+    }
+    Block * block;
+    try
+    {
+        block = Block::alloc(len);
+    }
+    catch (std::bad_alloc&)
+    {
+        LL_WARNS() << "Bad memory allocation reserving " << len << " bytes in BufferArray" << LL_ENDL;
+        return false;
+    }
+    mBlocks.push_back(block);
+    return true;
+}
+
+
+char * BufferArray::detachContiguous(size_t pos, size_t * len)
+{
+    *len = 0;
+    if (pos >= mLen)
+    {
+        return NULL;
+    }
+
+    const size_t want(mLen - pos);
+    size_t offset(0);
+    const int block_start(findBlock(pos, &offset));
+    if (block_start < 0)
+    {
+        return NULL;
+    }
+
+    char * result(NULL);
+    Block & block(*mBlocks[block_start]);
+    if (block.mUsed - offset == want)
+    {
+        // Everything from pos on is in one block, hand over its
+        // storage.  An offset into the block (skipping leading
+        // bytes the caller doesn't want) is closed up in place.
+        if (offset)
+        {
+            memmove(block.mData, &block.mData[offset], want);
+        }
+        result = block.detach();
+    }
+    else
+    {
+        result = static_cast<char *>(ll_aligned_malloc_16(want));
+        if (! result)
+        {
+            LL_WARNS() << "Bad memory allocation detaching " << want << " bytes from BufferArray" << LL_ENDL;
+            return NULL;
+        }
+        read(pos, result, want);
+    }
+
+    for (container_t::iterator it(mBlocks.begin());
+         it != mBlocks.end();
+         ++it)
+    {
+        delete *it;
+        *it = NULL;
+    }
+    mBlocks.clear();
+    mLen = 0;
+
+    *len = want;
+    return result;
+}
+
+
 size_t BufferArray::read(size_t pos, void * dst, size_t len)
 {
     char * c_dst(static_cast<char *>(dst));
@@ -323,45 +411,41 @@ bool BufferArray::getBlockStartEnd(int block, const char ** start, const char **
 // ==================================
 
 
-BufferArray::Block::Block(size_t len)
+BufferArray::Block::Block(size_t len, char * data)
     : mUsed(0),
-      mAlloced(len)
-{
-    memset(mData, 0, len);
-}
+      mAlloced(len),
+      mData(data)
+{}
 
 
 BufferArray::Block::~Block()
 {
+    ll_aligned_free_16(mData);
+    mData = NULL;
     mUsed = 0;
     mAlloced = 0;
 }
 
 
-void * BufferArray::Block::operator new(size_t len, size_t addl_len)
-{
-    void * mem = new char[len + addl_len + sizeof(void *)];
-    return mem;
-}
-
-
-void BufferArray::Block::operator delete(void * mem)
-{
-    char * cmem = static_cast<char *>(mem);
-    delete [] cmem;
-}
-
-
-void BufferArray::Block::operator delete(void * mem, size_t)
+BufferArray::Block * BufferArray::Block::alloc(size_t len)
 {
-    operator delete(mem);
+    // Zero-length blocks still get a valid, distinct pointer
+    char * data = static_cast<char *>(ll_aligned_malloc_16((std::max)(len, size_t(16))));
+    if (! data)
+    {
+        throw std::bad_alloc();
+    }
+    return new Block(len, data);
 }
 
 
-BufferArray::Block * BufferArray::Block::alloc(size_t len)
+char * BufferArray::Block::detach()
 {
-    Block * block = new (len) Block(len);
-    return block;
+    char * data(mData);
+    mData = NULL;
+    mUsed = 0;
+    mAlloced = 0;
+    return data;
 }
 
 
@@ -103,6 +103,30 @@ public:
     ///                 of BufferArray of 'len' size.
     void * appendBufferAlloc(size_t len);
 
+    /// Ensures that the next 'len' bytes appended land in a
+    /// single contiguous block, allocating one of exactly that
+    /// size if the last block can't hold them.  Use when the
+    /// final size of a body is known up front (e.g. from a
+    /// Content-Length header) so that the body can be taken
+    /// with detachContiguous() instead of being copied out.
+    /// Size and current contents are unchanged.
+    ///
+    /// @return         True if the space is available.
+    bool reserve(size_t len);
+
+    /// Takes the contents of the instance from 'pos' to the
+    /// end as one contiguous buffer and leaves the instance
+    /// empty.  When that data lives in a single block (see
+    /// reserve()) the block's memory is handed over without
+    /// copying, otherwise a new buffer is allocated and filled.
+    /// Either way the memory comes from ll_aligned_malloc_16()
+    /// and the caller must release it with ll_aligned_free_16().
+    ///
+    /// @return         Buffer holding '*len' bytes or NULL if
+    ///                 there is no data at 'pos' or memory
+    ///                 could not be allocated.
+    char * detachContiguous(size_t pos, size_t * len);
+
     /// Current count of bytes in BufferArray instance.
     size_t size() const
         {
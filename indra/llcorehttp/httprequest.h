@@ -232,6 +232,24 @@ public:
         /// Global only
         PO_SSL_VERIFY_CALLBACK,
 
+        /// If greater than 0, requests in the class ask for HTTP/2
+        /// (over TLS, falling back to HTTP/1.1 when the server does
+        /// not negotiate it) and libcurl multiplexes them as streams
+        /// over shared connections.  Value gives the maximum number
+        /// of concurrent streams on a single connection.
+        ///
+        /// When set, this takes precedence over PO_PIPELINING_DEPTH.
+        /// In-flight requests are then limited to
+        /// PO_PER_HOST_CONNECTION_LIMIT times this value rather than
+        /// to PO_CONNECTION_LIMIT, so a handful of connections can
+        /// carry hundreds of small range requests.  Connections are
+        /// still capped by PO_CONNECTION_LIMIT and libcurl will wait
+        /// for an existing connection to confirm multiplexing before
+        /// opening another.
+        ///
+        /// Per-class only
+        PO_HTTP2_STREAM_LIMIT,
+
         PO_LAST  // Always at end
     };
 
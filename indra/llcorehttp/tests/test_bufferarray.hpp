@@ -29,6 +29,9 @@
 #include "bufferarray.h"
 
 #include <iostream>
+#include <vector>
+
+#include "llmemory.h"
 
 
 using namespace LLCore;
@@ -374,6 +377,100 @@ void BufferArrayTestObjectType::test<8>()
     ba->release();
 }
 
+template <> template <>
+void BufferArrayTestObjectType::test<9>()
+{
+    set_test_name("BufferArray reserve and zero-copy detachContiguous");
+
+    // create a new ref counted object with an implicit reference
+    BufferArray * ba = new BufferArray();
+
+    // Reserve a right-sized block bigger than the default allocation
+    const size_t body_len(3 * BufferArray::BLOCK_ALLOC_SIZE + 7);
+    ensure("Reserve succeeds", ba->reserve(body_len));
+    ensure("Reserve doesn't change size", 0 == ba->size());
+
+    // Fill it in pieces as libcurl would
+    char chunk[1000];
+    size_t written(0);
+    while (written < body_len)
+    {
+        const size_t len((std::min)(sizeof(chunk), body_len - written));
+        for (size_t i(0); i < len; ++i)
+        {
+            chunk[i] = char((written + i) % 251);
+        }
+        written += ba->append(chunk, len);
+    }
+    ensure("All data appended", body_len == ba->size());
+
+    // Data is in the single reserved block so detach hands it over
+    size_t detached_len(0);
+    char * detached(ba->detachContiguous(0, &detached_len));
+    ensure("Detached buffer returned", NULL != detached);
+    ensure("Detached length correct", body_len == detached_len);
+    ensure("Detached buffer is aligned", 0 == (reinterpret_cast<uintptr_t>(detached) & 0xF));
+    ensure("BufferArray empty after detach", 0 == ba->size());
+    bool content_ok(true);
+    for (size_t i(0); i < detached_len; ++i)
+    {
+        content_ok = content_ok && detached[i] == char(i % 251);
+    }
+    ensure("Detached content correct", content_ok);
+    ll_aligned_free_16(detached);
+
+    // Nothing left to detach
+    detached = ba->detachContiguous(0, &detached_len);
+    ensure("Empty detach returns NULL", NULL == detached);
+    ensure("Empty detach returns zero length", 0 == detached_len);
+
+    // release the implicit reference, causing the object to be released
+    ba->release();
+}
+
+template <> template <>
+void BufferArrayTestObjectType::test<10>()
+{
+    set_test_name("BufferArray detachContiguous with offset and spanning blocks");
+
+    // create a new ref counted object with an implicit reference
+    BufferArray * ba = new BufferArray();
+
+    char str1[] = "abcdefghij";
+    size_t str1_len(strlen(str1));
+
+    // Offset within a single block is closed up in place
+    ba->append(str1, str1_len);
+    size_t detached_len(0);
+    char * detached(ba->detachContiguous(3, &detached_len));
+    ensure("Detached buffer returned with offset", NULL != detached);
+    ensure("Detached length with offset correct", (str1_len - 3) == detached_len);
+    ensure("Detached content with offset correct", 0 == strncmp(detached, str1 + 3, detached_len));
+    ensure("BufferArray empty after offset detach", 0 == ba->size());
+    ll_aligned_free_16(detached);
+
+    // Data spanning blocks is copied into a new buffer
+    std::vector<char> big(BufferArray::BLOCK_ALLOC_SIZE + 100, 'Z');
+    ba->append(&big[0], big.size());
+    ba->append(str1, str1_len);
+    detached = ba->detachContiguous(BufferArray::BLOCK_ALLOC_SIZE, &detached_len);
+    ensure("Detached buffer returned spanning blocks", NULL != detached);
+    ensure("Detached length spanning blocks correct", (100 + str1_len) == detached_len);
+    ensure("Detached content spanning blocks correct.1", 'Z' == detached[0] && 'Z' == detached[99]);
+    ensure("Detached content spanning blocks correct.2", 0 == strncmp(detached + 100, str1, str1_len));
+    ensure("BufferArray empty after spanning detach", 0 == ba->size());
+    ll_aligned_free_16(detached);
+
+    // Past the end gets nothing and leaves the instance alone
+    ba->append(str1, str1_len);
+    detached = ba->detachContiguous(str1_len, &detached_len);
+    ensure("Detach past end returns NULL", NULL == detached);
+    ensure("Detach past end leaves data", str1_len == ba->size());
+
+    // release the implicit reference, causing the object to be released
+    ba->release();
+}
+
 }  // end namespace tut
 
 
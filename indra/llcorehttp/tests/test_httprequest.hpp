@@ -3043,6 +3043,132 @@ void HttpRequestTestObjectType::test<23>()
 }
 
 
+template <> template <>
+void HttpRequestTestObjectType::test<24>()
+{
+    ScopedCurlInit ready;
+
+    std::string url_base(get_base_url());
+
+    set_test_name("HttpRequest GETs multiplexed with HTTP/2 stream limit");
+
+    // The peer only speaks HTTP/1.1 on a plain http: socket so this
+    // exercises the policy and transport setup for multiplexing plus
+    // the fallback path libcurl takes when HTTP/2 isn't negotiated.
+    // All requests must still complete with the in-flight limit
+    // raised well above the connection count.
+
+    // Handler can be stack-allocated *if* there are no dangling
+    // references to it after completion of this method.
+    // Create before memory record as the string copy will bump numbers.
+    TestHandler2 handler(this, "handler");
+    LLCore::HttpHandler::ptr_t handlerp(&handler, NoOpDeletor);
+    mHandlerCalls = 0;
+
+    HttpRequest * req = NULL;
+
+    try
+    {
+        // Get singletons created
+        HttpRequest::createService();
+
+        // Limits are clamped to the supported range
+        long ret_value(0);
+        HttpStatus status = HttpRequest::setStaticPolicyOption(HttpRequest::PO_HTTP2_STREAM_LIMIT,
+                                                               HttpRequest::DEFAULT_POLICY_ID,
+                                                               100000L,
+                                                               &ret_value);
+        ensure("Stream limit accepted on class", bool(status));
+        ensure("Stream limit clamped to maximum", 256L == ret_value);
+
+        status = HttpRequest::setStaticPolicyOption(HttpRequest::PO_HTTP2_STREAM_LIMIT,
+                                                    HttpRequest::GLOBAL_POLICY_ID,
+                                                    8L,
+                                                    NULL);
+        ensure("Stream limit rejected as global option", ! status);
+
+        // Two connections carrying up to eight streams each
+        HttpRequest::setStaticPolicyOption(HttpRequest::PO_CONNECTION_LIMIT, HttpRequest::DEFAULT_POLICY_ID, 2L, NULL);
+        HttpRequest::setStaticPolicyOption(HttpRequest::PO_PER_HOST_CONNECTION_LIMIT, HttpRequest::DEFAULT_POLICY_ID, 2L, NULL);
+        HttpRequest::setStaticPolicyOption(HttpRequest::PO_HTTP2_STREAM_LIMIT, HttpRequest::DEFAULT_POLICY_ID, 8L, &ret_value);
+        ensure("Stream limit set", 8L == ret_value);
+
+        // Start threading early so that thread memory is invariant
+        // over the test.
+        HttpRequest::startThread();
+
+        // create a new ref counted object with an implicit reference
+        req = new HttpRequest();
+
+        // Issue a burst of ranged GETs, more than one connection's worth
+        mStatus = HttpStatus(200);
+        const int request_count(40);
+        for (int i(0); i < request_count; ++i)
+        {
+            HttpHandle handle = req->requestGetByteRange(HttpRequest::DEFAULT_POLICY_ID,
+                                                         url_base,
+                                                         0,
+                                                         0,
+                                                         HttpOptions::ptr_t(),
+                                                         HttpHeaders::ptr_t(),
+                                                         handlerp);
+            ensure("Valid handle returned for multiplexed request", handle != LLCORE_HTTP_HANDLE_INVALID);
+        }
+
+        // Run the notification pump.
+        int count(0);
+        int limit(LOOP_COUNT_LONG);
+        while (count++ < limit && mHandlerCalls < request_count)
+        {
+            req->update(1000000);
+            usleep(LOOP_SLEEP_INTERVAL);
+        }
+        ensure("Requests executed in reasonable time", count < limit);
+        ensure("One handler invocation per request", mHandlerCalls == request_count);
+
+        // Okay, request a shutdown of the servicing thread
+        mStatus = HttpStatus();
+        mHandlerCalls = 0;
+        HttpHandle handle = req->requestStopThread(handlerp);
+        ensure("Valid handle returned for second request", handle != LLCORE_HTTP_HANDLE_INVALID);
+
+        // Run the notification pump again
+        count = 0;
+        limit = LOOP_COUNT_LONG;
+        while (count++ < limit && mHandlerCalls < 1)
+        {
+            req->update(1000000);
+            usleep(LOOP_SLEEP_INTERVAL);
+        }
+        ensure("Second request executed in reasonable time", count < limit);
+        ensure("Second handler invocation", mHandlerCalls == 1);
+
+        // See that we actually shutdown the thread
+        count = 0;
+        limit = LOOP_COUNT_SHORT;
+        while (count++ < limit && ! HttpService::isStopped())
+        {
+            usleep(LOOP_SLEEP_INTERVAL);
+        }
+        ensure("Thread actually stopped running", HttpService::isStopped());
+
+        // release the request object
+        delete req;
+        req = NULL;
+
+        // Shut down service
+        HttpRequest::destroyService();
+    }
+    catch (...)
+    {
+        stop_thread(req);
+        delete req;
+        HttpRequest::destroyService();
+        throw;
+    }
+}
+
+
 }  // end namespace tut
 
 namespace
@@ -58,6 +58,108 @@ extern float gOctreeMinSize;
 // user is responsible for managing the storage lifecycle of elements added to
 // the tree.
 template <class T, typename T_PTR> class LLOctreeNode;
+template <class T, typename T_PTR> class LLOctreeRoot;
+template <class T, typename T_PTR> class LLOctreeNodePool;
+
+// Element storage of a node.  The first N elements live in the node itself
+// and only larger nodes spill to the heap, so walking the elements of most
+// nodes doesn't leave the node's own cache lines.
+template <typename T_PTR, U32 N>
+class LLOctreeElementList
+{
+public:
+    typedef T_PTR*          iterator;
+    typedef const T_PTR*    const_iterator;
+
+    LLOctreeElementList()
+    :   mBegin(inlineData()),
+        mSize(0),
+        mCapacity(N)
+    {
+    }
+
+    ~LLOctreeElementList()
+    {
+        clear();
+        releaseHeap();
+    }
+
+    LLOctreeElementList(const LLOctreeElementList&) = delete;
+    LLOctreeElementList& operator=(const LLOctreeElementList&) = delete;
+
+    U32 size() const                                { return mSize; }
+    bool empty() const                              { return mSize == 0; }
+    U32 capacity() const                            { return mCapacity; }
+    bool isInline() const                           { return mBegin == inlineData(); }
+
+    T_PTR& operator[](U32 index)                    { return mBegin[index]; }
+    const T_PTR& operator[](U32 index) const        { return mBegin[index]; }
+
+    iterator begin()                                { return mBegin; }
+    iterator end()                                  { return mBegin + mSize; }
+    const_iterator begin() const                    { return mBegin; }
+    const_iterator end() const                      { return mBegin + mSize; }
+    const_iterator cbegin() const                   { return mBegin; }
+    const_iterator cend() const                     { return mBegin + mSize; }
+
+    void push_back(const T_PTR& value)
+    {
+        if (mSize == mCapacity)
+        {
+            grow();
+        }
+        ::new (mBegin + mSize) T_PTR(value);
+        ++mSize;
+    }
+
+    void pop_back()
+    {
+        --mSize;
+        mBegin[mSize].~T_PTR();
+    }
+
+    // Keeps the heap storage, like std::vector
+    void clear()
+    {
+        while (mSize > 0)
+        {
+            pop_back();
+        }
+    }
+
+private:
+    T_PTR* inlineData()                             { return reinterpret_cast<T_PTR*>(mInline); }
+    const T_PTR* inlineData() const                 { return reinterpret_cast<const T_PTR*>(mInline); }
+
+    void grow()
+    {
+        const U32 capacity = mCapacity * 2;
+        T_PTR* data = static_cast<T_PTR*>(::operator new(capacity * sizeof(T_PTR)));
+        for (U32 i = 0; i < mSize; ++i)
+        {
+            ::new (data + i) T_PTR(std::move(mBegin[i]));
+            mBegin[i].~T_PTR();
+        }
+        releaseHeap();
+        mBegin = data;
+        mCapacity = capacity;
+    }
+
+    void releaseHeap()
+    {
+        if (!isInline())
+        {
+            ::operator delete(mBegin);
+            mBegin = inlineData();
+            mCapacity = N;
+        }
+    }
+
+    T_PTR* mBegin;
+    U32 mSize;
+    U32 mCapacity;
+    alignas(T_PTR) U8 mInline[N * sizeof(T_PTR)];
+};
 
 template <class T, typename T_PTR>
 class LLOctreeListener: public LLTreeListener<T>
@@ -93,7 +195,7 @@ public:
 
     typedef LLOctreeTraveler<T, T_PTR>                          oct_traveler;
     typedef LLTreeTraveler<T>                                   tree_traveler;
-    typedef std::vector<T_PTR>                                  element_list;
+    typedef LLOctreeElementList<T_PTR, 4>                       element_list;
     typedef typename element_list::iterator                     element_iter;
     typedef typename element_list::const_iterator               const_element_iter;
     typedef typename std::vector<LLTreeListener<T>*>::iterator  tree_listener_iter;
@@ -103,6 +205,9 @@ public:
     typedef LLTreeNode<T>               BaseType;
     typedef LLOctreeNode<T, T_PTR>      oct_node;
     typedef LLOctreeListener<T, T_PTR>  oct_listener;
+    typedef LLOctreeNodePool<T, T_PTR>  node_pool;
+
+    friend class LLOctreeRoot<T, T_PTR>;
 
     enum
     {
@@ -114,7 +219,11 @@ public:
                     BaseType* parent,
                     U8 octant = NO_CHILD_NODES)
     :   mParent((oct_node*)parent),
-        mOctant(octant)
+        mOctant(octant),
+        mPool(parent ? ((oct_node*)parent)->mPool : NULL),
+        mChildBlock(NULL),
+        mChildSlots(0),
+        mPooled(false)
     {
         llassert(size[0] >= gOctreeMinSize*0.5f);
 
@@ -146,7 +255,7 @@ public:
 
         for (U32 i = 0; i < getChildCount(); i++)
         {
-            delete getChild(i);
+            deleteChildNode(getChild(i));
         }
     }
 
@@ -418,7 +527,7 @@ public:
 
                 llassert(size[0] >= gOctreeMinSize*0.5f);
                 //make the new kid
-                child = new oct_node(center, size, this);
+                child = createChild(center, size);
                 addChild(child);
 
                 child->insert(data);
@@ -575,7 +684,7 @@ public:
         for (U32 i = 0; i < getChildCount(); i++)
         {
             mChild[i]->destroy();
-            delete mChild[i];
+            deleteChildNode(mChild[i]);
         }
     }
 
@@ -634,10 +743,13 @@ public:
             listener->handleChildRemoval(this, getChild(index));
         }
 
+        // pooled nodes only leave the block of their parent by dying
+        llassert(destroy || !mChild[index]->mPooled);
+
         if (destroy)
         {
             mChild[index]->destroy();
-            delete mChild[index];
+            deleteChildNode(mChild[index]);
         }
 
         --mChildCount;
@@ -681,7 +793,55 @@ public:
         OCT_ERRS << "Octree failed to delete requested child." << LL_ENDL;
     }
 
+    // Node pool of the tree, NULL if nodes are allocated one by one
+    const node_pool* getNodePool() const            { return mPool; }
+    // Lives in a block of the pool rather than on its own
+    bool isPooled() const                           { return mPooled; }
+
 protected:
+    // A pooled tree puts the children of a node in one block of eight
+    // slots from the pool, each in the slot of its octant.  A child whose
+    // slot is taken (floating point error at octant boundaries) goes on
+    // the heap like in an unpooled tree.
+    oct_node* createChild(const LLVector4a& center, const LLVector4a& size)
+    {
+        if (mPool)
+        {
+            const U8 octant = getOctant(center);
+            if (!(mChildSlots & (1 << octant)))
+            {
+                if (!mChildBlock)
+                {
+                    mChildBlock = mPool->allocateBlock();
+                }
+                oct_node* child = ::new (mChildBlock + octant) oct_node(center, size, this, octant);
+                child->mPooled = true;
+                mChildSlots |= 1 << octant;
+                return child;
+            }
+        }
+        return new oct_node(center, size, this);
+    }
+
+    void deleteChildNode(oct_node* child)
+    {
+        if (!child->mPooled)
+        {
+            delete child;
+            return;
+        }
+
+        const ptrdiff_t slot = child - mChildBlock;
+        llassert(mChildBlock && slot >= 0 && slot < 8);
+        child->~oct_node();
+        mChildSlots &= ~(1 << slot);
+        if (!mChildSlots)
+        {
+            mPool->freeBlock(mChildBlock);
+            mChildBlock = NULL;
+        }
+    }
+
     typedef enum
     {
         CENTER = 0,
@@ -703,6 +863,98 @@ protected:
     U32 mChildCount;
 
     element_list mData;
+
+    node_pool* mPool;
+    oct_node* mChildBlock;      // pooled children, by octant
+    U8 mChildSlots;             // live slots of mChildBlock
+    bool mPooled;               // lives in the parent's mChildBlock
+};
+
+// Node storage of a pooled octree, see LLOctreeRoot.  Hands out blocks of
+// eight adjacent node slots carved out of slabs that double in size up to
+// a limit, and recycles them through a free list.  Not thread safe, like
+// the tree that owns it.
+template <class T, typename T_PTR>
+class LLOctreeNodePool
+{
+public:
+    typedef LLOctreeNode<T, T_PTR> oct_node;
+
+    LLOctreeNodePool()
+    :   mFreeList(NULL),
+        mNextSlabBlocks(4),
+        mBlocksInUse(0),
+        mBlocksAllocated(0)
+    {
+    }
+
+    ~LLOctreeNodePool()
+    {
+        llassert(mBlocksInUse == 0);
+        for (U8* slab : mSlabs)
+        {
+            ll_aligned_free_16(slab);
+        }
+    }
+
+    LLOctreeNodePool(const LLOctreeNodePool&) = delete;
+    LLOctreeNodePool& operator=(const LLOctreeNodePool&) = delete;
+
+    // Eight unconstructed node slots
+    oct_node* allocateBlock()
+    {
+        if (!mFreeList)
+        {
+            addSlab();
+        }
+        FreeBlock* block = mFreeList;
+        mFreeList = block->mNext;
+        ++mBlocksInUse;
+        return reinterpret_cast<oct_node*>(block);
+    }
+
+    void freeBlock(oct_node* block)
+    {
+        FreeBlock* free_block = reinterpret_cast<FreeBlock*>(block);
+        free_block->mNext = mFreeList;
+        mFreeList = free_block;
+        --mBlocksInUse;
+    }
+
+    U32 getBlocksInUse() const          { return mBlocksInUse; }
+    size_t getAllocatedBytes() const    { return mBlocksAllocated * blockBytes(); }
+
+    static size_t blockBytes()          { return 8 * sizeof(oct_node); }
+
+private:
+    struct FreeBlock
+    {
+        FreeBlock* mNext;
+    };
+
+    void addSlab()
+    {
+        const U32 count = mNextSlabBlocks;
+        mNextSlabBlocks = llmin(count * 2, (U32)256);
+
+        U8* slab = (U8*)ll_aligned_malloc_16(count * blockBytes());
+        mSlabs.push_back(slab);
+        mBlocksAllocated += count;
+
+        // first block of the slab on top
+        for (U32 i = count; i > 0; --i)
+        {
+            FreeBlock* block = reinterpret_cast<FreeBlock*>(slab + (i - 1) * blockBytes());
+            block->mNext = mFreeList;
+            mFreeList = block;
+        }
+    }
+
+    std::vector<U8*> mSlabs;
+    FreeBlock* mFreeList;
+    U32 mNextSlabBlocks;
+    U32 mBlocksInUse;
+    U32 mBlocksAllocated;
 };
 
 //just like a regular node, except it might expand on insert and compress on balance
@@ -713,11 +965,36 @@ public:
     typedef LLOctreeNode<T, T_PTR> BaseType;
     typedef LLOctreeNode<T, T_PTR> oct_node;
 
+    // A pooled root allocates its branches from a node pool of its own
+    // rather than one by one
     LLOctreeRoot(const LLVector4a& center,
                  const LLVector4a& size,
-                 BaseType* parent)
+                 BaseType* parent,
+                 bool pooled = false)
     :   BaseType(center, size, parent)
     {
+        if (pooled)
+        {
+            this->mPool = new typename BaseType::node_pool();
+        }
+    }
+
+    ~LLOctreeRoot()
+    {
+        if (this->mPool)
+        {
+            // the branches live in the pool, so they go before it, in the
+            // order ~LLOctreeNode() would take
+            this->destroyListeners();
+            for (U32 i = 0; i < this->getChildCount(); i++)
+            {
+                this->deleteChildNode(this->getChild(i));
+            }
+            this->clearChildren();
+
+            delete this->mPool;
+            this->mPool = NULL;
+        }
     }
 
     bool balance() override
@@ -730,6 +1007,13 @@ public:
         { //if we have only one child and that child is an empty branch, make that child the root
             oct_node* child = this->mChild[0];
 
+            //the grandchildren stay in the child's block, which becomes ours
+            oct_node* block = this->mChildBlock;
+            this->mChildBlock = child->mChildBlock;
+            this->mChildSlots = child->mChildSlots;
+            child->mChildBlock = NULL;
+            child->mChildSlots = 0;
+
             //make the root node look like the child
             this->setCenter(this->mChild[0]->getCenter());
             this->setSize(this->mChild[0]->getSize());
@@ -747,7 +1031,18 @@ public:
 
             //destroy child
             child->clearChildren();
-            delete child;
+            if (child->mPooled)
+            {
+                child->~oct_node();
+            }
+            else
+            {
+                delete child;
+            }
+            if (block)
+            {
+                this->mPool->freeBlock(block);
+            }
 
             return false;
         }
@@ -839,8 +1134,16 @@ public:
 
                 llassert(size[0] >= gOctreeMinSize);
 
-                //copy our children to a new branch
-                oct_node* newnode = new oct_node(center, size, this);
+                //copy our children to a new branch, which takes over
+                //their block
+                oct_node* block = this->mChildBlock;
+                const U8 slots = this->mChildSlots;
+                this->mChildBlock = NULL;
+                this->mChildSlots = 0;
+
+                oct_node* newnode = this->createChild(center, size);
+                newnode->mChildBlock = block;
+                newnode->mChildSlots = slots;
 
                 for (U32 i = 0; i < this->getChildCount(); i++)
                 {
@@ -0,0 +1,251 @@
+/**
+ * @file lloctreecull.h
+ * @brief Parallel frustum check pass for octree cull traversals
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLOCTREECULL_H
+#define LL_LLOCTREECULL_H
+
+#include "lloctree.h"
+#include "llparallelfor.h"
+
+#include <vector>
+
+// The frustum checks of a cull traversal, done up front on several threads.
+//
+// A cull traversal (see LLViewerOctreeCull) walks the tree keeping one
+// result: 0 outside, 1 partially inside, 2 fully inside.  A node inherits
+// its parent's result when that is 2, or when it is nonzero and the node
+// skips the check, otherwise the node does its own check, descends if that
+// isn't 0, and leaves 0 behind for its next sibling.  Partially inside
+// interior nodes with elements also check their objects' bounds.
+//
+// build() records that walk in traversal order, one entry per node, with
+// the tree split at split_depth into subtrees that are recorded on
+// separate threads and spliced back in order.  The recording is the same
+// whatever the split.  A traversal can then replay it, using the recorded
+// results instead of doing the checks, skipping to mEnd when it prunes a
+// subtree of its own accord (occlusion).
+template <class T, typename T_PTR>
+class LLOctreeCullPlan
+{
+public:
+    typedef LLOctreeNode<T, T_PTR> node_t;
+
+    struct Entry
+    {
+        const node_t* mNode;
+        U32 mEnd;           // index after the last entry of the node's subtree
+        S8 mInRes;          // result the node was entered with
+        S8 mRes;            // the node's own check, -1 if it inherited mInRes
+        S8 mObjectRes;      // the check of its objects, -1 if not needed
+    };
+
+    // Called from several threads at once
+    class Checker
+    {
+    public:
+        virtual ~Checker() = default;
+        virtual S32 frustumCheck(const node_t* node) = 0;
+        virtual S32 frustumCheckObjects(const node_t* node) = 0;
+        virtual bool skipFrustumCheck(const node_t* node) = 0;
+    };
+
+    // split_depth 0 or no pool records on this thread only
+    void build(const node_t* root, Checker& checker, U32 split_depth, LL::ThreadPool* pool);
+
+    const std::vector<Entry>& getEntries() const { return mEntries; }
+
+    // Subtrees recorded separately by the last build()
+    U32 getSubtreeCount() const { return (U32)mTasks.size(); }
+
+private:
+    struct Task
+    {
+        const node_t* mNode;
+        S32 mInRes;
+        U32 mIndex;         // placeholder in mEntries
+    };
+
+    static void record(std::vector<Entry>& out, const node_t* node, S32& res, Checker& checker,
+                       U32 depth, U32 split_depth, std::vector<Task>* tasks);
+
+    // The result a traversal leaves behind after a subtree entered with
+    // res, without doing any checks
+    static S32 exitRes(const node_t* node, S32 res, Checker& checker);
+
+    std::vector<Entry> mEntries;
+    std::vector<Task> mTasks;
+
+    // Reused between builds
+    std::vector<std::vector<Entry> > mShards;
+    std::vector<Entry> mSkeleton;
+    std::vector<U32> mStart;
+};
+
+template <class T, typename T_PTR>
+void LLOctreeCullPlan<T, T_PTR>::build(const node_t* root, Checker& checker, U32 split_depth, LL::ThreadPool* pool)
+{
+    mEntries.clear();
+    mTasks.clear();
+
+    if (!root)
+    {
+        return;
+    }
+
+    S32 res = 0;
+    if (!pool || !split_depth)
+    {
+        record(mEntries, root, res, checker, 0, 0, NULL);
+        return;
+    }
+
+    // The top of the tree on this thread, leaving placeholders for the
+    // subtrees at split_depth
+    mSkeleton.clear();
+    record(mSkeleton, root, res, checker, 0, split_depth, &mTasks);
+
+    const size_t count = mTasks.size();
+    if (mShards.size() < count)
+    {
+        mShards.resize(count);
+    }
+
+    ll_parallel_for(pool, count, [this, &checker](size_t i)
+        {
+            std::vector<Entry>& shard = mShards[i];
+            shard.clear();
+            S32 task_res = mTasks[i].mInRes;
+            record(shard, mTasks[i].mNode, task_res, checker, 0, 0, NULL);
+        });
+
+    // Splice the shards into the placeholders
+    const U32 skeleton_size = (U32)mSkeleton.size();
+    mStart.resize(skeleton_size + 1);
+
+    U32 total = 0;
+    size_t task = 0;
+    for (U32 i = 0; i < skeleton_size; ++i)
+    {
+        mStart[i] = total;
+        if (task < count && mTasks[task].mIndex == i)
+        {
+            total += (U32)mShards[task].size();
+            ++task;
+        }
+        else
+        {
+            ++total;
+        }
+    }
+    mStart[skeleton_size] = total;
+
+    mEntries.reserve(total);
+    task = 0;
+    for (U32 i = 0; i < skeleton_size; ++i)
+    {
+        if (task < count && mTasks[task].mIndex == i)
+        {
+            const U32 offset = mStart[i];
+            for (const Entry& entry : mShards[task])
+            {
+                mEntries.push_back(entry);
+                mEntries.back().mEnd += offset;
+            }
+            ++task;
+        }
+        else
+        {
+            mEntries.push_back(mSkeleton[i]);
+            mEntries.back().mEnd = mStart[mSkeleton[i].mEnd];
+        }
+    }
+}
+
+// static
+template <class T, typename T_PTR>
+void LLOctreeCullPlan<T, T_PTR>::record(std::vector<Entry>& out, const node_t* node, S32& res, Checker& checker,
+                                        U32 depth, U32 split_depth, std::vector<Task>* tasks)
+{
+    const U32 index = (U32)out.size();
+    out.push_back({ node, index + 1, (S8)res, -1, -1 });
+
+    if (tasks && depth == split_depth)
+    {
+        tasks->push_back({ node, res, index });
+        res = exitRes(node, res, checker);
+        return;
+    }
+
+    bool inherited = res == 2 || (res && checker.skipFrustumCheck(node));
+    if (!inherited)
+    {
+        res = checker.frustumCheck(node);
+        out[index].mRes = (S8)res;
+    }
+
+    if (res)
+    {
+        if (res == 1 && node->getElementCount() > 0 && node->getChildCount() > 0)
+        {
+            out[index].mObjectRes = (S8)checker.frustumCheckObjects(node);
+        }
+
+        for (U32 i = 0; i < node->getChildCount(); ++i)
+        {
+            record(out, node->getChild(i), res, checker, depth + 1, split_depth, tasks);
+        }
+    }
+
+    if (!inherited)
+    {
+        res = 0;
+    }
+
+    out[index].mEnd = (U32)out.size();
+}
+
+// static
+template <class T, typename T_PTR>
+S32 LLOctreeCullPlan<T, T_PTR>::exitRes(const node_t* node, S32 res, Checker& checker)
+{
+    if (res == 2)
+    {
+        return 2;
+    }
+    if (res == 0 || !checker.skipFrustumCheck(node))
+    {
+        // Does its own check and clears the result after
+        return 0;
+    }
+
+    for (U32 i = 0; i < node->getChildCount(); ++i)
+    {
+        res = exitRes(node->getChild(i), res, checker);
+    }
+    return res;
+}
+
+#endif // LL_LLOCTREECULL_H
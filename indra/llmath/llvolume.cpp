@@ -45,18 +45,23 @@
 #include "llmatrix3a.h"
 #include "lloctree.h"
 #include "llvolume.h"
+#include "llvolumekernels.h"
 #include "llstl.h"
 #include "llsdserialize.h"
 #include "llvector4a.h"
 #include "llmatrix4a.h"
 #include "llmeshoptimizer.h"
 #include "lltimer.h"
+#include "llvolumebvh.h"
 #include "llvolumeoctree.h"
 
 #include "mikktspace/mikktspace.hh"
 
 #include "meshoptimizer/meshoptimizer.h"
 
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/stream.hpp>
+
 #define DEBUG_SILHOUETTE_BINORMALS 0
 #define DEBUG_SILHOUETTE_NORMALS 0 // TomY: Use this to display normals using the silhouette
 #define DEBUG_SILHOUETTE_EDGE_MAP 0 // DaveP: Use this to display edge map using the silhouette
@@ -1969,7 +1974,7 @@ LLProfile::~LLProfile()
 }
 
 
-S32 LLVolume::sNumMeshPoints = 0;
+std::atomic<S32> LLVolume::sNumMeshPoints(0);
 
 LLVolume::LLVolume(const LLVolumeParams &params, const F32 detail, const bool generate_single_face, const bool is_unique)
     : mParams(params)
@@ -2025,13 +2030,13 @@ void LLVolume::regen()
 void LLVolume::genTangents(S32 face)
 {
     // generate legacy tangents for the specified face
-    llassert(!isMeshAssetLoaded() || mVolumeFaces[face].mTangents != nullptr); // if this is a complete mesh asset, we should already have tangents
+    llassert(!isMeshAssetLoaded() || mVolumeFaces[face].hasTangents()); // if this is a complete mesh asset, we should already have tangents
     mVolumeFaces[face].createTangents();
 }
 
 LLVolume::~LLVolume()
 {
-    sNumMeshPoints -= mMesh.size();
+    sNumMeshPoints -= (S32)mMesh.size();
     delete mPathp;
 
     delete mProfilep;
@@ -2100,9 +2105,9 @@ bool LLVolume::generate()
         S32 sizeS = mPathp->mPath.size();
         S32 sizeT = mProfilep->mProfile.size();
 
-        sNumMeshPoints -= mMesh.size();
+        sNumMeshPoints -= (S32)mMesh.size();
         mMesh.resize(sizeT * sizeS);
-        sNumMeshPoints += mMesh.size();
+        sNumMeshPoints += (S32)mMesh.size();
 
         //generate vertex positions
 
@@ -2308,40 +2313,289 @@ bool LLVolumeFace::VertexData::compareNormal(const LLVolumeFace::VertexData& rhs
     return retval;
 }
 
+struct LLVolume::FaceBlock
+{
+    bool mNoGeometry = false;
+    const U8* mPosition = nullptr;
+    U32 mPositionSize = 0;
+    const U8* mNormal = nullptr;
+    U32 mNormalSize = 0;
+    const U8* mTexCoord0 = nullptr;
+    U32 mTexCoord0Size = 0;
+    const U8* mTriangleList = nullptr;
+    U32 mTriangleListSize = 0;
+    bool mHasWeights = false;
+    const U8* mWeights = nullptr;
+    U32 mWeightsSize = 0;
+    LLVector3 mPositionMin;
+    LLVector3 mPositionMax;
+    LLVector2 mTexCoord0Min;
+    LLVector2 mTexCoord0Max;
+    bool mHasNormalizedScale = false;
+    LLVector3 mNormalizedScale;
+};
+
+namespace
+{
+    // Anything but a binary reads as empty, like LLSD::asBinary()
+    bool read_face_binary(LLSDBinaryReader& reader, const U8*& data, U32& size)
+    {
+        if (reader.peek() != 'b')
+        {
+            return reader.skip();
+        }
+        return reader.readBinary(data, size);
+    }
+
+    // [x, y, z] style vector, like LLVector3::setValue(const LLSD&)
+    bool read_face_vector(LLSDBinaryReader& reader, F32* out, U32 components)
+    {
+        if (reader.peek() != '[')
+        {
+            return reader.skip();
+        }
+        U32 count = 0;
+        if (!reader.beginArray(count))
+        {
+            return false;
+        }
+        for (U32 i = 0; i < count; ++i)
+        {
+            char type = reader.peek();
+            if (i < components && (type == 'r' || type == 'i'))
+            {
+                F64 value = 0.0;
+                if (!reader.readReal(value))
+                {
+                    return false;
+                }
+                out[i] = (F32)value;
+            }
+            else if (!reader.skip())
+            {
+                return false;
+            }
+        }
+        return reader.endArray();
+    }
+
+    // { Min: [...], Max: [...] }
+    bool read_face_domain(LLSDBinaryReader& reader, F32* min, F32* max, U32 components)
+    {
+        if (reader.peek() != '{')
+        {
+            return reader.skip();
+        }
+        U32 count = 0;
+        if (!reader.beginMap(count))
+        {
+            return false;
+        }
+        for (U32 i = 0; i < count; ++i)
+        {
+            std::string_view key;
+            if (!reader.readKey(key))
+            {
+                return false;
+            }
+            bool ok = key == "Min" ? read_face_vector(reader, min, components)
+                    : key == "Max" ? read_face_vector(reader, max, components)
+                    : reader.skip();
+            if (!ok)
+            {
+                return false;
+            }
+        }
+        return reader.endMap();
+    }
+
+    // Face arrays are not necessarily U16 aligned in the inflated block
+    inline F32 load_face_u16(const U8* data)
+    {
+        U16 value;
+        memcpy(&value, data, sizeof(U16));
+        return (F32)value;
+    }
+
+    void get_face_binary(const LLSD& sd, const U8*& data, U32& size)
+    {
+        const LLSD::Binary& binary = sd.asBinary();
+        data = binary.empty() ? nullptr : binary.data();
+        size = (U32)binary.size();
+    }
+}
+
 bool LLVolume::unpackVolumeFaces(std::istream& is, S32 size)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_VOLUME;
 
     //input stream is now pointing at a zlib compressed block of LLSD
-    //decompress block
-    LLSD mdl;
-    U32 uzip_result = LLUZipHelper::unzip_llsd(mdl, is, size);
-    if (uzip_result != LLUZipHelper::ZR_OK)
+    std::unique_ptr<U8[]> in_data(new(std::nothrow) U8[size]);
+    if (!in_data)
     {
-        LL_DEBUGS("MeshStreaming") << "Failed to unzip LLSD blob for LoD with code " << uzip_result << " , will probably fetch from sim again." << LL_ENDL;
+        LL_DEBUGS("MeshStreaming") << "Failed to allocate " << size << " bytes for LoD, will probably fetch from sim again." << LL_ENDL;
         return false;
     }
-    return unpackVolumeFacesInternal(mdl);
+    is.read((char*)in_data.get(), size);
+    return unpackVolumeFaces(in_data.get(), size);
 }
 
-bool LLVolume::unpackVolumeFaces(U8* in_data, S32 size)
+bool LLVolume::unpackVolumeFaces(U8* in_data, S32 size, bool cache_optimize)
 {
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_VOLUME;
+
     //input data is now pointing at a zlib compressed block of LLSD
-    //decompress block
-    LLSD mdl;
-    U32 uzip_result = LLUZipHelper::unzip_llsd(mdl, in_data, size);
+    //decompress block into a reused buffer and pick the face arrays
+    //straight out of it, no LLSD is built on this path
+    const U8* llsd_data = nullptr;
+    llssize llsd_size = 0;
+    U32 uzip_result = LLUZipHelper::unzip_to_buffer(in_data, size, llsd_data, llsd_size);
     if (uzip_result != LLUZipHelper::ZR_OK)
     {
         LL_DEBUGS("MeshStreaming") << "Failed to unzip LLSD blob for LoD with code " << uzip_result << " , will probably fetch from sim again." << LL_ENDL;
         return false;
     }
-    return unpackVolumeFacesInternal(mdl);
+
+    std::vector<FaceBlock> blocks;
+    if (readFaceBlocks(llsd_data, llsd_size, blocks))
+    {
+        return unpackFaceBlocks(blocks, cache_optimize);
+    }
+
+    // unusual layout, let the full parser sort it out
+    LLSD mdl;
+    boost::iostreams::stream<boost::iostreams::array_source> istrm((const char*)llsd_data, llsd_size);
+    if (LLSDSerialize::fromBinary(mdl, istrm, llsd_size, UNZIP_LLSD_MAX_DEPTH) <= 0)
+    {
+        LL_DEBUGS("MeshStreaming") << "Failed to parse LLSD blob for LoD, will probably fetch from sim again." << LL_ENDL;
+        return false;
+    }
+    return unpackVolumeFacesInternal(mdl, cache_optimize);
 }
 
-bool LLVolume::unpackVolumeFacesInternal(const LLSD& mdl)
+// static
+bool LLVolume::readFaceBlocks(const U8* data, llssize size, std::vector<FaceBlock>& blocks)
 {
+    LLSDBinaryReader reader(data, size);
+
+    U32 face_count = 0;
+    if (!reader.beginArray(face_count))
     {
-        auto face_count = mdl.size();
+        return false;
+    }
+
+    for (U32 i = 0; i < face_count; ++i)
+    {
+        FaceBlock& block = blocks.emplace_back();
+
+        U32 field_count = 0;
+        if (!reader.beginMap(field_count))
+        {
+            return false;
+        }
+        for (U32 j = 0; j < field_count; ++j)
+        {
+            std::string_view key;
+            if (!reader.readKey(key))
+            {
+                return false;
+            }
+
+            bool ok = true;
+            if (key == "Position")
+            {
+                ok = read_face_binary(reader, block.mPosition, block.mPositionSize);
+            }
+            else if (key == "Normal")
+            {
+                ok = read_face_binary(reader, block.mNormal, block.mNormalSize);
+            }
+            else if (key == "TexCoord0")
+            {
+                ok = read_face_binary(reader, block.mTexCoord0, block.mTexCoord0Size);
+            }
+            else if (key == "TriangleList")
+            {
+                ok = read_face_binary(reader, block.mTriangleList, block.mTriangleListSize);
+            }
+            else if (key == "Weights")
+            {
+                block.mHasWeights = true;
+                ok = read_face_binary(reader, block.mWeights, block.mWeightsSize);
+            }
+            else if (key == "PositionDomain")
+            {
+                ok = read_face_domain(reader, block.mPositionMin.mV, block.mPositionMax.mV, 3);
+            }
+            else if (key == "TexCoord0Domain")
+            {
+                ok = read_face_domain(reader, block.mTexCoord0Min.mV, block.mTexCoord0Max.mV, 2);
+            }
+            else if (key == "NormalizedScale")
+            {
+                block.mHasNormalizedScale = true;
+                ok = read_face_vector(reader, block.mNormalizedScale.mV, 3);
+            }
+            else if (key == "NoGeometry")
+            {
+                block.mNoGeometry = true;
+                ok = reader.skip();
+            }
+            else
+            {
+                ok = reader.skip();
+            }
+
+            if (!ok)
+            {
+                return false;
+            }
+        }
+        if (!reader.endMap())
+        {
+            return false;
+        }
+    }
+
+    return reader.endArray();
+}
+
+bool LLVolume::unpackVolumeFacesInternal(const LLSD& mdl, bool cache_optimize)
+{
+    std::vector<FaceBlock> blocks(mdl.size());
+
+    for (size_t i = 0; i < blocks.size(); ++i)
+    {
+        const LLSD& face = mdl[i];
+        FaceBlock& block = blocks[i];
+
+        block.mNoGeometry = face.has("NoGeometry");
+        get_face_binary(face["Position"], block.mPosition, block.mPositionSize);
+        get_face_binary(face["Normal"], block.mNormal, block.mNormalSize);
+        get_face_binary(face["TexCoord0"], block.mTexCoord0, block.mTexCoord0Size);
+        get_face_binary(face["TriangleList"], block.mTriangleList, block.mTriangleListSize);
+        block.mHasWeights = face.has("Weights");
+        get_face_binary(face["Weights"], block.mWeights, block.mWeightsSize);
+
+        block.mPositionMin.setValue(face["PositionDomain"]["Min"]);
+        block.mPositionMax.setValue(face["PositionDomain"]["Max"]);
+        block.mTexCoord0Min.setValue(face["TexCoord0Domain"]["Min"]);
+        block.mTexCoord0Max.setValue(face["TexCoord0Domain"]["Max"]);
+
+        block.mHasNormalizedScale = face.has("NormalizedScale");
+        if (block.mHasNormalizedScale)
+        {
+            block.mNormalizedScale.setValue(face["NormalizedScale"]);
+        }
+    }
+
+    return unpackFaceBlocks(blocks, cache_optimize);
+}
+
+bool LLVolume::unpackFaceBlocks(const std::vector<FaceBlock>& blocks, bool cache_optimize)
+{
+    {
+        auto face_count = blocks.size();
 
         if (face_count == 0)
         { //no faces unpacked, treat as failed decode
@@ -2354,8 +2608,9 @@ bool LLVolume::unpackVolumeFacesInternal(const LLSD& mdl)
         for (size_t i = 0; i < face_count; ++i)
         {
             LLVolumeFace& face = mVolumeFaces[i];
+            const FaceBlock& block = blocks[i];
 
-            if (mdl[i].has("NoGeometry"))
+            if (block.mNoGeometry)
             { //face has no geometry, continue
                 face.resizeIndices(3);
                 face.resizeVertices(1);
@@ -2366,14 +2621,10 @@ bool LLVolume::unpackVolumeFacesInternal(const LLSD& mdl)
                 continue;
             }
 
-            const LLSD::Binary& pos = mdl[i]["Position"].asBinary();
-            const LLSD::Binary& norm = mdl[i]["Normal"].asBinary();
             // const LLSD::Binary& tangent = mdl[i]["Tangent"].asBinary(); // <FS:Beq/> more set but unused
-            const LLSD::Binary& tc = mdl[i]["TexCoord0"].asBinary();
-            const LLSD::Binary& idx = mdl[i]["TriangleList"].asBinary();
 
             //copy out indices
-            auto num_indices = idx.size() / 2;
+            auto num_indices = block.mTriangleListSize / 2;
             const S32 indices_to_discard = num_indices % 3;
             if (indices_to_discard > 0)
             {
@@ -2389,20 +2640,17 @@ bool LLVolume::unpackVolumeFacesInternal(const LLSD& mdl)
                 continue;
             }
 
-            if (idx.empty() || face.mNumIndices < 3)
+            if (block.mTriangleListSize == 0 || face.mNumIndices < 3)
             { //why is there an empty index list?
                 LL_WARNS() << "Empty face present! Face index: " << i << " Total: " << face_count << LL_ENDL;
                 continue;
             }
 
-            U16* indices = (U16*) &(idx[0]);
-            for (U32 j = 0; j < num_indices; ++j)
-            {
-                face.mIndices[j] = indices[j];
-            }
+            // blocks point into a byte buffer, don't assume U16 alignment
+            memcpy(face.mIndices, block.mTriangleList, num_indices * sizeof(U16));
 
             //copy out vertices
-            U32 num_verts = static_cast<U32>(pos.size())/(3*2);
+            U32 num_verts = block.mPositionSize/(3*2);
             face.resizeVertices(num_verts);
 
             if (num_verts > 0 && !face.mPositions)
@@ -2412,24 +2660,19 @@ bool LLVolume::unpackVolumeFacesInternal(const LLSD& mdl)
                 continue;
             }
 
-            LLVector3 minp;
-            LLVector3 maxp;
-            LLVector2 min_tc;
-            LLVector2 max_tc;
+            const LLVector3& minp = block.mPositionMin;
+            const LLVector3& maxp = block.mPositionMax;
+            const LLVector2& min_tc = block.mTexCoord0Min;
+            const LLVector2& max_tc = block.mTexCoord0Max;
 
-            minp.setValue(mdl[i]["PositionDomain"]["Min"]);
-            maxp.setValue(mdl[i]["PositionDomain"]["Max"]);
             LLVector4a min_pos, max_pos;
             min_pos.load3(minp.mV);
             max_pos.load3(maxp.mV);
 
-            min_tc.setValue(mdl[i]["TexCoord0Domain"]["Min"]);
-            max_tc.setValue(mdl[i]["TexCoord0Domain"]["Max"]);
-
             //unpack normalized scale/translation
-            if (mdl[i].has("NormalizedScale"))
+            if (block.mHasNormalizedScale)
             {
-                face.mNormalizedScale.setValue(mdl[i]["NormalizedScale"]);
+                face.mNormalizedScale = block.mNormalizedScale;
             }
             else
             {
@@ -2449,31 +2692,31 @@ bool LLVolume::unpackVolumeFacesInternal(const LLSD& mdl)
             LLVector4a* tc_out = (LLVector4a*) face.mTexCoords;
 
             {
-                U16* v = (U16*) &(pos[0]);
+                const U8* v = block.mPosition;
                 for (U32 j = 0; j < num_verts; ++j)
                 {
-                    pos_out->set((F32) v[0], (F32) v[1], (F32) v[2]);
+                    pos_out->set(load_face_u16(v), load_face_u16(v + 2), load_face_u16(v + 4));
                     pos_out->div(65535.f);
                     pos_out->mul(pos_range);
                     pos_out->add(min_pos);
                     pos_out++;
-                    v += 3;
+                    v += 6;
                 }
 
             }
 
             {
-                if (!norm.empty())
+                if (block.mNormalSize >= num_verts * 6)
                 {
-                    U16* n = (U16*) &(norm[0]);
+                    const U8* n = block.mNormal;
                     for (U32 j = 0; j < num_verts; ++j)
                     {
-                        norm_out->set((F32) n[0], (F32) n[1], (F32) n[2]);
+                        norm_out->set(load_face_u16(n), load_face_u16(n + 2), load_face_u16(n + 4));
                         norm_out->div(65535.f);
                         norm_out->mul(2.f);
                         norm_out->sub(1.f);
                         norm_out++;
-                        n += 3;
+                        n += 6;
                     }
                 }
                 else
@@ -2515,21 +2758,21 @@ bool LLVolume::unpackVolumeFacesInternal(const LLSD& mdl)
 #endif
 
             {
-                if (!tc.empty())
+                if (block.mTexCoord0Size >= num_verts * 4)
                 {
-                    U16* t = (U16*) &(tc[0]);
+                    const U8* t = block.mTexCoord0;
                     for (U32 j = 0; j < num_verts; j+=2)
                     {
                         if (j < num_verts-1)
                         {
-                            tc_out->set((F32) t[0], (F32) t[1], (F32) t[2], (F32) t[3]);
+                            tc_out->set(load_face_u16(t), load_face_u16(t + 2), load_face_u16(t + 4), load_face_u16(t + 6));
                         }
                         else
                         {
-                            tc_out->set((F32) t[0], (F32) t[1], 0.f, 0.f);
+                            tc_out->set(load_face_u16(t), load_face_u16(t + 2), 0.f, 0.f);
                         }
 
-                        t += 4;
+                        t += 8;
 
                         tc_out->div(65535.f);
                         tc_out->mul(tc_range);
@@ -2548,7 +2791,7 @@ bool LLVolume::unpackVolumeFacesInternal(const LLSD& mdl)
                 }
             }
 
-            if (mdl[i].has("Weights"))
+            if (block.mHasWeights)
             {
                 face.allocateWeights(num_verts);
                 if (!face.mWeights && num_verts)
@@ -2559,12 +2802,13 @@ bool LLVolume::unpackVolumeFacesInternal(const LLSD& mdl)
                     continue;
                 }
 
-                const LLSD::Binary& weights = mdl[i]["Weights"].asBinary();
+                const U8* weights = block.mWeights;
+                const U32 weights_size = block.mWeightsSize;
 
                 U32 idx = 0;
 
                 U32 cur_vertex = 0;
-                while (idx < weights.size() && cur_vertex < num_verts)
+                while (idx < weights_size && cur_vertex < num_verts)
                 {
                     const U8 END_INFLUENCES = 0xFF;
                     U8 joint = weights[idx++];
@@ -2574,7 +2818,7 @@ bool LLVolume::unpackVolumeFacesInternal(const LLSD& mdl)
                     U32 joints[4] = {0,0,0,0};
                     LLVector4 joints_with_weights(0,0,0,0);
 
-                    while (joint != END_INFLUENCES && idx < weights.size())
+                    while (joint != END_INFLUENCES && idx < weights_size)
                     {
                         U16 influence = weights[idx++];
                         influence |= ((U16) weights[idx++] << 8);
@@ -2611,7 +2855,7 @@ bool LLVolume::unpackVolumeFacesInternal(const LLSD& mdl)
                     cur_vertex++;
                 }
 
-                if (cur_vertex != num_verts || idx != weights.size())
+                if (cur_vertex != num_verts || idx != weights_size)
                 {
                     LL_WARNS() << "Vertex weight count does not match vertex count!" << LL_ENDL;
                 }
@@ -2687,13 +2931,7 @@ bool LLVolume::unpackVolumeFacesInternal(const LLSD& mdl)
             }
             else
             {
-                min = max = face.mPositions[0];
-
-                for (S32 i = 1; i < face.mNumVertices; ++i)
-                {
-                    min.setMin(min, face.mPositions[i]);
-                    max.setMax(max, face.mPositions[i]);
-                }
+                LLCalculateExtents(face.mPositions, face.mNumVertices, min, max);
 
                 if (face.mTexCoords)
                 {
@@ -2717,7 +2955,7 @@ bool LLVolume::unpackVolumeFacesInternal(const LLSD& mdl)
         }
     }
 
-    if (!cacheOptimize(true))
+    if (cache_optimize && !cacheOptimize(true))
     {
         // Out of memory?
         LL_WARNS() << "Failed to optimize!" << LL_ENDL;
@@ -2776,19 +3014,85 @@ void LLVolume::copyVolumeFaces(const LLVolume* volume)
     mSculptLevel = 0;
 }
 
-bool LLVolume::cacheOptimize(bool gen_tangents)
+// Bump when the packed face layout or the output of cacheOptimize() changes
+constexpr U32 OPTIMIZED_FACES_VERSION = 2;
+
+bool LLVolume::cacheOptimize(bool gen_tangents, std::vector<U8>* packed)
 {
+    if (packed)
+    {
+        U32 header[] = { OPTIMIZED_FACES_VERSION, (U32)mVolumeFaces.size() };
+        packed->insert(packed->end(), (const U8*)header, (const U8*)header + sizeof(header));
+    }
+
+    std::vector<U16> vertex_source;
     for (S32 i = 0; i < mVolumeFaces.size(); ++i)
     {
-        if (!mVolumeFaces[i].cacheOptimize(gen_tangents))
+        LLVolumeFace& face = mVolumeFaces[i];
+        const S32 src_vertices = face.mNumVertices;
+        const S32 src_indices = face.mNumIndices;
+        vertex_source.clear();
+        if (!face.cacheOptimize(gen_tangents, packed ? &vertex_source : nullptr))
         {
             return false;
         }
+        if (packed)
+        {
+            face.packOptimized(*packed, src_vertices, src_indices, vertex_source);
+        }
     }
     return true;
 }
 
 
+bool LLVolume::unpackOptimizedFaces(const U8* data, S32 size)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_VOLUME;
+
+    U32 header[2];
+    if (!data || size < (S32)sizeof(header))
+    {
+        return false;
+    }
+    memcpy(header, data, sizeof(header));
+    if (header[0] != OPTIMIZED_FACES_VERSION || header[1] != (U32)mVolumeFaces.size())
+    {
+        return false;
+    }
+
+    // Check every face first so a bad blob leaves the volume untouched
+    const U8* end = data + size;
+    const U8* cur = data + sizeof(header);
+    for (LLVolumeFace& face : mVolumeFaces)
+    {
+        if (face.mOptimized || !face.unpackOptimized(cur, end, false))
+        {
+            return false;
+        }
+    }
+    if (cur != end)
+    {
+        return false;
+    }
+
+    cur = data + sizeof(header);
+    for (LLVolumeFace& face : mVolumeFaces)
+    {
+        face.unpackOptimized(cur, end, true);
+    }
+    return true;
+}
+
+S32 LLVolume::compactFaces()
+{
+    S32 freed = 0;
+    for (LLVolumeFace& face : mVolumeFaces)
+    {
+        freed += face.compact();
+    }
+    return freed;
+}
+
 S32 LLVolume::getNumFaces() const
 {
     return mIsMeshAssetLoaded ? getNumVolumeFaces() : (S32)mProfilep->mFaces.size();
@@ -3231,9 +3535,9 @@ void LLVolume::sculpt(U16 sculpt_width, U16 sculpt_height, S8 sculpt_components,
         LL_WARNS() << "sculpt bad mesh size " << sizeS << " " << sizeT << LL_ENDL;
     }
 
-    sNumMeshPoints -= mMesh.size();
+    sNumMeshPoints -= (S32)mMesh.size();
     mMesh.resize(sizeS * sizeT);
-    sNumMeshPoints += mMesh.size();
+    sNumMeshPoints += (S32)mMesh.size();
 
     //generate vertex positions
     if (!data_is_empty)
@@ -4396,6 +4700,77 @@ S32 LLVolume::lineSegmentIntersect(const LLVector4a& start, const LLVector4a& en
                     }
                 }
             }
+            else if (LLVolumeFace::sUseBVH)
+            {
+                const LLVolumeBVH* bvh = face.getBVH();
+                if (!bvh || bvh->getTriangleCount() != (U32)face.mNumIndices / 3)
+                {
+                    face.createBVH();
+                    bvh = face.getBVH();
+                }
+
+                F32 a, b;
+                S32 tri = bvh->intersect(face.mPositions, face.mIndices, start, dir, closest_t, a, b);
+                if (tri >= 0)
+                {
+                    hit_face = i;
+
+                    if (intersection != NULL)
+                    {
+                        LLVector4a intersect = dir;
+                        intersect.mul(closest_t);
+                        intersect.add(start);
+                        *intersection = intersect;
+                    }
+
+                    U16 idx0 = face.mIndices[tri * 3 + 0];
+                    U16 idx1 = face.mIndices[tri * 3 + 1];
+                    U16 idx2 = face.mIndices[tri * 3 + 2];
+
+                    if (tex_coord != NULL && face.hasTexCoords())
+                    {
+                        *tex_coord = ((1.f - a - b) * face.getTexCoord(idx0) +
+                            a              * face.getTexCoord(idx1) +
+                            b              * face.getTexCoord(idx2));
+                    }
+
+                    if (normal != NULL && face.hasNormals())
+                    {
+                        LLVector4a n1, n2, n3;
+                        n1 = face.getNormal(idx0);
+                        n1.mul(1.f - a - b);
+
+                        n2 = face.getNormal(idx1);
+                        n2.mul(a);
+
+                        n3 = face.getNormal(idx2);
+                        n3.mul(b);
+
+                        n1.add(n2);
+                        n1.add(n3);
+
+                        *normal = n1;
+                    }
+
+                    if (tangent_out != NULL && face.hasTangents())
+                    {
+                        LLVector4a t1, t2, t3;
+                        t1 = face.getTangent(idx0);
+                        t1.mul(1.f - a - b);
+
+                        t2 = face.getTangent(idx1);
+                        t2.mul(a);
+
+                        t3 = face.getTangent(idx2);
+                        t3.mul(b);
+
+                        t1.add(t2);
+                        t1.add(t3);
+
+                        *tangent_out = t1;
+                    }
+                }
+            }
             else
             {
                 if (!face.getOctree())
@@ -4937,6 +5312,8 @@ std::ostream& operator<<(std::ostream &s, const LLVolume *volumep)
     return s;
 }
 
+bool LLVolumeFace::sUseBVH = true;
+
 LLVolumeFace::LLVolumeFace() :
     mID(0),
     mTypeMask(0),
@@ -4960,6 +5337,7 @@ LLVolumeFace::LLVolumeFace() :
     mWeightsScrubbed(false),
     mOctree(NULL),
     mOctreeTriangles(NULL),
+    mBVH(NULL),
     mOptimized(false)
 {
     mExtents = (LLVector4a*) ll_aligned_malloc_16(sizeof(LLVector4a)*3);
@@ -4990,7 +5368,8 @@ LLVolumeFace::LLVolumeFace(const LLVolumeFace& src)
 #endif
     mWeightsScrubbed(false),
     mOctree(NULL),
-    mOctreeTriangles(NULL)
+    mOctreeTriangles(NULL),
+    mBVH(NULL)
 {
     mExtents = (LLVector4a*) ll_aligned_malloc_16(sizeof(LLVector4a)*3);
     mCenter = mExtents+2;
@@ -5023,7 +5402,31 @@ LLVolumeFace& LLVolumeFace::operator=(const LLVolumeFace& src)
     resizeVertices(src.mNumVertices);
     resizeIndices(src.mNumIndices);
 
-    if (mNumVertices)
+    if (mNumVertices && src.isCompact())
+    {
+        // Copy compact as compact, positions only plus the packed attributes
+        S32 vert_size = mNumVertices*sizeof(LLVector4a);
+        LLVector4a* positions = (LLVector4a*) ll_aligned_malloc<64>(vert_size);
+        mPackedAttributes = (U32*) ll_aligned_malloc_16(sizeof(U32)*3*mNumVertices);
+        if (!positions || !mPackedAttributes)
+        {
+            LLError::LLUserWarningMsg::showOutOfMemory();
+            LL_ERRS() << "Failed to allocate memory for compact face copy (" << mNumVertices << ")" << LL_ENDL;
+        }
+
+        LLVector4a::memcpyNonAliased16((F32*) positions, (F32*) src.mPositions, vert_size);
+        memcpy(mPackedAttributes, src.mPackedAttributes, sizeof(U32)*3*mNumVertices);
+        mPackedTexCoordRange[0] = src.mPackedTexCoordRange[0];
+        mPackedTexCoordRange[1] = src.mPackedTexCoordRange[1];
+
+        ll_aligned_free<64>(mPositions);
+        mPositions = positions;
+        mNormals = NULL;
+        mTexCoords = NULL;
+        mNumAllocatedVertices = mNumVertices;
+        mWeightsScrubbed = false;
+    }
+    else if (mNumVertices)
     {
         S32 vert_size = mNumVertices*sizeof(LLVector4a);
         S32 tc_size = (mNumVertices*sizeof(LLVector2)+0xF) & ~0xF;
@@ -5124,6 +5527,8 @@ void LLVolumeFace::freeData()
     mTangents = NULL;
     ll_aligned_free_16(mWeights);
     mWeights = NULL;
+    ll_aligned_free_16(mPackedAttributes);
+    mPackedAttributes = nullptr;
 
 #if USE_SEPARATE_JOINT_INDICES_AND_WEIGHTS
     ll_aligned_free_16(mJointIndices);
@@ -5165,18 +5570,18 @@ bool LLVolumeFace::create(LLVolume* volume, bool partial_build)
 void LLVolumeFace::getVertexData(U16 index, LLVolumeFace::VertexData& cv)
 {
     cv.setPosition(mPositions[index]);
-    if (mNormals)
+    if (hasNormals())
     {
-        cv.setNormal(mNormals[index]);
+        cv.setNormal(getNormal(index));
     }
     else
     {
         cv.getNormal().clear();
     }
 
-    if (mTexCoords)
+    if (hasTexCoords())
     {
-        cv.mTexCoord = mTexCoords[index];
+        cv.mTexCoord = getTexCoord(index);
     }
     else
     {
@@ -5711,7 +6116,7 @@ struct MikktData
     }
 };
 
-bool LLVolumeFace::cacheOptimize(bool gen_tangents)
+bool LLVolumeFace::cacheOptimize(bool gen_tangents, std::vector<U16>* vertex_source)
 { //optimize for vertex cache according to Forsyth method:
     LL_PROFILE_ZONE_SCOPED_CATEGORY_VOLUME;
     llassert(!mOptimized);
@@ -5791,6 +6196,11 @@ bool LLVolumeFace::cacheOptimize(bool gen_tangents)
 
             allocateTangents(mNumVertices);
 
+            if (vertex_source)
+            {
+                vertex_source->assign(mNumVertices, 0);
+            }
+
             for (S32 i = 0; i < mNumIndices; ++i)
             {
                 U32 src_idx = i;
@@ -5816,6 +6226,10 @@ bool LLVolumeFace::cacheOptimize(bool gen_tangents)
                     llassert(false);
                     LL_DEBUGS_ONCE("LLVOLUME") << "Invalid source index, substituting" << LL_ENDL;
                 }
+                if (vertex_source)
+                {
+                    (*vertex_source)[dst_idx] = mIndices[i];
+                }
                 mIndices[i] = dst_idx;
 
                 mPositions[dst_idx].load3(data.p[src_idx].mV);
@@ -5872,6 +6286,407 @@ bool LLVolumeFace::cacheOptimize(bool gen_tangents)
     return true;
 }
 
+namespace
+{
+    enum
+    {
+        PACKED_HAS_TANGENTS = 0x1,
+        PACKED_REMAPPED = 0x2
+    };
+
+    void pack_bytes(std::vector<U8>& out, const void* src, size_t bytes)
+    {
+        out.insert(out.end(), (const U8*)src, (const U8*)src + bytes);
+    }
+}
+
+void LLVolumeFace::packOptimized(std::vector<U8>& out, S32 src_vertices, S32 src_indices, const std::vector<U16>& vertex_source) const
+{
+    llassert(mOptimized);
+    llassert(vertex_source.empty() || vertex_source.size() == (size_t)mNumVertices);
+
+    U32 flags = (mTangents ? PACKED_HAS_TANGENTS : 0) | (vertex_source.empty() ? 0 : PACKED_REMAPPED);
+    S32 header[] = { src_vertices, src_indices, mNumVertices, mNumIndices, (S32)flags };
+    pack_bytes(out, header, sizeof(header));
+
+    // Positions, normals, texture coordinates and weights are all
+    // reproducible from the source face, about 60 bytes a vertex saved
+    if (!vertex_source.empty())
+    {
+        pack_bytes(out, vertex_source.data(), sizeof(U16) * mNumVertices);
+    }
+    if (mTangents)
+    {
+        pack_bytes(out, mTangents, sizeof(LLVector4a) * mNumVertices);
+    }
+    pack_bytes(out, mIndices, sizeof(U16) * mNumIndices);
+}
+
+bool LLVolumeFace::unpackOptimized(const U8*& data, const U8* end, bool apply)
+{
+    S32 header[5];
+    if (end - data < (ptrdiff_t)sizeof(header))
+    {
+        return false;
+    }
+    memcpy(header, data, sizeof(header));
+
+    const S32 num_vertices = header[2];
+    const S32 num_indices = header[3];
+    const U32 flags = (U32)header[4];
+    const bool remapped = (flags & PACKED_REMAPPED) != 0;
+    if (header[0] != mNumVertices || header[1] != mNumIndices
+        || num_vertices <= 0 || num_vertices > 65536 || num_indices <= 0 || num_indices % 3 != 0
+        || (!remapped && num_vertices != mNumVertices))
+    {
+        return false;
+    }
+
+    const size_t remap_bytes = remapped ? sizeof(U16) * num_vertices : 0;
+    const size_t tangent_bytes = (flags & PACKED_HAS_TANGENTS) ? sizeof(LLVector4a) * num_vertices : 0;
+    const size_t index_bytes = sizeof(U16) * num_indices;
+    const size_t size = sizeof(header) + remap_bytes + tangent_bytes + index_bytes;
+    if ((size_t)(end - data) < size)
+    {
+        return false;
+    }
+
+    const U8* cur = data + sizeof(header);
+    std::vector<U16> vertex_source(remapped ? num_vertices : 0);
+    std::vector<U16> indices(num_indices);
+    memcpy(vertex_source.data(), cur, remap_bytes);
+    memcpy(indices.data(), cur + remap_bytes + tangent_bytes, index_bytes);
+
+    if (!apply)
+    {
+        for (U16 src : vertex_source)
+        {
+            if (src >= mNumVertices)
+            {
+                return false;
+            }
+        }
+        for (U16 idx : indices)
+        {
+            if (idx >= num_vertices)
+            {
+                return false;
+            }
+        }
+        data += size;
+        return true;
+    }
+    cur += remap_bytes;
+    data += size;
+
+    if (remapped)
+    {
+        // The same steps cacheOptimize() takes through MikktData, from the
+        // source vertex instead of the source corner
+        LLVolumeFace src(*this);
+
+        resizeVertices(num_vertices);
+        if (mNumVertices != num_vertices)
+        {
+            LLError::LLUserWarningMsg::showOutOfMemory();
+            LL_ERRS("LLCoros") << "Failed to allocate memory for resizeVertices(" << num_vertices << ")" << LL_ENDL;
+        }
+        if (src.mWeights)
+        {
+            allocateWeights(num_vertices);
+        }
+
+        LLVector3 inv_scale3(1.f / mNormalizedScale.mV[0], 1.f / mNormalizedScale.mV[1], 1.f / mNormalizedScale.mV[2]);
+        LLVector4a inv_scale(1.f / mNormalizedScale.mV[0], 1.f / mNormalizedScale.mV[1], 1.f / mNormalizedScale.mV[2]);
+        LLVector4a scale;
+        scale.load3(mNormalizedScale.mV);
+        scale.getF32ptr()[3] = 1.f;
+
+        for (S32 i = 0; i < num_vertices; ++i)
+        {
+            const U16 s = vertex_source[i];
+
+            LLVector3 p(src.mPositions[s].getF32ptr());
+            p.scaleVec(mNormalizedScale);
+            mPositions[i].load3(p.mV);
+            mPositions[i].mul(inv_scale);
+
+            LLVector3 n(src.mNormals[s].getF32ptr());
+            n.scaleVec(inv_scale3);
+            n.normalize();
+            mNormals[i].load3(n.mV);
+            mNormals[i].mul(scale);
+            mNormals[i].normalize3();
+
+            mTexCoords[i] = src.mTexCoords[s];
+
+            if (mWeights)
+            {
+                LLVector4 w(src.mWeights[s].getF32ptr());
+                mWeights[i].loadua(w.mV);
+            }
+        }
+    }
+
+    if (flags & PACKED_HAS_TANGENTS)
+    {
+        allocateTangents(num_vertices);
+        memcpy(mTangents, cur, tangent_bytes);
+    }
+
+    resizeIndices(num_indices);
+    if (mNumIndices != num_indices)
+    {
+        LLError::LLUserWarningMsg::showOutOfMemory();
+        LL_ERRS("LLCoros") << "Failed to allocate memory for resizeIndices(" << num_indices << ")" << LL_ENDL;
+    }
+    memcpy(mIndices, indices.data(), index_bytes);
+
+    mOptimized = true;
+    return true;
+}
+
+namespace
+{
+    constexpr F32 SNORM16_SCALE = 32767.f;
+    constexpr F32 SNORM15_SCALE = 16383.f;
+    constexpr F32 UNORM16_SCALE = 65535.f;
+
+    // Octahedral mapping of a direction onto [-1, 1]^2 and back
+    void oct_encode(const LLVector4a& v, F32& u, F32& w)
+    {
+        const F32* f = v.getF32ptr();
+        const F32 l1 = fabsf(f[0]) + fabsf(f[1]) + fabsf(f[2]);
+        if (l1 <= 0.f)
+        {
+            u = w = 0.f;
+            return;
+        }
+        u = f[0] / l1;
+        w = f[1] / l1;
+        if (f[2] < 0.f)
+        {
+            const F32 x = u;
+            u = (1.f - fabsf(w)) * (x >= 0.f ? 1.f : -1.f);
+            w = (1.f - fabsf(x)) * (w >= 0.f ? 1.f : -1.f);
+        }
+    }
+
+    void oct_decode(F32 u, F32 w, LLVector4a& v)
+    {
+        const F32 z = 1.f - fabsf(u) - fabsf(w);
+        if (z < 0.f)
+        {
+            const F32 x = u;
+            u = (1.f - fabsf(w)) * (x >= 0.f ? 1.f : -1.f);
+            w = (1.f - fabsf(x)) * (w >= 0.f ? 1.f : -1.f);
+        }
+        v.set(u, w, z);
+        v.normalize3fast();
+    }
+
+    U32 pack_normal(const LLVector4a& n)
+    {
+        F32 u, w;
+        oct_encode(n, u, w);
+        const S16 x = (S16)ll_round(u * SNORM16_SCALE);
+        const S16 y = (S16)ll_round(w * SNORM16_SCALE);
+        return (U32)(U16)x | ((U32)(U16)y << 16);
+    }
+
+    LLVector4a unpack_normal(U32 packed)
+    {
+        LLVector4a n;
+        oct_decode((S16)(packed & 0xFFFF) / SNORM16_SCALE, (S16)(packed >> 16) / SNORM16_SCALE, n);
+        return n;
+    }
+
+    // Like pack_normal(), with the sign of w (bitangent direction) in the
+    // low bit of the first component
+    U32 pack_tangent(const LLVector4a& t)
+    {
+        F32 u, w;
+        oct_encode(t, u, w);
+        const S32 sign = t.getF32ptr()[3] < 0.f ? 1 : 0;
+        const S16 x = (S16)(ll_round(u * SNORM15_SCALE) * 2 + sign);
+        const S16 y = (S16)ll_round(w * SNORM16_SCALE);
+        return (U32)(U16)x | ((U32)(U16)y << 16);
+    }
+
+    LLVector4a unpack_tangent(U32 packed)
+    {
+        const S32 x = (S16)(packed & 0xFFFF);
+        const S32 sign = x & 1;
+        LLVector4a t;
+        oct_decode(((x - sign) / 2) / SNORM15_SCALE, (S16)(packed >> 16) / SNORM16_SCALE, t);
+        t.getF32ptr()[3] = sign ? -1.f : 1.f;
+        return t;
+    }
+
+    // range is { minimum, extent }
+    U32 pack_tex_coord(const LLVector2& tc, const LLVector2* range)
+    {
+        U32 q[2];
+        for (S32 i = 0; i < 2; ++i)
+        {
+            const F32 t = range[1].mV[i] > 0.f ? (tc.mV[i] - range[0].mV[i]) / range[1].mV[i] : 0.f;
+            q[i] = (U32)ll_round(llclamp(t, 0.f, 1.f) * UNORM16_SCALE);
+        }
+        return q[0] | (q[1] << 16);
+    }
+
+    LLVector2 unpack_tex_coord(U32 packed, const LLVector2* range)
+    {
+        return LLVector2(range[0].mV[0] + (packed & 0xFFFF) * (range[1].mV[0] / UNORM16_SCALE),
+                         range[0].mV[1] + (packed >> 16) * (range[1].mV[1] / UNORM16_SCALE));
+    }
+}
+
+S32 LLVolumeFace::compact()
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_VOLUME;
+
+    if (isCompact() || mWeights || mNumVertices <= 0 || !mNormals || !mTexCoords)
+    {
+        return 0;
+    }
+
+    // Mesh LODs come with MikkTSpace tangents from cacheOptimize(), this
+    // only fills in legacy ones for faces that never got any
+    createTangents();
+
+    const S32 num_verts = mNumVertices;
+    U32* packed = (U32*)ll_aligned_malloc_16(sizeof(U32) * 3 * num_verts);
+    LLVector4a* positions = (LLVector4a*)ll_aligned_malloc<64>(sizeof(LLVector4a) * num_verts);
+    if (!packed || !positions)
+    {
+        // Not fatal, the face just stays as it is
+        ll_aligned_free_16(packed);
+        ll_aligned_free<64>(positions);
+        return 0;
+    }
+
+    LLVector2 min_tc = mTexCoords[0];
+    LLVector2 max_tc = min_tc;
+    for (S32 i = 1; i < num_verts; ++i)
+    {
+        min_tc.mV[0] = llmin(min_tc.mV[0], mTexCoords[i].mV[0]);
+        min_tc.mV[1] = llmin(min_tc.mV[1], mTexCoords[i].mV[1]);
+        max_tc.mV[0] = llmax(max_tc.mV[0], mTexCoords[i].mV[0]);
+        max_tc.mV[1] = llmax(max_tc.mV[1], mTexCoords[i].mV[1]);
+    }
+    mPackedTexCoordRange[0] = min_tc;
+    mPackedTexCoordRange[1] = max_tc - min_tc;
+
+    U32* dst = packed;
+    for (S32 i = 0; i < num_verts; ++i)
+    {
+        *dst++ = pack_normal(mNormals[i]);
+        *dst++ = pack_tangent(mTangents[i]);
+        *dst++ = pack_tex_coord(mTexCoords[i], mPackedTexCoordRange);
+    }
+
+    LLVector4a::memcpyNonAliased16((F32*)positions, (F32*)mPositions, sizeof(LLVector4a) * num_verts);
+
+    const S32 tc_size = ((mNumAllocatedVertices * sizeof(LLVector2)) + 0xF) & ~0xF;
+    const S32 old_size = sizeof(LLVector4a) * 2 * mNumAllocatedVertices + tc_size + sizeof(LLVector4a) * num_verts;
+    const S32 new_size = (sizeof(LLVector4a) + sizeof(U32) * 3) * num_verts;
+
+    // the octree points into mPositions, it is rebuilt on the next raycast
+    destroyOctree();
+
+    ll_aligned_free<64>(mPositions);
+    //mNormals and mTexCoords are part of the mPositions buffer
+    ll_aligned_free_16(mTangents);
+    mPositions = positions;
+    mNormals = NULL;
+    mTexCoords = NULL;
+    mTangents = NULL;
+    mNumAllocatedVertices = num_verts;
+    mPackedAttributes = packed;
+
+    return old_size - new_size;
+}
+
+void LLVolumeFace::expand()
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_VOLUME;
+
+    if (!isCompact())
+    {
+        return;
+    }
+
+    const S32 num_verts = mNumVertices;
+    const S32 tc_size = ((num_verts * sizeof(LLVector2)) + 0xF) & ~0xF;
+    LLVector4a* buffer = (LLVector4a*)ll_aligned_malloc<64>(sizeof(LLVector4a) * 2 * num_verts + tc_size);
+    LLVector4a* tangents = (LLVector4a*)ll_aligned_malloc_16(sizeof(LLVector4a) * num_verts);
+    if (!buffer || !tangents)
+    {
+        LLError::LLUserWarningMsg::showOutOfMemory();
+        LL_ERRS() << "Failed to allocate memory to expand face (" << num_verts << ")" << LL_ENDL;
+    }
+
+    LLVector4a* normals = buffer + num_verts;
+    LLVector2* tex_coords = (LLVector2*)(normals + num_verts);
+    LLVector4a::memcpyNonAliased16((F32*)buffer, (F32*)mPositions, sizeof(LLVector4a) * num_verts);
+    decodeAttributes(num_verts, normals, tex_coords, tangents);
+
+    destroyOctree();
+
+    ll_aligned_free<64>(mPositions);
+    ll_aligned_free_16(mPackedAttributes);
+    mPackedAttributes = nullptr;
+    mPositions = buffer;
+    mNormals = normals;
+    mTexCoords = tex_coords;
+    mTangents = tangents;
+}
+
+void LLVolumeFace::decodeAttributes(S32 count, LLVector4a* normals, LLVector2* tex_coords, LLVector4a* tangents) const
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_VOLUME;
+
+    llassert(isCompact() && count <= mNumVertices);
+
+    const U32* src = mPackedAttributes;
+    for (S32 i = 0; i < count; ++i, src += 3)
+    {
+        if (normals)
+        {
+            normals[i] = unpack_normal(src[0]);
+        }
+        if (tangents)
+        {
+            tangents[i] = unpack_tangent(src[1]);
+        }
+        if (tex_coords)
+        {
+            tex_coords[i] = unpack_tex_coord(src[2], mPackedTexCoordRange);
+        }
+    }
+
+    if (tex_coords && (count & 1))
+    { // keep the padding of whole LLVector4a reads defined
+        tex_coords[count].clear();
+    }
+}
+
+LLVector4a LLVolumeFace::getNormal(S32 index) const
+{
+    return mPackedAttributes ? unpack_normal(mPackedAttributes[index * 3]) : mNormals[index];
+}
+
+LLVector4a LLVolumeFace::getTangent(S32 index) const
+{
+    return mPackedAttributes ? unpack_tangent(mPackedAttributes[index * 3 + 1]) : mTangents[index];
+}
+
+LLVector2 LLVolumeFace::getTexCoord(S32 index) const
+{
+    return mPackedAttributes ? unpack_tex_coord(mPackedAttributes[index * 3 + 2], mPackedTexCoordRange) : mTexCoords[index];
+}
+
 void LLVolumeFace::createOctree(F32 scaler, const LLVector4a& center, const LLVector4a& size)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_VOLUME;
@@ -5963,6 +6778,25 @@ void LLVolumeFace::destroyOctree()
     mOctree = nullptr;
     delete[] mOctreeTriangles;
     mOctreeTriangles = nullptr;
+    delete mBVH;
+    mBVH = nullptr;
+}
+
+void LLVolumeFace::createBVH()
+{
+    if (!mBVH)
+    {
+        mBVH = new LLVolumeBVH();
+    }
+    mBVH->build(mPositions, mIndices, mNumIndices / 3);
+}
+
+void LLVolumeFace::refitBVH()
+{
+    if (mBVH)
+    {
+        mBVH->refit(mPositions, mIndices);
+    }
 }
 
 const LLVolumeOctree* LLVolumeFace::getOctree() const
@@ -5977,6 +6811,9 @@ void LLVolumeFace::swapData(LLVolumeFace& rhs)
     llswap(rhs.mNormals, mNormals);
     llswap(rhs.mTangents, mTangents);
     llswap(rhs.mTexCoords, mTexCoords);
+    llswap(rhs.mPackedAttributes, mPackedAttributes);
+    llswap(rhs.mPackedTexCoordRange[0], mPackedTexCoordRange[0]);
+    llswap(rhs.mPackedTexCoordRange[1], mPackedTexCoordRange[1]);
     llswap(rhs.mIndices,mIndices);
     llswap(rhs.mNumVertices, mNumVertices);
     llswap(rhs.mNumIndices, mNumIndices);
@@ -6587,7 +7424,7 @@ void LLVolumeFace::createTangents()
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_VOLUME;
 
-    if (!mTangents)
+    if (!mTangents && !isCompact())
     {
         allocateTangents(mNumVertices);
 
@@ -6619,8 +7456,10 @@ void LLVolumeFace::resizeVertices(S32 num_verts)
     ll_aligned_free<64>(mPositions);
     //DO NOT free mNormals and mTexCoords as they are part of mPositions buffer
     ll_aligned_free_16(mTangents);
+    ll_aligned_free_16(mPackedAttributes);
 
     mTangents = NULL;
+    mPackedAttributes = nullptr;
 
     if (num_verts)
     {
@@ -6664,6 +7503,8 @@ void LLVolumeFace::pushVertex(const LLVolumeFace::VertexData& cv)
 
 void LLVolumeFace::pushVertex(const LLVector4a& pos, const LLVector4a& norm, const LLVector2& tc)
 {
+    llassert(!isCompact());
+
     S32 new_verts = mNumVertices+1;
 
     if (new_verts > mNumAllocatedVertices)
@@ -6936,19 +7777,11 @@ bool LLVolumeFace::createSide(LLVolume* volume, bool partial_build)
 
     mCenter->clear();
 
-    LLVector4a* cur_pos = pos;
-    LLVector4a* end_pos = pos + mNumVertices;
-
     //get bounding box for this side
     LLVector4a face_min;
     LLVector4a face_max;
 
-    face_min = face_max = *cur_pos++;
-
-    while (cur_pos < end_pos)
-    {
-        update_min_max(face_min, face_max, *cur_pos++);
-    }
+    LLCalculateExtents(pos, mNumVertices, face_min, face_max);
     // VFExtents change
     mExtents[0] = face_min;
     mExtents[1] = face_max;
@@ -7035,58 +7868,10 @@ bool LLVolumeFace::createSide(LLVolume* volume, bool partial_build)
         LL_WARNS("LLVOLUME") << "Resize of triangle_normals to " << count << " failed" << LL_ENDL;
         return false;
     }
-    LLVector4a* output = triangle_normals.mArray;
-    LLVector4a* end_output = output+count;
+    LLCalculateTriangleNormals(pos, mIndices, count, triangle_normals.mArray);
 
     U16* idx = mIndices;
 
-    while (output < end_output)
-    {
-        LLVector4a b,v1,v2;
-        b.load4a((F32*) (pos+idx[0]));
-        v1.load4a((F32*) (pos+idx[1]));
-        v2.load4a((F32*) (pos+idx[2]));
-
-        //calculate triangle normal
-        LLVector4a a;
-
-        a.setSub(b, v1);
-        b.sub(v2);
-
-
-        LLQuad& vector1 = *((LLQuad*) &v1);
-        LLQuad& vector2 = *((LLQuad*) &v2);
-
-        LLQuad& amQ = *((LLQuad*) &a);
-        LLQuad& bmQ = *((LLQuad*) &b);
-
-        //v1.setCross3(t,v0);
-        //setCross3(const LLVector4a& a, const LLVector4a& b)
-        // Vectors are stored in memory in w, z, y, x order from high to low
-        // Set vector1 = { a[W], a[X], a[Z], a[Y] }
-        vector1 = _mm_shuffle_ps( amQ, amQ, _MM_SHUFFLE( 3, 0, 2, 1 ));
-        // Set vector2 = { b[W], b[Y], b[X], b[Z] }
-        vector2 = _mm_shuffle_ps( bmQ, bmQ, _MM_SHUFFLE( 3, 1, 0, 2 ));
-        // mQ = { a[W]*b[W], a[X]*b[Y], a[Z]*b[X], a[Y]*b[Z] }
-        vector2 = _mm_mul_ps( vector1, vector2 );
-        // vector3 = { a[W], a[Y], a[X], a[Z] }
-        amQ = _mm_shuffle_ps( amQ, amQ, _MM_SHUFFLE( 3, 1, 0, 2 ));
-        // vector4 = { b[W], b[X], b[Z], b[Y] }
-        bmQ = _mm_shuffle_ps( bmQ, bmQ, _MM_SHUFFLE( 3, 0, 2, 1 ));
-        // mQ = { 0, a[X]*b[Y] - a[Y]*b[X], a[Z]*b[X] - a[X]*b[Z], a[Y]*b[Z] - a[Z]*b[Y] }
-        vector1 = _mm_sub_ps( vector2, _mm_mul_ps( amQ, bmQ ));
-
-        llassert(v1.isFinite3());
-
-        v1.store4a((F32*) output);
-
-
-        output++;
-        idx += 3;
-    }
-
-    idx = mIndices;
-
     LLVector4a* src = triangle_normals.mArray;
 
     for (U32 i = 0; i < count; i++) //for each triangle
@@ -7262,109 +8047,5 @@ bool LLVolumeFace::createSide(LLVolume* volume, bool partial_build)
     return true;
 }
 
-//adapted from Lengyel, Eric. "Computing Tangent Space Basis Vectors for an Arbitrary Mesh". Terathon Software 3D Graphics Library, 2001. http://www.terathon.com/code/tangent.html
-void LLCalculateTangentArray(U32 vertexCount, const LLVector4a *vertex, const LLVector4a *normal,
-        const LLVector2 *texcoord, U32 triangleCount, const U16* index_array, LLVector4a *tangent)
-{
-    LL_PROFILE_ZONE_SCOPED_CATEGORY_VOLUME;
-
-    //LLVector4a *tan1 = new LLVector4a[vertexCount * 2];
-    LLVector4a* tan1 = (LLVector4a*) ll_aligned_malloc_16(vertexCount*2*sizeof(LLVector4a));
-    // new(tan1) LLVector4a;
-
-    LLVector4a* tan2 = tan1 + vertexCount;
-
-    U32 count = vertexCount * 2;
-    for (U32 i = 0; i < count; i++)
-    {
-        tan1[i].clear();
-    }
-
-    for (U32 a = 0; a < triangleCount; a++)
-    {
-        U32 i1 = *index_array++;
-        U32 i2 = *index_array++;
-        U32 i3 = *index_array++;
-
-        const LLVector4a& v1 = vertex[i1];
-        const LLVector4a& v2 = vertex[i2];
-        const LLVector4a& v3 = vertex[i3];
-
-        const LLVector2& w1 = texcoord[i1];
-        const LLVector2& w2 = texcoord[i2];
-        const LLVector2& w3 = texcoord[i3];
-
-        const F32* v1ptr = v1.getF32ptr();
-        const F32* v2ptr = v2.getF32ptr();
-        const F32* v3ptr = v3.getF32ptr();
-
-        float x1 = v2ptr[0] - v1ptr[0];
-        float x2 = v3ptr[0] - v1ptr[0];
-        float y1 = v2ptr[1] - v1ptr[1];
-        float y2 = v3ptr[1] - v1ptr[1];
-        float z1 = v2ptr[2] - v1ptr[2];
-        float z2 = v3ptr[2] - v1ptr[2];
-
-        float s1 = w2.mV[0] - w1.mV[0];
-        float s2 = w3.mV[0] - w1.mV[0];
-        float t1 = w2.mV[1] - w1.mV[1];
-        float t2 = w3.mV[1] - w1.mV[1];
-
-        F32 rd = s1*t2-s2*t1;
-
-        float r = ((rd*rd) > FLT_EPSILON) ? (1.0f / rd)
-                                                     : ((rd > 0.0f) ? 1024.f : -1024.f); //some made up large ratio for division by zero
-
-        llassert(llfinite(r));
-        llassert(!llisnan(r));
-
-        LLVector4a sdir((t2 * x1 - t1 * x2) * r, (t2 * y1 - t1 * y2) * r,
-                (t2 * z1 - t1 * z2) * r);
-        LLVector4a tdir((s1 * x2 - s2 * x1) * r, (s1 * y2 - s2 * y1) * r,
-                (s1 * z2 - s2 * z1) * r);
-
-        tan1[i1].add(sdir);
-        tan1[i2].add(sdir);
-        tan1[i3].add(sdir);
-
-        tan2[i1].add(tdir);
-        tan2[i2].add(tdir);
-        tan2[i3].add(tdir);
-    }
-
-    for (U32 a = 0; a < vertexCount; a++)
-    {
-        LLVector4a n = normal[a];
-
-        const LLVector4a& t = tan1[a];
-
-        LLVector4a ncrosst;
-        ncrosst.setCross3(n,t);
-
-        // Gram-Schmidt orthogonalize
-        n.mul(n.dot3(t).getF32());
-
-        LLVector4a tsubn;
-        tsubn.setSub(t,n);
-
-        if (tsubn.dot3(tsubn).getF32() > F_APPROXIMATELY_ZERO)
-        {
-            tsubn.normalize3fast();
-
-            // Calculate handedness
-            F32 handedness = ncrosst.dot3(tan2[a]).getF32() < 0.f ? -1.f : 1.f;
-
-            tsubn.getF32ptr()[3] = handedness;
-
-            tangent[a] = tsubn;
-        }
-        else
-        { //degenerate, make up a value
-            tangent[a].set(0,0,1,1);
-        }
-    }
-
-    ll_aligned_free_16(tan1);
-}
 
 
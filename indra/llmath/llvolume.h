@@ -27,6 +27,7 @@
 #ifndef LL_LLVOLUME_H
 #define LL_LLVOLUME_H
 
+#include <atomic>
 #include <iostream>
 
 class LLProfileParams;
@@ -42,6 +43,7 @@ class LLVolumeFace;
 class LLVolume;
 class LLVolumeTriangle;
 class LLVolumeOctree;
+class LLVolumeBVH;
 
 #include "lluuid.h"
 #include "v4color.h"
@@ -913,13 +915,62 @@ public:
     void remap();
 
     void optimize(F32 angle_cutoff = 2.f);
-    bool cacheOptimize(bool gen_tangents = false);
+    // vertex_source - if not null, gets the source vertex of each vertex
+    //  when tangent generation re-welded them (left empty otherwise)
+    bool cacheOptimize(bool gen_tangents = false, std::vector<U16>* vertex_source = nullptr);
+
+    // Serialize the result of cacheOptimize() so that a later load of the
+    // same source face can skip it.  Only the vertex_source remap, the
+    // tangents and the indices are kept, unpackOptimized() rebuilds the
+    // rest from the source face.  It checks the blob was made from a face
+    // with src_vertices/src_indices matching this one and advances data
+    // past it; with apply false it only checks.
+    void packOptimized(std::vector<U8>& out, S32 src_vertices, S32 src_indices, const std::vector<U16>& vertex_source) const;
+    bool unpackOptimized(const U8*& data, const U8* end, bool apply);
+
+    // Compact storage for decoded mesh faces that are not being edited.
+    // compact() packs normals and tangents octahedrally into 16 bits per
+    // component and quantizes texture coordinates to 16 bits across their
+    // range, then frees mNormals, mTexCoords and mTangents (left null).
+    // Positions stay full precision, picking, the octree, culling and
+    // skinning read them directly.  Faces with skin weights are left alone.
+    // Readers of a compact face use the accessors below or
+    // decodeAttributes(); expand() restores the full arrays for code that
+    // needs to modify them.  compact() returns the bytes freed, zero if the
+    // face was left as is.
+    S32 compact();
+    void expand();
+    bool isCompact() const { return mPackedAttributes != nullptr; }
+
+    // Decode vertices [0, count) of a compact face; any output may be null.
+    // tex_coords is written in whole LLVector4a, so must have room for an
+    // even number of entries.
+    void decodeAttributes(S32 count, LLVector4a* normals, LLVector2* tex_coords, LLVector4a* tangents) const;
+
+    // Per vertex reads that work for both full and compact faces.  Callers
+    // check the face has the attribute (hasNormals() etc.) first.
+    bool hasNormals() const { return mNormals || mPackedAttributes; }
+    bool hasTexCoords() const { return mTexCoords || mPackedAttributes; }
+    bool hasTangents() const { return mTangents || mPackedAttributes; }
+    LLVector4a getNormal(S32 index) const;
+    LLVector2 getTexCoord(S32 index) const;
+    LLVector4a getTangent(S32 index) const;
 
     void createOctree(F32 scaler = 0.25f, const LLVector4a& center = LLVector4a(0,0,0), const LLVector4a& size = LLVector4a(0.5f,0.5f,0.5f));
+    // Also drops the BVH, both are only valid for the current geometry
     void destroyOctree();
     // Get a reference to the octree, which may be null
     const LLVolumeOctree* getOctree() const;
 
+    // Flat BVH used instead of the octree by LLVolume::lineSegmentIntersect()
+    // while sUseBVH is set.  Built on the first raycast; refitBVH() updates
+    // an existing one after the positions moved but the triangles didn't.
+    void createBVH();
+    void refitBVH();
+    const LLVolumeBVH* getBVH() const { return mBVH; }
+
+    static bool sUseBVH;
+
     // Part of silhouette generation (used by selection outlines)
     // Populates the provided edge array with numbers corresponding to
     // *partial* logic of whether a particular index should be rendered
@@ -993,6 +1044,12 @@ public:
     //whether or not face has been cache optimized
     bool mOptimized;
 
+    // Packed normal, tangent and texture coordinate of each vertex while
+    // compact (see compact()), null otherwise.  mPackedTexCoordRange holds
+    // the minimum and extent the texture coordinates are quantized across.
+    U32* mPackedAttributes = nullptr;
+    LLVector2 mPackedTexCoordRange[2];
+
     // if this is a mesh asset, scale and translation that were applied
     // when encoding the source mesh into a unit cube
     // used for regenerating tangents
@@ -1001,6 +1058,7 @@ public:
 private:
     LLVolumeOctree* mOctree;
     LLVolumeTriangle* mOctreeTriangles;
+    LLVolumeBVH* mBVH;
 
     bool createUnCutCubeCap(LLVolume* volume, bool partial_build = false);
     bool createCap(LLVolume* volume, bool partial_build = false);
@@ -1086,7 +1144,7 @@ public:
     LLFaceID generateFaceMask();
 
     bool isFaceMaskValid(LLFaceID face_mask);
-    static S32 sNumMeshPoints;
+    static std::atomic<S32> sNumMeshPoints; // volumes may be generated off the main thread
 
     friend std::ostream& operator<<(std::ostream &s, const LLVolume &volume);
     friend std::ostream& operator<<(std::ostream &s, const LLVolume *volumep);      // HACK to bypass Windoze confusion over
@@ -1112,7 +1170,18 @@ public:
 
     // use meshoptimizer to optimize index buffer for vertex shader cache
     //  gen_tangents - if true, generate MikkTSpace tangents if needed before optimizing index buffer
-    bool cacheOptimize(bool gen_tangents = false);
+    //  packed - if not null, what unpackOptimizedFaces() needs to redo it is appended
+    bool cacheOptimize(bool gen_tangents = false, std::vector<U8>* packed = nullptr);
+
+    // Restore the result of cacheOptimize() instead of running it again.
+    // Call right after unpackVolumeFaces(..., false) of the same LOD data
+    // that was optimized; fails, leaving the faces untouched, if the
+    // packed data does not match them.
+    bool unpackOptimizedFaces(const U8* data, S32 size);
+
+    // Compact all faces that support it, see LLVolumeFace::compact().
+    // Returns the number of bytes freed.
+    S32 compactFaces();
 
 private:
     void sculptGenerateMapVertices(U16 sculpt_width, U16 sculpt_height, S8 sculpt_components, const U8* sculpt_data, U8 sculpt_type);
@@ -1125,9 +1194,14 @@ protected:
     void createVolumeFaces();
 public:
     bool unpackVolumeFaces(std::istream& is, S32 size);
-    bool unpackVolumeFaces(U8* in_data, S32 size);
+    // cache_optimize false leaves cacheOptimize() to the caller
+    bool unpackVolumeFaces(U8* in_data, S32 size, bool cache_optimize = true);
 private:
-    bool unpackVolumeFacesInternal(const LLSD& mdl);
+    // One face of a mesh LOD block, pointing into the inflated data
+    struct FaceBlock;
+    static bool readFaceBlocks(const U8* data, llssize size, std::vector<FaceBlock>& blocks);
+    bool unpackVolumeFacesInternal(const LLSD& mdl, bool cache_optimize = true);
+    bool unpackFaceBlocks(const std::vector<FaceBlock>& blocks, bool cache_optimize);
 
 public:
     virtual void setMeshAssetLoaded(bool loaded);
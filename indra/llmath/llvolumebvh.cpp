@@ -0,0 +1,438 @@
+/**
+ * @file llvolumebvh.cpp
+ * @brief Flat bounding volume hierarchy over the triangles of a volume face
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+#include "llmath.h"
+
+#include "llvolumebvh.h"
+#include "llvolume.h"
+
+#include <algorithm>
+
+namespace
+{
+    constexpr U32 BVH_BINS = 12;
+
+    // Leaves up to this size are kept when splitting doesn't pay
+    constexpr U32 BVH_MAX_LEAF = 4;
+
+    // Traversal pushes at most one node per level
+    constexpr U32 BVH_MAX_DEPTH = 48;
+    constexpr U32 BVH_STACK_SIZE = BVH_MAX_DEPTH + 2;
+
+    // Slack on the box test so rounding never culls a triangle the
+    // triangle test would hit; t is relative to the segment length
+    constexpr F32 BVH_T_EPSILON = 1.e-5f;
+
+    F32 half_area(const LLVector4a& min, const LLVector4a& max)
+    {
+        LLVector4a size;
+        size.setSub(max, min);
+        return size[0] * size[1] + size[1] * size[2] + size[2] * size[0];
+    }
+}
+
+struct LLVolumeBVH::BuildTri
+{
+    LLVector4a mMin;
+    LLVector4a mMax;
+    LLVector4a mCentroid;
+    U32 mIndex;
+};
+
+void LLVolumeBVH::build(const LLVector4a* positions, const U16* indices, U32 triangle_count)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_VOLUME;
+
+    mNodes.clear();
+    mTriangles.clear();
+
+    if (!positions || !indices || triangle_count == 0)
+    {
+        return;
+    }
+
+    std::vector<BuildTri> tris(triangle_count);
+    for (U32 i = 0; i < triangle_count; ++i)
+    {
+        const LLVector4a& v0 = positions[indices[i * 3 + 0]];
+        const LLVector4a& v1 = positions[indices[i * 3 + 1]];
+        const LLVector4a& v2 = positions[indices[i * 3 + 2]];
+
+        BuildTri& tri = tris[i];
+        tri.mMin.setMin(v0, v1);
+        tri.mMin.setMin(tri.mMin, v2);
+        tri.mMax.setMax(v0, v1);
+        tri.mMax.setMax(tri.mMax, v2);
+        tri.mCentroid.setAdd(tri.mMin, tri.mMax);
+        tri.mCentroid.mul(0.5f);
+        tri.mIndex = i;
+    }
+
+    // a binary tree with at least one triangle per leaf, the nodes
+    // never move while building
+    mNodes.reserve(triangle_count * 2 - 1);
+    mNodes.emplace_back();
+    buildNode(0, 0, triangle_count, 0, tris);
+
+    mTriangles.resize(triangle_count);
+    for (U32 i = 0; i < triangle_count; ++i)
+    {
+        mTriangles[i] = tris[i].mIndex;
+    }
+}
+
+void LLVolumeBVH::buildNode(U32 node_index, U32 begin, U32 end, U32 depth, std::vector<BuildTri>& tris)
+{
+    LLVector4a bounds_min = tris[begin].mMin;
+    LLVector4a bounds_max = tris[begin].mMax;
+    LLVector4a centroid_min = tris[begin].mCentroid;
+    LLVector4a centroid_max = tris[begin].mCentroid;
+    for (U32 i = begin + 1; i < end; ++i)
+    {
+        bounds_min.setMin(bounds_min, tris[i].mMin);
+        bounds_max.setMax(bounds_max, tris[i].mMax);
+        centroid_min.setMin(centroid_min, tris[i].mCentroid);
+        centroid_max.setMax(centroid_max, tris[i].mCentroid);
+    }
+
+    Node& node = mNodes[node_index];
+    node.mMin = bounds_min;
+    node.mMax = bounds_max;
+    node.mFirst = begin;
+    node.mCount = end - begin;
+
+    const U32 count = end - begin;
+    if (count <= 1 || depth >= BVH_MAX_DEPTH)
+    {
+        return;
+    }
+
+    LLVector4a extent;
+    extent.setSub(centroid_max, centroid_min);
+    S32 axis = 0;
+    if (extent[1] > extent[axis])
+    {
+        axis = 1;
+    }
+    if (extent[2] > extent[axis])
+    {
+        axis = 2;
+    }
+    if (extent[axis] <= 0.f)
+    {
+        // all centroids coincide, no split separates them
+        return;
+    }
+
+    // bin the centroids along the widest axis
+    struct Bin
+    {
+        LLVector4a mMin;
+        LLVector4a mMax;
+        U32 mCount = 0;
+    };
+    Bin bins[BVH_BINS];
+
+    const F32 axis_min = centroid_min[axis];
+    const F32 scale = (F32)BVH_BINS / extent[axis];
+    auto bin_of = [&](const BuildTri& tri)
+    {
+        return llmin((U32)((tri.mCentroid[axis] - axis_min) * scale), BVH_BINS - 1);
+    };
+
+    for (U32 i = begin; i < end; ++i)
+    {
+        Bin& bin = bins[bin_of(tris[i])];
+        if (bin.mCount++ == 0)
+        {
+            bin.mMin = tris[i].mMin;
+            bin.mMax = tris[i].mMax;
+        }
+        else
+        {
+            bin.mMin.setMin(bin.mMin, tris[i].mMin);
+            bin.mMax.setMax(bin.mMax, tris[i].mMax);
+        }
+    }
+
+    // sweep from the right for the cost of everything above each split
+    F32 right_cost[BVH_BINS];
+    LLVector4a sweep_min, sweep_max;
+    U32 sweep_count = 0;
+    for (U32 i = BVH_BINS - 1; i > 0; --i)
+    {
+        const Bin& bin = bins[i];
+        if (bin.mCount)
+        {
+            if (sweep_count == 0)
+            {
+                sweep_min = bin.mMin;
+                sweep_max = bin.mMax;
+            }
+            else
+            {
+                sweep_min.setMin(sweep_min, bin.mMin);
+                sweep_max.setMax(sweep_max, bin.mMax);
+            }
+            sweep_count += bin.mCount;
+        }
+        right_cost[i] = sweep_count ? sweep_count * half_area(sweep_min, sweep_max) : 0.f;
+    }
+
+    // then from the left, splitting between bins split - 1 and split
+    U32 best_split = 0;
+    F32 best_cost = F32_MAX;
+    sweep_count = 0;
+    for (U32 split = 1; split < BVH_BINS; ++split)
+    {
+        const Bin& bin = bins[split - 1];
+        if (bin.mCount)
+        {
+            if (sweep_count == 0)
+            {
+                sweep_min = bin.mMin;
+                sweep_max = bin.mMax;
+            }
+            else
+            {
+                sweep_min.setMin(sweep_min, bin.mMin);
+                sweep_max.setMax(sweep_max, bin.mMax);
+            }
+            sweep_count += bin.mCount;
+        }
+        if (sweep_count == 0 || sweep_count == count)
+        {
+            continue;
+        }
+
+        const F32 cost = sweep_count * half_area(sweep_min, sweep_max) + right_cost[split];
+        if (cost < best_cost)
+        {
+            best_cost = cost;
+            best_split = split;
+        }
+    }
+
+    // cost of a split relative to testing every triangle here, counting
+    // a node visit as one triangle test
+    const F32 parent_area = half_area(bounds_min, bounds_max);
+    if (count <= BVH_MAX_LEAF
+        && (best_split == 0 || (parent_area > 0.f && 1.f + best_cost / parent_area >= (F32)count)))
+    {
+        return;
+    }
+
+    U32 mid = begin;
+    if (best_split)
+    {
+        mid = (U32)(std::partition(tris.begin() + begin, tris.begin() + end,
+                                   [&](const BuildTri& tri) { return bin_of(tri) < best_split; })
+                    - tris.begin());
+    }
+    if (mid == begin || mid == end)
+    {
+        mid = begin + count / 2;
+        std::nth_element(tris.begin() + begin, tris.begin() + mid, tris.begin() + end,
+                         [axis](const BuildTri& a, const BuildTri& b) { return a.mCentroid[axis] < b.mCentroid[axis]; });
+    }
+
+    const U32 left = (U32)mNodes.size();
+    mNodes.emplace_back();
+    buildNode(left, begin, mid, depth + 1, tris);
+
+    const U32 right = (U32)mNodes.size();
+    mNodes.emplace_back();
+    buildNode(right, mid, end, depth + 1, tris);
+
+    mNodes[node_index].mFirst = right;
+    mNodes[node_index].mCount = 0;
+}
+
+void LLVolumeBVH::refit(const LLVector4a* positions, const U16* indices)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_VOLUME;
+
+    // children always follow their parent
+    for (S32 i = (S32)mNodes.size() - 1; i >= 0; --i)
+    {
+        Node& node = mNodes[i];
+        if (node.mCount)
+        {
+            const U16* tri = indices + mTriangles[node.mFirst] * 3;
+            node.mMin = positions[tri[0]];
+            node.mMax = node.mMin;
+            for (U32 j = node.mFirst; j < node.mFirst + node.mCount; ++j)
+            {
+                tri = indices + mTriangles[j] * 3;
+                for (U32 k = 0; k < 3; ++k)
+                {
+                    node.mMin.setMin(node.mMin, positions[tri[k]]);
+                    node.mMax.setMax(node.mMax, positions[tri[k]]);
+                }
+            }
+        }
+        else
+        {
+            const Node& left = mNodes[i + 1];
+            const Node& right = mNodes[node.mFirst];
+            node.mMin.setMin(left.mMin, right.mMin);
+            node.mMax.setMax(left.mMax, right.mMax);
+        }
+    }
+}
+
+S32 LLVolumeBVH::intersect(const LLVector4a* positions, const U16* indices,
+                           const LLVector4a& start, const LLVector4a& dir,
+                           F32& closest_t, F32& a, F32& b) const
+{
+    if (mNodes.empty())
+    {
+        return -1;
+    }
+
+    // keep axis parallel segments out of inf * 0
+    LLVector4a inv_dir;
+    {
+        F32 inv[3];
+        for (S32 k = 0; k < 3; ++k)
+        {
+            F32 d = dir[k];
+            if (fabsf(d) < 1.e-20f)
+            {
+                d = d < 0.f ? -1.e-20f : 1.e-20f;
+            }
+            inv[k] = 1.f / d;
+        }
+        inv_dir.set(inv[0], inv[1], inv[2], 0.f);
+    }
+
+    F32 limit = llmin(closest_t, 1.f);
+
+    // entry t of the segment into node, false if it misses or enters past limit
+    auto enter = [&](const Node& node, F32& t_enter)
+    {
+        LLVector4a t0, t1, t_min, t_max;
+        t0.setSub(node.mMin, start);
+        t0.mul(inv_dir);
+        t1.setSub(node.mMax, start);
+        t1.mul(inv_dir);
+        t_min.setMin(t0, t1);
+        t_max.setMax(t0, t1);
+
+        t_enter = llmax(llmax(t_min[0], t_min[1]), llmax(t_min[2], 0.f));
+        const F32 t_exit = llmin(llmin(t_max[0], t_max[1]), llmin(t_max[2], limit));
+        return t_enter <= t_exit + BVH_T_EPSILON;
+    };
+
+    struct StackEntry
+    {
+        U32 mNode;
+        F32 mEnter;
+    };
+    StackEntry stack[BVH_STACK_SIZE];
+    U32 stack_size = 0;
+
+    F32 t_enter;
+    if (!enter(mNodes[0], t_enter))
+    {
+        return -1;
+    }
+    stack[stack_size++] = { 0, t_enter };
+
+    S32 hit = -1;
+    while (stack_size)
+    {
+        const StackEntry entry = stack[--stack_size];
+        if (entry.mEnter > limit + BVH_T_EPSILON)
+        {
+            // a closer hit was found since this node was pushed
+            continue;
+        }
+
+        const Node& node = mNodes[entry.mNode];
+        if (node.mCount)
+        {
+            for (U32 j = node.mFirst; j < node.mFirst + node.mCount; ++j)
+            {
+                const U32 tri = mTriangles[j];
+                const U16* idx = indices + tri * 3;
+
+                F32 tri_a, tri_b, t;
+                if (LLTriangleRayIntersect(positions[idx[0]], positions[idx[1]], positions[idx[2]],
+                                           start, dir, tri_a, tri_b, t))
+                {
+                    if (t >= 0.f && t <= 1.f && t < closest_t)
+                    {
+                        closest_t = t;
+                        limit = t;
+                        a = tri_a;
+                        b = tri_b;
+                        hit = (S32)tri;
+                    }
+                }
+            }
+            continue;
+        }
+
+        const U32 left = entry.mNode + 1;
+        const U32 right = node.mFirst;
+        F32 t_left, t_right;
+        const bool hit_left = enter(mNodes[left], t_left);
+        const bool hit_right = enter(mNodes[right], t_right);
+
+        llassert(stack_size + 2 <= BVH_STACK_SIZE);
+        if (hit_left && hit_right)
+        {
+            // nearer child on top
+            if (t_left <= t_right)
+            {
+                stack[stack_size++] = { right, t_right };
+                stack[stack_size++] = { left, t_left };
+            }
+            else
+            {
+                stack[stack_size++] = { left, t_left };
+                stack[stack_size++] = { right, t_right };
+            }
+        }
+        else if (hit_left)
+        {
+            stack[stack_size++] = { left, t_left };
+        }
+        else if (hit_right)
+        {
+            stack[stack_size++] = { right, t_right };
+        }
+    }
+
+    return hit;
+}
+
+size_t LLVolumeBVH::getMemoryUsage() const
+{
+    return mNodes.capacity() * sizeof(Node) + mTriangles.capacity() * sizeof(U32);
+}
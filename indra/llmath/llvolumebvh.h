@@ -0,0 +1,80 @@
+/**
+ * @file llvolumebvh.h
+ * @brief Flat bounding volume hierarchy over the triangles of a volume face
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLVOLUMEBVH_H
+#define LL_LLVOLUMEBVH_H
+
+#include "llvector4a.h"
+
+#include <vector>
+
+// Raycast acceleration for LLVolumeFace, an alternative to LLVolumeOctree.
+//
+// Nodes live in one array in depth first order: an interior node's left
+// child directly follows it and mFirst holds the right child, a leaf's
+// mFirst and mCount index a run of mTriangles.  The tree is built with
+// binned surface area heuristic splits.  Positions and indices are not
+// copied, callers pass the face arrays the tree was built from.
+class LLVolumeBVH
+{
+public:
+    void build(const LLVector4a* positions, const U16* indices, U32 triangle_count);
+
+    // Recompute the node bounds after positions moved (rigged faces)
+    // without changing the tree.  Same indices as build().
+    void refit(const LLVector4a* positions, const U16* indices);
+
+    // Closest triangle hit by the segment start + t * dir with t in
+    // [0, 1] and t < closest_t, same test as LLOctreeTriangleRayIntersect.
+    // Returns the triangle index and updates closest_t and the
+    // barycentric a and b of the hit, or returns -1.
+    S32 intersect(const LLVector4a* positions, const U16* indices,
+                  const LLVector4a& start, const LLVector4a& dir,
+                  F32& closest_t, F32& a, F32& b) const;
+
+    bool isEmpty() const { return mNodes.empty(); }
+    U32 getTriangleCount() const { return (U32)mTriangles.size(); }
+    U32 getNodeCount() const { return (U32)mNodes.size(); }
+    size_t getMemoryUsage() const;
+
+private:
+    struct alignas(16) Node
+    {
+        LLVector4a mMin;
+        LLVector4a mMax;
+        U32 mFirst;     // right child, or first entry of mTriangles
+        U32 mCount;     // triangles in a leaf, 0 for interior nodes
+    };
+
+    struct BuildTri;
+
+    void buildNode(U32 node_index, U32 begin, U32 end, U32 depth, std::vector<BuildTri>& tris);
+
+    std::vector<Node> mNodes;
+    std::vector<U32> mTriangles;
+};
+
+#endif // LL_LLVOLUMEBVH_H
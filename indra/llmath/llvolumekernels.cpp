@@ -0,0 +1,678 @@
+/**
+ * @file llvolumekernels.cpp
+ * @brief Batched LLVolumeFace kernels and the vertex transforms of LLFace::getGeometryVolume()
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+#include "llmemory.h"
+#include "llmath.h"
+
+#include "llvolumekernels.h"
+#include "llmatrix4a.h"
+#include "llvolume.h"
+#include "m4math.h"
+#include "v2math.h"
+
+namespace
+{
+
+// Gather corner k of four consecutive triangles into x[k], y[k], z[k]
+inline void load_triangles_soa(const LLVector4a* positions, const U16* idx, LLQuad* x, LLQuad* y, LLQuad* z)
+{
+    for (S32 k = 0; k < 3; ++k)
+    {
+        LLQuad r0 = positions[idx[k]];
+        LLQuad r1 = positions[idx[3 + k]];
+        LLQuad r2 = positions[idx[6 + k]];
+        LLQuad r3 = positions[idx[9 + k]];
+        _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+        x[k] = r0;
+        y[k] = r1;
+        z[k] = r2;
+    }
+}
+
+// Same for texture coordinates
+inline void load_texcoords_soa(const LLVector2* texcoord, const U16* idx, LLQuad* s, LLQuad* t)
+{
+    for (S32 k = 0; k < 3; ++k)
+    {
+        const LLVector2& w0 = texcoord[idx[k]];
+        const LLVector2& w1 = texcoord[idx[3 + k]];
+        const LLVector2& w2 = texcoord[idx[6 + k]];
+        const LLVector2& w3 = texcoord[idx[9 + k]];
+        s[k] = _mm_setr_ps(w0.mV[0], w1.mV[0], w2.mV[0], w3.mV[0]);
+        t[k] = _mm_setr_ps(w0.mV[1], w1.mV[1], w2.mV[1], w3.mV[1]);
+    }
+}
+
+inline void load_vertices_soa(const LLVector4a* v, LLQuad& x, LLQuad& y, LLQuad& z)
+{
+    LLQuad w = v[3];
+    x = v[0];
+    y = v[1];
+    z = v[2];
+    _MM_TRANSPOSE4_PS(x, y, z, w);
+}
+
+//adapted from Lengyel, Eric. "Computing Tangent Space Basis Vectors for an Arbitrary Mesh". Terathon Software 3D Graphics Library, 2001. http://www.terathon.com/code/tangent.html
+inline void accumulate_triangle_tangents(const LLVector4a* vertex, const LLVector2* texcoord, const U16* idx,
+                                         LLVector4a* tan1, LLVector4a* tan2)
+{
+    U32 i1 = idx[0];
+    U32 i2 = idx[1];
+    U32 i3 = idx[2];
+
+    const F32* v1ptr = vertex[i1].getF32ptr();
+    const F32* v2ptr = vertex[i2].getF32ptr();
+    const F32* v3ptr = vertex[i3].getF32ptr();
+
+    const LLVector2& w1 = texcoord[i1];
+    const LLVector2& w2 = texcoord[i2];
+    const LLVector2& w3 = texcoord[i3];
+
+    float x1 = v2ptr[0] - v1ptr[0];
+    float x2 = v3ptr[0] - v1ptr[0];
+    float y1 = v2ptr[1] - v1ptr[1];
+    float y2 = v3ptr[1] - v1ptr[1];
+    float z1 = v2ptr[2] - v1ptr[2];
+    float z2 = v3ptr[2] - v1ptr[2];
+
+    float s1 = w2.mV[0] - w1.mV[0];
+    float s2 = w3.mV[0] - w1.mV[0];
+    float t1 = w2.mV[1] - w1.mV[1];
+    float t2 = w3.mV[1] - w1.mV[1];
+
+    F32 rd = s1*t2-s2*t1;
+
+    float r = ((rd*rd) > FLT_EPSILON) ? (1.0f / rd)
+                                      : ((rd > 0.0f) ? 1024.f : -1024.f); //some made up large ratio for division by zero
+
+    llassert(llfinite(r));
+    llassert(!llisnan(r));
+
+    LLVector4a sdir((t2 * x1 - t1 * x2) * r, (t2 * y1 - t1 * y2) * r,
+            (t2 * z1 - t1 * z2) * r);
+    LLVector4a tdir((s1 * x2 - s2 * x1) * r, (s1 * y2 - s2 * y1) * r,
+            (s1 * z2 - s2 * z1) * r);
+
+    tan1[i1].add(sdir);
+    tan1[i2].add(sdir);
+    tan1[i3].add(sdir);
+
+    tan2[i1].add(tdir);
+    tan2[i2].add(tdir);
+    tan2[i3].add(tdir);
+}
+
+inline void orthogonalize_tangent(const LLVector4a& normal, const LLVector4a& t, const LLVector4a& b, LLVector4a& tangent)
+{
+    LLVector4a n = normal;
+
+    LLVector4a ncrosst;
+    ncrosst.setCross3(n,t);
+
+    // Gram-Schmidt orthogonalize
+    n.mul(n.dot3(t).getF32());
+
+    LLVector4a tsubn;
+    tsubn.setSub(t,n);
+
+    if (tsubn.dot3(tsubn).getF32() > F_APPROXIMATELY_ZERO)
+    {
+        tsubn.normalize3fast();
+
+        // Calculate handedness
+        F32 handedness = ncrosst.dot3(b).getF32() < 0.f ? -1.f : 1.f;
+
+        tsubn.getF32ptr()[3] = handedness;
+
+        tangent = tsubn;
+    }
+    else
+    { //degenerate, make up a value
+        tangent.set(0,0,1,1);
+    }
+}
+
+// Same as planarProjection() in llface.cpp
+inline void planar_projection(LLVector2& tc, const LLVector4a& normal, const LLVector4a& vec)
+{
+    LLVector4a binormal;
+    F32 d = normal[0];
+
+    if (d >= 0.5f || d <= -0.5f)
+    {
+        binormal.set(0.f, d < 0 ? -1.f : 1.f, 0.f);
+    }
+    else
+    {
+        binormal.set(normal[1] > 0 ? -1.f : 1.f, 0.f, 0.f);
+    }
+    LLVector4a tangent;
+    tangent.setCross3(binormal, normal);
+
+    tc.mV[1] = -((tangent.dot3(vec).getF32()) * 2 - 0.5f);
+    tc.mV[0] = 1.0f + ((binormal.dot3(vec).getF32()) * 2 - 0.5f);
+}
+
+// s' = (a s + b t) + c in the order the scalar transform rounds
+inline LLQuad affine_soa(const F32* row, const LLQuad& s, const LLQuad& t)
+{
+    return _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(row[0]), s), _mm_mul_ps(_mm_set1_ps(row[1]), t)),
+                      _mm_set1_ps(row[2]));
+}
+
+} // anonymous namespace
+
+void LLCalculateTriangleNormals(const LLVector4a* positions, const U16* indices, U32 triangle_count, LLVector4a* normals)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_VOLUME;
+
+    const U32 batched = triangle_count & ~3U;
+    const LLQuad zero = _mm_setzero_ps();
+
+    const U16* idx = indices;
+    for (U32 i = 0; i < batched; i += 4, idx += 12)
+    {
+        LLQuad x[3], y[3], z[3];
+        load_triangles_soa(positions, idx, x, y, z);
+
+        const LLQuad ax = _mm_sub_ps(x[0], x[1]);
+        const LLQuad ay = _mm_sub_ps(y[0], y[1]);
+        const LLQuad az = _mm_sub_ps(z[0], z[1]);
+        const LLQuad bx = _mm_sub_ps(x[0], x[2]);
+        const LLQuad by = _mm_sub_ps(y[0], y[2]);
+        const LLQuad bz = _mm_sub_ps(z[0], z[2]);
+
+        LLQuad nx = _mm_sub_ps(_mm_mul_ps(ay, bz), _mm_mul_ps(az, by));
+        LLQuad ny = _mm_sub_ps(_mm_mul_ps(az, bx), _mm_mul_ps(ax, bz));
+        LLQuad nz = _mm_sub_ps(_mm_mul_ps(ax, by), _mm_mul_ps(ay, bx));
+        LLQuad nw = zero;
+        _MM_TRANSPOSE4_PS(nx, ny, nz, nw);
+
+        normals[i] = nx;
+        normals[i + 1] = ny;
+        normals[i + 2] = nz;
+        normals[i + 3] = nw;
+    }
+
+    LLCalculateTriangleNormalsScalar(positions, idx, triangle_count - batched, normals + batched);
+}
+
+void LLCalculateTriangleNormalsScalar(const LLVector4a* positions, const U16* indices, U32 triangle_count, LLVector4a* normals)
+{
+    const U16* idx = indices;
+    for (U32 i = 0; i < triangle_count; ++i, idx += 3)
+    {
+        LLVector4a a, b;
+        a.setSub(positions[idx[0]], positions[idx[1]]);
+        b.setSub(positions[idx[0]], positions[idx[2]]);
+
+        LLVector4a& n = normals[i];
+        n.setCross3(a, b);
+        n.getF32ptr()[3] = 0.f;
+
+        llassert(n.isFinite3());
+    }
+}
+
+void LLCalculateExtents(const LLVector4a* positions, U32 count, LLVector4a& min, LLVector4a& max)
+{
+    llassert(count > 0);
+
+    // Four independent accumulators so the min/max chains don't
+    // serialize on each other
+    LLQuad min0 = positions[0];
+    LLQuad max0 = min0;
+    LLQuad min1 = min0, min2 = min0, min3 = min0;
+    LLQuad max1 = min0, max2 = min0, max3 = min0;
+
+    const U32 batched = count & ~3U;
+    for (U32 i = 0; i < batched; i += 4)
+    {
+        const LLQuad p0 = positions[i];
+        const LLQuad p1 = positions[i + 1];
+        const LLQuad p2 = positions[i + 2];
+        const LLQuad p3 = positions[i + 3];
+        min0 = _mm_min_ps(min0, p0);
+        max0 = _mm_max_ps(max0, p0);
+        min1 = _mm_min_ps(min1, p1);
+        max1 = _mm_max_ps(max1, p1);
+        min2 = _mm_min_ps(min2, p2);
+        max2 = _mm_max_ps(max2, p2);
+        min3 = _mm_min_ps(min3, p3);
+        max3 = _mm_max_ps(max3, p3);
+    }
+
+    for (U32 i = batched; i < count; ++i)
+    {
+        min0 = _mm_min_ps(min0, positions[i]);
+        max0 = _mm_max_ps(max0, positions[i]);
+    }
+
+    min = _mm_min_ps(_mm_min_ps(min0, min1), _mm_min_ps(min2, min3));
+    max = _mm_max_ps(_mm_max_ps(max0, max1), _mm_max_ps(max2, max3));
+}
+
+void LLCalculateExtentsScalar(const LLVector4a* positions, U32 count, LLVector4a& min, LLVector4a& max)
+{
+    llassert(count > 0);
+
+    min = max = positions[0];
+    for (U32 i = 1; i < count; ++i)
+    {
+        update_min_max(min, max, positions[i]);
+    }
+}
+
+void LLCalculateTangentArray(U32 vertexCount, const LLVector4a *vertex, const LLVector4a *normal,
+        const LLVector2 *texcoord, U32 triangleCount, const U16* index_array, LLVector4a *tangent)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_VOLUME;
+
+    LLVector4a* tan1 = (LLVector4a*) ll_aligned_malloc_16(vertexCount*2*sizeof(LLVector4a));
+    LLVector4a* tan2 = tan1 + vertexCount;
+
+    U32 count = vertexCount * 2;
+    for (U32 i = 0; i < count; i++)
+    {
+        tan1[i].clear();
+    }
+
+    const LLQuad zero = _mm_setzero_ps();
+    const LLQuad one = _mm_set1_ps(1.f);
+    const LLQuad sign = _mm_set1_ps(-0.f);
+    const LLQuad epsilon = _mm_set1_ps(FLT_EPSILON);
+    const LLQuad degenerate_ratio = _mm_set1_ps(1024.f); // some made up large ratio for division by zero
+
+    // Per triangle texture space directions, four triangles at a time.
+    // Accumulation is done in triangle order, same as the scalar path.
+    const U32 batched_triangles = triangleCount & ~3U;
+    const U16* idx = index_array;
+    for (U32 a = 0; a < batched_triangles; a += 4, idx += 12)
+    {
+        LLQuad x[3], y[3], z[3];
+        load_triangles_soa(vertex, idx, x, y, z);
+
+        LLQuad s[3], t[3];
+        load_texcoords_soa(texcoord, idx, s, t);
+
+        const LLQuad x1 = _mm_sub_ps(x[1], x[0]);
+        const LLQuad x2 = _mm_sub_ps(x[2], x[0]);
+        const LLQuad y1 = _mm_sub_ps(y[1], y[0]);
+        const LLQuad y2 = _mm_sub_ps(y[2], y[0]);
+        const LLQuad z1 = _mm_sub_ps(z[1], z[0]);
+        const LLQuad z2 = _mm_sub_ps(z[2], z[0]);
+
+        const LLQuad s1 = _mm_sub_ps(s[1], s[0]);
+        const LLQuad s2 = _mm_sub_ps(s[2], s[0]);
+        const LLQuad t1 = _mm_sub_ps(t[1], t[0]);
+        const LLQuad t2 = _mm_sub_ps(t[2], t[0]);
+
+        const LLQuad rd = _mm_sub_ps(_mm_mul_ps(s1, t2), _mm_mul_ps(s2, t1));
+        const LLQuad valid = _mm_cmpgt_ps(_mm_mul_ps(rd, rd), epsilon);
+        const LLQuad fallback = _mm_or_ps(degenerate_ratio, _mm_andnot_ps(_mm_cmpgt_ps(rd, zero), sign));
+        const LLQuad r = _mm_or_ps(_mm_and_ps(valid, _mm_div_ps(one, rd)), _mm_andnot_ps(valid, fallback));
+
+        LLQuad sx = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(t2, x1), _mm_mul_ps(t1, x2)), r);
+        LLQuad sy = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(t2, y1), _mm_mul_ps(t1, y2)), r);
+        LLQuad sz = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(t2, z1), _mm_mul_ps(t1, z2)), r);
+        LLQuad sw = zero;
+        _MM_TRANSPOSE4_PS(sx, sy, sz, sw);
+
+        LLQuad tx = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(s1, x2), _mm_mul_ps(s2, x1)), r);
+        LLQuad ty = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(s1, y2), _mm_mul_ps(s2, y1)), r);
+        LLQuad tz = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(s1, z2), _mm_mul_ps(s2, z1)), r);
+        LLQuad tw = zero;
+        _MM_TRANSPOSE4_PS(tx, ty, tz, tw);
+
+        const LLQuad sdir[4] = { sx, sy, sz, sw };
+        const LLQuad tdir[4] = { tx, ty, tz, tw };
+        for (S32 j = 0; j < 4; ++j)
+        {
+            for (S32 k = 0; k < 3; ++k)
+            {
+                LLVector4a& t1v = tan1[idx[3 * j + k]];
+                t1v = _mm_add_ps(t1v, sdir[j]);
+            }
+            for (S32 k = 0; k < 3; ++k)
+            {
+                LLVector4a& t2v = tan2[idx[3 * j + k]];
+                t2v = _mm_add_ps(t2v, tdir[j]);
+            }
+        }
+    }
+
+    for (U32 a = batched_triangles; a < triangleCount; a++, idx += 3)
+    {
+        accumulate_triangle_tangents(vertex, texcoord, idx, tan1, tan2);
+    }
+
+    // Gram-Schmidt orthogonalize and work out handedness, four vertices
+    // at a time
+    const LLQuad threshold = _mm_set1_ps(F_APPROXIMATELY_ZERO);
+    const U32 batched_vertices = vertexCount & ~3U;
+    for (U32 a = 0; a < batched_vertices; a += 4)
+    {
+        LLQuad nx, ny, nz;
+        load_vertices_soa(normal + a, nx, ny, nz);
+        LLQuad tx, ty, tz;
+        load_vertices_soa(tan1 + a, tx, ty, tz);
+        LLQuad bx, by, bz;
+        load_vertices_soa(tan2 + a, bx, by, bz);
+
+        // n x t
+        const LLQuad cx = _mm_sub_ps(_mm_mul_ps(ny, tz), _mm_mul_ps(nz, ty));
+        const LLQuad cy = _mm_sub_ps(_mm_mul_ps(nz, tx), _mm_mul_ps(nx, tz));
+        const LLQuad cz = _mm_sub_ps(_mm_mul_ps(nx, ty), _mm_mul_ps(ny, tx));
+
+        // t - n * (n . t)
+        const LLQuad d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, tx), _mm_mul_ps(ny, ty)), _mm_mul_ps(nz, tz));
+        LLQuad ux = _mm_sub_ps(tx, _mm_mul_ps(nx, d));
+        LLQuad uy = _mm_sub_ps(ty, _mm_mul_ps(ny, d));
+        LLQuad uz = _mm_sub_ps(tz, _mm_mul_ps(nz, d));
+
+        const LLQuad len_sqrd = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ux, ux), _mm_mul_ps(uy, uy)), _mm_mul_ps(uz, uz));
+        const LLQuad ok = _mm_cmpgt_ps(len_sqrd, threshold);
+        const LLQuad rsqrt = _mm_rsqrt_ps(len_sqrd);
+
+        const LLQuad h = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, bx), _mm_mul_ps(cy, by)), _mm_mul_ps(cz, bz));
+        const LLQuad handedness = _mm_or_ps(one, _mm_and_ps(_mm_cmplt_ps(h, zero), sign));
+
+        // degenerate lanes get made up value (0,0,1,1)
+        ux = _mm_and_ps(ok, _mm_mul_ps(ux, rsqrt));
+        uy = _mm_and_ps(ok, _mm_mul_ps(uy, rsqrt));
+        uz = _mm_or_ps(_mm_and_ps(ok, _mm_mul_ps(uz, rsqrt)), _mm_andnot_ps(ok, one));
+        LLQuad uw = _mm_or_ps(_mm_and_ps(ok, handedness), _mm_andnot_ps(ok, one));
+        _MM_TRANSPOSE4_PS(ux, uy, uz, uw);
+
+        tangent[a] = ux;
+        tangent[a + 1] = uy;
+        tangent[a + 2] = uz;
+        tangent[a + 3] = uw;
+    }
+
+    for (U32 a = batched_vertices; a < vertexCount; a++)
+    {
+        orthogonalize_tangent(normal[a], tan1[a], tan2[a], tangent[a]);
+    }
+
+    ll_aligned_free_16(tan1);
+}
+
+void LLCalculateTangentArrayScalar(U32 vertexCount, const LLVector4a *vertex, const LLVector4a *normal,
+        const LLVector2 *texcoord, U32 triangleCount, const U16* index_array, LLVector4a *tangent)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_VOLUME;
+
+    LLVector4a* tan1 = (LLVector4a*) ll_aligned_malloc_16(vertexCount*2*sizeof(LLVector4a));
+    LLVector4a* tan2 = tan1 + vertexCount;
+
+    U32 count = vertexCount * 2;
+    for (U32 i = 0; i < count; i++)
+    {
+        tan1[i].clear();
+    }
+
+    for (U32 a = 0; a < triangleCount; a++, index_array += 3)
+    {
+        accumulate_triangle_tangents(vertex, texcoord, index_array, tan1, tan2);
+    }
+
+    for (U32 a = 0; a < vertexCount; a++)
+    {
+        orthogonalize_tangent(normal[a], tan1[a], tan2[a], tangent[a]);
+    }
+
+    ll_aligned_free_16(tan1);
+}
+
+void LLTexCoordTransform::setIdentity()
+{
+    mS[0] = 1.f; mS[1] = 0.f; mS[2] = 0.f;
+    mT[0] = 0.f; mT[1] = 1.f; mT[2] = 0.f;
+}
+
+void LLTexCoordTransform::setRotateScaleOffset(F32 cos_ang, F32 sin_ang, F32 offset_s, F32 offset_t, F32 repeat_s, F32 repeat_t)
+{
+    // s' = repeat_s ((s - .5) cos + (t - .5) sin) + offset_s + .5
+    // t' = repeat_t ((t - .5) cos - (s - .5) sin) + offset_t + .5
+    mS[0] = repeat_s * cos_ang;
+    mS[1] = repeat_s * sin_ang;
+    mS[2] = offset_s + 0.5f - 0.5f * repeat_s * (cos_ang + sin_ang);
+    mT[0] = -repeat_t * sin_ang;
+    mT[1] = repeat_t * cos_ang;
+    mT[2] = offset_t + 0.5f - 0.5f * repeat_t * (cos_ang - sin_ang);
+}
+
+void LLTexCoordTransform::setMatrix(const LLMatrix4& mat)
+{
+    mS[0] = mat.mMatrix[VX][VX];
+    mS[1] = mat.mMatrix[VY][VX];
+    mS[2] = mat.mMatrix[VW][VX];
+    mT[0] = mat.mMatrix[VX][VY];
+    mT[1] = mat.mMatrix[VY][VY];
+    mT[2] = mat.mMatrix[VW][VY];
+}
+
+bool LLTexCoordTransform::isIdentity() const
+{
+    return mS[0] == 1.f && mS[1] == 0.f && mS[2] == 0.f &&
+           mT[0] == 0.f && mT[1] == 1.f && mT[2] == 0.f;
+}
+
+void LLTexCoordTransform::transform(LLVector2& tc) const
+{
+    const F32 s = tc.mV[0];
+    const F32 t = tc.mV[1];
+    tc.mV[0] = (mS[0] * s + mS[1] * t) + mS[2];
+    tc.mV[1] = (mT[0] * s + mT[1] * t) + mT[2];
+}
+
+void LLTransformPositions(const LLMatrix4a& mat, const LLVector4a* src, U32 count, F32 w, LLVector4a* dst)
+{
+    const LLQuad r0 = mat.mMatrix[0];
+    const LLQuad r1 = mat.mMatrix[1];
+    const LLQuad r2 = mat.mMatrix[2];
+    const LLQuad r3 = mat.mMatrix[3];
+    const LLQuad xyz = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+    const LLQuad wq = _mm_setr_ps(0.f, 0.f, 0.f, w);
+
+    // Four independent vertices per pass, with the matrix held in
+    // registers across the whole face
+    const U32 batched = count & ~3U;
+    for (U32 i = 0; i < batched; i += 4)
+    {
+        for (U32 j = 0; j < 4; ++j)
+        {
+            const LLQuad v = src[i + j];
+            const LLQuad x = _mm_mul_ps(_mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0)), r0);
+            const LLQuad y = _mm_mul_ps(_mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1)), r1);
+            const LLQuad z = _mm_mul_ps(_mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2)), r2);
+            const LLQuad res = _mm_add_ps(_mm_add_ps(x, y), _mm_add_ps(z, r3));
+            dst[i + j] = _mm_or_ps(_mm_and_ps(res, xyz), wq);
+        }
+    }
+
+    LLTransformPositionsScalar(mat, src + batched, count - batched, w, dst + batched);
+}
+
+void LLTransformPositionsScalar(const LLMatrix4a& mat, const LLVector4a* src, U32 count, F32 w, LLVector4a* dst)
+{
+    LLVector4Logical mask;
+    mask.clear();
+    mask.setElement<3>();
+
+    LLVector4a tex_idx;
+    tex_idx.set(0.f, 0.f, 0.f, w);
+
+    for (U32 i = 0; i < count; ++i)
+    {
+        LLVector4a res;
+        mat.affineTransform(src[i], res);
+        dst[i].setSelectWithMask(mask, tex_idx, res);
+    }
+}
+
+void LLRotateVectors(const LLMatrix4a& mat, const LLVector4a* src, U32 count, bool keep_w, LLVector4a* dst)
+{
+    const LLQuad r0 = mat.mMatrix[0];
+    const LLQuad r1 = mat.mMatrix[1];
+    const LLQuad r2 = mat.mMatrix[2];
+    const LLQuad xyz = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, keep_w ? 0 : -1));
+
+    const U32 batched = count & ~3U;
+    for (U32 i = 0; i < batched; i += 4)
+    {
+        for (U32 j = 0; j < 4; ++j)
+        {
+            const LLQuad v = src[i + j];
+            const LLQuad x = _mm_mul_ps(_mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0)), r0);
+            const LLQuad y = _mm_mul_ps(_mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1)), r1);
+            const LLQuad z = _mm_mul_ps(_mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2)), r2);
+            const LLQuad res = _mm_add_ps(_mm_add_ps(x, y), z);
+            dst[i + j] = _mm_or_ps(_mm_and_ps(res, xyz), _mm_andnot_ps(xyz, v));
+        }
+    }
+
+    LLRotateVectorsScalar(mat, src + batched, count - batched, keep_w, dst + batched);
+}
+
+void LLRotateVectorsScalar(const LLMatrix4a& mat, const LLVector4a* src, U32 count, bool keep_w, LLVector4a* dst)
+{
+    LLVector4Logical mask;
+    mask.clear();
+    mask.setElement<3>();
+
+    for (U32 i = 0; i < count; ++i)
+    {
+        LLVector4a res;
+        mat.rotate(src[i], res);
+        if (keep_w)
+        {
+            res.setSelectWithMask(mask, src[i], res);
+        }
+        dst[i] = res;
+    }
+}
+
+void LLTransformTexCoords(const LLTexCoordTransform& xform, const LLVector2* src, U32 count, LLVector2* dst)
+{
+    // Coordinates go two to a quad as <s0, t0, s1, t1>, so
+    // res = st * <a, e, a, e> + ts * <b, d, b, d> + <c, f, c, f>
+    const LLQuad diag = _mm_setr_ps(xform.mS[0], xform.mT[1], xform.mS[0], xform.mT[1]);
+    const LLQuad cross = _mm_setr_ps(xform.mS[1], xform.mT[0], xform.mS[1], xform.mT[0]);
+    const LLQuad offset = _mm_setr_ps(xform.mS[2], xform.mT[2], xform.mS[2], xform.mT[2]);
+
+    const F32* in = reinterpret_cast<const F32*>(src);
+    F32* out = reinterpret_cast<F32*>(dst);
+    const U32 batched = count & ~3U;
+    for (U32 i = 0; i < batched; i += 4, in += 8, out += 8)
+    {
+        const LLQuad st0 = _mm_loadu_ps(in);
+        const LLQuad st1 = _mm_loadu_ps(in + 4);
+        const LLQuad ts0 = _mm_shuffle_ps(st0, st0, _MM_SHUFFLE(2, 3, 0, 1));
+        const LLQuad ts1 = _mm_shuffle_ps(st1, st1, _MM_SHUFFLE(2, 3, 0, 1));
+        _mm_storeu_ps(out, _mm_add_ps(_mm_add_ps(_mm_mul_ps(diag, st0), _mm_mul_ps(cross, ts0)), offset));
+        _mm_storeu_ps(out + 4, _mm_add_ps(_mm_add_ps(_mm_mul_ps(diag, st1), _mm_mul_ps(cross, ts1)), offset));
+    }
+
+    LLTransformTexCoordsScalar(xform, src + batched, count - batched, dst + batched);
+}
+
+void LLTransformTexCoordsScalar(const LLTexCoordTransform& xform, const LLVector2* src, U32 count, LLVector2* dst)
+{
+    for (U32 i = 0; i < count; ++i)
+    {
+        LLVector2 tc(src[i]);
+        xform.transform(tc);
+        dst[i] = tc;
+    }
+}
+
+void LLPlanarTexCoords(const LLTexCoordTransform& xform, const LLVector4a* positions, const LLVector4a* normals,
+                       const LLVector4a& scale, U32 count, LLVector2* dst)
+{
+    const LLQuad zero = _mm_setzero_ps();
+    const LLQuad one = _mm_set1_ps(1.f);
+    const LLQuad two = _mm_set1_ps(2.f);
+    const LLQuad half = _mm_set1_ps(0.5f);
+    const LLQuad sign = _mm_set1_ps(-0.f);
+
+    F32* out = reinterpret_cast<F32*>(dst);
+    const U32 batched = count & ~3U;
+    for (U32 i = 0; i < batched; i += 4, out += 8)
+    {
+        LLVector4a vec[4];
+        for (U32 j = 0; j < 4; ++j)
+        {
+            vec[j].setMul(positions[i + j], scale);
+        }
+
+        LLQuad px, py, pz, nx, ny, nz;
+        load_vertices_soa(vec, px, py, pz);
+        load_vertices_soa(normals + i, nx, ny, nz);
+
+        // The binormal is <0, +-1, 0> for faces pointing along x, else
+        // <-+1, 0, 0>, and the tangent is binormal x normal
+        const LLQuad along_x = _mm_cmpge_ps(_mm_andnot_ps(sign, nx), half);
+        const LLQuad sign_x = _mm_or_ps(one, _mm_and_ps(_mm_cmplt_ps(nx, zero), sign));
+        const LLQuad sign_y = _mm_or_ps(one, _mm_and_ps(_mm_cmpgt_ps(ny, zero), sign));
+        const LLQuad bx = _mm_andnot_ps(along_x, sign_y);
+        const LLQuad by = _mm_and_ps(along_x, sign_x);
+
+        const LLQuad tx = _mm_mul_ps(by, nz);
+        const LLQuad ty = _mm_sub_ps(zero, _mm_mul_ps(bx, nz));
+        const LLQuad tz = _mm_sub_ps(_mm_mul_ps(bx, ny), _mm_mul_ps(by, nx));
+
+        const LLQuad b_dot = _mm_add_ps(_mm_mul_ps(bx, px), _mm_mul_ps(by, py));
+        const LLQuad t_dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(tx, px), _mm_mul_ps(ty, py)), _mm_mul_ps(tz, pz));
+
+        const LLQuad u = _mm_add_ps(one, _mm_sub_ps(_mm_mul_ps(b_dot, two), half));
+        const LLQuad v = _mm_xor_ps(sign, _mm_sub_ps(_mm_mul_ps(t_dot, two), half));
+
+        const LLQuad s = affine_soa(xform.mS, u, v);
+        const LLQuad t = affine_soa(xform.mT, u, v);
+        _mm_storeu_ps(out, _mm_unpacklo_ps(s, t));
+        _mm_storeu_ps(out + 4, _mm_unpackhi_ps(s, t));
+    }
+
+    LLPlanarTexCoordsScalar(xform, positions + batched, normals + batched, scale, count - batched, dst + batched);
+}
+
+void LLPlanarTexCoordsScalar(const LLTexCoordTransform& xform, const LLVector4a* positions, const LLVector4a* normals,
+                             const LLVector4a& scale, U32 count, LLVector2* dst)
+{
+    for (U32 i = 0; i < count; ++i)
+    {
+        LLVector4a vec;
+        vec.setMul(positions[i], scale);
+
+        LLVector2 tc;
+        planar_projection(tc, normals[i], vec);
+        xform.transform(tc);
+        dst[i] = tc;
+    }
+}
@@ -0,0 +1,113 @@
+/**
+ * @file llvolumekernels.h
+ * @brief Batched LLVolumeFace kernels and the vertex transforms of LLFace::getGeometryVolume()
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLVOLUMEKERNELS_H
+#define LL_LLVOLUMEKERNELS_H
+
+#include "llvector4a.h"
+
+class LLMatrix4;
+class LLMatrix4a;
+class LLVector2;
+
+// These run for every prim rebuild and every mesh LOD load.  The batched
+// versions gather four triangles (or vertices) at a time, transpose them
+// to structure-of-arrays form and do the math in LLQuad lanes (SSE2, or
+// NEON through sse2neon); the remainder of a batch goes through the scalar
+// path.  The scalar versions are the reference the batched ones are
+// checked and benchmarked against, see llvolumekernels_libtest.
+//
+// Results match the scalar versions exactly, except for tangents where
+// the reciprocal square root estimate may differ in the last bits.
+
+// Unnormalized face normal (v0 - v1) x (v0 - v2) of each triangle in an
+// index list.  w is zero.
+void LLCalculateTriangleNormals(const LLVector4a* positions, const U16* indices, U32 triangle_count, LLVector4a* normals);
+void LLCalculateTriangleNormalsScalar(const LLVector4a* positions, const U16* indices, U32 triangle_count, LLVector4a* normals);
+
+// Component-wise min and max over count positions.  count must be > 0.
+void LLCalculateExtents(const LLVector4a* positions, U32 count, LLVector4a& min, LLVector4a& max);
+void LLCalculateExtentsScalar(const LLVector4a* positions, U32 count, LLVector4a& min, LLVector4a& max);
+
+// Batched implementation of LLCalculateTangentArray() (declared in
+// llvolume.h) and its scalar reference.
+void LLCalculateTangentArrayScalar(U32 vertexCount, const LLVector4a *vertex, const LLVector4a *normal,
+                                   const LLVector2 *texcoord, U32 triangleCount, const U16* index_array, LLVector4a *tangent);
+
+// Texture coordinate transform of a face: s' = mS[0] s + mS[1] t + mS[2]
+// and t' = mT[0] s + mT[1] t + mT[2].  The rotation, repeats and offsets
+// of a texture entry or material, or a texture animation matrix, all fold
+// into this form so the per-vertex loops don't branch on which applies.
+class LLTexCoordTransform
+{
+public:
+    LLTexCoordTransform() { setIdentity(); }
+
+    void setIdentity();
+
+    // Same as xform() in llface.cpp: rotate about the face center, then
+    // scale by the repeats, then offset.  Results may differ from it in
+    // the last bits.
+    void setRotateScaleOffset(F32 cos_ang, F32 sin_ang, F32 offset_s, F32 offset_t, F32 repeat_s, F32 repeat_t);
+
+    // (s, t, 0) * mat, as done with the texture animation matrix
+    void setMatrix(const LLMatrix4& mat);
+
+    bool isIdentity() const;
+
+    void transform(LLVector2& tc) const;
+
+    F32 mS[3];
+    F32 mT[3];
+};
+
+// The per-vertex work of LLFace::getGeometryVolume().  Sources are the
+// 16 byte aligned LLVolumeFace arrays, vector destinations are 16 byte
+// aligned, texture coordinate destinations need not be.  These match
+// their scalar versions exactly.
+
+// Affine transform of count positions, w replaced by w (the face's
+// texture index, as integer bits).
+void LLTransformPositions(const LLMatrix4a& mat, const LLVector4a* src, U32 count, F32 w, LLVector4a* dst);
+void LLTransformPositionsScalar(const LLMatrix4a& mat, const LLVector4a* src, U32 count, F32 w, LLVector4a* dst);
+
+// Rotation of count normals or tangents.  With keep_w, w is copied from
+// the source (the tangent's bitangent sign).
+void LLRotateVectors(const LLMatrix4a& mat, const LLVector4a* src, U32 count, bool keep_w, LLVector4a* dst);
+void LLRotateVectorsScalar(const LLMatrix4a& mat, const LLVector4a* src, U32 count, bool keep_w, LLVector4a* dst);
+
+// Texture transform of count coordinates.  src and dst may not overlap.
+void LLTransformTexCoords(const LLTexCoordTransform& xform, const LLVector2* src, U32 count, LLVector2* dst);
+void LLTransformTexCoordsScalar(const LLTexCoordTransform& xform, const LLVector2* src, U32 count, LLVector2* dst);
+
+// Planar texture coordinates (see planarProjection() in llface.cpp) of
+// count vertices, from positions multiplied by scale, then transformed.
+void LLPlanarTexCoords(const LLTexCoordTransform& xform, const LLVector4a* positions, const LLVector4a* normals,
+                       const LLVector4a& scale, U32 count, LLVector2* dst);
+void LLPlanarTexCoordsScalar(const LLTexCoordTransform& xform, const LLVector4a* positions, const LLVector4a* normals,
+                             const LLVector4a& scale, U32 count, LLVector2* dst);
+
+#endif // LL_LLVOLUMEKERNELS_H
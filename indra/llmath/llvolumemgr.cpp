@@ -27,10 +27,44 @@
 
 #include "llvolumemgr.h"
 #include "llvolume.h"
+#include "threadpool.h"
+#include "workqueue.h"
 
 
 const F32 BASE_THRESHOLD = 0.03f;
 
+namespace
+{
+    // Carries a volume generated on a worker thread to the reply queue.
+    // The worker never touches the volume's refcount, which is not atomic;
+    // take() hands it to the main thread.  If the reply is dropped because
+    // the reply queue closed, the volume is freed with the last copy of the
+    // reply, on whichever thread that is.
+    class GeneratedVolume
+    {
+    public:
+        GeneratedVolume(LLVolume* volumep) : mVolumep(volumep) {}
+        ~GeneratedVolume()
+        {
+            if (mVolumep)
+            {
+                // Nobody else ever saw it, so the refcount is ours
+                LLPointer<LLVolume> unused = mVolumep;
+            }
+        }
+
+        LLVolume* take()
+        {
+            LLVolume* volumep = mVolumep;
+            mVolumep = nullptr;
+            return volumep;
+        }
+
+    private:
+        LLVolume* mVolumep;
+    };
+}
+
 //static
 F32 LLVolumeLODGroup::mDetailThresholds[NUM_LODS] = {BASE_THRESHOLD,
                                                      2*BASE_THRESHOLD,
@@ -44,7 +78,8 @@ F32 LLVolumeLODGroup::mDetailScales[NUM_LODS] = {1.f, 1.5f, 2.5f, 4.f};
 //============================================================================
 
 LLVolumeMgr::LLVolumeMgr()
-:   mDataMutex(NULL)
+:   mDataMutex(NULL),
+    mInstallSerial(0)
 {
     // the LLMutex magic interferes with easy unit testing,
     // so you now must manually call useMutex() to use it
@@ -53,6 +88,11 @@ LLVolumeMgr::LLVolumeMgr()
 
 LLVolumeMgr::~LLVolumeMgr()
 {
+    mAsyncHandle.reset();
+    if (mThreadPool)
+    {
+        mThreadPool->close();
+    }
     cleanup();
 
     delete mDataMutex;
@@ -92,24 +132,137 @@ bool LLVolumeMgr::cleanup()
 LLVolume* LLVolumeMgr::refVolume(const LLVolumeParams &volume_params, const S32 lod)
 {
     LLVolumeLODGroup* volgroupp;
-    if (mDataMutex)
     {
-        mDataMutex->lock();
+        LLMutexLock lock(mDataMutex);
+        volume_lod_group_map_t::iterator iter = mVolumeLODGroups.find(&volume_params);
+        if( iter == mVolumeLODGroups.end() )
+        {
+            volgroupp = createNewGroup(volume_params);
+        }
+        else
+        {
+            volgroupp = iter->second;
+        }
+
+        // The reference keeps the group alive while the LOD is generated
+        // below without the lock, so other threads don't queue up behind it
+        if (LLVolume* volumep = volgroupp->reserveLOD(lod))
+        {
+            return volumep;
+        }
     }
-    volume_lod_group_map_t::iterator iter = mVolumeLODGroups.find(&volume_params);
-    if( iter == mVolumeLODGroups.end() )
+
+    LLVolume* volumep = new LLVolume(volume_params, LLVolumeLODGroup::getVolumeScaleFromDetail(lod));
+
+    LLMutexLock lock(mDataMutex);
+    return volgroupp->publishLOD(lod, volumep);
+}
+
+LLVolume* LLVolumeMgr::refVolumeOrPlaceholder(const LLVolumeParams &volume_params, const S32 lod)
+{
+    if (!mAsyncHandle || !canGenerateAsync(volume_params))
     {
-        volgroupp = createNewGroup(volume_params);
+        return refVolume(volume_params, lod);
     }
-    else
+
+    S32 ref_lod = lod;
     {
-        volgroupp = iter->second;
+        LLMutexLock lock(mDataMutex);
+
+        LLVolumeLODGroup* volgroupp;
+        volume_lod_group_map_t::iterator iter = mVolumeLODGroups.find(&volume_params);
+        if (iter == mVolumeLODGroups.end())
+        {
+            volgroupp = createNewGroup(volume_params);
+        }
+        else
+        {
+            volgroupp = iter->second;
+        }
+
+        // The coarsest LOD is cheap enough to build right away, and
+        // serves as the placeholder of last resort for the others.
+        if (!volgroupp->hasLOD(lod) && lod != LLVolumeLODGroup::NUM_LODS - 1)
+        {
+            if (!volgroupp->isLODPending(lod) && postGenerate(volume_params, lod))
+            {
+                volgroupp->setLODPending(lod, true);
+            }
+
+            if (volgroupp->isLODPending(lod))
+            {
+                S32 placeholder = volgroupp->getNearestLOD(lod);
+                ref_lod = placeholder >= 0 ? placeholder : LLVolumeLODGroup::NUM_LODS - 1;
+            }
+        }
     }
-    if (mDataMutex)
+
+    // generates outside the lock if the LOD went away meanwhile
+    return refVolume(volume_params, ref_lod);
+}
+
+bool LLVolumeMgr::isLODReady(const LLVolumeParams &volume_params, const S32 lod) const
+{
+    LLMutexLock lock(mDataMutex);
+
+    volume_lod_group_map_t::const_iterator iter = mVolumeLODGroups.find(&volume_params);
+    return iter != mVolumeLODGroups.end() && iter->second->hasLOD(lod);
+}
+
+// static
+bool LLVolumeMgr::canGenerateAsync(const LLVolumeParams& volume_params)
+{
+    // Sculpts and meshes get their faces later, from their texture or
+    // asset, on the threads that own that data.  Flexi paths are rebuilt
+    // every frame anyway.
+    return volume_params.getSculptID().isNull()
+        && volume_params.getSculptType() == LL_SCULPT_TYPE_NONE
+        && volume_params.getPathParams().getCurveType() != LL_PCODE_PATH_FLEXIBLE;
+}
+
+// Locks:  mDataMutex held by caller
+bool LLVolumeMgr::postGenerate(const LLVolumeParams& volume_params, const S32 lod)
+{
+    LL::WorkQueue::ptr_t worker_queue = LL::WorkQueue::getInstance(mWorkerQueueName);
+    LL::WorkQueue::ptr_t reply_queue = LL::WorkQueue::getInstance(mReplyQueueName);
+    if (!worker_queue || !reply_queue)
     {
-        mDataMutex->unlock();
+        return false;
+    }
+
+    F32 detail = LLVolumeLODGroup::getVolumeScaleFromDetail(lod);
+    std::weak_ptr<LLVolumeMgr*> handle = mAsyncHandle;
+
+    // The reply lambda is copied into std::function, so the result is a
+    // shared_ptr, whose count is atomic.
+    return reply_queue->postTo(
+        worker_queue,
+        [volume_params, detail]() // Work done on the worker queue
+        {
+            LL_PROFILE_ZONE_NAMED_CATEGORY_VOLUME("generate volume async");
+            return std::make_shared<GeneratedVolume>(new LLVolume(volume_params, detail));
+        },
+        [handle, volume_params, lod](std::shared_ptr<GeneratedVolume> generated) // Callback to the reply queue
+        {
+            LLPointer<LLVolume> volume = generated->take();
+            if (std::shared_ptr<LLVolumeMgr*> mgr = handle.lock())
+            {
+                (*mgr)->installLOD(volume_params, lod, volume);
+            }
+        });
+}
+
+void LLVolumeMgr::installLOD(const LLVolumeParams& volume_params, const S32 lod, LLVolume* volumep)
+{
+    LLMutexLock lock(mDataMutex);
+
+    // The group may be gone if all its users went away meanwhile
+    volume_lod_group_map_t::iterator iter = mVolumeLODGroups.find(&volume_params);
+    if (iter != mVolumeLODGroups.end())
+    {
+        iter->second->setGeneratedLOD(lod, volumep);
+        mInstallSerial++;
     }
-    return volgroupp->refLOD(lod);
 }
 
 // virtual
@@ -218,6 +371,27 @@ void LLVolumeMgr::useMutex()
     }
 }
 
+void LLVolumeMgr::useThreadPool(const std::string& name, S32 threads, const std::string& reply_queue)
+{
+    if (!mThreadPool)
+    {
+        // "ThreadPoolSizes" overrides threads
+        mThreadPool = std::make_unique<LL::ThreadPool>(name, llmax(threads, 1));
+        mThreadPool->start();
+    }
+    useWorkQueues(name, reply_queue);
+}
+
+void LLVolumeMgr::useWorkQueues(const std::string& worker_queue, const std::string& reply_queue)
+{
+    mWorkerQueueName = worker_queue;
+    mReplyQueueName = reply_queue;
+    if (!mAsyncHandle)
+    {
+        mAsyncHandle = std::make_shared<LLVolumeMgr*>(this);
+    }
+}
+
 std::ostream& operator<<(std::ostream& s, const LLVolumeMgr& volume_mgr)
 {
     s << "{ numLODgroups=" << volume_mgr.mVolumeLODGroups.size() << ", ";
@@ -253,6 +427,7 @@ LLVolumeLODGroup::LLVolumeLODGroup(const LLVolumeParams &params)
     {
         mLODRefs[i] = 0;
         mAccessCount[i] = 0;
+        mLODPending[i] = false;
     }
 }
 
@@ -301,6 +476,56 @@ LLVolume* LLVolumeLODGroup::refLOD(const S32 lod)
     return mVolumeLODs[lod];
 }
 
+LLVolume* LLVolumeLODGroup::reserveLOD(const S32 lod)
+{
+    llassert(lod >=0 && lod < NUM_LODS);
+    mAccessCount[lod]++;
+
+    mRefs++;
+    mLODRefs[lod]++;
+    return mVolumeLODs[lod];
+}
+
+LLVolume* LLVolumeLODGroup::publishLOD(const S32 lod, LLVolume* volumep)
+{
+    llassert(lod >=0 && lod < NUM_LODS);
+
+    // drops volumep if another thread got there first
+    LLPointer<LLVolume> generated = volumep;
+    if (mVolumeLODs[lod].isNull())
+    {
+        mVolumeLODs[lod] = generated;
+    }
+    return mVolumeLODs[lod];
+}
+
+void LLVolumeLODGroup::setGeneratedLOD(const S32 lod, LLVolume* volumep)
+{
+    llassert(lod >=0 && lod < NUM_LODS);
+    mLODPending[lod] = false;
+    if (mVolumeLODs[lod].isNull())
+    {
+        mVolumeLODs[lod] = volumep;
+    }
+}
+
+S32 LLVolumeLODGroup::getNearestLOD(const S32 lod) const
+{
+    // Prefer finer detail over coarser at the same distance
+    for (S32 delta = 1; delta < NUM_LODS; delta++)
+    {
+        if (lod - delta >= 0 && mVolumeLODs[lod - delta].notNull())
+        {
+            return lod - delta;
+        }
+        if (lod + delta < NUM_LODS && mVolumeLODs[lod + delta].notNull())
+        {
+            return lod + delta;
+        }
+    }
+    return -1;
+}
+
 bool LLVolumeLODGroup::derefLOD(LLVolume *volumep)
 {
     llassert_always(mRefs > 0);
@@ -27,11 +27,14 @@
 #ifndef LL_LLVOLUMEMGR_H
 #define LL_LLVOLUMEMGR_H
 
+#include <atomic>
 #include <map>
+#include <memory>
 
 #include "llvolume.h"
 #include "llpointer.h"
 #include "llthread.h"
+#include "threadpool_fwd.h"
 
 class LLVolumeParams;
 class LLVolumeLODGroup;
@@ -59,6 +62,19 @@ public:
     bool derefLOD(LLVolume *volumep);
     S32 getNumRefs() const { return mRefs; }
 
+    // Takes a reference to the LOD, which may not be generated yet (null),
+    // then publishLOD() installs it unless another thread got there first.
+    // Lets LLVolumeMgr generate without holding its lock.
+    LLVolume* reserveLOD(const S32 detail);
+    LLVolume* publishLOD(const S32 detail, LLVolume* volumep);
+
+    // Asynchronous generation support, see LLVolumeMgr::refVolumeOrPlaceholder()
+    bool hasLOD(const S32 detail) const { return mVolumeLODs[detail].notNull(); }
+    bool isLODPending(const S32 detail) const { return mLODPending[detail]; }
+    void setLODPending(const S32 detail, bool pending) { mLODPending[detail] = pending; }
+    void setGeneratedLOD(const S32 detail, LLVolume* volumep);
+    S32 getNearestLOD(const S32 detail) const; // -1 if no LOD is generated
+
     const LLVolumeParams* getVolumeParams() const { return &mVolumeParams; };
 
     F32 dump();
@@ -70,6 +86,7 @@ protected:
     S32 mRefs;
     S32 mLODRefs[NUM_LODS];
     LLPointer<LLVolume> mVolumeLODs[NUM_LODS];
+    bool mLODPending[NUM_LODS];
     static F32 mDetailThresholds[NUM_LODS];
     static F32 mDetailScales[NUM_LODS];
     S32     mAccessCount[NUM_LODS];
@@ -90,11 +107,31 @@ public:
     virtual LLVolume *refVolume(const LLVolumeParams &volume_params, const S32 detail);
     virtual void unrefVolume(LLVolume *volumep);
 
+    // Same as refVolume(), except that when work queues are in use and the
+    // requested LOD of a plain prim has not been generated yet, generation
+    // is posted to the worker queue and the nearest available LOD is
+    // referenced instead.  Callers ref again once isLODReady() to swap the
+    // placeholder for the real thing.
+    LLVolume *refVolumeOrPlaceholder(const LLVolumeParams &volume_params, const S32 detail);
+    bool isLODReady(const LLVolumeParams &volume_params, const S32 detail) const;
+
+    // Changes each time a generated LOD is installed.  Cheap to poll, so
+    // placeholder holders only need isLODReady() once it has moved.
+    U32 getInstallSerial() const { return mInstallSerial; }
+
     void dump();
 
     // manually call this for mutex magic
     void useMutex();
 
+    // manually call this to generate prim volumes on worker_queue, with
+    // results installed from reply_queue (both looked up by name when
+    // used, generation falls back to synchronous if either is gone)
+    void useWorkQueues(const std::string& worker_queue, const std::string& reply_queue);
+
+    // same, on a pool of our own named name
+    void useThreadPool(const std::string& name, S32 threads, const std::string& reply_queue);
+
     friend std::ostream& operator<<(std::ostream& s, const LLVolumeMgr& volume_mgr);
 
 protected:
@@ -102,11 +139,23 @@ protected:
     // Overridden in llphysics/abstract/utils/llphysicsvolumemanager.h
     virtual LLVolumeLODGroup* createNewGroup(const LLVolumeParams& volume_params);
 
+    static bool canGenerateAsync(const LLVolumeParams& volume_params);
+    bool postGenerate(const LLVolumeParams& volume_params, const S32 detail);
+    void installLOD(const LLVolumeParams& volume_params, const S32 detail, LLVolume* volumep);
+
 protected:
     typedef std::map<const LLVolumeParams*, LLVolumeLODGroup*, LLVolumeParams::compare> volume_lod_group_map_t;
     volume_lod_group_map_t mVolumeLODGroups;
 
     LLMutex* mDataMutex;
+
+    std::string mWorkerQueueName;
+    std::string mReplyQueueName;
+    // Replies hold a weak reference so late completions after
+    // destruction are dropped
+    std::shared_ptr<LLVolumeMgr*> mAsyncHandle;
+    std::unique_ptr<LL::ThreadPool> mThreadPool;
+    std::atomic<U32> mInstallSerial;
 };
 
 #endif // LL_LLVOLUMEMGR_H
@@ -0,0 +1,318 @@
+/**
+ * @file   lloctree_test.cpp
+ * @brief  Test for lloctree.h, pooled against unpooled trees
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../test/lltut.h"
+
+#include "../lloctree.h"
+
+#include <random>
+
+namespace
+{
+    S32 sLiveElements = 0;
+
+    // Owned by the tree through LLPointer, like the viewer's entries
+    class OctreeTestElement : public LLRefCount
+    {
+    public:
+        OctreeTestElement(const LLVector4a& pos, F32 radius)
+        :   mBinIndex(-1),
+            mRadius(radius)
+        {
+            mPosition = pos;
+            ++sLiveElements;
+        }
+
+        const LLVector4a& getPositionGroup() const  { return mPosition; }
+        F32 getBinRadius() const                    { return mRadius; }
+        S32 getBinIndex() const                     { return mBinIndex; }
+        void setBinIndex(S32 index)                 { mBinIndex = index; }
+
+    protected:
+        ~OctreeTestElement()
+        {
+            --sLiveElements;
+        }
+
+    private:
+        LL_ALIGN_16(LLVector4a mPosition);
+        S32 mBinIndex;
+        F32 mRadius;
+    };
+
+    typedef LLPointer<OctreeTestElement> test_ptr_t;
+    typedef LLOctreeNode<OctreeTestElement, test_ptr_t> test_node_t;
+    typedef LLOctreeRoot<OctreeTestElement, test_ptr_t> test_root_t;
+
+    struct ListenerCounts
+    {
+        S32 mInsertions = 0;
+        S32 mRemovals = 0;
+        S32 mChildAdditions = 0;
+        S32 mChildRemovals = 0;
+        S32 mDestructions = 0;
+    };
+
+    // Follows the tree down like LLViewerOctreeGroup does
+    class CountingListener : public LLOctreeListener<OctreeTestElement, test_ptr_t>
+    {
+    public:
+        CountingListener(ListenerCounts* counts) : mCounts(counts) { }
+
+        void handleInsertion(const LLTreeNode<OctreeTestElement>* node, OctreeTestElement* data) override { mCounts->mInsertions++; }
+        void handleRemoval(const LLTreeNode<OctreeTestElement>* node, OctreeTestElement* data) override { mCounts->mRemovals++; }
+        void handleDestruction(const LLTreeNode<OctreeTestElement>* node) override { mCounts->mDestructions++; }
+        void handleStateChange(const LLTreeNode<OctreeTestElement>* node) override { }
+
+        void handleChildAddition(const test_node_t* parent, test_node_t* child) override
+        {
+            mCounts->mChildAdditions++;
+            child->addListener(new CountingListener(mCounts));
+        }
+
+        void handleChildRemoval(const test_node_t* parent, const test_node_t* child) override
+        {
+            mCounts->mChildRemovals++;
+        }
+
+    private:
+        ListenerCounts* mCounts;
+    };
+
+    // Flattens a tree in traversal order
+    class LayoutTraveler : public LLOctreeTraveler<OctreeTestElement, test_ptr_t>
+    {
+    public:
+        void visit(const test_node_t* node) override
+        {
+            for (S32 i = 0; i < 4; ++i)
+            {
+                mLayout.push_back(node->getCenter()[i]);
+            }
+            mLayout.push_back(node->getSize()[0]);
+            mLayout.push_back((F32)node->getElementCount());
+            mLayout.push_back((F32)node->getChildCount());
+            for (test_node_t::const_element_iter i = node->getDataBegin(); i != node->getDataEnd(); ++i)
+            {
+                mLayout.push_back((*i)->getPositionGroup()[0]);
+            }
+            for (U32 i = 0; i < node->getChildCount(); ++i)
+            {
+                mParentsOk = mParentsOk && node->getChild(i)->getParent() == node;
+            }
+        }
+
+        std::vector<F32> mLayout;
+        bool mParentsOk = true;
+    };
+
+    // Same operations on an unpooled and a pooled tree
+    struct TreePair
+    {
+        TreePair()
+        {
+            mHeap = new test_root_t(LLVector4a(0.f, 0.f, 0.f), LLVector4a(1.f, 1.f, 1.f), NULL);
+            mPooled = new test_root_t(LLVector4a(0.f, 0.f, 0.f), LLVector4a(1.f, 1.f, 1.f), NULL, true);
+            mHeap->addListener(new CountingListener(&mHeapCounts));
+            mPooled->addListener(new CountingListener(&mPooledCounts));
+        }
+
+        ~TreePair()
+        {
+            delete mHeap;
+            delete mPooled;
+        }
+
+        void insert(const LLVector4a& pos, F32 radius)
+        {
+            OctreeTestElement* a = new OctreeTestElement(pos, radius);
+            OctreeTestElement* b = new OctreeTestElement(pos, radius);
+            mHeapElements.push_back(a);
+            mPooledElements.push_back(b);
+            mHeap->insert(a);
+            mPooled->insert(b);
+        }
+
+        void remove(size_t index)
+        {
+            // the trees own the elements, remove() may release them
+            LLPointer<OctreeTestElement> a = mHeapElements[index];
+            LLPointer<OctreeTestElement> b = mPooledElements[index];
+            mHeapElements.erase(mHeapElements.begin() + index);
+            mPooledElements.erase(mPooledElements.begin() + index);
+            mHeap->getNodeAt(a)->remove(a);
+            mPooled->getNodeAt(b)->remove(b);
+        }
+
+        bool sameLayout()
+        {
+            LayoutTraveler heap;
+            LayoutTraveler pooled;
+            heap.traverse(mHeap);
+            pooled.traverse(mPooled);
+            return heap.mParentsOk && pooled.mParentsOk && heap.mLayout == pooled.mLayout;
+        }
+
+        test_root_t* mHeap;
+        test_root_t* mPooled;
+        std::vector<OctreeTestElement*> mHeapElements;
+        std::vector<OctreeTestElement*> mPooledElements;
+        ListenerCounts mHeapCounts;
+        ListenerCounts mPooledCounts;
+    };
+
+    bool same_counts(const ListenerCounts& a, const ListenerCounts& b)
+    {
+        return a.mInsertions == b.mInsertions && a.mRemovals == b.mRemovals && a.mChildAdditions == b.mChildAdditions &&
+               a.mChildRemovals == b.mChildRemovals && a.mDestructions == b.mDestructions;
+    }
+}
+
+namespace tut
+{
+    struct LLOctreeData
+    {
+        LLOctreeData()
+        {
+            gOctreeMaxCapacity = 8;
+            gOctreeMinSize = 0.25f;
+        }
+    };
+
+    typedef test_group<LLOctreeData> factory;
+    typedef factory::object object;
+}
+
+namespace
+{
+    tut::factory lloctree_test_factory("LLOctree");
+}
+
+namespace tut
+{
+    template<> template<>
+    void object::test<1>()
+    {
+        //
+        // element storage spills to the heap and keeps its order
+        //
+        {
+            LLOctreeElementList<test_ptr_t, 4> list;
+            for (S32 i = 0; i < 4; ++i)
+            {
+                list.push_back(new OctreeTestElement(LLVector4a((F32)i, 0.f, 0.f), 1.f));
+            }
+            ensure("inline up to capacity", list.isInline());
+
+            for (S32 i = 4; i < 37; ++i)
+            {
+                list.push_back(new OctreeTestElement(LLVector4a((F32)i, 0.f, 0.f), 1.f));
+            }
+            ensure("spilled", !list.isInline());
+            ensure_equals("size", list.size(), 37U);
+            for (U32 i = 0; i < list.size(); ++i)
+            {
+                ensure_equals("order kept", list[i]->getPositionGroup()[0], (F32)i);
+            }
+
+            list.pop_back();
+            ensure_equals("pop_back releases", sLiveElements, 36);
+        }
+        ensure_equals("destructor releases", sLiveElements, 0);
+    }
+
+    template<> template<>
+    void object::test<2>()
+    {
+        //
+        // a pooled tree builds the same tree as an unpooled one, with the
+        // same listener calls, through growth, removal and balancing
+        //
+        std::mt19937 rng(1234);
+        std::uniform_real_distribution<F32> pos(-500.f, 500.f);
+        std::uniform_real_distribution<F32> radius(0.05f, 8.f);
+        {
+            TreePair trees;
+            for (S32 i = 0; i < 6000; ++i)
+            {
+                trees.insert(LLVector4a(pos(rng), pos(rng), pos(rng)), radius(rng));
+                if (i % 3 == 2)
+                {
+                    trees.remove(rng() % trees.mHeapElements.size());
+                }
+                if (i % 1000 == 999)
+                {
+                    trees.mHeap->balance();
+                    trees.mPooled->balance();
+                }
+            }
+
+            ensure("same layout", trees.sameLayout());
+            ensure("same listener calls", same_counts(trees.mHeapCounts, trees.mPooledCounts));
+            ensure("branches in blocks", trees.mPooled->getNodePool()->getBlocksInUse() > 0);
+            ensure("unpooled has no pool", trees.mHeap->getNodePool() == NULL);
+
+            // emptied trees give all their blocks back
+            while (!trees.mHeapElements.empty())
+            {
+                trees.remove(trees.mHeapElements.size() - 1);
+            }
+            ensure_equals("no branches left", trees.mPooled->getChildCount(), 0U);
+            ensure_equals("blocks returned", trees.mPooled->getNodePool()->getBlocksInUse(), 0U);
+
+            // and grow again, then die full
+            for (S32 i = 0; i < 2000; ++i)
+            {
+                trees.insert(LLVector4a(pos(rng), pos(rng), pos(rng)), radius(rng));
+            }
+            ensure("same layout after regrowth", trees.sameLayout());
+        }
+        ensure_equals("elements released", sLiveElements, 0);
+    }
+
+    template<> template<>
+    void object::test<3>()
+    {
+        //
+        // balance() hands the root the block of its only branch
+        //
+        TreePair trees;
+        // a tight cluster far from the origin leaves a single branch chain
+        for (S32 i = 0; i < 64; ++i)
+        {
+            trees.insert(LLVector4a(300.f + i * 0.1f, 300.f, 300.f), 0.05f);
+        }
+        for (S32 i = 0; i < 8; ++i)
+        {
+            trees.mHeap->balance();
+            trees.mPooled->balance();
+        }
+        ensure("same layout", trees.sameLayout());
+        ensure("same listener calls", same_counts(trees.mHeapCounts, trees.mPooledCounts));
+    }
+}
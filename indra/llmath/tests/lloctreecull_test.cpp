@@ -0,0 +1,345 @@
+/**
+ * @file   lloctreecull_test.cpp
+ * @brief  Test for lloctreecull.h
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../test/lltut.h"
+
+#include "../lloctreecull.h"
+#include "threadpool.h"
+
+#include <random>
+
+namespace
+{
+    // Just enough of an octree element
+    class CullTestElement
+    {
+    public:
+        CullTestElement(const LLVector4a& pos, F32 radius)
+        :   mBinIndex(-1),
+            mRadius(radius)
+        {
+            mPosition = pos;
+        }
+
+        const LLVector4a& getPositionGroup() const  { return mPosition; }
+        F32 getBinRadius() const                    { return mRadius; }
+        S32 getBinIndex() const                     { return mBinIndex; }
+        void setBinIndex(S32 index)                 { mBinIndex = index; }
+
+    private:
+        LL_ALIGN_16(LLVector4a mPosition);
+        S32 mBinIndex;
+        F32 mRadius;
+    };
+
+    typedef LLOctreeNode<CullTestElement, CullTestElement*> cull_node_t;
+    typedef LLOctreeRoot<CullTestElement, CullTestElement*> cull_root_t;
+    typedef LLOctreeCullPlan<CullTestElement, CullTestElement*> cull_plan_t;
+
+    // 0 outside, 1 partially inside, 2 fully inside a sphere
+    S32 sphere_check(const LLVector4a& center, const LLVector4a& size, const LLVector4a& sphere, F32 radius)
+    {
+        F32 near_dist = 0.f;
+        F32 far_dist = 0.f;
+        for (S32 i = 0; i < 3; ++i)
+        {
+            const F32 lo = center[i] - size[i];
+            const F32 hi = center[i] + size[i];
+            const F32 n = llmax(lo - sphere[i], 0.f, sphere[i] - hi);
+            const F32 f = llmax(fabsf(sphere[i] - lo), fabsf(sphere[i] - hi));
+            near_dist += n * n;
+            far_dist += f * f;
+        }
+        if (near_dist > radius * radius)
+        {
+            return 0;
+        }
+        return far_dist <= radius * radius ? 2 : 1;
+    }
+
+    // Stands in for the camera frustum, objects are checked against a
+    // shrunk node box so that they can disagree with the node
+    class SphereChecker : public cull_plan_t::Checker
+    {
+    public:
+        SphereChecker(const LLVector4a& center, F32 radius)
+        :   mRadius(radius)
+        {
+            mCenter = center;
+        }
+
+        S32 frustumCheck(const cull_node_t* node) override
+        {
+            return sphere_check(node->getCenter(), node->getSize(), mCenter, mRadius);
+        }
+
+        S32 frustumCheckObjects(const cull_node_t* node) override
+        {
+            LLVector4a size;
+            size.setMul(node->getSize(), 0.75f);
+            return sphere_check(node->getCenter(), size, mCenter, mRadius);
+        }
+
+        bool skipFrustumCheck(const cull_node_t* node) override
+        {
+            // As LLViewerOctreeGroup::rebound() flags them
+            const cull_node_t* parent = node->getOctParent();
+            return parent && parent->getChildCount() == 1 && parent->getElementCount() == 0;
+        }
+
+    private:
+        LL_ALIGN_16(LLVector4a mCenter);
+        F32 mRadius;
+    };
+
+    // Nodes an occlusion pass would prune, picked by address
+    bool test_occluded(const cull_node_t* node, U32 modulo)
+    {
+        return modulo && node->getParent() && ((uintptr_t)node / sizeof(void*)) % modulo == 0;
+    }
+
+    // The stateful walk of LLViewerOctreeCull, optionally replaying a plan
+    class CullTestWalker
+    {
+    public:
+        CullTestWalker(SphereChecker& checker, U32 occlusion_modulo, const std::vector<cull_plan_t::Entry>* plan)
+        :   mMismatches(0),
+            mChecker(checker),
+            mOcclusionModulo(occlusion_modulo),
+            mPlan(plan),
+            mCursor(0),
+            mRes(0)
+        {
+        }
+
+        void traverse(const cull_node_t* n)
+        {
+            const cull_plan_t::Entry* entry = NULL;
+            if (mPlan)
+            {
+                entry = &(*mPlan)[mCursor++];
+                const bool inherit = mRes == 2 || (mRes && mChecker.skipFrustumCheck(n));
+                if (entry->mNode != n || (entry->mRes < 0) != inherit || (inherit && entry->mInRes != mRes))
+                {
+                    mMismatches++;
+                }
+            }
+
+            if (test_occluded(n, mOcclusionModulo))
+            {
+                if (entry)
+                {
+                    mCursor = entry->mEnd;
+                }
+                return;
+            }
+
+            if (mRes == 2 || (mRes && mChecker.skipFrustumCheck(n)))
+            {
+                visit(n, entry);
+            }
+            else
+            {
+                mRes = entry ? entry->mRes : mChecker.frustumCheck(n);
+                if (mRes)
+                {
+                    visit(n, entry);
+                }
+                mRes = 0;
+            }
+        }
+
+        std::vector<const cull_node_t*> mVisible;
+        U32 mMismatches;
+
+    private:
+        void visit(const cull_node_t* n, const cull_plan_t::Entry* entry)
+        {
+            if (n->getElementCount() > 0 &&
+                (n->getChildCount() == 0 || mRes != 1 ||
+                 (entry ? entry->mObjectRes : mChecker.frustumCheckObjects(n))))
+            {
+                mVisible.push_back(n);
+            }
+            for (U32 i = 0; i < n->getChildCount(); ++i)
+            {
+                traverse(n->getChild(i));
+            }
+        }
+
+        SphereChecker& mChecker;
+        U32 mOcclusionModulo;
+        const std::vector<cull_plan_t::Entry>* mPlan;
+        U32 mCursor;
+        S32 mRes;
+    };
+
+    bool same_entries(const cull_plan_t& a, const cull_plan_t& b)
+    {
+        const std::vector<cull_plan_t::Entry>& ea = a.getEntries();
+        const std::vector<cull_plan_t::Entry>& eb = b.getEntries();
+        if (ea.size() != eb.size())
+        {
+            return false;
+        }
+        for (size_t i = 0; i < ea.size(); ++i)
+        {
+            if (ea[i].mNode != eb[i].mNode || ea[i].mEnd != eb[i].mEnd || ea[i].mInRes != eb[i].mInRes ||
+                ea[i].mRes != eb[i].mRes || ea[i].mObjectRes != eb[i].mObjectRes)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+namespace tut
+{
+    struct LLOctreeCullData
+    {
+        LLOctreeCullData()
+        :   mRoot(NULL),
+            mPool("OctreeCullTest", 3)
+        {
+            gOctreeMaxCapacity = 8;
+            gOctreeMinSize = 0.25f;
+
+            LLVector4a center(128.f, 128.f, 128.f);
+            LLVector4a size(128.f, 128.f, 128.f);
+            mRoot = new cull_root_t(center, size, NULL);
+
+            std::mt19937 rng(4321);
+            std::uniform_real_distribution<F32> pos(0.f, 256.f);
+            std::uniform_real_distribution<F32> radius(0.1f, 4.f);
+            for (S32 i = 0; i < 5000; ++i)
+            {
+                CullTestElement* element = new CullTestElement(LLVector4a(pos(rng), pos(rng), pos(rng)), radius(rng));
+                mElements.push_back(element);
+                mRoot->insert(element);
+            }
+
+            mPool.start();
+        }
+
+        ~LLOctreeCullData()
+        {
+            mPool.close();
+            // the nodes reset the elements' bin index on the way out
+            delete mRoot;
+            for (CullTestElement* element : mElements)
+            {
+                delete element;
+            }
+        }
+
+        cull_root_t* mRoot;
+        std::vector<CullTestElement*> mElements;
+        LL::ThreadPool mPool;
+    };
+
+    typedef test_group<LLOctreeCullData> factory;
+    typedef factory::object object;
+}
+
+namespace
+{
+    tut::factory lloctreecull_test_factory("LLOctreeCull");
+}
+
+namespace tut
+{
+    template<> template<>
+    void object::test<1>()
+    {
+        //
+        // the recording doesn't depend on the split
+        //
+        SphereChecker checker(LLVector4a(100.f, 140.f, 90.f), 70.f);
+
+        cull_plan_t serial;
+        serial.build(mRoot, checker, 0, NULL);
+        ensure("recorded the root", !serial.getEntries().empty());
+        ensure_equals("single subtree", serial.getSubtreeCount(), 0U);
+
+        for (U32 depth = 1; depth <= 3; ++depth)
+        {
+            cull_plan_t parallel;
+            parallel.build(mRoot, checker, depth, &mPool);
+            ensure("split into subtrees", parallel.getSubtreeCount() > 0);
+            ensure(llformat("same entries at split depth %u", depth), same_entries(serial, parallel));
+        }
+    }
+
+    template<> template<>
+    void object::test<2>()
+    {
+        //
+        // replaying gives what the checks give, with and without occlusion
+        //
+        const LLVector4a spheres[] = { LLVector4a(128.f, 128.f, 128.f), LLVector4a(10.f, 240.f, 60.f), LLVector4a(200.f, 30.f, 180.f) };
+        const F32 radii[] = { 300.f, 90.f, 45.f };
+
+        for (S32 s = 0; s < 3; ++s)
+        {
+            SphereChecker checker(spheres[s], radii[s]);
+
+            cull_plan_t plan;
+            plan.build(mRoot, checker, 2, &mPool);
+
+            for (U32 modulo = 0; modulo < 4; ++modulo)
+            {
+                CullTestWalker reference(checker, modulo, NULL);
+                reference.traverse(mRoot);
+
+                CullTestWalker replay(checker, modulo, &plan.getEntries());
+                replay.traverse(mRoot);
+
+                ensure_equals("replay follows the recording", replay.mMismatches, 0U);
+                ensure("same visible nodes", reference.mVisible == replay.mVisible);
+            }
+        }
+    }
+
+    template<> template<>
+    void object::test<3>()
+    {
+        //
+        // a plan is reusable across builds
+        //
+        cull_plan_t plan;
+        cull_plan_t serial;
+        for (S32 i = 0; i < 4; ++i)
+        {
+            SphereChecker checker(LLVector4a(64.f * i, 64.f * i, 128.f), 40.f + 20.f * i);
+            plan.build(mRoot, checker, 1 + i % 3, &mPool);
+            serial.build(mRoot, checker, 0, NULL);
+            ensure(llformat("same entries on build %d", i), same_entries(serial, plan));
+        }
+    }
+}
@@ -0,0 +1,204 @@
+/**
+ * @file   llvolume_test.cpp
+ * @brief  Test for unpacking mesh LOD faces in llvolume.cpp
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../test/lltut.h"
+
+#include "../llvolume.h"
+#include "../v2math.h"
+#include "../v3math.h"
+#include "llsdserialize.h"
+
+#ifdef LL_USESYSTEMLIBS
+# include <zlib.h>
+#else
+# include "zlib-ng/zlib.h"
+#endif
+
+#include <sstream>
+
+namespace
+{
+    void push_u16(std::vector<U8>& out, U16 value)
+    {
+        out.push_back((U8)(value & 0xFF));
+        out.push_back((U8)(value >> 8));
+    }
+
+    // A quad with an extra string field, the way a mesh LOD block looks
+    // on the wire
+    LLSD make_face()
+    {
+        const U16 positions[] = { 0, 0, 0,  65535, 0, 0,  65535, 65535, 0,  0, 65535, 32768 };
+        const U16 normals[] = { 32768, 32768, 65535,  32768, 32768, 65535,  32768, 65535, 32768,  65535, 32768, 32768 };
+        const U16 tex_coords[] = { 0, 0,  65535, 0,  65535, 65535,  0, 65535 };
+        const U16 triangles[] = { 0, 1, 2,  0, 2, 3 };
+
+        std::vector<U8> bytes;
+        LLSD face;
+        for (U16 v : positions) push_u16(bytes, v);
+        face["Position"] = LLSD::Binary(bytes);
+        bytes.clear();
+        for (U16 v : normals) push_u16(bytes, v);
+        face["Normal"] = LLSD::Binary(bytes);
+        bytes.clear();
+        for (U16 v : tex_coords) push_u16(bytes, v);
+        face["TexCoord0"] = LLSD::Binary(bytes);
+        bytes.clear();
+        for (U16 v : triangles) push_u16(bytes, v);
+        face["TriangleList"] = LLSD::Binary(bytes);
+
+        face["PositionDomain"]["Min"] = LLVector3(-0.5f, -0.25f, -1.f).getValue();
+        face["PositionDomain"]["Max"] = LLVector3(0.5f, 0.25f, 1.f).getValue();
+        face["TexCoord0Domain"]["Min"] = LLVector2(0.f, -1.f).getValue();
+        face["TexCoord0Domain"]["Max"] = LLVector2(2.f, 1.f).getValue();
+        face["NormalizedScale"] = LLVector3(2.f, 0.5f, 4.f).getValue();
+        face["Comment"] = "x";
+        return face;
+    }
+
+    std::string to_binary(const LLSD& sd)
+    {
+        std::ostringstream out;
+        LLSDSerialize::toBinary(sd, out);
+        return out.str();
+    }
+
+    std::string zip(const std::string& data)
+    {
+        uLongf size = compressBound((uLong)data.size());
+        std::string out(size, '\0');
+        if (compress((Bytef*)out.data(), &size, (const Bytef*)data.data(), (uLong)data.size()) != Z_OK)
+        {
+            return std::string();
+        }
+        out.resize(size);
+        return out;
+    }
+
+    bool unpack(LLVolume& volume, std::string zipped)
+    {
+        return volume.unpackVolumeFaces((U8*)zipped.data(), (S32)zipped.size(), false);
+    }
+
+    bool fast_reader_takes(const std::string& binary)
+    {
+        LLSDBinaryReader reader((const U8*)binary.data(), binary.size());
+        return reader.skip();
+    }
+
+    LLVolumeParams mesh_params()
+    {
+        LLVolumeParams params;
+        params.setType(LL_PCODE_PROFILE_SQUARE, LL_PCODE_PATH_LINE);
+        return params;
+    }
+}
+
+namespace tut
+{
+    struct LLVolumeData
+    {
+    };
+
+    typedef test_group<LLVolumeData> factory;
+    typedef factory::object object;
+}
+
+namespace
+{
+    tut::factory llvolume_test_factory("LLVolume");
+}
+
+namespace tut
+{
+    template<> template<>
+    void object::test<1>()
+    {
+        //
+        // the in place reader and the LLSD fallback unpack the same faces
+        //
+        LLSD mdl = LLSD::emptyArray();
+        mdl.append(make_face());
+        const std::string fast = to_binary(mdl);
+
+        // A notation style string, which only LLSDBinaryParser reads
+        const std::string binary_string("s\0\0\0\x01x", 6);
+        std::string fallback = fast;
+        const size_t pos = fallback.find(binary_string);
+        ensure("string field found", pos != std::string::npos);
+        fallback.replace(pos, binary_string.size(), "\"x\"");
+
+        ensure("fast path", fast_reader_takes(fast));
+        ensure("fallback path", !fast_reader_takes(fallback));
+
+        LLPointer<LLVolume> fast_volume = new LLVolume(mesh_params(), 1.f);
+        LLPointer<LLVolume> fallback_volume = new LLVolume(mesh_params(), 1.f);
+        ensure("fast unpack", unpack(*fast_volume, zip(fast)));
+        ensure("fallback unpack", unpack(*fallback_volume, zip(fallback)));
+
+        ensure_equals("face count", fallback_volume->getNumVolumeFaces(), fast_volume->getNumVolumeFaces());
+        ensure_equals("one face", fast_volume->getNumVolumeFaces(), 1);
+
+        const LLVolumeFace& a = fast_volume->getVolumeFace(0);
+        const LLVolumeFace& b = fallback_volume->getVolumeFace(0);
+        ensure_equals("vertices", b.mNumVertices, a.mNumVertices);
+        ensure_equals("indices", b.mNumIndices, a.mNumIndices);
+        ensure_equals("four vertices", a.mNumVertices, 4);
+        ensure("positions", !memcmp(a.mPositions, b.mPositions, sizeof(LLVector4a) * a.mNumVertices));
+        ensure("normals", !memcmp(a.mNormals, b.mNormals, sizeof(LLVector4a) * a.mNumVertices));
+        ensure("tex coords", !memcmp(a.mTexCoords, b.mTexCoords, sizeof(LLVector2) * a.mNumVertices));
+        ensure("triangles", !memcmp(a.mIndices, b.mIndices, sizeof(U16) * a.mNumIndices));
+        ensure("normalized scale", a.mNormalizedScale == b.mNormalizedScale);
+    }
+
+    template<> template<>
+    void object::test<2>()
+    {
+        //
+        // the fallback keeps the depth limit of LLUZipHelper::unzip_llsd()
+        //
+        LLSD deep = LLSD::emptyArray();
+        for (S32 i = 0; i < UNZIP_LLSD_MAX_DEPTH * 2; ++i)
+        {
+            LLSD outer = LLSD::emptyArray();
+            outer.append(deep);
+            deep = outer;
+        }
+
+        LLSD face = make_face();
+        face["Deep"] = deep;
+        LLSD mdl = LLSD::emptyArray();
+        mdl.append(face);
+        const std::string binary = to_binary(mdl);
+
+        ensure("too deep for the fast path", !fast_reader_takes(binary));
+
+        LLPointer<LLVolume> volume = new LLVolume(mesh_params(), 1.f);
+        ensure("too deep for the fallback", !unpack(*volume, zip(binary)));
+    }
+}
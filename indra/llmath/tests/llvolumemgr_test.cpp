@@ -0,0 +1,174 @@
+/**
+ * @file   llvolumemgr_test.cpp
+ * @brief  Test for llvolumemgr.h
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../test/lltut.h"
+
+#include "../llvolumemgr.h"
+#include "../llvolume.h"
+#include "workqueue.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace tut
+{
+    struct LLVolumeMgrData
+    {
+        LLVolumeMgrData()
+        :   mReplyQueue("VolumeMgrTestReply")
+        {
+            mParams.setType(LL_PCODE_PROFILE_SQUARE, LL_PCODE_PATH_LINE);
+        }
+
+        // What the main loop would do, for up to ten seconds
+        bool waitForLOD(LLVolumeMgr& mgr, S32 lod)
+        {
+            for (S32 i = 0; i < 10000 && !mgr.isLODReady(mParams, lod); ++i)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                mReplyQueue.runPending();
+            }
+            return mgr.isLODReady(mParams, lod);
+        }
+
+        LL::WorkQueue mReplyQueue;
+        LLVolumeParams mParams;
+    };
+
+    typedef test_group<LLVolumeMgrData> factory;
+    typedef factory::object object;
+}
+
+namespace
+{
+    tut::factory llvolumemgr_test_factory("LLVolumeMgr");
+}
+
+namespace tut
+{
+    template<> template<>
+    void object::test<1>()
+    {
+        //
+        // without queues every LOD is generated on the spot and shared
+        //
+        LLVolumeMgr mgr;
+        mgr.useMutex();
+
+        LLVolume* first = mgr.refVolumeOrPlaceholder(mParams, 0);
+        LLVolume* second = mgr.refVolume(mParams, 0);
+        ensure("generated", first != NULL);
+        ensure("shared", first == second);
+        ensure_equals("detail", first->getDetail(), LLVolumeLODGroup::getVolumeScaleFromDetail(0));
+        ensure("ready", mgr.isLODReady(mParams, 0));
+
+        mgr.unrefVolume(first);
+        mgr.unrefVolume(second);
+        ensure("group released", mgr.getGroup(mParams) == NULL);
+    }
+
+    template<> template<>
+    void object::test<2>()
+    {
+        //
+        // a missing LOD comes back as the coarsest one until the pool
+        // built it and the reply queue installed it
+        //
+        LLVolumeMgr mgr;
+        mgr.useMutex();
+        mgr.useThreadPool("VolumeMgrTest", 1, "VolumeMgrTestReply");
+
+        const U32 serial = mgr.getInstallSerial();
+        LLVolume* placeholder = mgr.refVolumeOrPlaceholder(mParams, 0);
+        ensure("placeholder", placeholder != NULL);
+        ensure_equals("coarsest detail", placeholder->getDetail(),
+                      LLVolumeLODGroup::getVolumeScaleFromDetail(LLVolumeLODGroup::NUM_LODS - 1));
+
+        ensure("installed", waitForLOD(mgr, 0));
+        ensure("serial moved", mgr.getInstallSerial() != serial);
+
+        LLVolume* generated = mgr.refVolumeOrPlaceholder(mParams, 0);
+        ensure("not the placeholder", generated != placeholder);
+        ensure_equals("full detail", generated->getDetail(), LLVolumeLODGroup::getVolumeScaleFromDetail(0));
+
+        mgr.unrefVolume(generated);
+        mgr.unrefVolume(placeholder);
+        ensure("group released", mgr.getGroup(mParams) == NULL);
+    }
+
+    template<> template<>
+    void object::test<3>()
+    {
+        //
+        // a reply that arrives after the reply queue closed is dropped, and
+        // the volume it carried is freed
+        //
+        LLVolumeMgr mgr;
+        mgr.useMutex();
+        mgr.useThreadPool("VolumeMgrTest", 1, "VolumeMgrTestReply");
+
+        // Hold the only worker until the reply queue is closed
+        LL::WorkQueue::ptr_t worker = LL::WorkQueue::getInstance("VolumeMgrTest");
+        ensure("worker queue", worker != nullptr);
+        std::atomic<bool> closed(false);
+        worker->post([&closed]()
+            {
+                while (!closed)
+                {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+            });
+
+        const U32 serial = mgr.getInstallSerial();
+        LLVolume* placeholder = mgr.refVolumeOrPlaceholder(mParams, 0);
+        ensure("placeholder", placeholder != NULL);
+        const S32 points = LLVolume::sNumMeshPoints;
+
+        mReplyQueue.close();
+        closed = true;
+
+        // The worker runs its jobs in order, so once this one ran the
+        // volume was generated and its reply dropped
+        std::atomic<bool> done(false);
+        worker->post([&done]() { done = true; });
+        for (S32 i = 0; i < 10000 && !done; ++i)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        ensure("generated", done);
+
+        mReplyQueue.runPending();
+        ensure_equals("serial unchanged", mgr.getInstallSerial(), serial);
+        ensure("not installed", !mgr.isLODReady(mParams, 0));
+        ensure_equals("volume freed", (S32)LLVolume::sNumMeshPoints, points);
+
+        mgr.unrefVolume(placeholder);
+        ensure("group released", mgr.getGroup(mParams) == NULL);
+    }
+}
@@ -57,16 +57,55 @@ LLCDResult LLConvexDecompositionVHACD::initSystem()
     return LLCD_OK;
 }
 
+thread_local LLConvexDecompositionVHACD::ThreadState* LLConvexDecompositionVHACD::sThreadState = nullptr;
+
+LLConvexDecompositionVHACD::ThreadState::ThreadState(VHACD::IVHACD::IUserLogger* logger)
+{
+    mVHACD = VHACD::CreateVHACD();
+    mVHACDCallback.setVHACD(mVHACD);
+
+    mVHACDParameters.m_callback = &mVHACDCallback;
+    mVHACDParameters.m_logger = logger;
+}
+
+LLConvexDecompositionVHACD::ThreadState::~ThreadState()
+{
+    mBoundDecomp = nullptr;
+    mVHACD->Release();
+}
+
 LLCDResult LLConvexDecompositionVHACD::initThread()
 {
+    if (!instanceExists())
+    {
+        return LLCD_NULL_PTR;
+    }
+
+    if (!sThreadState)
+    {
+        LLConvexDecompositionVHACD* self = LLSimpleton::getInstance();
+        sThreadState = new ThreadState(&self->mVHACDLogger);
+
+        // Start from the defaults, not from whatever the last request on
+        // another thread set
+        sThreadState->mVHACDParameters = self->mDefaultParameters;
+        sThreadState->mVHACDParameters.m_callback = &sThreadState->mVHACDCallback;
+    }
     return LLCD_OK;
 }
 
 LLCDResult LLConvexDecompositionVHACD::quitThread()
 {
+    delete sThreadState;
+    sThreadState = nullptr;
     return LLCD_OK;
 }
 
+LLConvexDecompositionVHACD::ThreadState& LLConvexDecompositionVHACD::getThreadState()
+{
+    return sThreadState ? *sThreadState : *mMainState;
+}
+
 LLCDResult LLConvexDecompositionVHACD::quitSystem()
 {
     deleteSingleton();
@@ -76,10 +115,7 @@ LLCDResult LLConvexDecompositionVHACD::quitSystem()
 LLConvexDecompositionVHACD::LLConvexDecompositionVHACD()
 {
     //Create our vhacd instance and setup default parameters
-    mVHACD = VHACD::CreateVHACD();
-
-    mVHACDParameters.m_callback = &mVHACDCallback;
-    mVHACDParameters.m_logger = &mVHACDLogger;
+    mMainState = std::make_unique<ThreadState>(&mVHACDLogger);
 
     mDecompStages[0].mName = "Analyze";
     mDecompStages[0].mDescription = nullptr;
@@ -202,31 +238,36 @@ LLConvexDecompositionVHACD::LLConvexDecompositionVHACD()
         }
         }
     }
+
+    mDefaultParameters = mMainState->mVHACDParameters;
 }
 
 LLConvexDecompositionVHACD::~LLConvexDecompositionVHACD()
 {
-    mBoundDecomp = nullptr;
+    mMainState.reset();
     mDecompData.clear();
-
-    mVHACD->Release();
 }
 
 void LLConvexDecompositionVHACD::genDecomposition(int& decomp)
 {
-    int new_decomp_id = static_cast<int>(mDecompData.size()) + 1;
+    std::lock_guard<std::mutex> lock(mDecompMutex);
+    // Ids are never reused, the size of the map would repeat once one
+    // was deleted
+    int new_decomp_id = ++mLastDecompID;
     mDecompData[new_decomp_id] = LLDecompData();
     decomp = new_decomp_id;
 }
 
 void LLConvexDecompositionVHACD::deleteDecomposition(int decomp)
 {
+    std::lock_guard<std::mutex> lock(mDecompMutex);
     auto iter = mDecompData.find(decomp);
     if (iter != mDecompData.end())
     {
-        if (mBoundDecomp == &iter->second)
+        ThreadState& state = getThreadState();
+        if (state.mBoundDecomp == &iter->second)
         {
-            mBoundDecomp = nullptr;
+            state.mBoundDecomp = nullptr;
         }
         mDecompData.erase(iter);
     }
@@ -234,15 +275,18 @@ void LLConvexDecompositionVHACD::deleteDecomposition(int decomp)
 
 void LLConvexDecompositionVHACD::bindDecomposition(int decomp)
 {
+    std::lock_guard<std::mutex> lock(mDecompMutex);
+    ThreadState& state = getThreadState();
     auto iter = mDecompData.find(decomp);
     if (iter != mDecompData.end())
     {
-        mBoundDecomp = &iter->second;
+        // Elements of an unordered_map don't move when others are added
+        state.mBoundDecomp = &iter->second;
     }
     else
     {
         LL_WARNS() << "Failed to bind unknown decomposition: " << decomp << LL_ENDL;
-        mBoundDecomp = nullptr;
+        state.mBoundDecomp = nullptr;
     }
 }
 
@@ -250,15 +294,15 @@ LLCDResult LLConvexDecompositionVHACD::setParam(const char* name, float val)
 {
     if (name == std::string("Num Hulls"))
     {
-        mVHACDParameters.m_maxConvexHulls = llclamp(ll_round(val), 1, MAX_HULLS);
+        getThreadState().mVHACDParameters.m_maxConvexHulls = llclamp(ll_round(val), 1, MAX_HULLS);
     }
     else if (name == std::string("Num Vertices"))
     {
-        mVHACDParameters.m_maxNumVerticesPerCH = llclamp(ll_round(val), 3, MAX_VERTICES_PER_HULL);
+        getThreadState().mVHACDParameters.m_maxNumVerticesPerCH = llclamp(ll_round(val), 3, MAX_VERTICES_PER_HULL);
     }
     else if (name == std::string("Error Tolerance"))
     {
-        mVHACDParameters.m_minimumVolumePercentErrorAllowed = val;
+        getThreadState().mVHACDParameters.m_minimumVolumePercentErrorAllowed = val;
     }
     return LLCD_OK;
 }
@@ -272,30 +316,34 @@ LLCDResult LLConvexDecompositionVHACD::setParam(const char* name, int val)
 {
     if (name == std::string("Fill Mode"))
     {
-        mVHACDParameters.m_fillMode = (VHACD::FillMode)val;
+        getThreadState().mVHACDParameters.m_fillMode = (VHACD::FillMode)val;
     }
     else if (name == std::string("Voxel Resolution"))
     {
-        mVHACDParameters.m_resolution = val;
+        getThreadState().mVHACDParameters.m_resolution = val;
     }
     return LLCD_OK;
 }
 
 LLCDResult LLConvexDecompositionVHACD::setMeshData( const LLCDMeshData* data, bool vertex_based )
 {
-    if (!mBoundDecomp)
+    ThreadState& state = getThreadState();
+
+    if (!state.mBoundDecomp)
     {
         return LLCD_NULL_PTR;
     }
 
-    return mBoundDecomp->mSourceMesh.from(data, vertex_based);
+    return state.mBoundDecomp->mSourceMesh.from(data, vertex_based);
 }
 
 LLCDResult LLConvexDecompositionVHACD::registerCallback(int stage, llcdCallbackFunc callback )
 {
+    ThreadState& state = getThreadState();
+
     if (stage == 0)
     {
-        mVHACDCallback.setCallbackFunc(callback);
+        state.mVHACDCallback.setCallbackFunc(callback);
         return LLCD_OK;
     }
     else
@@ -306,7 +354,9 @@ LLCDResult LLConvexDecompositionVHACD::registerCallback(int stage, llcdCallbackF
 
 LLCDResult LLConvexDecompositionVHACD::executeStage(int stage)
 {
-    if (!mBoundDecomp)
+    ThreadState& state = getThreadState();
+
+    if (!state.mBoundDecomp)
     {
         return LLCD_NULL_PTR;
     }
@@ -316,15 +366,15 @@ LLCDResult LLConvexDecompositionVHACD::executeStage(int stage)
         return LLCD_INVALID_STAGE;
     }
 
-    mBoundDecomp->mDecomposedHulls.clear();
+    state.mBoundDecomp->mDecomposedHulls.clear();
 
-    const auto& decomp_mesh = mBoundDecomp->mSourceMesh;
-    if (!mVHACD->Compute((const double* const)decomp_mesh.mVertices.data(), static_cast<uint32_t>(decomp_mesh.mVertices.size()), (const uint32_t* const)decomp_mesh.mIndices.data(), static_cast<uint32_t>(decomp_mesh.mIndices.size()), mVHACDParameters))
+    const auto& decomp_mesh = state.mBoundDecomp->mSourceMesh;
+    if (!state.mVHACD->Compute((const double* const)decomp_mesh.mVertices.data(), static_cast<uint32_t>(decomp_mesh.mVertices.size()), (const uint32_t* const)decomp_mesh.mIndices.data(), static_cast<uint32_t>(decomp_mesh.mIndices.size()), state.mVHACDParameters))
     {
         return LLCD_INVALID_HULL_DATA;
     }
 
-    uint32_t num_nulls = mVHACD->GetNConvexHulls();
+    uint32_t num_nulls = state.mVHACD->GetNConvexHulls();
     if (num_nulls == 0)
     {
         return LLCD_INVALID_HULL_DATA;
@@ -333,37 +383,39 @@ LLCDResult LLConvexDecompositionVHACD::executeStage(int stage)
     for (uint32_t i = 0; num_nulls > i; ++i)
     {
         VHACD::IVHACD::ConvexHull ch;
-        if (!mVHACD->GetConvexHull(i, ch))
+        if (!state.mVHACD->GetConvexHull(i, ch))
             continue;
 
         LLConvexMesh out_mesh;
         out_mesh.setVertices(ch.m_points);
         out_mesh.setIndices(ch.m_triangles);
 
-        mBoundDecomp->mDecomposedHulls.push_back(std::move(out_mesh));
+        state.mBoundDecomp->mDecomposedHulls.push_back(std::move(out_mesh));
     }
 
-    mVHACD->Clean();
+    state.mVHACD->Clean();
 
     return LLCD_OK;
 }
 
 LLCDResult LLConvexDecompositionVHACD::buildSingleHull()
 {
+    ThreadState& state = getThreadState();
+
     LL_INFOS() << "Building single hull mesh" << LL_ENDL;
-    if (!mBoundDecomp || mBoundDecomp->mSourceMesh.mVertices.empty())
+    if (!state.mBoundDecomp || state.mBoundDecomp->mSourceMesh.mVertices.empty())
     {
         return LLCD_NULL_PTR;
     }
 
-    mBoundDecomp->mSingleHullMesh.clear();
+    state.mBoundDecomp->mSingleHullMesh.clear();
 
     VHACD::QuickHull quickhull;
-    uint32_t num_tris = quickhull.ComputeConvexHull(mBoundDecomp->mSourceMesh.mVertices, MAX_VERTICES_PER_HULL);
+    uint32_t num_tris = quickhull.ComputeConvexHull(state.mBoundDecomp->mSourceMesh.mVertices, MAX_VERTICES_PER_HULL);
     if (num_tris > 0)
     {
-        mBoundDecomp->mSingleHullMesh.setVertices(quickhull.GetVertices());
-        mBoundDecomp->mSingleHullMesh.setIndices(quickhull.GetIndices());
+        state.mBoundDecomp->mSingleHullMesh.setVertices(quickhull.GetVertices());
+        state.mBoundDecomp->mSingleHullMesh.setIndices(quickhull.GetIndices());
 
         return LLCD_OK;
     }
@@ -373,37 +425,43 @@ LLCDResult LLConvexDecompositionVHACD::buildSingleHull()
 
 int LLConvexDecompositionVHACD::getNumHullsFromStage(int stage)
 {
-    if (!mBoundDecomp || stage != 0)
+    ThreadState& state = getThreadState();
+
+    if (!state.mBoundDecomp || stage != 0)
     {
         return 0;
     }
 
-    return narrow(mBoundDecomp->mDecomposedHulls.size());
+    return narrow(state.mBoundDecomp->mDecomposedHulls.size());
 }
 
 LLCDResult LLConvexDecompositionVHACD::getSingleHull( LLCDHull* hullOut )
 {
+    ThreadState& state = getThreadState();
+
     memset( hullOut, 0, sizeof(LLCDHull) );
 
-    if (!mBoundDecomp)
+    if (!state.mBoundDecomp)
     {
         return LLCD_NULL_PTR;
     }
 
-    if (mBoundDecomp->mSingleHullMesh.vertices.empty())
+    if (state.mBoundDecomp->mSingleHullMesh.vertices.empty())
     {
         return LLCD_INVALID_HULL_DATA;
     }
 
-    mBoundDecomp->mSingleHullMesh.to(hullOut);
+    state.mBoundDecomp->mSingleHullMesh.to(hullOut);
     return LLCD_OK;
 }
 
 LLCDResult LLConvexDecompositionVHACD::getHullFromStage( int stage, int hull, LLCDHull* hullOut )
 {
+    ThreadState& state = getThreadState();
+
     memset( hullOut, 0, sizeof(LLCDHull) );
 
-    if (!mBoundDecomp)
+    if (!state.mBoundDecomp)
     {
         return LLCD_NULL_PTR;
     }
@@ -413,19 +471,21 @@ LLCDResult LLConvexDecompositionVHACD::getHullFromStage( int stage, int hull, LL
         return LLCD_INVALID_STAGE;
     }
 
-    if (mBoundDecomp->mDecomposedHulls.empty() || mBoundDecomp->mDecomposedHulls.size() <= hull)
+    if (state.mBoundDecomp->mDecomposedHulls.empty() || state.mBoundDecomp->mDecomposedHulls.size() <= hull)
     {
         return LLCD_REQUEST_OUT_OF_RANGE;
     }
 
-    mBoundDecomp->mDecomposedHulls[hull].to(hullOut);
+    state.mBoundDecomp->mDecomposedHulls[hull].to(hullOut);
     return LLCD_OK;
 }
 
 LLCDResult LLConvexDecompositionVHACD::getMeshFromStage( int stage, int hull, LLCDMeshData* meshDataOut )
 {
+    ThreadState& state = getThreadState();
+
     memset( meshDataOut, 0, sizeof(LLCDMeshData));
-    if (!mBoundDecomp)
+    if (!state.mBoundDecomp)
     {
         return LLCD_NULL_PTR;
     }
@@ -435,17 +495,19 @@ LLCDResult LLConvexDecompositionVHACD::getMeshFromStage( int stage, int hull, LL
         return LLCD_INVALID_STAGE;
     }
 
-    if (mBoundDecomp->mDecomposedHulls.empty() || mBoundDecomp->mDecomposedHulls.size() <= hull)
+    if (state.mBoundDecomp->mDecomposedHulls.empty() || state.mBoundDecomp->mDecomposedHulls.size() <= hull)
     {
         return LLCD_REQUEST_OUT_OF_RANGE;
     }
 
-    mBoundDecomp->mDecomposedHulls[hull].to(meshDataOut);
+    state.mBoundDecomp->mDecomposedHulls[hull].to(meshDataOut);
     return LLCD_OK;
 }
 
 LLCDResult LLConvexDecompositionVHACD::getMeshFromHull( LLCDHull* hullIn, LLCDMeshData* meshOut )
 {
+    ThreadState& state = getThreadState();
+
     memset(meshOut, 0, sizeof(LLCDMeshData));
 
     LLVHACDMesh inMesh(hullIn);
@@ -454,10 +516,10 @@ LLCDResult LLConvexDecompositionVHACD::getMeshFromHull( LLCDHull* hullIn, LLCDMe
     uint32_t num_tris = quickhull.ComputeConvexHull(inMesh.mVertices, MAX_VERTICES_PER_HULL);
     if (num_tris > 0)
     {
-        mMeshFromHullData.setVertices(quickhull.GetVertices());
-        mMeshFromHullData.setIndices(quickhull.GetIndices());
+        state.mMeshFromHullData.setVertices(quickhull.GetVertices());
+        state.mMeshFromHullData.setIndices(quickhull.GetIndices());
 
-        mMeshFromHullData.to(meshOut);
+        state.mMeshFromHullData.to(meshOut);
         return LLCD_OK;
     }
 
@@ -466,6 +528,8 @@ LLCDResult LLConvexDecompositionVHACD::getMeshFromHull( LLCDHull* hullIn, LLCDMe
 
 LLCDResult LLConvexDecompositionVHACD::generateSingleHullMeshFromMesh(LLCDMeshData* meshIn, LLCDMeshData* meshOut)
 {
+    ThreadState& state = getThreadState();
+
     memset( meshOut, 0, sizeof(LLCDMeshData) );
 
     LLVHACDMesh inMesh(meshIn, true);
@@ -474,10 +538,10 @@ LLCDResult LLConvexDecompositionVHACD::generateSingleHullMeshFromMesh(LLCDMeshDa
     uint32_t num_tris = quickhull.ComputeConvexHull(inMesh.mVertices, MAX_VERTICES_PER_HULL);
     if (num_tris > 0)
     {
-        mSingleHullMeshFromMeshData.setVertices(quickhull.GetVertices());
-        mSingleHullMeshFromMeshData.setIndices(quickhull.GetIndices());
+        state.mSingleHullMeshFromMeshData.setVertices(quickhull.GetVertices());
+        state.mSingleHullMeshFromMeshData.setIndices(quickhull.GetIndices());
 
-        mSingleHullMeshFromMeshData.to(meshOut);
+        state.mSingleHullMeshFromMeshData.to(meshOut);
         return LLCD_OK;
     }
 
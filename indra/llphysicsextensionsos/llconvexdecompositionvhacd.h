@@ -32,6 +32,8 @@
 #include "llsingleton.h"
 #include "llmath.h"
 
+#include <memory>
+#include <mutex>
 #include <vector>
 
 #include "VHACD.h"
@@ -55,7 +57,12 @@ class LLConvexDecompositionVHACD : public LLSimpleton<LLConvexDecompositionVHACD
 
             if(mCallbackFunc)
             {
-                mCallbackFunc(out_msg.c_str(), ll_round(static_cast<F32>(stageProgress)), ll_round(static_cast<F32>(overallProgress)));
+                // A zero return asks to stop, VHACD checks for it between steps
+                if (!mCallbackFunc(out_msg.c_str(), ll_round(static_cast<F32>(stageProgress)), ll_round(static_cast<F32>(overallProgress)))
+                    && mVHACD)
+                {
+                    mVHACD->Cancel();
+                }
             }
         }
 
@@ -64,7 +71,13 @@ class LLConvexDecompositionVHACD : public LLSimpleton<LLConvexDecompositionVHACD
             mCallbackFunc = func;
         }
 
+        void setVHACD(VHACD::IVHACD* vhacd)
+        {
+            mVHACD = vhacd;
+        }
+
     private:
+        VHACD::IVHACD* mVHACD = nullptr;
         std::string mCurrentStage;
         std::string mCurrentOperation;
         llcdCallbackFunc mCallbackFunc = nullptr;
@@ -323,17 +336,37 @@ private:
         std::vector<LLConvexMesh> mDecomposedHulls;
     };
 
-    std::unordered_map<int, LLDecompData> mDecompData;
+    // Everything a decomposition in progress touches.  Each thread that
+    // called initThread() has its own so that decompositions can run
+    // concurrently, other threads share mMainState.
+    struct ThreadState
+    {
+        ThreadState(VHACD::IVHACD::IUserLogger* logger);
+        ~ThreadState();
 
-    LLDecompData* mBoundDecomp = nullptr;
+        LLDecompData* mBoundDecomp = nullptr;
 
-    VHACD::IVHACD* mVHACD = nullptr;
-    VHACDCallback  mVHACDCallback;
-    VHACDLogger    mVHACDLogger;
-    VHACD::IVHACD::Parameters mVHACDParameters;
+        VHACD::IVHACD* mVHACD = nullptr;
+        VHACDCallback  mVHACDCallback;
+        VHACD::IVHACD::Parameters mVHACDParameters;
 
-    LLConvexMesh mMeshFromHullData;
-    LLConvexMesh mSingleHullMeshFromMeshData;
+        LLConvexMesh mMeshFromHullData;
+        LLConvexMesh mSingleHullMeshFromMeshData;
+    };
+
+    ThreadState& getThreadState();
+
+    static thread_local ThreadState* sThreadState;
+
+    // Guards mDecompData, decompositions are created and deleted on the
+    // main thread while others are bound on worker threads
+    std::mutex mDecompMutex;
+    std::unordered_map<int, LLDecompData> mDecompData;
+    int mLastDecompID = 0;
+
+    VHACDLogger    mVHACDLogger;
+    VHACD::IVHACD::Parameters mDefaultParameters;
+    std::unique_ptr<ThreadState> mMainState;
 };
 
 #endif //LL_CONVEX_DECOMP_UTIL_VHACD_H
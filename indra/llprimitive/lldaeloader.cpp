@@ -60,6 +60,8 @@
 #include <boost/regex.hpp>
 #include <boost/algorithm/string/replace.hpp>
 
+#include <mutex>
+
 // <FS:ND> Logging for error and warning messages from colladadom
 #include "dae/daeErrorHandler.h"
 
@@ -113,6 +115,12 @@ std::string colladaVersion[VERSIONTYPE_COUNT+1] =
 
 const U32 LIMIT_MATERIALS_OUTPUT = 12;
 
+// Meshes are converted on worker threads, see LLDAELoader::OpenFile.
+// collada-dom resolves URIs through shared tables and reference counts
+// elements without atomics, so looking up the sources of a face is done
+// under this lock.  Reading the arrays afterwards is not.
+static std::mutex sDomSourceMutex;
+
 bool get_dom_sources(const domInputLocalOffset_Array& inputs, S32& pos_offset, S32& tc_offset, S32& norm_offset, S32 &idx_stride,
     domSource* &pos_source, domSource* &tc_source, domSource* &norm_source)
 {
@@ -201,6 +209,8 @@ LLModel::EModelStatus load_face_from_dom_triangles(
 
     S32 idx_stride = 0;
 
+    std::unique_lock<std::mutex> dom_lock(sDomSourceMutex);
+
     if ( !get_dom_sources(inputs, pos_offset, tc_offset, norm_offset, idx_stride, pos_source, tc_source, norm_source))
     {
         LLSD args;
@@ -226,6 +236,8 @@ LLModel::EModelStatus load_face_from_dom_triangles(
     domListOfFloats& tc = tc_source ? tc_source->getFloat_array()->getValue() : dummy ;
     domListOfFloats& n = norm_source ? norm_source->getFloat_array()->getValue() : dummy ;
 
+    dom_lock.unlock();
+
     if (pos_source)
     {
         if(v.getCount() == 0)
@@ -429,6 +441,8 @@ LLModel::EModelStatus load_face_from_dom_polylist(
 
     S32 idx_stride = 0;
 
+    std::unique_lock<std::mutex> dom_lock(sDomSourceMutex);
+
     if (!get_dom_sources(inputs, pos_offset, tc_offset, norm_offset, idx_stride, pos_source, tc_source, norm_source))
     {
         LL_WARNS() << "Bad element." << LL_ENDL;
@@ -465,6 +479,8 @@ LLModel::EModelStatus load_face_from_dom_polylist(
         n = norm_source->getFloat_array()->getValue();
     }
 
+    dom_lock.unlock();
+
     LLVolumeFace::VertexMapData::PointMap point_map;
 
     U32 cur_idx = 0;
@@ -698,6 +714,9 @@ LLModel::EModelStatus load_face_from_dom_polygons(std::vector<LLVolumeFace>& fac
     domListOfFloats* t = NULL;
 
     U32 stride = 0;
+
+    std::unique_lock<std::mutex> dom_lock(sDomSourceMutex);
+
     for (U32 i = 0; i < inputs.getCount(); ++i)
     {
         stride = llmax((U32) inputs[i]->getOffset()+1, stride);
@@ -757,6 +776,8 @@ LLModel::EModelStatus load_face_from_dom_polygons(std::vector<LLVolumeFace>& fac
         }
     }
 
+    dom_lock.unlock();
+
     domP_Array& ps = poly->getP_array();
 
     //make a triangle list in <verts>
@@ -1112,41 +1133,66 @@ bool LLDAELoader::OpenFile(const std::string& filename)
     mTransform.condition();
 
     U32 submodel_limit = count > 0 ? mGeneratedModelLimit/count : 0;
+
+    // Convert the meshes in parallel.  The database and the labels are
+    // only touched here, each job fills its own slot and the results are
+    // gathered in document order, so the model list and the log come out
+    // the same as a serial load.
+    struct MeshJob
+    {
+        domMesh* mMesh = NULL;
+        std::string mLabel;
+        std::vector<LLPointer<LLModel> > mModels;
+        LLSD mLog;
+    };
+    std::vector<MeshJob> mesh_jobs;
+    mesh_jobs.reserve(count);
     for (daeInt idx = 0; idx < count; ++idx)
-    { //build map of domEntities to LLModel
+    {
         domMesh* mesh = NULL;
         db->getElement((daeElement**) &mesh, idx, NULL, COLLADA_TYPE_MESH);
 
         if (mesh)
         {
+            MeshJob& job = mesh_jobs.emplace_back();
+            job.mMesh = mesh;
+            job.mLabel = getLodlessLabel(mesh);
+        }
+    }
 
-            std::vector<LLModel*> models;
+    parallelFor(mesh_jobs.size(), [&](size_t i)
+    {
+        MeshJob& job = mesh_jobs[i];
+        std::vector<LLModel*> models;
+        loadModelsFromDomMesh(job.mMesh, job.mLabel, models, submodel_limit, job.mLog);
+        job.mModels.assign(models.begin(), models.end());
+    });
 
-            loadModelsFromDomMesh(mesh, models, submodel_limit);
+    for (MeshJob& job : mesh_jobs)
+    { //build map of domEntities to LLModel
+        for (LLSD::array_const_iterator it = job.mLog.beginArray(); it != job.mLog.endArray(); ++it)
+        {
+            mWarningsArray.append(*it);
+        }
 
-            std::vector<LLModel*>::iterator i;
-            i = models.begin();
-            while (i != models.end())
+        for (const LLPointer<LLModel>& mdl : job.mModels)
+        {
+            if(mdl->getStatus() != LLModel::NO_ERRORS)
             {
-                LLModel* mdl = *i;
-                if(mdl->getStatus() != LLModel::NO_ERRORS)
-                {
-                    // <FS:Beq> Fix deprecated arithmetic between different enum types (ERROR_MODEL + EModelStatus)
-                    // Ugly fix. could use a helper instead but its only called in two places.
-                    // setLoadState(ERROR_MODEL + mdl->getStatus());
-                    setLoadState(
-                        static_cast<LLModelLoader::eLoadState>(
-                                 static_cast<S32>(ERROR_MODEL) + static_cast<S32>(mdl->getStatus())));
-                    // </FS:Beq>
-                    return false; //abort
-                }
+                // <FS:Beq> Fix deprecated arithmetic between different enum types (ERROR_MODEL + EModelStatus)
+                // Ugly fix. could use a helper instead but its only called in two places.
+                // setLoadState(ERROR_MODEL + mdl->getStatus());
+                setLoadState(
+                    static_cast<LLModelLoader::eLoadState>(
+                             static_cast<S32>(ERROR_MODEL) + static_cast<S32>(mdl->getStatus())));
+                // </FS:Beq>
+                return false; //abort
+            }
 
-                if (mdl && validate_model(mdl))
-                {
-                    mModelList.push_back(mdl);
-                    mModelsMap[mesh].push_back(mdl);
-                }
-                i++;
+            if (validate_model(mdl))
+            {
+                mModelList.push_back(mdl);
+                mModelsMap[job.mMesh].push_back(mdl);
             }
         }
     }
@@ -2641,7 +2687,8 @@ bool LLDAELoader::addVolumeFacesFromDomMesh(LLModel* pModel,domMesh* mesh, LLSD&
 //static diff version supports creating multiple models when material counts spill
 // over the 8 face server-side limit
 //
-bool LLDAELoader::loadModelsFromDomMesh(domMesh* mesh, std::vector<LLModel*>& models_out, U32 submodel_limit)
+bool LLDAELoader::loadModelsFromDomMesh(domMesh* mesh, const std::string& model_name, std::vector<LLModel*>& models_out, U32 submodel_limit,
+                                        LLSD& log_msg)
 {
 
     LLVolumeParams volume_params;
@@ -2651,7 +2698,6 @@ bool LLDAELoader::loadModelsFromDomMesh(domMesh* mesh, std::vector<LLModel*>& mo
 
     LLModel* ret = new LLModel(volume_params, 0.f);
 
-    std::string model_name = getLodlessLabel(mesh);
     // <FS:Beq> Support altenate LOD naming conventions
     // ret->mLabel = model_name + sLODSuffix[mLod];
     if ( sLODSuffix[mLod].size() > 0 )
@@ -2671,7 +2717,7 @@ bool LLDAELoader::loadModelsFromDomMesh(domMesh* mesh, std::vector<LLModel*>& mo
 
     // Get the whole set of volume faces
     //
-    addVolumeFacesFromDomMesh(ret, mesh, mWarningsArray);
+    addVolumeFacesFromDomMesh(ret, mesh, log_msg);
 
     U32 volume_faces = ret->getNumVolumeFaces();
 
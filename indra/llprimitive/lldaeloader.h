@@ -99,9 +99,11 @@ protected:
     static bool addVolumeFacesFromDomMesh(LLModel* model, domMesh* mesh, LLSD& log_msg);
 
     // Loads a mesh breaking it into one or more models as necessary
-    // to get around volume face limitations while retaining >8 materials
+    // to get around volume face limitations while retaining >8 materials.
+    // Runs on worker threads, warnings go to log_msg rather than the loader.
     //
-    bool loadModelsFromDomMesh(domMesh* mesh, std::vector<LLModel*>& models_out, U32 submodel_limit);
+    bool loadModelsFromDomMesh(domMesh* mesh, const std::string& model_name, std::vector<LLModel*>& models_out, U32 submodel_limit,
+                               LLSD& log_msg);
 
     static std::string getElementLabel(daeElement *element);
     static size_t getSuffixPosition(const std::string& label);
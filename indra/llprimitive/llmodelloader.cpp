@@ -32,12 +32,23 @@
 #include "llcallbacklist.h"
 
 #include "llmatrix4a.h"
+#include "threadpool.h"
 #include <boost/bind.hpp>
 #include <boost/exception/diagnostic_information.hpp>
 
 #include "../llxml/llcontrol.h"
 
+#include <thread>
+
 std::list<LLModelLoader*> LLModelLoader::sActiveLoaderList;
+S32 LLModelLoader::sImportThreads = -1;
+
+namespace
+{
+    // Created by the first loader, gone with the last one.  Both happen on
+    // the main thread, as ThreadPool::start() listens on the "LLApp" pump.
+    std::weak_ptr<LL::ThreadPool> sImportPool;
+}
 
 static void stretch_extents(const LLModel* model, const LLMatrix4a& mat, LLVector4a& min, LLVector4a& max, bool& first_transform)
 {
@@ -145,12 +156,33 @@ LLModelLoader::LLModelLoader(
     assert_main_thread();
     sActiveLoaderList.push_back(this) ;
     mWarningsArray = LLSD::emptyArray();
+
+    if (sImportThreads != 0)
+    {
+        mImportPool = sImportPool.lock();
+        if (!mImportPool)
+        {
+            // Imports are rare and the user waits on them, so unlike the
+            // per-frame pools this one may take most of the machine
+            S32 threads = sImportThreads;
+            if (threads < 0)
+            {
+                threads = llclamp((S32)std::thread::hardware_concurrency() - 1, 1, 16);
+            }
+            mImportPool = std::make_shared<LL::ThreadPool>("MeshImport", threads);
+            mImportPool->start();
+            sImportPool = mImportPool;
+        }
+    }
 }
 
 LLModelLoader::~LLModelLoader()
 {
     assert_main_thread();
     sActiveLoaderList.remove(this);
+
+    // the last loader out joins the pool threads
+    mImportPool.reset();
 }
 
 void LLModelLoader::run()
@@ -405,6 +437,13 @@ bool LLModelLoader::isAlive(LLModelLoader* loader)
     return *iter == loader ;
 }
 
+void LLModelLoader::parallelFor(size_t count, const std::function<void(size_t)>& func)
+{
+    LL_PROFILE_ZONE_SCOPED;
+
+    ll_parallel_for(mImportPool.get(), count, func);
+}
+
 void LLModelLoader::loadModelCallback()
 {
     if (!LLApp::isExiting())
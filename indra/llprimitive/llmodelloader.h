@@ -29,8 +29,11 @@
 
 #include "llmodel.h"
 #include "llthread.h"
+#include "llparallelfor.h"
 #include <boost/function.hpp>
+#include <functional>
 #include <list>
+#include <memory>
 
 class LLJoint;
 
@@ -223,6 +226,23 @@ protected:
 
     static std::list<LLModelLoader*> sActiveLoaderList;
     static bool isAlive(LLModelLoader* loader);
+
+public:
+    // Width of the "MeshImport" pool behind parallelFor(), shared by the
+    // loaders alive at the same time and started by the first of them.
+    // Below 0 picks from the core count, 0 loads on the loader thread
+    // only.  "ThreadPoolSizes" overrides it.
+    static S32 sImportThreads;
+
+protected:
+    // Call func(0) to func(count - 1) spread over the "MeshImport" pool,
+    // the calling thread taking jobs too.  Returns once all calls are done.
+    // Callers keep results per index so that the output does not depend
+    // on which thread ran what.
+    void parallelFor(size_t count, const std::function<void(size_t)>& func);
+
+private:
+    std::shared_ptr<LL::ThreadPool> mImportPool;
 };
 
 #endif  // LL_LLMODELLOADER_H
@@ -0,0 +1,267 @@
+/**
+ * @file llmodelsimplifier.cpp
+ * @brief Multithreaded level of detail and physics mesh generation for LLModel
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llmodelsimplifier.h"
+
+#include "llmemory.h"
+#include "llmeshoptimizer.h"
+#include "llparallelfor.h"
+#include "llvector4a.h"
+#include "threadpool.h"
+
+#include <thread>
+
+namespace
+{
+    struct SimplifyJob
+    {
+        LLModel* mSource;
+        LLModel* mTarget;
+        S32 mFace;
+        F32 mDecimator;
+        bool mPhysics;
+        bool mFailed = false;
+    };
+
+    void simplify_job(SimplifyJob& job, F32 error_threshold)
+    {
+        const LLVolumeFace& src = job.mSource->getVolumeFace(job.mFace);
+        LLVolumeFace& dst = job.mTarget->getVolumeFace(job.mFace);
+
+        if (job.mDecimator <= 1.f || src.mNumIndices < 3)
+        {
+            dst = src;
+            return;
+        }
+
+        // Physics meshes don't need normals or uvs, try the sloppy
+        // mode first like the upload floater's sloppy option
+        F32 res = -1.f;
+        if (job.mPhysics)
+        {
+            res = LLModelSimplifier::simplifyFace(src, dst, job.mDecimator, error_threshold,
+                                                  LLModelSimplifier::SIMPLIFY_SLOPPY);
+        }
+        if (res < 0.f)
+        {
+            res = LLModelSimplifier::simplifyFace(src, dst, job.mDecimator, error_threshold,
+                                                  LLModelSimplifier::SIMPLIFY_FULL);
+        }
+        if (res < 0.f)
+        {
+            dst = src;
+            job.mFailed = true;
+        }
+    }
+}
+
+LLModelSimplifier::LLModelSimplifier(const std::string& name, S32 threads)
+{
+    if (threads <= 0)
+    {
+        threads = llclamp((S32)std::thread::hardware_concurrency() - 1, 1, 16);
+    }
+    mThreadPool = std::make_unique<LL::ThreadPool>(name, threads);
+    mThreadPool->start();
+}
+
+LLModelSimplifier::~LLModelSimplifier()
+{
+    mThreadPool->close();
+}
+
+void LLModelSimplifier::simplify(const std::vector<LLPointer<LLModel> >& models, const Targets& targets, std::vector<Result>& results)
+{
+    LL_PROFILE_ZONE_SCOPED;
+
+    results.clear();
+    results.resize(models.size());
+
+    std::vector<SimplifyJob> jobs;
+
+    // Create all the target models up front, jobs only write their own face
+    for (size_t i = 0; i < models.size(); ++i)
+    {
+        LLModel* base = models[i];
+        const S32 num_faces = base->getNumVolumeFaces();
+
+        for (S32 lod = 0; lod < LLModel::NUM_LODS; ++lod)
+        {
+            const F32 ratio = targets.mRatio[lod];
+            if (ratio <= 0.f)
+            {
+                continue;
+            }
+
+            LLVolumeParams volume_params;
+            volume_params.setType(LL_PCODE_PROFILE_SQUARE, LL_PCODE_PATH_LINE);
+            LLModel* target = new LLModel(volume_params, 0.f);
+            target->mLabel = base->mLabel;
+            target->mSubmodelID = base->mSubmodelID;
+            target->setNumVolumeFaces(num_faces);
+            results[i].mLOD[lod] = target;
+
+            for (S32 face = 0; face < num_faces; ++face)
+            {
+                target->getVolumeFace(face).mNormalizedScale = base->getVolumeFace(face).mNormalizedScale;
+
+                SimplifyJob& job = jobs.emplace_back();
+                job.mSource = base;
+                job.mTarget = target;
+                job.mFace = face;
+                job.mDecimator = ratio >= 1.f ? 1.f : 1.f / ratio;
+                job.mPhysics = lod == LLModel::LOD_PHYSICS;
+            }
+        }
+    }
+
+    ll_parallel_for(mThreadPool.get(), jobs.size(), [&](size_t i)
+    {
+        simplify_job(jobs[i], targets.mErrorThreshold);
+    });
+
+    size_t job = 0;
+    for (size_t i = 0; i < models.size(); ++i)
+    {
+        for (S32 lod = 0; lod < LLModel::NUM_LODS; ++lod)
+        {
+            if (results[i].mLOD[lod].isNull())
+            {
+                continue;
+            }
+            for (S32 face = 0; face < models[i]->getNumVolumeFaces(); ++face, ++job)
+            {
+                results[i].mFailedFaces += jobs[job].mFailed ? 1 : 0;
+            }
+        }
+    }
+}
+
+// static
+F32 LLModelSimplifier::simplifyFace(const LLVolumeFace& face, LLVolumeFace& new_face, F32 indices_decimator, F32 error_threshold,
+                                    ESimplifyMode mode, FaceStats* stats)
+{
+    LL_PROFILE_ZONE_SCOPED;
+
+    S32 size_indices = face.mNumIndices;
+    if (size_indices < 3)
+    {
+        return -1;
+    }
+
+    S32 size = (size_indices * sizeof(U16) + 0xF) & ~0xF;
+    U16* output_indices = (U16*)ll_aligned_malloc_16(size);
+
+    // SIMPLIFY_FULL works on the indices as they are, the face was remapped
+    // on load.  SIMPLIFY_SLOPPY ignores all topology, including normals and
+    // uvs, so a shadow index buffer would be pointless.  The other two weld
+    // vertices that only differ in the ignored attributes, so edges along
+    // those seams can collapse; the result then uses the first of each set
+    // of welded vertices.
+    U16* shadow_indices = NULL;
+    if (mode == SIMPLIFY_NO_NORMALS)
+    {
+        shadow_indices = (U16*)ll_aligned_malloc_16(size);
+        LLMeshOptimizer::generateShadowIndexBufferU16(shadow_indices, face.mIndices, size_indices, face.mPositions, NULL, face.mTexCoords, face.mNumVertices);
+    }
+    else if (mode == SIMPLIFY_NO_UVS)
+    {
+        shadow_indices = (U16*)ll_aligned_malloc_16(size);
+        LLMeshOptimizer::generateShadowIndexBufferU16(shadow_indices, face.mIndices, size_indices, face.mPositions, NULL, NULL, face.mNumVertices);
+    }
+
+    const U16* source_indices = shadow_indices ? shadow_indices : face.mIndices;
+
+    S32 target_indices = 0;
+    F32 result_error = 0; // how far from original the model is, 1 == 100%
+    S32 size_new_indices = 0;
+
+    if (indices_decimator > 0)
+    {
+        target_indices = llclamp(llfloor(size_indices / indices_decimator), 3, (S32)size_indices); // leave at least one triangle
+    }
+    else
+    {
+        target_indices = 3;
+    }
+
+    size_new_indices = (S32)LLMeshOptimizer::simplify(
+        output_indices,
+        source_indices,
+        size_indices,
+        face.mPositions,
+        face.mNumVertices,
+        sizeof(LLVector4a),
+        target_indices,
+        error_threshold,
+        mode == SIMPLIFY_SLOPPY,
+        &result_error);
+
+    if (stats)
+    {
+        stats->mTargetIndices = target_indices;
+        stats->mNewIndices = size_new_indices;
+        stats->mResultError = result_error;
+    }
+
+    // Copy old values
+    new_face = face;
+
+    if (size_new_indices < 3)
+    {
+        // Face got optimized away
+        // Generate empty triangle
+        new_face.resizeIndices(3);
+        new_face.resizeVertices(1);
+        memset(new_face.mIndices, 0, sizeof(U16) * 3);
+        new_face.mPositions[0].clear(); // set first vertice to 0
+        new_face.mNormals[0].clear();
+        new_face.mTexCoords[0].setZero();
+    }
+    else
+    {
+        // Assign new values
+        new_face.resizeIndices(size_new_indices); // will wipe out mIndices, so new_face can't substitute output
+        S32 idx_size = (size_new_indices * sizeof(U16) + 0xF) & ~0xF;
+        LLVector4a::memcpyNonAliased16((F32*)new_face.mIndices, (F32*)output_indices, idx_size);
+
+        // Clear unused values
+        new_face.optimize();
+    }
+
+    ll_aligned_free_16(output_indices);
+    ll_aligned_free_16(shadow_indices);
+
+    if (size_new_indices < 3)
+    {
+        // At least one triangle is needed
+        return -1;
+    }
+
+    return (F32)size_indices / (F32)size_new_indices;
+}
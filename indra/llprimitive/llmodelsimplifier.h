@@ -0,0 +1,102 @@
+/**
+ * @file llmodelsimplifier.h
+ * @brief Multithreaded level of detail and physics mesh generation for LLModel
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLMODELSIMPLIFIER_H
+#define LL_LLMODELSIMPLIFIER_H
+
+#include "llmodel.h"
+#include "llpointer.h"
+#include "threadpool_fwd.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// Generates the lower levels of detail and the physics mesh of models with
+// LLMeshOptimizer.  Every face of every model and level is a separate job,
+// spread over a pool of worker threads, so a batch of models finishes in
+// about the time of its largest face rather than the sum of all of them.
+// Doesn't need the viewer, see llmodelsimplify_libtest.
+class LLModelSimplifier
+{
+public:
+    enum ESimplifyMode
+    {
+        SIMPLIFY_FULL = 0,      // keep topology, normals and uvs
+        SIMPLIFY_NO_NORMALS,    // may collapse across normal seams
+        SIMPLIFY_NO_UVS,        // may collapse across normal and uv seams
+        SIMPLIFY_SLOPPY,        // ignore topology entirely
+    };
+
+    struct Targets
+    {
+        // Triangle count of each level relative to the source model.
+        // Ratios of 1 or more copy the source faces, 0 or less skip the
+        // level.  The defaults match the upload floater's auto mode.
+        F32 mRatio[LLModel::NUM_LODS] = { 1.f / 27.f, 1.f / 9.f, 1.f / 3.f, 1.f, 1.f / 27.f };
+
+        // As LLMeshOptimizer::simplify(), 1 == 100%
+        F32 mErrorThreshold = 1.f;
+    };
+
+    struct Result
+    {
+        // Null for skipped levels
+        LLPointer<LLModel> mLOD[LLModel::NUM_LODS];
+
+        // Faces left as the source because simplification failed
+        U32 mFailedFaces = 0;
+    };
+
+    struct FaceStats
+    {
+        S32 mTargetIndices = 0;
+        S32 mNewIndices = 0;
+        F32 mResultError = 0.f;
+    };
+
+    // threads <= 0 picks a width from the core count.  The "ThreadPoolSizes"
+    // setting overrides it by name, like any LL::ThreadPool, and the name
+    // must not be in use by another live pool.
+    LLModelSimplifier(const std::string& name = "MeshSimplify", S32 threads = 0);
+    ~LLModelSimplifier();
+
+    // Simplify every model for every level in targets.  Each level is
+    // made from the source faces, so levels don't wait on each other.
+    // Blocks until done, the calling thread takes jobs too.
+    void simplify(const std::vector<LLPointer<LLModel> >& models, const Targets& targets, std::vector<Result>& results);
+
+    // Simplify src into dst, aiming for src.mNumIndices / indices_decimator
+    // indices.  Returns the reached decimation, or -1 if nothing was left,
+    // in which case dst is a single degenerate triangle.  Thread safe.
+    static F32 simplifyFace(const LLVolumeFace& src, LLVolumeFace& dst, F32 indices_decimator, F32 error_threshold,
+                            ESimplifyMode mode, FaceStats* stats = nullptr);
+
+private:
+    std::unique_ptr<LL::ThreadPool> mThreadPool;
+};
+
+#endif // LL_LLMODELSIMPLIFIER_H
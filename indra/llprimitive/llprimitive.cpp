@@ -202,6 +202,7 @@ LLPrimitive::LLPrimitive()
 
     mMaterial = LL_MCODE_STONE;
     mVolumep  = NULL;
+    mAllowVolumePlaceholder = false;
 
     mChanged  = UNCHANGED;
 
@@ -816,7 +817,8 @@ bool LLPrimitive::setVolume(const LLVolumeParams &volume_params, const S32 detai
             }
         }
 
-        volumep = sVolumeManager->refVolume(volume_params, detail);
+        volumep = mAllowVolumePlaceholder ? sVolumeManager->refVolumeOrPlaceholder(volume_params, detail)
+                                          : sVolumeManager->refVolume(volume_params, detail);
         if (volumep == mVolumep)
         {
             sVolumeManager->unrefVolume( volumep );  // LLVolumeMgr::refVolume() creates a reference, but we don't need a second one.
@@ -596,6 +596,7 @@ protected:
     LLVector3           mAcceleration;      // are we under constant acceleration?
     LLVector3           mAngularVelocity;   // angular velocity
     LLPointer<LLVolume> mVolumep;
+    bool                mAllowVolumePlaceholder; // setVolume() may hand out another LOD while the requested one is generated
     LLPrimTextureList   mTextureList;       // list of texture GUIDs, scales, offsets
     U8                  mMaterial;          // Material code
     U8                  mNumTEs;            // # of faces on the primitve
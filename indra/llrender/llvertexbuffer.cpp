@@ -36,6 +36,7 @@
 #include "llshadermgr.h"
 #include "llglslshader.h"
 #include "llmemory.h"
+#include "lltlsfallocator.h"
 #include <glm/gtc/type_ptr.hpp>
 
 //Next Highest Power Of Two
@@ -321,14 +322,21 @@ static void delete_buffers(S32 count, GLuint* buffers)
 
 #define ANALYZE_VBO_POOL 0
 
+// sGLRenderBufferOffset after GL_ARRAY_BUFFER was bound without setting up
+// attribute pointers
+static constexpr U32 UNKNOWN_OFFSET = 0xFFFFFFFF;
+
 // VBO Pool interface
 class LLVBOPool
 {
     public:
     virtual ~LLVBOPool() = default;
-    virtual void allocate(GLenum type, U32 size, GLuint& name, U8*& data) = 0;
-    virtual void free(GLenum type, U32 size, GLuint name, U8* data) = 0;
+    // offset is where owner's data starts in buffer name
+    virtual void allocate(LLVertexBuffer* owner, GLenum type, U32 size, GLuint& name, U32& offset, U8*& data) = 0;
+    virtual void free(GLenum type, U32 size, GLuint name, U32 offset, U8* data) = 0;
     virtual U64 getVramBytesUsed() = 0;
+    // called between frames, when no vertex buffer is mid draw
+    virtual void defragment() { }
 };
 
 // VBO Pool for Apple GPUs (as in M1/M2 etc, not Intel macs)
@@ -343,7 +351,7 @@ public:
         return mAllocated;
     }
 
-    void allocate(GLenum type, U32 size, GLuint& name, U8*& data) override
+    void allocate(LLVertexBuffer* owner, GLenum type, U32 size, GLuint& name, U32& offset, U8*& data) override
     {
         LL_PROFILE_ZONE_SCOPED_CATEGORY_VERTEX;
         STOP_GLERROR;
@@ -353,6 +361,7 @@ public:
         llassert(size >= 2);  // any buffer size smaller than a single index is nonsensical
 
         mAllocated += size;
+        offset = 0;
 
         { //allocate a new buffer
             LL_PROFILE_GPU_ZONE("vbo alloc");
@@ -363,7 +372,7 @@ public:
         }
     }
 
-    void free(GLenum type, U32 size, GLuint name, U8* data) override
+    void free(GLenum type, U32 size, GLuint name, U32 offset, U8* data) override
     {
         LL_PROFILE_ZONE_SCOPED_CATEGORY_VERTEX;
         llassert(type == GL_ARRAY_BUFFER || type == GL_ELEMENT_ARRAY_BUFFER);
@@ -430,7 +439,7 @@ public:
         size += block_size - (size % block_size);
     }
 
-    void allocate(GLenum type, U32 size, GLuint& name, U8*& data) override
+    void allocate(LLVertexBuffer* owner, GLenum type, U32 size, GLuint& name, U32& offset, U8*& data) override
     {
         LL_PROFILE_ZONE_SCOPED_CATEGORY_VERTEX;
         llassert(type == GL_ARRAY_BUFFER || type == GL_ELEMENT_ARRAY_BUFFER);
@@ -441,6 +450,7 @@ public:
         mDistributed += size;
         adjustSize(size);
         mAllocated += size;
+        offset = 0;
 
         auto& pool = type == GL_ELEMENT_ARRAY_BUFFER ? mIBOPool : mVBOPool;
 
@@ -461,6 +471,7 @@ public:
             else
             {
                 LLVertexBuffer::sGLRenderBuffer = name;
+                LLVertexBuffer::sGLRenderBufferOffset = UNKNOWN_OFFSET;
             }
 
             data = (U8*)ll_aligned_malloc_16(size);
@@ -486,7 +497,7 @@ public:
         clean();
     }
 
-    void free(GLenum type, U32 size, GLuint name, U8* data) override
+    void free(GLenum type, U32 size, GLuint name, U32 offset, U8* data) override
     {
         LL_PROFILE_ZONE_SCOPED_CATEGORY_VERTEX;
         llassert(type == GL_ARRAY_BUFFER || type == GL_ELEMENT_ARRAY_BUFFER);
@@ -605,6 +616,364 @@ public:
     }
 };
 
+// VBO Pool that places vertex and index data in ranges of a few large
+// buffers, so most vertex buffers share a GL buffer object and drawing one
+// after another costs no glBindBuffer.  Ranges are placed by
+// LLTLSFAllocator, buffers too big for an arena get a GL buffer of their
+// own.  An arena that empties out is released, and when enough space sits
+// free across the arenas of a type, the emptiest one is drained into the
+// others a little each frame.
+class LLArenaVBOPool final : public LLVBOPool
+{
+public:
+    static constexpr U32 ARENA_SIZE = 16 * 1024 * 1024;
+    // larger requests get a buffer of their own
+    static constexpr U32 MAX_RANGE_SIZE = ARENA_SIZE / 4;
+    // offsets stay aligned for any vertex attribute or index type
+    static constexpr U32 RANGE_ALIGNMENT = 16;
+    // bytes moved out of a draining arena per frame
+    static constexpr U32 DRAIN_BUDGET = 1024 * 1024;
+
+    struct Range
+    {
+        LLTLSFAllocator::handle_t mHandle;
+        LLVertexBuffer* mOwner;
+    };
+
+    struct Arena
+    {
+        Arena(GLuint name) : mGLName(name), mAllocator(ARENA_SIZE, RANGE_ALIGNMENT) { }
+
+        GLuint mGLName;
+        LLTLSFAllocator mAllocator;
+        std::unordered_map<U32, Range> mRanges; // by offset
+        bool mDraining = false; // takes no new ranges while being emptied
+    };
+
+    typedef std::vector<std::unique_ptr<Arena>> arena_list_t;
+
+    arena_list_t mVBOArenas;
+    arena_list_t mIBOArenas;
+
+    U64 mDedicated = 0; // bytes in buffers of their own
+
+    ~LLArenaVBOPool() override
+    {
+        for (arena_list_t* arenas : { &mVBOArenas, &mIBOArenas })
+        {
+            for (auto& arena : *arenas)
+            {
+                delete_buffers(1, &arena->mGLName);
+            }
+            arenas->clear();
+        }
+    }
+
+    U64 getVramBytesUsed() override
+    {
+        return (U64)(mVBOArenas.size() + mIBOArenas.size()) * ARENA_SIZE + mDedicated;
+    }
+
+    arena_list_t& getArenas(GLenum type)
+    {
+        return type == GL_ELEMENT_ARRAY_BUFFER ? mIBOArenas : mVBOArenas;
+    }
+
+    // GL_ARRAY_BUFFER or GL_ELEMENT_ARRAY_BUFFER was bound to name
+    static void setBound(GLenum type, GLuint name)
+    {
+        if (type == GL_ELEMENT_ARRAY_BUFFER)
+        {
+            LLVertexBuffer::sGLRenderIndices = name;
+        }
+        else
+        {
+            LLVertexBuffer::sGLRenderBuffer = name;
+            LLVertexBuffer::sGLRenderBufferOffset = UNKNOWN_OFFSET;
+        }
+    }
+
+    static GLuint genBuffer(GLenum type, U32 size)
+    {
+        LL_PROFILE_GPU_ZONE("vbo alloc");
+        GLuint name = gen_buffer();
+        glBindBuffer(type, name);
+        glBufferData(type, size, nullptr, GL_DYNAMIC_DRAW);
+        setBound(type, name);
+        return name;
+    }
+
+    static void deleteBuffer(GLuint name)
+    {
+        // names are recycled, don't let a new buffer look bound already
+        if (LLVertexBuffer::sGLRenderBuffer == name)
+        {
+            LLVertexBuffer::sGLRenderBuffer = 0;
+        }
+        if (LLVertexBuffer::sGLRenderIndices == name)
+        {
+            LLVertexBuffer::sGLRenderIndices = 0;
+        }
+        delete_buffers(1, &name);
+    }
+
+    static bool place(Arena& arena, LLVertexBuffer* owner, U32 size, U32& offset)
+    {
+        LLTLSFAllocator::handle_t handle = arena.mAllocator.allocate(size);
+        if (handle == LLTLSFAllocator::INVALID_HANDLE)
+        {
+            return false;
+        }
+        offset = arena.mAllocator.getOffset(handle);
+        arena.mRanges[offset] = { handle, owner };
+        return true;
+    }
+
+    Arena* findArena(GLenum type, GLuint name)
+    {
+        for (auto& arena : getArenas(type))
+        {
+            if (arena->mGLName == name)
+            {
+                return arena.get();
+            }
+        }
+        return nullptr;
+    }
+
+    void allocate(LLVertexBuffer* owner, GLenum type, U32 size, GLuint& name, U32& offset, U8*& data) override
+    {
+        LL_PROFILE_ZONE_SCOPED_CATEGORY_VERTEX;
+        llassert(type == GL_ARRAY_BUFFER || type == GL_ELEMENT_ARRAY_BUFFER);
+        llassert(name == 0); // non zero name indicates a gl name that wasn't freed
+        llassert(data == nullptr);  // non null data indicates a buffer that wasn't freed
+        llassert(size >= 2);  // any buffer size smaller than a single index is nonsensical
+
+        data = (U8*)ll_aligned_malloc_16(size);
+
+        if (size > MAX_RANGE_SIZE)
+        {
+            LL_PROFILE_ZONE_NAMED_CATEGORY_VERTEX("vbo arena dedicated");
+            name = genBuffer(type, size);
+            offset = 0;
+            mDedicated += size;
+            return;
+        }
+
+        arena_list_t& arenas = getArenas(type);
+
+        // earlier arenas fill first so later ones are the ones left to empty out
+        Arena* target = nullptr;
+        for (auto& arena : arenas)
+        {
+            if (!arena->mDraining && place(*arena, owner, size, offset))
+            {
+                target = arena.get();
+                break;
+            }
+        }
+
+        if (!target)
+        {
+            // space is short after all, stop draining before growing
+            for (auto& arena : arenas)
+            {
+                if (arena->mDraining && place(*arena, owner, size, offset))
+                {
+                    arena->mDraining = false;
+                    target = arena.get();
+                    break;
+                }
+            }
+        }
+
+        if (!target)
+        {
+            LL_PROFILE_ZONE_NAMED_CATEGORY_VERTEX("vbo arena grow");
+            arenas.push_back(std::make_unique<Arena>(genBuffer(type, ARENA_SIZE)));
+            target = arenas.back().get();
+            llverify(place(*target, owner, size, offset));
+        }
+
+        name = target->mGLName;
+    }
+
+    void free(GLenum type, U32 size, GLuint name, U32 offset, U8* data) override
+    {
+        LL_PROFILE_ZONE_SCOPED_CATEGORY_VERTEX;
+        llassert(type == GL_ARRAY_BUFFER || type == GL_ELEMENT_ARRAY_BUFFER);
+        llassert(size >= 2);
+        llassert(name != 0);
+        llassert(data != nullptr);
+
+        ll_aligned_free_16(data);
+
+        Arena* arena = findArena(type, name);
+        if (!arena)
+        {
+            llassert(offset == 0);
+            llassert(mDedicated >= size);
+            mDedicated -= size;
+            deleteBuffer(name);
+            return;
+        }
+
+        auto iter = arena->mRanges.find(offset);
+        llassert(iter != arena->mRanges.end());
+        if (iter != arena->mRanges.end())
+        {
+            arena->mAllocator.free(iter->second.mHandle);
+            arena->mRanges.erase(iter);
+        }
+
+        if (arena->mAllocator.isEmpty())
+        {
+            releaseArena(type, arena);
+        }
+    }
+
+    // drop an empty arena, keeping the last one of each type around
+    void releaseArena(GLenum type, Arena* arena)
+    {
+        arena_list_t& arenas = getArenas(type);
+        if (arenas.size() < 2)
+        {
+            arena->mDraining = false;
+            return;
+        }
+
+        for (auto iter = arenas.begin(); iter != arenas.end(); ++iter)
+        {
+            if (iter->get() == arena)
+            {
+                LL_PROFILE_ZONE_NAMED_CATEGORY_VERTEX("vbo arena release");
+                deleteBuffer(arena->mGLName);
+                arenas.erase(iter);
+                return;
+            }
+        }
+    }
+
+    // Move up to DRAIN_BUDGET bytes out of the emptiest arena of a type once
+    // the other arenas have room for all of it and an arena's worth of space
+    // is going unused overall.
+    void drain(GLenum type)
+    {
+        arena_list_t& arenas = getArenas(type);
+        if (arenas.size() < 2)
+        {
+            return;
+        }
+
+        // keep on with the arena already draining, if any
+        Arena* source = nullptr;
+        U64 free_bytes = 0;
+        for (auto& arena : arenas)
+        {
+            free_bytes += arena->mAllocator.getFreeBytes();
+            if (arena->mDraining)
+            {
+                source = arena.get();
+                break;
+            }
+            if (!source || arena->mAllocator.getUsedBytes() < source->mAllocator.getUsedBytes())
+            {
+                source = arena.get();
+            }
+        }
+
+        if (!source->mDraining)
+        {
+            const U64 room = free_bytes - source->mAllocator.getFreeBytes();
+            if (free_bytes < ARENA_SIZE || room < source->mAllocator.getUsedBytes())
+            {
+                return;
+            }
+            source->mDraining = true;
+        }
+
+        LL_PROFILE_ZONE_NAMED_CATEGORY_VERTEX("vbo arena drain");
+
+        glBindBuffer(GL_COPY_READ_BUFFER, source->mGLName);
+
+        U32 moved = 0;
+        GLuint bound_target = 0;
+        while (moved < DRAIN_BUDGET && !source->mRanges.empty())
+        {
+            auto iter = source->mRanges.begin();
+            const U32 src_offset = iter->first;
+            const Range range = iter->second;
+            const U32 size = source->mAllocator.getSize(range.mHandle);
+
+            Arena* target = nullptr;
+            U32 dst_offset = 0;
+            for (auto& arena : arenas)
+            {
+                if (arena.get() != source && place(*arena, range.mOwner, size, dst_offset))
+                {
+                    target = arena.get();
+                    break;
+                }
+            }
+
+            if (!target)
+            {
+                // too fragmented to take it, try again later
+                break;
+            }
+
+            if (bound_target != target->mGLName)
+            {
+                glBindBuffer(GL_COPY_WRITE_BUFFER, target->mGLName);
+                bound_target = target->mGLName;
+            }
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, src_offset, dst_offset, size);
+
+            relocate(type, range.mOwner, source->mGLName, src_offset, target->mGLName, dst_offset);
+
+            source->mAllocator.free(range.mHandle);
+            source->mRanges.erase(iter);
+            moved += size;
+        }
+
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+        if (source->mAllocator.isEmpty())
+        {
+            releaseArena(type, source);
+        }
+    }
+
+    static void relocate(GLenum type, LLVertexBuffer* owner, GLuint old_name, U32 old_offset, GLuint name, U32 offset)
+    {
+        if (type == GL_ELEMENT_ARRAY_BUFFER)
+        {
+            llassert(owner->mGLIndices == old_name && owner->mGLIndicesOffset == old_offset);
+            owner->mGLIndices = name;
+            owner->mGLIndicesOffset = offset;
+        }
+        else
+        {
+            llassert(owner->mGLBuffer == old_name && owner->mGLBufferOffset == old_offset);
+            owner->mGLBuffer = name;
+            owner->mGLBufferOffset = offset;
+
+            if (LLVertexBuffer::sGLRenderBuffer == old_name && LLVertexBuffer::sGLRenderBufferOffset == old_offset)
+            {
+                LLVertexBuffer::sGLRenderBufferOffset = UNKNOWN_OFFSET;
+            }
+        }
+    }
+
+    void defragment() override
+    {
+        LL_PROFILE_ZONE_SCOPED_CATEGORY_VERTEX;
+        drain(GL_ARRAY_BUFFER);
+        drain(GL_ELEMENT_ARRAY_BUFFER);
+    }
+};
+
 static LLVBOPool* sVBOPool = nullptr;
 
 void LLVertexBufferData::drawWithMatrix()
@@ -679,6 +1048,7 @@ U64 LLVertexBuffer::getBytesAllocated()
 //
 //static
 U32 LLVertexBuffer::sGLRenderBuffer = 0;
+U32 LLVertexBuffer::sGLRenderBufferOffset = 0;
 U32 LLVertexBuffer::sGLRenderIndices = 0;
 U32 LLVertexBuffer::sLastMask = 0;
 U32 LLVertexBuffer::sVertexCount = 0;
@@ -922,14 +1292,14 @@ void LLVertexBuffer::drawRange(U32 mode, U32 start, U32 end, U32 count, U32 indi
     gGL.syncMatrices();
     STOP_GLERROR;
     glDrawRangeElements(sGLMode[mode], start, end, count, mIndicesType,
-        (GLvoid*) (indices_offset * (size_t) mIndicesStride));
+        (GLvoid*) (mGLIndicesOffset + indices_offset * (size_t) mIndicesStride));
     STOP_GLERROR;
 }
 
 void LLVertexBuffer::drawRangeFast(U32 mode, U32 start, U32 end, U32 count, U32 indices_offset) const
 {
     glDrawRangeElements(sGLMode[mode], start, end, count, mIndicesType,
-        (GLvoid*)(indices_offset * (size_t)mIndicesStride));
+        (GLvoid*)(mGLIndicesOffset + indices_offset * (size_t)mIndicesStride));
 }
 
 
@@ -952,7 +1322,7 @@ void LLVertexBuffer::drawArrays(U32 mode, U32 first, U32 count) const
 }
 
 //static
-void LLVertexBuffer::initClass(LLWindow* window)
+void LLVertexBuffer::initClass(LLWindow* window, bool use_arenas)
 {
     llassert(sVBOPool == nullptr);
 
@@ -961,6 +1331,11 @@ void LLVertexBuffer::initClass(LLWindow* window)
         LL_INFOS() << "VBO Pooling Disabled" << LL_ENDL;
         sVBOPool = new LLAppleVBOPool();
     }
+    else if (use_arenas)
+    {
+        LL_INFOS() << "VBO Arenas Enabled" << LL_ENDL;
+        sVBOPool = new LLArenaVBOPool();
+    }
     else
     {
         LL_INFOS() << "VBO Pooling Enabled" << LL_ENDL;
@@ -978,6 +1353,15 @@ void LLVertexBuffer::initClass(LLWindow* window)
 #endif
 }
 
+//static
+void LLVertexBuffer::defragment()
+{
+    if (sVBOPool)
+    {
+        sVBOPool->defragment();
+    }
+}
+
 //static
 void LLVertexBuffer::unbind()
 {
@@ -1028,6 +1412,9 @@ LLVertexBuffer::LLVertexBuffer(U32 typemask)
 // NOTE: must not be LLPointer<LLVertexBuffer> to avoid breaking non-ref-counted LLVertexBuffer instances
 static std::vector<LLVertexBuffer*> sMappedBuffers;
 
+// set on threads filling regions flagged by mapRegions()
+static thread_local bool sDeferredMap = false;
+
 //static
 void LLVertexBuffer::flushBuffers()
 {
@@ -1118,7 +1505,7 @@ void LLVertexBuffer::genBuffer(U32 size)
         llassert(mMappedData == nullptr);
 
         mSize = size;
-        sVBOPool->allocate(GL_ARRAY_BUFFER, mSize, mGLBuffer, mMappedData);
+        sVBOPool->allocate(this, GL_ARRAY_BUFFER, mSize, mGLBuffer, mGLBufferOffset, mMappedData);
     }
 }
 
@@ -1133,7 +1520,7 @@ void LLVertexBuffer::genIndices(U32 size)
         llassert(mGLIndices == 0);
         llassert(mMappedIndexData == nullptr);
         mIndicesSize = size;
-        sVBOPool->allocate(GL_ELEMENT_ARRAY_BUFFER, mIndicesSize, mGLIndices, mMappedIndexData);
+        sVBOPool->allocate(this, GL_ELEMENT_ARRAY_BUFFER, mIndicesSize, mGLIndices, mGLIndicesOffset, mMappedIndexData);
     }
 }
 
@@ -1191,11 +1578,18 @@ void LLVertexBuffer::destroyGLBuffer()
         //llassert(sVBOPool);
         if (sVBOPool)
         {
-            sVBOPool->free(GL_ARRAY_BUFFER, mSize, mGLBuffer, mMappedData);
+            sVBOPool->free(GL_ARRAY_BUFFER, mSize, mGLBuffer, mGLBufferOffset, mMappedData);
+        }
+
+        // the name and offset may be handed to a buffer with another layout
+        if (sGLRenderBuffer == mGLBuffer && sGLRenderBufferOffset == mGLBufferOffset)
+        {
+            sGLRenderBufferOffset = UNKNOWN_OFFSET;
         }
 
         mSize = 0;
         mGLBuffer = 0;
+        mGLBufferOffset = 0;
         mMappedData = nullptr;
     }
 }
@@ -1208,11 +1602,12 @@ void LLVertexBuffer::destroyGLIndices()
         //llassert(sVBOPool);
         if (sVBOPool)
         {
-            sVBOPool->free(GL_ELEMENT_ARRAY_BUFFER, mIndicesSize, mGLIndices, mMappedIndexData);
+            sVBOPool->free(GL_ELEMENT_ARRAY_BUFFER, mIndicesSize, mGLIndices, mGLIndicesOffset, mMappedIndexData);
         }
 
         mIndicesSize = 0;
         mGLIndices = 0;
+        mGLIndicesOffset = 0;
         mMappedIndexData = nullptr;
     }
 }
@@ -1292,6 +1687,11 @@ bool expand_region(LLVertexBuffer::MappedRegion& region, U32 start, U32 end)
 U8* LLVertexBuffer::mapVertexBuffer(LLVertexBuffer::AttributeType type, U32 index, S32 count)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_VERTEX;
+    if (sDeferredMap)
+    { // already flagged by mapRegions
+        return mMappedData+mOffsets[type]+sTypeSize[type]*index;
+    }
+
     _mapBuffer();
 
     if (count == -1)
@@ -1329,6 +1729,11 @@ U8* LLVertexBuffer::mapVertexBuffer(LLVertexBuffer::AttributeType type, U32 inde
 U8* LLVertexBuffer::mapIndexBuffer(U32 index, S32 count)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_VERTEX;
+    if (sDeferredMap)
+    { // already flagged by mapRegions
+        return mMappedIndexData + sizeof(U16)*index;
+    }
+
     _mapBuffer();
 
     if (count == -1)
@@ -1363,6 +1768,39 @@ U8* LLVertexBuffer::mapIndexBuffer(U32 index, S32 count)
     return mMappedIndexData + sizeof(U16)*index;
 }
 
+void LLVertexBuffer::mapRegions(U32 type_mask, U32 index, U32 count, U32 indices_index, U32 indices_count)
+{
+    llassert(!sDeferredMap);
+
+    if (count > 0)
+    {
+        type_mask &= mTypeMask;
+        for (U32 type = 0; type < TYPE_MAX; ++type)
+        {
+            if (type_mask & (1 << type))
+            {
+                mapVertexBuffer((AttributeType) type, index, count);
+            }
+        }
+    }
+
+    if (indices_count > 0)
+    {
+        mapIndexBuffer(indices_index, indices_count);
+    }
+}
+
+LLVertexBuffer::DeferredMapScope::DeferredMapScope()
+{
+    llassert(!sDeferredMap);
+    sDeferredMap = true;
+}
+
+LLVertexBuffer::DeferredMapScope::~DeferredMapScope()
+{
+    sDeferredMap = false;
+}
+
 // flush the given byte range
 //  target -- "target" parameter for glBufferSubData
 //  start -- first byte to copy
@@ -1395,13 +1833,16 @@ void LLVertexBuffer::flush_vbo(GLenum target, U32 start, U32 end, void* data, U8
 
             constexpr U32 block_size = 65536;
 
+            // where this buffer's range starts in the GL buffer
+            const U32 base = target == GL_ARRAY_BUFFER ? mGLBufferOffset : mGLIndicesOffset;
+
             for (U32 i = start; i <= end; i += block_size)
             {
                 //LL_PROFILE_ZONE_NAMED_CATEGORY_VERTEX("glBufferSubData block");
                 //LL_PROFILE_GPU_ZONE("glBufferSubData");
                 U32 tend = llmin(i + block_size, end);
                 U32 size = tend - i + 1;
-                glBufferSubData(target, i, size, (U8*) data + (i-start));
+                glBufferSubData(target, base + i, size, (U8*) data + (i-start));
             }
         }
     }
@@ -1449,12 +1890,14 @@ void LLVertexBuffer::_unmapBuffer()
             mGLBuffer = gen_buffer();
             glBindBuffer(GL_ARRAY_BUFFER, mGLBuffer);
             sGLRenderBuffer = mGLBuffer;
+            sGLRenderBufferOffset = UNKNOWN_OFFSET;
             glBufferData(GL_ARRAY_BUFFER, mSize, mMappedData, GL_STATIC_DRAW);
         }
         else if (mGLBuffer != sGLRenderBuffer)
         {
             glBindBuffer(GL_ARRAY_BUFFER, mGLBuffer);
             sGLRenderBuffer = mGLBuffer;
+            sGLRenderBufferOffset = UNKNOWN_OFFSET;
         }
         STOP_GLERROR;
 
@@ -1488,6 +1931,7 @@ void LLVertexBuffer::_unmapBuffer()
             {
                 glBindBuffer(GL_ARRAY_BUFFER, mGLBuffer);
                 sGLRenderBuffer = mGLBuffer;
+                sGLRenderBufferOffset = UNKNOWN_OFFSET;
             }
 
             U32 start = 0;
@@ -1704,9 +2148,17 @@ void LLVertexBuffer::setBuffer()
     {
         glBindBuffer(GL_ARRAY_BUFFER, mGLBuffer);
         sGLRenderBuffer = mGLBuffer;
+        sGLRenderBufferOffset = mGLBufferOffset;
 
         setupVertexBuffer();
     }
+    else if (sGLRenderBufferOffset != mGLBufferOffset)
+    {
+        // another range of the same GL buffer, only the attribute pointers move
+        sGLRenderBufferOffset = mGLBufferOffset;
+        setupVertexBuffer();
+        sLastMask = data_mask;
+    }
     else if (sLastMask != data_mask)
     {
         setupVertexBuffer();
@@ -1727,7 +2179,7 @@ void LLVertexBuffer::setBuffer()
 void LLVertexBuffer::setupVertexBuffer()
 {
     STOP_GLERROR;
-    U8* base = nullptr;
+    U8* base = (U8*)(size_t) mGLBufferOffset;
 
     U32 data_mask = LLGLSLShader::sCurBoundShaderPtr->mAttributeMask;
 
@@ -109,7 +109,8 @@ public:
         return *this;
     }
 
-    static void initClass(LLWindow* window);
+    // use_arenas places buffers in ranges of a few large GL buffers
+    static void initClass(LLWindow* window, bool use_arenas = false);
     static void cleanupClass();
     static void setupClientArrays(U32 data_mask);
     static void drawArrays(U32 mode, const std::vector<LLVector3>& pos);
@@ -117,6 +118,9 @@ public:
 
     static void unbind(); //unbind any bound vertex buffer
 
+    // compact the VBO pool, only between frames as buffers may move
+    static void defragment();
+
     //get the size of a vertex with the given typemask
     static U32 calcVertexSize(const U32& typemask);
 
@@ -175,6 +179,7 @@ public:
 
 protected:
     friend class LLRender;
+    friend class LLArenaVBOPool;
 
     ~LLVertexBuffer(); // use unref()
 
@@ -199,6 +204,22 @@ public:
     U8*     mapVertexBuffer(AttributeType type, U32 index, S32 count = -1);
     U8*     mapIndexBuffer(U32 index, S32 count = -1);
 
+    // flag [index, index + count) of the attributes in type_mask and
+    // [indices_index, indices_index + indices_count) of the indices as mapped
+    // ahead of filling them under a DeferredMapScope
+    void    mapRegions(U32 type_mask, U32 index, U32 count, U32 indices_index, U32 indices_count);
+
+    // While one is alive on a thread, map*Buffer and the strider accessors on
+    // that thread only hand out pointers into the client side data.  Lets
+    // worker threads fill ranges that the main thread flagged with
+    // mapRegions(), the main thread then sends them to GL with flushBuffers().
+    class DeferredMapScope
+    {
+    public:
+        DeferredMapScope();
+        ~DeferredMapScope();
+    };
+
     // synonym for flushBuffers
     void    unmapBuffer();
 
@@ -292,6 +313,8 @@ public:
 protected:
     U32     mGLBuffer = 0;      // GL VBO handle
     U32     mGLIndices = 0;     // GL IBO handle
+    U32     mGLBufferOffset = 0;    // byte offset of this buffer's vertices in mGLBuffer
+    U32     mGLIndicesOffset = 0;   // byte offset of this buffer's indices in mGLIndices
     U32     mNumVerts = 0;      // Number of vertices allocated
     U32     mNumIndices = 0;    // Number of indices allocated
     U32     mIndicesType = GL_UNSIGNED_SHORT; // type of indices in index buffer
@@ -339,6 +362,7 @@ public:
     static const U32 sTypeSize[TYPE_MAX];
     static const U32 sGLMode[LLRender::NUM_MODES];
     static U32 sGLRenderBuffer;
+    static U32 sGLRenderBufferOffset;
     static U32 sGLRenderIndices;
     static U32 sLastMask;
     static U32 sVertexCount;
@@ -793,7 +793,8 @@ bool DAESaver::saveDAE(std::string filename)
         {
             if (skipFace(obj->getTE(face_num))) continue;
 
-            const LLVolumeFace* face = (LLVolumeFace*)&obj->getVolume()->getVolumeFace(face_num);
+            LLVolumeFace* face = (LLVolumeFace*)&obj->getVolume()->getVolumeFace(face_num);
+            face->expand(); // compact mesh faces have no normal or UV arrays
 
             v4adapt verts(face->mPositions);
             v4adapt norms(face->mNormals);
@@ -373,12 +373,63 @@ bool LLGLTFLoader::parseMeshes()
 
             LL_INFOS("GLTF_IMPORT") << "Processing scene " << scene_idx << " with " << scene.mNodes.size() << " root nodes" << LL_ENDL;
 
-            // Process all root nodes defined in the scene
+            // Walk all root nodes defined in the scene, naming models
+            // and caching materials in scene order
+            std::vector<MeshNodeJob> jobs;
             for (S32 root_idx : scene.mNodes)
             {
                 if (root_idx >= 0 && root_idx < static_cast<S32>(mGLTFAsset.mNodes.size()))
                 {
-                    processNodeHierarchy(root_idx, mesh_name_counts, submodel_limit, volume_params);
+                    collectMeshNodes(root_idx, mesh_name_counts, jobs);
+                }
+            }
+
+            // Convert the meshes in parallel, each into its own job
+            parallelFor(jobs.size(), [&](size_t i)
+            {
+                MeshNodeJob& job = jobs[i];
+                if (job.mValidMesh)
+                {
+                    const LL::GLTF::Node& node = mGLTFAsset.mNodes[job.mNode];
+                    job.mModel = new LLModel(volume_params, 0.f);
+                    job.mPopulated = populateModelFromMesh(job.mModel, job.mName, mGLTFAsset.mMeshes[node.mMesh], node, job.mMats,
+                                                            job.mDefaultMaterials, job.mLog)
+                        && LLModel::NO_ERRORS == job.mModel->getStatus()
+                        && validate_model(job.mModel);
+                }
+            });
+
+            // Add them to the scene in traversal order.  A mesh that failed
+            // to convert skips its descendants, like the recursive walk did.
+            for (S32 i = 0; i < (S32)jobs.size(); ++i)
+            {
+                MeshNodeJob& job = jobs[i];
+                for (LLSD::array_const_iterator it = job.mLog.beginArray(); it != job.mLog.endArray(); ++it)
+                {
+                    mWarningsArray.append(*it);
+                }
+
+                if (!job.mValidMesh)
+                {
+                    continue;
+                }
+
+                resolveDefaultMaterials(job);
+
+                if (job.mPopulated)
+                {
+                    addMeshNodeToScene(job, submodel_limit, volume_params);
+                }
+                else
+                {
+                    // <FS:Beq> Fix deprecated arithmetic between different enum types (ERROR_MODEL + EModelStatus)
+                    // Ugly fix. could use a helper instead but its only called in two places.
+                    // setLoadState(ERROR_MODEL + pModel->getStatus());
+                    setLoadState(
+                        static_cast<LLModelLoader::eLoadState>(
+                                    static_cast<S32>(ERROR_MODEL) + static_cast<S32>(job.mModel->getStatus())));
+                    // </FS:Beq>
+                    i = job.mSubtreeEnd - 1;
                 }
             }
         }
@@ -398,7 +449,7 @@ bool LLGLTFLoader::parseMeshes()
     return true;
 }
 
-void LLGLTFLoader::processNodeHierarchy(S32 node_idx, std::map<std::string, S32>& mesh_name_counts, U32 submodel_limit, const LLVolumeParams& volume_params)
+void LLGLTFLoader::collectMeshNodes(S32 node_idx, std::map<std::string, S32>& mesh_name_counts, std::vector<MeshNodeJob>& jobs)
 {
     if (node_idx < 0 || node_idx >= static_cast<S32>(mGLTFAsset.mNodes.size()))
         return;
@@ -409,6 +460,8 @@ void LLGLTFLoader::processNodeHierarchy(S32 node_idx, std::map<std::string, S32>
                             << " - has mesh: " << (node.mMesh >= 0 ? "yes" : "no")
                             << " - children: " << node.mChildren.size() << LL_ENDL;
 
+    size_t job_idx = jobs.size();
+
     // Process this node's mesh if it has one
     if (node.mMesh >= 0 && node.mMesh < mGLTFAsset.mMeshes.size())
     {
@@ -430,74 +483,21 @@ void LLGLTFLoader::processNodeHierarchy(S32 node_idx, std::map<std::string, S32>
             base_name = base_name + "_copy_" + std::to_string(instance_count);
         }
 
-        LLMatrix4    transformation;
-        material_map mats;
+        MeshNodeJob& job = jobs.emplace_back();
+        job.mNode = node_idx;
+        job.mValidMesh = true;
+        job.mName = base_name;
 
-        LLModel* pModel = new LLModel(volume_params, 0.f);
+        // Fill the material cache here, populateModelFromMesh only reads
+        // it.  The names of valid materials don't depend on the face, the
+        // rest are settled by resolveDefaultMaterials().
         const LL::GLTF::Mesh& mesh = mGLTFAsset.mMeshes[node.mMesh];
-
-        if (populateModelFromMesh(pModel, base_name, mesh, node, mats) &&
-            (LLModel::NO_ERRORS == pModel->getStatus()) &&
-            validate_model(pModel))
+        for (const LL::GLTF::Primitive& prim : mesh.mPrimitives)
         {
-            mTransform.setIdentity();
-            transformation = mTransform;
-
-            // adjust the transformation to compensate for mesh normalization
-            LLVector3 mesh_scale_vector;
-            LLVector3 mesh_translation_vector;
-            pModel->getNormalizedScaleTranslation(mesh_scale_vector, mesh_translation_vector);
-
-            LLMatrix4 mesh_translation;
-            mesh_translation.setTranslation(mesh_translation_vector);
-            mesh_translation *= transformation;
-            transformation = mesh_translation;
-
-            LLMatrix4 mesh_scale;
-            mesh_scale.initScale(mesh_scale_vector);
-            mesh_scale *= transformation;
-            transformation = mesh_scale;
-
-            if (node.mSkin >= 0)
+            if (prim.mMaterial >= 0 && prim.mMaterial < mGLTFAsset.mMaterials.size())
             {
-                // "Bind Shape Matrix" is supposed to transform the geometry of the skinned mesh
-                // into the coordinate space of the joints.
-                // In GLTF, this matrix is omitted, and it is assumed that this transform is either
-                // premultiplied with the mesh data, or postmultiplied to the inverse bind matrices.
-                //
-                // TODO: There appears to be missing rotation when joints rotate the model
-                // or inverted bind matrices are missing inherited rotation
-                // (based of values the 'bento shoes' mesh might be missing 90 degrees horizontaly
-                // prior to skinning)
-
-                pModel->mSkinInfo.mBindShapeMatrix.loadu(mesh_scale);
-                LL_INFOS("GLTF_DEBUG") << "Model: " << pModel->mLabel << " mBindShapeMatrix: " << pModel->mSkinInfo.mBindShapeMatrix << LL_ENDL;
+                processMaterial(prim.mMaterial, -1);
             }
-
-            if (transformation.determinant() < 0)
-            { // negative scales are not supported
-                LL_INFOS("GLTF_IMPORT") << "Negative scale detected, unsupported post-normalization transform.  domInstance_geometry: "
-                           << pModel->mLabel << LL_ENDL;
-                LLSD args;
-                args["Message"] = "NegativeScaleNormTrans";
-                args["LABEL"]   = pModel->mLabel;
-                mWarningsArray.append(args);
-            }
-
-            addModelToScene(pModel, base_name, submodel_limit, transformation, volume_params, mats);
-            mats.clear();
-        }
-        else
-        {
-            // <FS:Beq> Fix deprecated arithmetic between different enum types (ERROR_MODEL + EModelStatus)
-            // Ugly fix. could use a helper instead but its only called in two places.
-            // setLoadState(ERROR_MODEL + pModel->getStatus());
-            setLoadState(
-                static_cast<LLModelLoader::eLoadState>(
-                            static_cast<S32>(ERROR_MODEL) + static_cast<S32>(pModel->getStatus())));
-            // </FS:Beq>
-            delete pModel;
-            return;
         }
     }
     else if (node.mMesh >= 0)
@@ -512,16 +512,105 @@ void LLGLTFLoader::processNodeHierarchy(S32 node_idx, std::map<std::string, S32>
         args["NODE_NAME"] = node.mName;
         args["MESH_INDEX"] = node.mMesh;
         args["TOTAL_MESHES"] = static_cast<S32>(mGLTFAsset.mMeshes.size());
-        mWarningsArray.append(args);
+
+        MeshNodeJob& job = jobs.emplace_back();
+        job.mNode = node_idx;
+        job.mLog.append(args);
     }
 
     // Process all children recursively
     for (S32 child_idx : node.mChildren)
     {
-        processNodeHierarchy(child_idx, mesh_name_counts, submodel_limit, volume_params);
+        collectMeshNodes(child_idx, mesh_name_counts, jobs);
+    }
+
+    if (job_idx < jobs.size())
+    {
+        jobs[job_idx].mSubtreeEnd = static_cast<S32>(jobs.size());
+    }
+}
+
+// The first primitive without a valid material names the default material
+// after its face, later ones reuse that name.  Jobs ran in any order with
+// names of their own, so settle them here in traversal order.
+void LLGLTFLoader::resolveDefaultMaterials(MeshNodeJob& job)
+{
+    for (const auto& [material_index, fallback_index] : job.mDefaultMaterials)
+    {
+        const std::string job_name = generateMaterialName(material_index, fallback_index);
+        const std::string name = processMaterial(material_index, fallback_index).name;
+        if (name == job_name)
+        {
+            continue;
+        }
+
+        std::vector<std::string>& material_list = job.mModel->getMaterialList();
+        std::replace(material_list.begin(), material_list.end(), job_name, name);
+
+        material_map::iterator it = job.mMats.find(job_name);
+        if (it != job.mMats.end())
+        {
+            job.mMats[name] = it->second;
+            job.mMats.erase(it);
+        }
     }
 }
 
+void LLGLTFLoader::addMeshNodeToScene(MeshNodeJob& job, U32 submodel_limit, const LLVolumeParams& volume_params)
+{
+    const LL::GLTF::Node& node = mGLTFAsset.mNodes[job.mNode];
+    LLModel* pModel = job.mModel;
+
+    LLMatrix4 transformation;
+
+    mTransform.setIdentity();
+    transformation = mTransform;
+
+    // adjust the transformation to compensate for mesh normalization
+    LLVector3 mesh_scale_vector;
+    LLVector3 mesh_translation_vector;
+    pModel->getNormalizedScaleTranslation(mesh_scale_vector, mesh_translation_vector);
+
+    LLMatrix4 mesh_translation;
+    mesh_translation.setTranslation(mesh_translation_vector);
+    mesh_translation *= transformation;
+    transformation = mesh_translation;
+
+    LLMatrix4 mesh_scale;
+    mesh_scale.initScale(mesh_scale_vector);
+    mesh_scale *= transformation;
+    transformation = mesh_scale;
+
+    if (node.mSkin >= 0)
+    {
+        // "Bind Shape Matrix" is supposed to transform the geometry of the skinned mesh
+        // into the coordinate space of the joints.
+        // In GLTF, this matrix is omitted, and it is assumed that this transform is either
+        // premultiplied with the mesh data, or postmultiplied to the inverse bind matrices.
+        //
+        // TODO: There appears to be missing rotation when joints rotate the model
+        // or inverted bind matrices are missing inherited rotation
+        // (based of values the 'bento shoes' mesh might be missing 90 degrees horizontaly
+        // prior to skinning)
+
+        pModel->mSkinInfo.mBindShapeMatrix.loadu(mesh_scale);
+        LL_INFOS("GLTF_DEBUG") << "Model: " << pModel->mLabel << " mBindShapeMatrix: " << pModel->mSkinInfo.mBindShapeMatrix << LL_ENDL;
+    }
+
+    if (transformation.determinant() < 0)
+    { // negative scales are not supported
+        LL_INFOS("GLTF_IMPORT") << "Negative scale detected, unsupported post-normalization transform.  domInstance_geometry: "
+                   << pModel->mLabel << LL_ENDL;
+        LLSD args;
+        args["Message"] = "NegativeScaleNormTrans";
+        args["LABEL"]   = pModel->mLabel;
+        mWarningsArray.append(args);
+    }
+
+    addModelToScene(pModel, job.mName, submodel_limit, transformation, volume_params, job.mMats);
+    job.mMats.clear();
+}
+
 void LLGLTFLoader::computeCombinedNodeTransform(const LL::GLTF::Asset& asset, S32 node_index, glm::mat4& combined_transform) const
 {
     if (node_index < 0 || node_index >= static_cast<S32>(asset.mNodes.size()))
@@ -571,11 +660,21 @@ bool LLGLTFLoader::addJointToModelSkin(LLMeshSkinInfo& skin_info, S32 gltf_skin_
     skin_info.mAlternateBindMatrix.push_back(mAlternateBindMatrices[gltf_skin_idx][gltf_joint_idx]);
 
     // Track joint usage for this skin, for the sake of unused joints detection
-    mJointUsage[gltf_skin_idx][gltf_joint_idx]++;
+    {
+        std::lock_guard<std::mutex> lock(mJointUsageMutex);
+        mJointUsage[gltf_skin_idx][gltf_joint_idx]++;
+    }
 
     return true;
 }
 
+const LLGLTFLoader::JointGroups& LLGLTFLoader::getJointGroups(const std::string& joint_name) const
+{
+    static const JointGroups no_groups;
+    joint_to_group_map_t::const_iterator found = mJointGroups.find(joint_name);
+    return found != mJointGroups.end() ? found->second : no_groups;
+}
+
 LLGLTFLoader::LLGLTFImportMaterial LLGLTFLoader::processMaterial(S32 material_index, S32 fallback_index)
 {
     // Check cache first
@@ -720,7 +819,10 @@ std::string LLGLTFLoader::generateMaterialName(S32 material_index, S32 fallback_
     }
 }
 
-bool LLGLTFLoader::populateModelFromMesh(LLModel* pModel, const std::string& base_name, const LL::GLTF::Mesh& mesh, const LL::GLTF::Node& nodeno, material_map& mats)
+// Runs on worker threads, see parseMeshes().  Warnings go to log_msg, the
+// material cache is already filled and joint usage is counted under a lock.
+bool LLGLTFLoader::populateModelFromMesh(LLModel* pModel, const std::string& base_name, const LL::GLTF::Mesh& mesh, const LL::GLTF::Node& nodeno, material_map& mats,
+                                         std::map<S32, S32>& default_materials, LLSD& log_msg)
 {
     // Set the requested label for the floater display and uploading
     pModel->mRequestedLabel = gDirUtilp->getBaseFileName(mFilename, true);
@@ -781,8 +883,21 @@ bool LLGLTFLoader::populateModelFromMesh(LLModel* pModel, const std::string& bas
         LLVolumeFace face;
         std::vector<GLTFVertex> vertices;
 
-        // Use cached material processing
-        LLGLTFImportMaterial cachedMat = processMaterial(prim.mMaterial, pModel->getNumVolumeFaces() - 1);
+        // Use cached material processing.  Without a valid material the
+        // name comes from the face the first such primitive starts, which
+        // earlier primitives split at the vertex limit push back.
+        LLGLTFImportMaterial cachedMat;
+        if (prim.mMaterial >= 0 && prim.mMaterial < mGLTFAsset.mMaterials.size())
+        {
+            cachedMat = processMaterial(prim.mMaterial, -1);
+        }
+        else
+        {
+            S32 fallback_index = default_materials.emplace(prim.mMaterial, pModel->getNumVolumeFaces() - 1).first->second;
+            LLImportMaterial default_mat;
+            default_mat.mDiffuseColor = LLColor4::white;
+            cachedMat = LLGLTFImportMaterial(default_mat, generateMaterialName(prim.mMaterial, fallback_index));
+        }
         LLImportMaterial impMat = cachedMat;
         std::string materialName = cachedMat.name;
         mats[materialName] = impMat;
@@ -798,7 +913,7 @@ bool LLGLTFLoader::populateModelFromMesh(LLModel* pModel, const std::string& bas
             args["MESH_NAME"] = mesh.mName;
             args["PRIMITIVE_INDEX"] = static_cast<S32>(prim_idx);
             args["INDEX_COUNT"] = static_cast<S32>(prim.getIndexCount());
-            mWarningsArray.append(args);
+            log_msg.append(args);
             return false; // Skip this primitive
         }
 
@@ -868,7 +983,7 @@ bool LLGLTFLoader::populateModelFromMesh(LLModel* pModel, const std::string& bas
             args["MESH_NAME"] = mesh.mName;
             args["PRIMITIVE_INDEX"] = static_cast<S32>(prim_idx);
             args["INDEX_COUNT"] = static_cast<S32>(prim.getIndexCount());
-            mWarningsArray.append(args);
+            log_msg.append(args);
             return false; // Skip this primitive
         }
 
@@ -1090,7 +1205,7 @@ bool LLGLTFLoader::populateModelFromMesh(LLModel* pModel, const std::string& bas
             args["Message"] = "ModelSplitPrimitive";
             args["MODEL_NAME"] = pModel->mLabel;
             args["FACE_COUNT"] = created_faces;
-            mWarningsArray.append(args);
+            log_msg.append(args);
         }
         else
         {
@@ -1161,7 +1276,7 @@ bool LLGLTFLoader::populateModelFromMesh(LLModel* pModel, const std::string& bas
                 {
                     if (gltf_joint_index_use[i] > 0)
                     {
-                        const JointGroups &group = mJointGroups[joint_name];
+                        const JointGroups &group = getJointGroups(joint_name);
                         // Joint in use, increment it's groups
                         goup_use_count[group.mGroup]++;
                         goup_use_count[group.mParentGroup]++;
@@ -1205,7 +1320,7 @@ bool LLGLTFLoader::populateModelFromMesh(LLModel* pModel, const std::string& bas
                     break;
                 }
                 const std::string& legal_name = mJointNames[skinIdx][i];
-                std::string group_name = mJointGroups[legal_name].mGroup;
+                std::string group_name = getJointGroups(legal_name).mGroup;
                 if (goup_use_count[group_name] > 0)
                 {
                     if (addJointToModelSkin(skin_info, skinIdx, i))
@@ -1247,7 +1362,7 @@ bool LLGLTFLoader::populateModelFromMesh(LLModel* pModel, const std::string& bas
             args["MODEL_NAME"] = pModel->mLabel;
             args["JOINT_COUNT"] = (S32)skin_info.mInvBindMatrix.size();
             args["MAX"] = (S32)mMaxJointsPerMesh;
-            mWarningsArray.append(args);
+            log_msg.append(args);
         }
 
         // Remap indices for pModel->mSkinWeights
@@ -35,6 +35,8 @@
 #include "lljointdata.h"
 #include "llmodelloader.h"
 
+#include <mutex>
+
 class LLGLTFLoader : public LLModelLoader
 {
   public:
@@ -125,6 +127,7 @@ protected:
     bind_matrices_t                     mAlternateBindMatrices;
     joint_names_t                       mJointNames; // empty string when no legal name for a given idx
     std::vector<std::vector<S32>>       mJointUsage; // detect and warn about unsed joints
+    std::mutex                          mJointUsageMutex; // meshes are converted in parallel
 
     // what group a joint belongs to.
     // For purpose of stripping unused groups when joints are over limit.
@@ -146,13 +149,31 @@ protected:
 private:
     bool parseMeshes();
     void computeCombinedNodeTransform(const LL::GLTF::Asset& asset, S32 node_index, glm::mat4& combined_transform) const;
-    void processNodeHierarchy(S32 node_idx, std::map<std::string, S32>& mesh_name_counts, U32 submodel_limit, const LLVolumeParams& volume_params);
+
+    // A node with a mesh, in scene traversal order
+    struct MeshNodeJob
+    {
+        S32 mNode = -1;
+        S32 mSubtreeEnd = 0;        // first job after this node's descendants
+        bool mValidMesh = false;
+        bool mPopulated = false;
+        std::string mName;
+        LLPointer<LLModel> mModel;
+        material_map mMats;
+        std::map<S32, S32> mDefaultMaterials;   // invalid material index -> fallback index it was named with
+        LLSD mLog;
+    };
+    void collectMeshNodes(S32 node_idx, std::map<std::string, S32>& mesh_name_counts, std::vector<MeshNodeJob>& jobs);
+    void resolveDefaultMaterials(MeshNodeJob& job);
+    void addMeshNodeToScene(MeshNodeJob& job, U32 submodel_limit, const LLVolumeParams& volume_params);
     bool addJointToModelSkin(LLMeshSkinInfo& skin_info, S32 gltf_skin_idx, size_t gltf_joint_idx);
     LLGLTFImportMaterial processMaterial(S32 material_index, S32 fallback_index);
     std::string processTexture(S32 texture_index, const std::string& texture_type, const std::string& material_name);
     bool validateTextureIndex(S32 texture_index, S32& source_index);
     std::string generateMaterialName(S32 material_index, S32 fallback_index = -1);
-    bool populateModelFromMesh(LLModel* pModel, const std::string& base_name, const LL::GLTF::Mesh &mesh, const LL::GLTF::Node &node, material_map& mats);
+    bool populateModelFromMesh(LLModel* pModel, const std::string& base_name, const LL::GLTF::Mesh &mesh, const LL::GLTF::Node &node, material_map& mats,
+                               std::map<S32, S32>& default_materials, LLSD& log_msg);
+    const JointGroups& getJointGroups(const std::string& joint_name) const;
     void populateJointsFromSkin(S32 skin_idx);
     void populateJointGroups();
     void addModelToScene(LLModel* pModel, const std::string& model_name, U32 submodel_limit, const LLMatrix4& transformation, const LLVolumeParams& volume_params, const material_map& mats);
@@ -133,6 +133,7 @@ static void ssl_verification_changed();
 LLAppCoreHttp::HttpClass::HttpClass()
     : mPolicy(LLCore::HttpRequest::DEFAULT_POLICY_ID),
       mConnLimit(0U),
+      mStreams(0U),
       mPipelined(false)
 {}
 
@@ -462,6 +463,42 @@ void LLAppCoreHttp::refreshSettings(bool initial)
             }
         }
 
+        // HTTP/2 multiplexing.  Only offered to classes that would
+        // otherwise pipeline as those are the ones carrying large
+        // numbers of small, independent GETs.
+        if (initial)
+        {
+            static const std::string http_streams("HttpMultiplexStreams");
+            U32 streams(0);
+            if (init_data[i].mPipelined && gSavedSettings.controlExists(http_streams))
+            {
+                streams = gSavedSettings.getU32(http_streams);
+            }
+            if (streams != mHttpClasses[app_policy].mStreams)
+            {
+                LLCore::HttpHandle handle;
+
+                handle = mRequest->setPolicyOption(LLCore::HttpRequest::PO_HTTP2_STREAM_LIMIT,
+                                                   mHttpClasses[app_policy].mPolicy,
+                                                   long(streams),
+                                                   LLCore::HttpHandler::ptr_t());
+                if (LLCORE_HTTP_HANDLE_INVALID == handle)
+                {
+                    status = mRequest->getStatus();
+                    LL_WARNS("Init") << "Unable to set " << init_data[i].mUsage
+                                     << " HTTP/2 stream limit.  Reason:  " << status.toString()
+                                     << LL_ENDL;
+                }
+                else
+                {
+                    LL_DEBUGS("Init") << "Changed " << init_data[i].mUsage
+                                      << " HTTP/2 stream limit.  New value:  " << streams
+                                      << LL_ENDL;
+                    mHttpClasses[app_policy].mStreams = streams;
+                }
+            }
+        }
+
         // Get target connection concurrency value
         U32 setting(init_data[i].mDefault);
         if (! init_data[i].mKey.empty() && gSavedSettings.controlExists(init_data[i].mKey))
@@ -244,6 +244,19 @@ public:
             return mHttpClasses[policy].mPipelined;
         }
 
+    // Return whether a policy is multiplexing requests over HTTP/2.
+    bool isMultiplexed(EAppPolicy policy) const
+        {
+            return mHttpClasses[policy].mStreams > 0;
+        }
+
+    // Return the HTTP/2 stream limit per connection for a policy
+    // or zero if the policy isn't multiplexed.
+    U32 getStreamLimit(EAppPolicy policy) const
+        {
+            return mHttpClasses[policy].mStreams;
+        }
+
     // Apply initial or new settings from the environment.
     void refreshSettings(bool initial);
 
@@ -261,6 +274,7 @@ private:
     public:
         policy_t                    mPolicy;            // Policy class id for the class
         U32                         mConnLimit;
+        U32                         mStreams;           // HTTP/2 streams per connection, 0 if not multiplexed
         bool                        mPipelined;
         boost::signals2::connection mSettingsSignal;    // Signal to global setting that affect this class (if any)
     };
@@ -37,6 +37,8 @@
 #include "llerrorcontrol.h"
 #include "lleventtimer.h"
 #include "llfile.h"
+#include "llframeallocator.h"
+#include "llframestatsrecorder.h"
 #include "llviewertexturelist.h"
 #include "llgroupmgr.h"
 #include "llagent.h"
@@ -102,6 +104,7 @@
 #include "llvocache.h"
 #include "lldiskcache.h"
 #include "llvopartgroup.h"
+#include "llparallelfor.h"
 // [SL:KB] - Patch: Appearance-Misc | Checked: 2013-02-12 (Catznip-3.4)
 #include "llappearancemgr.h"
 // [/SL:KB]
@@ -627,6 +630,7 @@ static void settings_to_globals()
     LLVOVolume::sLODFactor              = llclamp(gSavedSettings.getF32("RenderVolumeLODFactor"), 0.01f, MAX_LOD_FACTOR);
     LLVOVolume::sDistanceFactor         = 1.f-LLVOVolume::sLODFactor * 0.1f;
     LLVolumeImplFlexible::sUpdateFactor = gSavedSettings.getF32("RenderFlexTimeFactor");
+    LLVolumeFace::sUseBVH               = gSavedSettings.getBOOL("RenderRaycastBVH");
     LLVOTree::sTreeFactor               = gSavedSettings.getF32("RenderTreeLODFactor");
     LLVOAvatar::sLODFactor              = llclamp(gSavedSettings.getF32("RenderAvatarLODFactor"), 0.f, MAX_AVATAR_LOD_FACTOR);
     LLVOAvatar::sPhysicsLODFactor       = llclamp(gSavedSettings.getF32("RenderAvatarPhysicsLODFactor"), 0.f, MAX_AVATAR_LOD_FACTOR);
@@ -1474,9 +1478,11 @@ bool LLAppViewer::init()
     LLEnvironment::createInstance();
     LLWorld::createInstance();
     LLViewerStatsRecorder::createInstance();
+    LLFrameStatsRecorder::createInstance();
     LLSelectMgr::createInstance();
     LLViewerCamera::createInstance();
     LL::GLTFSceneManager::createInstance();
+    LLFrameAllocator::createInstance();
 
     gSavedSettings.setU32("DebugQualityPerformance", gSavedSettings.getU32("RenderQualityPerformance"));
 
@@ -1799,6 +1805,11 @@ bool LLAppViewer::doFrame()
                 {
                     LLViewerStatsRecorder::instance().idle();
                 }
+
+                if (LLFrameStatsRecorder::instanceExists())
+                {
+                    LLFrameStatsRecorder::instance().idle();
+                }
             }
         }
 
@@ -2420,6 +2431,7 @@ bool LLAppViewer::cleanup()
     {
         mGeneralThreadPool->close();
     }
+    ll_close_parallel_pool();
 
     sTextureFetch->shutDownTextureCacheThread() ;
     LLLFSThread::sLocal->shutdown();
@@ -2481,6 +2493,7 @@ bool LLAppViewer::cleanup()
     sPurgeDiskCacheThread = NULL;
     delete mGeneralThreadPool;
     mGeneralThreadPool = NULL;
+    ll_cleanup_parallel_pool();
 
     if (LLFastTimerView::sAnalyzePerformance)
     {
@@ -2542,9 +2555,11 @@ bool LLAppViewer::cleanup()
     ll_close_fail_log();
 
     LLError::LLCallStacks::cleanup();
+    LLFrameAllocator::deleteSingleton();
     LL::GLTFSceneManager::deleteSingleton();
     LLEnvironment::deleteSingleton();
     LLSelectMgr::deleteSingleton();
+    LLFrameStatsRecorder::deleteSingleton();
     LLViewerStatsRecorder::deleteSingleton();
     LLViewerEventRecorder::deleteSingleton();
     LLWorld::deleteSingleton();
@@ -2620,6 +2635,15 @@ bool LLAppViewer::initThreads()
     }
     // <FS:Ansariel>
     threadCounts["ImageDecode"] = image_decode_count;
+
+    // Mesh LOD, skin and physics decoding is mostly unzip and LLSD parsing,
+    // scale it with the machine but leave room for image decode
+    S32 mesh_decode_count = llclamp(cores / 2, 2, 6);
+    if (auto max_mesh_decodes = gSavedSettings.getU32("MeshDecodeThreads"); max_mesh_decodes > 0)
+    {
+        mesh_decode_count = llclamp((S32)max_mesh_decodes, 1, 16);
+    }
+    threadCounts["MeshLodProcessing"] = mesh_decode_count;
     gSavedSettings.setLLSD("ThreadPoolSizes", threadCounts);
 
     // Image decoding
@@ -2632,6 +2656,11 @@ bool LLAppViewer::initThreads()
     // general task background thread (LLPerfStats, etc)
     LLAppViewer::instance()->initGeneralThread();
 
+    // Per-frame work the main thread splits up and waits on: rigged
+    // skinning, cull frustum checks, geometry fills and render map sorts.
+    // The main thread takes jobs too, so keep it narrow
+    ll_init_parallel_pool(llclamp(cores / 4, 1, 4));
+
     LLAppViewer::sPurgeDiskCacheThread = new LLPurgeDiskCacheThread();
 
     if (LLTrace::BlockTimer::sLog || LLTrace::BlockTimer::sMetricLog)
@@ -3508,6 +3537,12 @@ bool LLAppViewer::initConfiguration()
     //LLVolumeMgr::initClass();
     LLVolumeMgr* volume_manager = new LLVolumeMgr();
     volume_manager->useMutex(); // LLApp and LLMutex magic must be manually enabled
+    if (gSavedSettings.getBOOL("AsyncPrimVolumeGeneration"))
+    {
+        // Not on "General", which is one thread wide and runs longer jobs,
+        // entering a region asks for LODs in bursts
+        volume_manager->useThreadPool("VolumeGeneration", llclamp((S32)std::thread::hardware_concurrency() / 4, 1, 4), "mainloop");
+    }
     LLPrimitive::setVolumeManager(volume_manager);
 
     // Note: this is where we used to initialize gFeatureManagerp.
@@ -5633,6 +5668,7 @@ void LLAppViewer::idle()
 
     LLFrameTimer::updateFrameTime();
     LLFrameTimer::updateFrameCount();
+    LLFrameAllocator::instance().nextFrame();
     LLEventTimer::updateClass();
     LLPerfStats::updateClass();
 
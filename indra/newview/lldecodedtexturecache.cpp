@@ -0,0 +1,248 @@
+/**
+ * @file lldecodedtexturecache.cpp
+ * @brief In-memory cache of decoded texture results.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "lldecodedtexturecache.h"
+
+#ifdef LL_USESYSTEMLIBS
+#include <zlib.h>
+#else
+#include "zlib-ng/zlib.h"
+#endif
+
+// Compressed data must save at least this fraction of the raw size,
+// otherwise the entry is kept as-is and hits are a plain copy.
+constexpr F32 MIN_COMPRESSION_SAVING = 0.1f;
+
+// No single entry may take more than this fraction of the budget.
+constexpr size_t MAX_ENTRY_BUDGET_DIVISOR = 4;
+
+LLDecodedTextureCache::LLDecodedTextureCache()
+    : mStoredBytes(0),
+      mRawBytes(0),
+      mBudget(0),
+      mHits(0),
+      mMisses(0)
+{
+}
+
+LLDecodedTextureCache::~LLDecodedTextureCache()
+{
+    clear();
+}
+
+void LLDecodedTextureCache::setBudget(size_t bytes)
+{
+    mBudget = bytes;
+
+    LLMutexLock lock(&mMutex);
+    evictToBudget(bytes);
+}
+
+void LLDecodedTextureCache::insert(const LLUUID& id, S32 discard, const LLImageRaw* raw)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
+
+    const size_t budget = mBudget;
+    if (!budget || !raw || discard < 0)
+    {
+        return;
+    }
+
+    Entry entry;
+    {
+        LLImageDataSharedLock lock(raw);
+
+        const U8* src = raw->getData();
+        const size_t raw_size = raw->getDataSize();
+        if (!src || !raw_size || raw_size > budget / MAX_ENTRY_BUDGET_DIVISOR)
+        {
+            return;
+        }
+
+        entry.mKey = key_t(id, discard);
+        entry.mWidth = raw->getWidth();
+        entry.mHeight = raw->getHeight();
+        entry.mComponents = raw->getComponents();
+        entry.mRawSize = raw_size;
+        entry.mCompressed = false;
+
+        auto data = std::make_shared<std::vector<U8> >();
+        uLongf comp_size = compressBound((uLong)raw_size);
+        data->resize(comp_size);
+        if (compress2(data->data(), &comp_size, src, (uLong)raw_size, Z_BEST_SPEED) == Z_OK
+            && comp_size < (uLongf)(raw_size * (1.f - MIN_COMPRESSION_SAVING)))
+        {
+            data->resize(comp_size);
+            data->shrink_to_fit();
+            entry.mCompressed = true;
+        }
+        else
+        {
+            data->assign(src, src + raw_size);
+        }
+        entry.mData = std::move(data);
+    }
+
+    LLMutexLock lock(&mMutex);
+
+    entry_map_t::iterator iter = mEntries.find(entry.mKey);
+    if (iter != mEntries.end())
+    {
+        removeEntry(iter);
+    }
+
+    mStoredBytes += entry.mData->size();
+    mRawBytes += entry.mRawSize;
+    mLRU.push_front(std::move(entry));
+    mEntries[mLRU.front().mKey] = mLRU.begin();
+
+    evictToBudget(mBudget);
+}
+
+LLPointer<LLImageRaw> LLDecodedTextureCache::fetch(const LLUUID& id, S32 discard)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
+
+    if (!mBudget)
+    {
+        return LLPointer<LLImageRaw>();
+    }
+
+    // Only a reference to the stored bytes is taken under the lock,
+    // several threads fetch at once and inflating is the slow part.
+    Entry entry;
+    {
+        LLMutexLock lock(&mMutex);
+
+        entry_map_t::iterator iter = mEntries.find(key_t(id, discard));
+        if (iter == mEntries.end())
+        {
+            ++mMisses;
+            return LLPointer<LLImageRaw>();
+        }
+
+        // Move to most recently used
+        mLRU.splice(mLRU.begin(), mLRU, iter->second);
+        entry = mLRU.front();
+    }
+
+    bool ok = false;
+    LLPointer<LLImageRaw> raw = new LLImageRaw(entry.mWidth, entry.mHeight, entry.mComponents);
+    U8* dst = raw->getData();
+    if (dst && (size_t)raw->getDataSize() == entry.mRawSize)
+    {
+        if (entry.mCompressed)
+        {
+            uLongf dst_size = (uLongf)entry.mRawSize;
+            ok = uncompress(dst, &dst_size, entry.mData->data(), (uLong)entry.mData->size()) == Z_OK
+                && dst_size == (uLongf)entry.mRawSize;
+        }
+        else
+        {
+            memcpy(dst, entry.mData->data(), entry.mRawSize);
+            ok = true;
+        }
+    }
+
+    if (!ok)
+    {
+        LL_WARNS("Texture") << "Dropping unusable decoded cache entry for " << id
+                            << " discard " << discard << LL_ENDL;
+
+        // Unless another thread replaced it meanwhile
+        LLMutexLock lock(&mMutex);
+        entry_map_t::iterator iter = mEntries.find(entry.mKey);
+        if (iter != mEntries.end() && iter->second->mData == entry.mData)
+        {
+            removeEntry(iter);
+        }
+
+        ++mMisses;
+        return LLPointer<LLImageRaw>();
+    }
+
+    ++mHits;
+    return raw;
+}
+
+void LLDecodedTextureCache::erase(const LLUUID& id)
+{
+    LLMutexLock lock(&mMutex);
+
+    entry_map_t::iterator iter = mEntries.lower_bound(key_t(id, S32_MIN));
+    while (iter != mEntries.end() && iter->first.first == id)
+    {
+        entry_map_t::iterator cur = iter++;
+        removeEntry(cur);
+    }
+}
+
+void LLDecodedTextureCache::clear()
+{
+    LLMutexLock lock(&mMutex);
+
+    mEntries.clear();
+    mLRU.clear();
+    mStoredBytes = 0;
+    mRawBytes = 0;
+}
+
+U32 LLDecodedTextureCache::getEntryCount()
+{
+    LLMutexLock lock(&mMutex);
+    return (U32)mEntries.size();
+}
+
+size_t LLDecodedTextureCache::getStoredBytes()
+{
+    LLMutexLock lock(&mMutex);
+    return mStoredBytes;
+}
+
+size_t LLDecodedTextureCache::getRawBytes()
+{
+    LLMutexLock lock(&mMutex);
+    return mRawBytes;
+}
+
+void LLDecodedTextureCache::removeEntry(entry_map_t::iterator iter)
+{
+    lru_list_t::iterator entry = iter->second;
+    mStoredBytes -= entry->mData->size();
+    mRawBytes -= entry->mRawSize;
+    mEntries.erase(iter);
+    mLRU.erase(entry);
+}
+
+void LLDecodedTextureCache::evictToBudget(size_t budget)
+{
+    while (!mLRU.empty() && mStoredBytes > budget)
+    {
+        removeEntry(mEntries.find(mLRU.back().mKey));
+    }
+}
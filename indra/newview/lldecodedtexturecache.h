@@ -0,0 +1,115 @@
+/**
+ * @file lldecodedtexturecache.h
+ * @brief In-memory cache of decoded texture results.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLDECODEDTEXTURECACHE_H
+#define LL_LLDECODEDTEXTURECACHE_H
+
+#include <atomic>
+#include <list>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "llimage.h"
+#include "llmutex.h"
+#include "llpointer.h"
+#include "lluuid.h"
+
+// Keeps recently decoded raw images, keyed by (texture id, discard level),
+// in a compressed RAM tier between LLTextureCache and LLImageDecodeThread.
+// A texture that is dropped and fetched again at the same discard level
+// skips the decoder entirely.
+//
+// Entries are deflated at the fastest zlib level; images that do not
+// compress well are kept as-is.  The tier is bounded by a byte budget
+// (stored size) and evicts least recently used entries.
+//
+// Threads:  T* (all methods lock internally)
+class LLDecodedTextureCache
+{
+public:
+    LLDecodedTextureCache();
+    ~LLDecodedTextureCache();
+
+    // Set the budget in bytes of stored (compressed) data.  Zero
+    // disables the cache and drops all entries.
+    void setBudget(size_t bytes);
+    size_t getBudget() const { return mBudget; }
+
+    // Store a copy of a decoded image.  Compression is done by the
+    // calling thread without holding the cache lock.
+    void insert(const LLUUID& id, S32 discard, const LLImageRaw* raw);
+
+    // Return a new raw image for an exact (id, discard) match or
+    // NULL on a miss.  Counts toward hit/miss stats.  Decompression is
+    // done by the calling thread without holding the cache lock.
+    LLPointer<LLImageRaw> fetch(const LLUUID& id, S32 discard);
+
+    // Drop all entries for a texture, e.g. when its data is found
+    // to be corrupt.
+    void erase(const LLUUID& id);
+
+    void clear();
+
+    // Stats
+    U32 getHits() const { return mHits; }
+    U32 getMisses() const { return mMisses; }
+    U32 getEntryCount();
+    size_t getStoredBytes();
+    size_t getRawBytes();
+
+private:
+    typedef std::pair<LLUUID, S32> key_t;
+
+    struct Entry
+    {
+        key_t mKey;
+        U16 mWidth;
+        U16 mHeight;
+        S8 mComponents;
+        bool mCompressed;
+        size_t mRawSize;
+        std::shared_ptr<const std::vector<U8> > mData;  // shared with fetches in flight, never changed
+    };
+
+    typedef std::list<Entry> lru_list_t;
+    typedef std::map<key_t, lru_list_t::iterator> entry_map_t;
+
+    // Locks:  Mdc held by caller
+    void removeEntry(entry_map_t::iterator iter);
+    void evictToBudget(size_t budget);
+
+    LLMutex mMutex;
+    lru_list_t mLRU;                                                    // Mdc, most recent first
+    entry_map_t mEntries;                                               // Mdc
+    size_t mStoredBytes;                                                // Mdc
+    size_t mRawBytes;                                                   // Mdc
+    std::atomic<size_t> mBudget;
+    std::atomic<U32> mHits;
+    std::atomic<U32> mMisses;
+};
+
+#endif // LL_LLDECODEDTEXTURECACHE_H
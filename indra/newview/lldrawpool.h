@@ -204,7 +204,7 @@ public:
         NUM_RENDER_TYPES,
     };
 
-    #if LL_PROFILER_ENABLE_RENDER_DOC
+    // vertex buffer labels and frame stats log columns
     static inline const char* lookupPassName(U32 pass)
     {
         switch (pass)
@@ -339,9 +339,6 @@ public:
                 return "Unknown pass";
         }
     }
-    #else
-    static inline const char* lookupPassName(U32 pass) { return ""; }
-    #endif
 
     LLRenderPass(const U32 type);
     virtual ~LLRenderPass();
@@ -32,6 +32,7 @@
 
 #include "llviewercontrol.h"
 #include "llvolume.h"
+#include "llvolumekernels.h"
 #include "m3math.h"
 #include "llmatrix4a.h"
 #include "v3color.h"
@@ -784,47 +785,6 @@ static void xform(LLVector2 &tex_coord, F32 cosAng, F32 sinAng, F32 offS, F32 of
     tex_coord.mV[1] = t;
 }
 
-// Transform the texture coordinates for this face.
-static void xform4a(LLVector4a &tex_coord, const LLVector4a& trans, const LLVector4Logical& mask, const LLVector4a& rot0, const LLVector4a& rot1, const LLVector4a& offset, const LLVector4a& scale)
-{
-    //tex coord is two coords, <s0, t0, s1, t1>
-    LLVector4a st;
-
-    // Texture transforms are done about the center of the face.
-    st.setAdd(tex_coord, trans);
-
-    // <s0 * cosAng, s0*-sinAng, s1*cosAng, s1*-sinAng>
-    LLVector4a s0;
-    s0.splat(st, 0);
-    LLVector4a s1;
-    s1.splat(st, 2);
-    LLVector4a ss;
-    ss.setSelectWithMask(mask, s1, s0);
-
-    LLVector4a a;
-    a.setMul(rot0, ss);
-
-    // <t0*sinAng, t0*cosAng, t1*sinAng, t1*cosAng>
-    LLVector4a t0;
-    t0.splat(st, 1);
-    LLVector4a t1;
-    t1.splat(st, 3);
-    LLVector4a tt;
-    tt.setSelectWithMask(mask, t1, t0);
-
-    LLVector4a b;
-    b.setMul(rot1, tt);
-
-    st.setAdd(a,b);
-
-    // Then scale
-    st.mul(scale);
-
-    // Then offset
-    tex_coord.setAdd(st, offset);
-}
-
-
 bool less_than_max_mag(const LLVector4a& vec)
 {
     LLVector4a MAX_MAG;
@@ -983,12 +943,12 @@ void LLFace::getPlanarProjectedParams(LLQuaternion* face_rot, LLVector3* face_po
     }
 
     const LLVolumeFace& vf = getViewerObject()->getVolume()->getVolumeFace(mTEOffset);
-    if (! (vf.mNormals && vf.mTangents))
+    if (! (vf.hasNormals() && vf.hasTangents()))
     {
         return;
     }
-    const LLVector4a& normal4a = *vf.mNormals;
-    const LLVector4a& tangent  = *vf.mTangents;
+    const LLVector4a normal4a = vf.getNormal(0);
+    const LLVector4a tangent  = vf.getTangent(0);
 
     LLVector4a binormal4a;
     binormal4a.setCross3(normal4a, tangent);
@@ -1189,6 +1149,67 @@ void push_for_transform(LLVertexBuffer* buff, U32 source_count, U32 dest_count)
     }
 }
 
+bool LLFace::prepareGeometryVolume(const LLVolume& volume, S32 face_index, bool force_rebuild)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_FACE;
+
+    if (face_index < 0 || face_index >= volume.getNumVolumeFaces() || mVertexBuffer.isNull())
+    { // let getGeometryVolume report it
+        return false;
+    }
+
+    const LLVolumeFace& vf = volume.getVolumeFace(face_index);
+    S32 num_vertices = llclamp((S32) vf.mNumVertices, (S32) 0, (S32) mGeomCount);
+    S32 num_indices = llclamp((S32) vf.mNumIndices, (S32) 0, (S32) mIndicesCount);
+    if (num_indices + mIndicesIndex > mVertexBuffer->getNumIndices() ||
+        num_vertices + (U32) mGeomIndex > mVertexBuffer->getNumVerts())
+    {
+        return false;
+    }
+
+    const LLTextureEntry* tep = mVObjp->getTE(face_index);
+    if (!tep)
+    {
+        return false;
+    }
+
+    if (mVertexBufferGLTF.notNull() || (tep->getGLTFRenderMaterial() && tep->isSelected()))
+    { // selection markers allocate and free vertex buffers
+        return false;
+    }
+
+    bool full_rebuild = force_rebuild || mDrawablep->isState(LLDrawable::REBUILD_VOLUME);
+    bool rebuild_pos = full_rebuild || mDrawablep->isState(LLDrawable::REBUILD_POSITION);
+    bool rebuild_color = full_rebuild || mDrawablep->isState(LLDrawable::REBUILD_COLOR);
+    bool rebuild_tcoord = full_rebuild || mDrawablep->isState(LLDrawable::REBUILD_TCOORD);
+    bool rebuild_tangent = rebuild_pos && mVertexBuffer->hasDataType(LLVertexBuffer::TYPE_TANGENT);
+
+    // The volume may be shared with faces filled on other threads, make the
+    // tangents getGeometryVolume would make
+    if (rebuild_tangent ||
+        (rebuild_tcoord && (tep->getBumpmap() || tep->getTexGen() != LLTextureEntry::TEX_GEN_DEFAULT)))
+    {
+        mVObjp->getVolume()->genTangents(face_index);
+    }
+
+    U32 type_mask = 0;
+    if (rebuild_pos)
+    {
+        type_mask |= LLVertexBuffer::MAP_VERTEX | LLVertexBuffer::MAP_NORMAL | LLVertexBuffer::MAP_TANGENT | LLVertexBuffer::MAP_WEIGHT4;
+    }
+    if (rebuild_color)
+    {
+        type_mask |= LLVertexBuffer::MAP_COLOR | LLVertexBuffer::MAP_EMISSIVE;
+    }
+    if (rebuild_tcoord)
+    {
+        type_mask |= LLVertexBuffer::MAP_TEXCOORD0 | LLVertexBuffer::MAP_TEXCOORD1 | LLVertexBuffer::MAP_TEXCOORD2;
+    }
+
+    mVertexBuffer->mapRegions(type_mask, mGeomIndex, mGeomCount, mIndicesIndex, full_rebuild ? mIndicesCount : 0);
+    return true;
+}
+
 bool LLFace::getGeometryVolume(const LLVolume& volume,
                                 S32 face_index,
                                 const LLMatrix4& mat_vert_in,
@@ -1355,6 +1376,26 @@ bool LLFace::getGeometryVolume(const LLVolume& volume,
     bool rebuild_tangent = rebuild_pos && mVertexBuffer->hasDataType(LLVertexBuffer::TYPE_TANGENT);
     bool rebuild_weights = rebuild_pos && mVertexBuffer->hasDataType(LLVertexBuffer::TYPE_WEIGHT4);
 
+    // Compact mesh faces (see LLVolumeFace::compact()) keep normals, tangents
+    // and texture coordinates packed, unpack them for this rebuild.  The
+    // tangents of other faces are picked up after genTangents().
+    const LLVector4a* vf_normals = vf.mNormals;
+    const LLVector2* vf_tex_coords = vf.mTexCoords;
+    const LLVector4a* vf_tangents = nullptr;
+    if (vf.isCompact() && num_vertices > 0 && (rebuild_tcoord || rebuild_normal || rebuild_tangent))
+    {
+        LL_PROFILE_ZONE_NAMED_CATEGORY_FACE("getGeometryVolume - unpack");
+        static thread_local std::vector<LLVector4a> unpacked;
+        unpacked.resize(num_vertices * 2 + (num_vertices + 1) / 2);
+        LLVector4a* normals = unpacked.data();
+        LLVector4a* tangents = normals + num_vertices;
+        LLVector2* tex_coords = (LLVector2*) (tangents + num_vertices);
+        vf.decodeAttributes(num_vertices, normals, tex_coords, tangents);
+        vf_normals = normals;
+        vf_tex_coords = tex_coords;
+        vf_tangents = tangents;
+    }
+
     const U8 bump_code = tep ? tep->getBumpmap() : 0;
 
     bool is_static = mDrawablep->isStatic();
@@ -1692,127 +1733,42 @@ bool LLFace::getGeometryVolume(const LLVolume& volume,
             { //not bump mapped, might be able to do a cheap update
                 mVertexBuffer->getTexCoord0Strider(tex_coords0, mGeomIndex, mGeomCount);
 
+                LLTexCoordTransform tc_xform;
+                if (do_tex_mat)
+                {
+                    tc_xform.setMatrix(*mTextureMatrix);
+                }
+                else if (xforms != XFORM_NONE)
+                {
+                    tc_xform.setRotateScaleOffset(cos_ang, sin_ang, os, ot, ms, mt);
+                }
+
                 if (texgen != LLTextureEntry::TEX_GEN_PLANAR)
                 {
                     LL_PROFILE_ZONE_NAMED_CATEGORY_FACE("getGeometryVolume - texgen");
-                    if (!do_tex_mat)
+                    if (!do_tex_mat && xforms == XFORM_NONE)
                     {
-                        if (xforms == XFORM_NONE)
-                        {
-                            LL_PROFILE_ZONE_NAMED_CATEGORY_FACE("ggv - texgen 1");
-
-                            // <FS:ND> Don't round up, or there's high risk to write past buffer
-
-                            // S32 tc_size = (num_vertices*2*sizeof(F32)+0xF) & ~0xF;
-                            S32 tc_size = (num_vertices*2*sizeof(F32));
-
-                            // </FS:ND>
-
-                            LLVector4a::memcpyNonAliased16((F32*) tex_coords0.get(), (F32*) vf.mTexCoords, tc_size);
-                        }
-                        else
-                        {
-                            LL_PROFILE_ZONE_NAMED_CATEGORY_FACE("ggv - texgen 2");
-                            F32* dst = (F32*) tex_coords0.get();
-                            LLVector4a* src = (LLVector4a*) vf.mTexCoords;
-
-                            LLVector4a trans;
-                            trans.splat(-0.5f);
+                        LL_PROFILE_ZONE_NAMED_CATEGORY_FACE("ggv - texgen 1");
 
-                            LLVector4a rot0;
-                            rot0.set(cos_ang, -sin_ang, cos_ang, -sin_ang);
+                        // <FS:ND> Don't round up, or there's high risk to write past buffer
 
-                            LLVector4a rot1;
-                            rot1.set(sin_ang, cos_ang, sin_ang, cos_ang);
+                        // S32 tc_size = (num_vertices*2*sizeof(F32)+0xF) & ~0xF;
+                        S32 tc_size = (num_vertices*2*sizeof(F32));
 
-                            LLVector4a scale;
-                            scale.set(ms, mt, ms, mt);
+                        // </FS:ND>
 
-                            LLVector4a offset;
-                            offset.set(os+0.5f, ot+0.5f, os+0.5f, ot+0.5f);
-
-                            LLVector4Logical mask;
-                            mask.clear();
-                            mask.setElement<2>();
-                            mask.setElement<3>();
-
-                            S32 count = num_vertices/2 + num_vertices%2;
-
-                            for (S32 i = 0; i < count; i++)
-                            {
-                                LLVector4a res = *src++;
-                                xform4a(res, trans, mask, rot0, rot1, offset, scale);
-                                res.store4a(dst);
-                                dst += 4;
-                            }
-                        }
+                        LLVector4a::memcpyNonAliased16((F32*) tex_coords0.get(), (const F32*) vf_tex_coords, tc_size);
                     }
                     else
-                    { //do tex mat, no texgen, no bump
-                        for (S32 i = 0; i < num_vertices; i++)
-                        {
-                            LLVector2 tc(vf.mTexCoords[i]);
-
-                            LLVector3 tmp(tc.mV[0], tc.mV[1], 0.f);
-                            tmp = tmp * *mTextureMatrix;
-                            tc.mV[0] = tmp.mV[0];
-                            tc.mV[1] = tmp.mV[1];
-                            *tex_coords0++ = tc;
-                        }
+                    {
+                        LL_PROFILE_ZONE_NAMED_CATEGORY_FACE("ggv - texgen 2");
+                        LLTransformTexCoords(tc_xform, vf_tex_coords, num_vertices, tex_coords0.get());
                     }
                 }
                 else
                 { //no bump, tex gen planar
                     LL_PROFILE_ZONE_NAMED_CATEGORY_FACE("getGeometryVolume - texgen planar");
-                    if (do_tex_mat)
-                    {
-                        for (S32 i = 0; i < num_vertices; i++)
-                        {
-                            LLVector2 tc(vf.mTexCoords[i]);
-                            LLVector4a& norm = vf.mNormals[i];
-                            LLVector4a& center = *(vf.mCenter);
-                            LLVector4a vec = vf.mPositions[i];
-                            vec.mul(scalea);
-                            planarProjection(tc, norm, center, vec);
-
-                            LLVector3 tmp(tc.mV[0], tc.mV[1], 0.f);
-                            tmp = tmp * *mTextureMatrix;
-                            tc.mV[0] = tmp.mV[0];
-                            tc.mV[1] = tmp.mV[1];
-
-                            *tex_coords0++ = tc;
-                        }
-                    }
-                    else if (xforms != XFORM_NONE)
-                    {
-                        for (S32 i = 0; i < num_vertices; i++)
-                        {
-                            LLVector2 tc(vf.mTexCoords[i]);
-                            LLVector4a& norm = vf.mNormals[i];
-                            LLVector4a& center = *(vf.mCenter);
-                            LLVector4a vec = vf.mPositions[i];
-                            vec.mul(scalea);
-                            planarProjection(tc, norm, center, vec);
-
-                            xform(tc, cos_ang, sin_ang, os, ot, ms, mt);
-
-                            *tex_coords0++ = tc;
-                        }
-                    }
-                    else
-                    {
-                        for (S32 i = 0; i < num_vertices; i++)
-                        {
-                            LLVector2 tc(vf.mTexCoords[i]);
-                            LLVector4a& norm = vf.mNormals[i];
-                            LLVector4a& center = *(vf.mCenter);
-                            LLVector4a vec = vf.mPositions[i];
-                            vec.mul(scalea);
-                            planarProjection(tc, norm, center, vec);
-
-                            *tex_coords0++ = tc;
-                        }
-                    }
+                    LLPlanarTexCoords(tc_xform, vf.mPositions, vf_normals, scalea, num_vertices, tex_coords0.get());
                 }
             }
             else
@@ -1881,64 +1837,28 @@ bool LLFace::getGeometryVolume(const LLVolume& volume,
                     }
                     const bool do_xform = (xforms & xform_channel) != XFORM_NONE;
 
+                    LLTexCoordTransform tc_xform;
+                    if (tex_mode && mTextureMatrix)
+                    {
+                        tc_xform.setMatrix(*mTextureMatrix);
+                    }
+                    else if (do_xform)
+                    {
+                        tc_xform.setRotateScaleOffset(cos_ang, sin_ang, os, ot, ms, mt);
+                    }
+
                     // hold onto strider to front of TC array for use later
                     bump_tc = dst;
 
+                    if (texgen == LLTextureEntry::TEX_GEN_PLANAR)
                     {
-                        // NOTE: split TEX_GEN_PLANAR implementation to reduce branchiness of inner loop
-                        // These are per-vertex operations and every little bit counts
-                        if (texgen == LLTextureEntry::TEX_GEN_PLANAR)
-                        {
-                            LL_PROFILE_ZONE_NAMED_CATEGORY_FACE("tgd - planar");
-                            for (S32 i = 0; i < num_vertices; i++)
-                            {
-                                LLVector2 tc(vf.mTexCoords[i]);
-                                LLVector4a& norm = vf.mNormals[i];
-                                LLVector4a& center = *(vf.mCenter);
-                                LLVector4a vec = vf.mPositions[i];
-
-                                vec.mul(scalea);
-
-                                planarProjection(tc, norm, center, vec);
-
-                                if (tex_mode && mTextureMatrix)
-                                {
-                                    LLVector3 tmp(tc.mV[0], tc.mV[1], 0.f);
-                                    tmp = tmp * *mTextureMatrix;
-                                    tc.mV[0] = tmp.mV[0];
-                                    tc.mV[1] = tmp.mV[1];
-                                }
-                                else if (do_xform)
-                                {
-                                    xform(tc, cos_ang, sin_ang, os, ot, ms, mt);
-                                }
-
-                                *dst++ = tc;
-                            }
-                        }
-                        else
-                        {
-                            LL_PROFILE_ZONE_NAMED_CATEGORY_FACE("tgd - transform");
-
-                            for (S32 i = 0; i < num_vertices; i++)
-                            {
-                                LLVector2 tc(vf.mTexCoords[i]);
-
-                                if (tex_mode && mTextureMatrix)
-                                {
-                                    LLVector3 tmp(tc.mV[0], tc.mV[1], 0.f);
-                                    tmp = tmp * *mTextureMatrix;
-                                    tc.mV[0] = tmp.mV[0];
-                                    tc.mV[1] = tmp.mV[1];
-                                }
-                                else if (do_xform)
-                                {
-                                    xform(tc, cos_ang, sin_ang, os, ot, ms, mt);
-                                }
-
-                                *dst++ = tc;
-                            }
-                        }
+                        LL_PROFILE_ZONE_NAMED_CATEGORY_FACE("tgd - planar");
+                        LLPlanarTexCoords(tc_xform, vf.mPositions, vf_normals, scalea, num_vertices, dst.get());
+                    }
+                    else
+                    {
+                        LL_PROFILE_ZONE_NAMED_CATEGORY_FACE("tgd - transform");
+                        LLTransformTexCoords(tc_xform, vf_tex_coords, num_vertices, dst.get());
                     }
                 }
 
@@ -1948,17 +1868,21 @@ bool LLFace::getGeometryVolume(const LLVolume& volume,
                     mVertexBuffer->getTexCoord1Strider(tex_coords1, mGeomIndex, mGeomCount);
 
                     mVObjp->getVolume()->genTangents(face_index);
+                    if (!vf.isCompact())
+                    {
+                        vf_tangents = vf.mTangents;
+                    }
 
                     for (S32 i = 0; i < num_vertices; i++)
                     {
-                        LLVector4a tangent = vf.mTangents[i];
+                        LLVector4a tangent = vf_tangents[i];
 
                         LLVector4a binorm;
-                        binorm.setCross3(vf.mNormals[i], tangent);
+                        binorm.setCross3(vf_normals[i], tangent);
                         binorm.mul(tangent.getF32ptr()[3]);
 
                         LLMatrix4a tangent_to_object;
-                        tangent_to_object.setRows(tangent, binorm, vf.mNormals[i]);
+                        tangent_to_object.setRows(tangent, binorm, vf_normals[i]);
                         LLVector4a t;
                         tangent_to_object.rotate(binormal_dir, t);
                         LLVector4a binormal;
@@ -1996,30 +1920,10 @@ bool LLFace::getGeometryVolume(const LLVolume& volume,
 
         if (rebuild_pos)
         {
-            LLVector4a* src = vf.mPositions;
-
-            //_mm_prefetch((char*)src, _MM_HINT_T0);
-
-            LLVector4a* end = src+num_vertices;
-            //LLVector4a* end_64 = end-4;
-
             llassert(num_vertices > 0);
 
             mVertexBuffer->getVertexStrider(vert, mGeomIndex, mGeomCount);
-
-
-            F32* dst = (F32*) vert.get();
-            F32* end_f32 = dst+mGeomCount*4;
-
-            //_mm_prefetch((char*)dst, _MM_HINT_NTA);
-            //_mm_prefetch((char*)src, _MM_HINT_NTA);
-
-            //_mm_prefetch((char*)dst, _MM_HINT_NTA);
-
-
-            LLVector4a res0; //,res1,res2,res3;
-
-            LLVector4a texIdx;
+            LLVector4a* dst = (LLVector4a*) vert.get();
 
             S32 index = mTextureIndex < FACE_DO_NOT_BATCH_TEXTURES ? mTextureIndex : 0;
 
@@ -2029,38 +1933,23 @@ bool LLFace::getGeometryVolume(const LLVolume& volume,
 
             llassert(index < LLGLSLShader::sIndexedTextureChannels);
 
-            LLVector4Logical mask;
-            mask.clear();
-            mask.setElement<3>();
-
-            texIdx.set(0,0,0,val);
-
-            LLVector4a tmp;
+            LLTransformPositions(mat_vert, vf.mPositions, num_vertices, val, dst);
 
-
-            while (src < end)
+            // pad out to the allocated vertex count with the last vertex, or
+            // with the origin if the volume face has none
+            LLVector4a pad;
+            if (num_vertices > 0)
             {
-                mat_vert.affineTransform(*src++, res0);
-                tmp.setSelectWithMask(mask, texIdx, res0);
-                tmp.store4a((F32*) dst);
-                dst += 4;
+                pad = dst[num_vertices - 1];
+            }
+            else
+            {
+                pad.set(0.f, 0.f, 0.f, val);
             }
 
-            while (dst < end_f32)
+            for (S32 i = num_vertices; i < mGeomCount; ++i)
             {
-// <FS:Zi> GCC12 warning: maybe-uninitialized - probably bogus
-#if defined(__GNUC__) && (__GNUC__ >= 12)
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
-#endif
-// </FS:Zi>
-                res0.store4a((F32*) dst);
-// <FS:Zi> GCC12 warning: maybe-uninitialized - probably bogus
-#if defined(__GNUC__) && (__GNUC__ >= 12)
-#pragma GCC diagnostic pop
-#endif
-// </FS:Zi>
-                dst += 4;
+                dst[i] = pad;
             }
         }
 
@@ -2069,66 +1958,21 @@ bool LLFace::getGeometryVolume(const LLVolume& volume,
             LL_PROFILE_ZONE_NAMED_CATEGORY_FACE("getGeometryVolume - normal");
 
             mVertexBuffer->getNormalStrider(norm, mGeomIndex, mGeomCount);
-            F32* normals = (F32*) norm.get();
-            LLVector4a* src = vf.mNormals;
-            LLVector4a* end = src+num_vertices;
-
-            while (src < end)
-            {
-                LLVector4a normal;
-// <FS:Zi> GCC12 warning: maybe-uninitialized - probably bogus
-#if defined(__GNUC__) && (__GNUC__ >= 12)
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
-#endif
-// </FS:Zi>
-                mat_normal.rotate(*src++, normal);
-// <FS:Zi> GCC12 warning: maybe-uninitialized - probably bogus
-#if defined(__GNUC__) && (__GNUC__ >= 12)
-#pragma GCC diagnostic pop
-#endif
-// </FS:Zi>
-                normal.store4a(normals);
-                normals += 4;
-            }
+            LLRotateVectors(mat_normal, vf_normals, num_vertices, false, (LLVector4a*) norm.get());
         }
 
         if (rebuild_tangent)
         {
             LL_PROFILE_ZONE_NAMED_CATEGORY_FACE("getGeometryVolume - tangent");
             mVertexBuffer->getTangentStrider(tangent, mGeomIndex, mGeomCount);
-            F32* tangents = (F32*) tangent.get();
 
             mVObjp->getVolume()->genTangents(face_index);
-
-            LLVector4Logical mask;
-            mask.clear();
-            mask.setElement<3>();
-
-            LLVector4a* src = vf.mTangents;
-            LLVector4a* end = vf.mTangents +num_vertices;
-
-            while (src < end)
+            if (!vf.isCompact())
             {
-                LLVector4a tangent_out;
-// <FS:Zi> GCC12 warning: maybe-uninitialized - probably bogus
-#if defined(__GNUC__) && (__GNUC__ >= 12)
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
-#endif
-// </FS:Zi>
-                mat_normal.rotate(*src, tangent_out);
-// <FS:Zi> GCC12 warning: maybe-uninitialized - probably bogus
-#if defined(__GNUC__) && (__GNUC__ >= 12)
-#pragma GCC diagnostic pop
-#endif
-// </FS:Zi>
-                tangent_out.setSelectWithMask(mask, *src, tangent_out);
-                tangent_out.store4a(tangents);
-
-                src++;
-                tangents += 4;
+                vf_tangents = vf.mTangents;
             }
+
+            LLRotateVectors(mat_normal, vf_tangents, num_vertices, true, (LLVector4a*) tangent.get());
         }
 
         if (rebuild_weights && vf.mWeights)
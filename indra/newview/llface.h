@@ -169,6 +169,11 @@ public:
                             bool force_rebuild = false,
                             bool no_debug_assert = false,
                             bool rebuild_for_gltf = false);
+    // Main thread part of a getGeometryVolume() run from another thread under
+    // an LLVertexBuffer::DeferredMapScope: generates the tangents it needs and
+    // flags the ranges it writes.  false if the face must be rebuilt on the
+    // main thread.
+    bool prepareGeometryVolume(const LLVolume& volume, S32 face_index, bool force_rebuild = false);
 
     // For avatar
     U16          getGeometryAvatar(
@@ -1313,6 +1313,7 @@ void LLFloaterModelPreview::onPhysicsStageCancel(LLUICtrl* ctrl, void*data)
         {
             DecompRequest* req = *iter;
             req->mContinue = 0;
+            req->cancel();
         }
 
         sInstance->mCurRequest.clear();
@@ -2211,7 +2212,8 @@ S32 LLFloaterModelPreview::DecompRequest::statusCallback(const char* status, S32
 {
     if (mContinue)
     {
-        setStatusMessage(llformat("%s: %d/%d", status, p1, p2));
+        // Models decompose concurrently, say which one this is
+        setStatusMessage(llformat("%s %s: %d/%d", mModel->mLabel.c_str(), status, p1, p2));
         if (LLFloaterModelPreview::sInstance)
         {
             LLFloaterModelPreview::sInstance->setStatusMessage(mStatusMessage);
@@ -0,0 +1,183 @@
+/**
+ * @file llframestatsrecorder.cpp
+ * @brief Writes per-frame render counts to a frame stats log
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+#include "llframestatsrecorder.h"
+
+#include "lldate.h"
+#include "lldir.h"
+#include "lldrawpool.h"
+#include "llimagegl.h"
+#include "llspatialpartition.h"
+#include "lltimer.h"
+#include "llviewercontrol.h"
+
+namespace
+{
+    // log columns, followed by one draw info count per render pass
+    enum
+    {
+        FRAME_TIME = 0,
+        CULL_TIME,
+        VISIBLE_GROUPS,
+        ALPHA_GROUPS,
+        VISIBLE_DRAWABLES,
+        GROUP_REBUILDS,
+        TEXTURE_BINDS,
+        UNIQUE_TEXTURES,
+        FIRST_PASS,
+        NUM_FIELDS = FIRST_PASS + LLRenderPass::NUM_RENDER_TYPES - LLRenderPass::PASS_SIMPLE
+    };
+
+    const char* FIELD_NAMES[FIRST_PASS] =
+    {
+        "frame_us",
+        "cull_us",
+        "visible_groups",
+        "alpha_groups",
+        "visible_drawables",
+        "group_rebuilds",
+        "texture_binds",
+        "unique_textures"
+    };
+}
+
+LLFrameStatsRecorder::LLFrameStatsRecorder()
+:   mValues(NUM_FIELDS, 0),
+    mEnabled(false),
+    mGroupRebuilds(0),
+    mCullTime(0),
+    mLastBindCount(0),
+    mLastUniqueCount(0),
+    mLastFrameTime(0)
+{
+}
+
+LLFrameStatsRecorder::~LLFrameStatsRecorder()
+{
+    stopLog();
+}
+
+void LLFrameStatsRecorder::clearStats()
+{
+    std::fill(mValues.begin(), mValues.end(), 0);
+    mGroupRebuilds = 0;
+    mCullTime = 0;
+}
+
+void LLFrameStatsRecorder::recordCullResult(LLCullResult& result)
+{
+    if (!mEnabled)
+    {
+        return;
+    }
+
+    mValues[VISIBLE_GROUPS] = result.getVisibleGroupsSize();
+    mValues[ALPHA_GROUPS] = result.getAlphaGroupsSize() + result.getRiggedAlphaGroupsSize();
+    mValues[VISIBLE_DRAWABLES] = result.getVisibleListSize();
+    for (U32 pass = LLRenderPass::PASS_SIMPLE; pass < LLRenderPass::NUM_RENDER_TYPES; ++pass)
+    {
+        mValues[FIRST_PASS + pass - LLRenderPass::PASS_SIMPLE] = result.getRenderMapSize(pass);
+    }
+}
+
+void LLFrameStatsRecorder::idle()
+{
+    static LLCachedControl<bool> log_frames(gSavedSettings, "RenderFrameStatsLog", false);
+    const bool logging = log_frames;
+    if (logging != mEnabled)
+    {
+        if (logging)
+        {
+            // the frame in progress started before the log did, skip it
+            startLog();
+            return;
+        }
+        stopLog();
+    }
+
+    if (!mEnabled)
+    {
+        return;
+    }
+
+    const U64 now = LLTimer::getTotalTime();
+    mValues[FRAME_TIME] = (U32)llmin(now - mLastFrameTime, (U64)U32_MAX);
+    mValues[CULL_TIME] = (U32)llmin(mCullTime, (U64)U32_MAX);
+    mValues[GROUP_REBUILDS] = mGroupRebuilds;
+    mValues[TEXTURE_BINDS] = LLImageGL::sBindCount - mLastBindCount;
+    mValues[UNIQUE_TEXTURES] = LLImageGL::sUniqueCount - mLastUniqueCount;
+    mLastFrameTime = now;
+    mLastBindCount = LLImageGL::sBindCount;
+    mLastUniqueCount = LLImageGL::sUniqueCount;
+
+    mWriter.writeFrame(mValues.data());
+    clearStats();
+
+    if (!mWriter.isOpen())
+    {
+        // write failure, already warned about
+        gSavedSettings.setBOOL("RenderFrameStatsLog", false);
+        mEnabled = false;
+    }
+}
+
+void LLFrameStatsRecorder::startLog()
+{
+    std::vector<std::string> fields(FIELD_NAMES, FIELD_NAMES + FIRST_PASS);
+    for (U32 pass = LLRenderPass::PASS_SIMPLE; pass < LLRenderPass::NUM_RENDER_TYPES; ++pass)
+    {
+        fields.push_back(std::string("draw_infos:") + LLRenderPass::lookupPassName(pass));
+    }
+
+    std::string date_str = LLDate(LLFrameTimer::getTotalSeconds()).asString();
+    std::replace(date_str.begin(), date_str.end(), ':', '-');  // Make it valid for a filename
+    const std::string filename = gDirUtilp->getExpandedFilename(LL_PATH_LOGS, "frame_stats-" + date_str + ".llfs");
+
+    if (!mWriter.open(filename, fields))
+    {
+        LL_WARNS() << "Couldn't open " << filename << ", turning off frame stats logging." << LL_ENDL;
+        gSavedSettings.setBOOL("RenderFrameStatsLog", false);
+        return;
+    }
+
+    LL_INFOS() << "Writing frame stats to " << filename << LL_ENDL;
+    mEnabled = true;
+    mLastFrameTime = LLTimer::getTotalTime();
+    mLastBindCount = LLImageGL::sBindCount;
+    mLastUniqueCount = LLImageGL::sUniqueCount;
+    clearStats();
+}
+
+void LLFrameStatsRecorder::stopLog()
+{
+    if (mEnabled)
+    {
+        LL_INFOS() << "Wrote " << mWriter.getFrameCount() << " frames of stats" << LL_ENDL;
+    }
+    mWriter.close();
+    mEnabled = false;
+}
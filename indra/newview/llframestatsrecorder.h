@@ -0,0 +1,88 @@
+/**
+ * @file llframestatsrecorder.h
+ * @brief Writes per-frame render counts to a frame stats log
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLFRAMESTATSRECORDER_H
+#define LL_LLFRAMESTATSRECORDER_H
+
+// Diagnostic class that logs what the pipeline did each frame, for
+// comparing builds on the same scene.  Turned on and off by the
+// RenderFrameStatsLog setting, see llframestats_libtest for reading the
+// logs back.
+
+#include "llframestatslog.h"
+
+class LLCullResult;
+
+class LLFrameStatsRecorder : public LLSimpleton<LLFrameStatsRecorder>
+{
+public:
+    LLFrameStatsRecorder();
+    LOG_CLASS(LLFrameStatsRecorder);
+    ~LLFrameStatsRecorder();
+
+    bool isEnabled() const { return mEnabled; }
+
+    void groupRebuilt()
+    {
+        if (mEnabled)
+        {
+            mGroupRebuilds++;
+        }
+    }
+
+    void addCullTime(U64 usec)
+    {
+        if (mEnabled)
+        {
+            mCullTime += usec;
+        }
+    }
+
+    // Counts of the world camera's cull result, after state sort
+    void recordCullResult(LLCullResult& result);
+
+    // Writes the frame just finished, once per frame
+    void idle();
+
+private:
+    void startLog();
+    void stopLog();
+    void clearStats();
+
+    LLFrameStatsWriter mWriter;
+    std::vector<U32> mValues;
+    bool mEnabled;
+
+    U32 mGroupRebuilds;
+    U64 mCullTime;
+
+    // running totals kept elsewhere, logged as the change since last frame
+    U32 mLastBindCount;
+    U32 mLastUniqueCount;
+    U64 mLastFrameTime;
+};
+
+#endif // LL_LLFRAMESTATSRECORDER_H
@@ -79,6 +79,7 @@
 #include "llfloaterreg.h"
 #include "llvoavatarself.h"
 #include "llskinningutil.h"
+#include "threadpool.h"
 
 #include "boost/iostreams/device/array.hpp"
 #include "boost/iostreams/stream.hpp"
@@ -88,6 +89,8 @@
 #include <boost/iostreams/stream.hpp>
 // </FS:Beq pp Rye>
 
+#include <thread>
+
 #ifndef LL_WINDOWS
 #include "netdb.h"
 #endif
@@ -175,7 +178,7 @@
 //   LLMeshRepoThread::mMutex
 //   LLMeshRepoThread::mHeaderMutex
 //   LLMeshRepoThread::mSignal (LLCondition)
-//   LLPhysicsDecomp::mSignal (LLCondition)
+//   LLPhysicsDecomp::mQueueMutex
 //   LLPhysicsDecomp::mMutex
 //   LLMeshUploadThread::mMutex
 //
@@ -183,6 +186,7 @@
 //
 //   1.  LLMeshRepoThread::mMutex before LLMeshRepoThread::mHeaderMutex
 //   2.  LLMeshRepository::mMeshMutex before LLMeshRepoThread::mMutex
+//   3.  LLPhysicsDecomp::mQueueMutex before LLPhysicsDecomp::mMutex
 //   (There are more rules, haven't been extracted.)
 //
 // Data Member Access/Locking
@@ -234,6 +238,13 @@
 //     sCacheBytesWritten              "
 //     sCacheReads                     "
 //     sCacheWrites                    "
+//     sCacheOptimizedHits             none            rw.lod.none, ro.main.none [1]
+//     sCacheOptimizedMisses           "
+//     sCompactBytesSaved              "
+//     sDecodeQueueDepth               none            rw.repo.none, rw.lod.none, ro.main.none [1]
+//     sDecodeCount                    none            rw.lod.none, ro.main.none [1]
+//     sDecodeTimeUsec                 "
+//     sDecodeMaxUsec                  "
 //     mLoadingMeshes                  mMeshMutex [4]  rw.main.none, rw.any.mMeshMutex
 //     mSkinMap                        none            rw.main.none
 //     mDecompositionMap               none            rw.main.none
@@ -258,10 +269,10 @@
 //     mMeshHeader              mHeaderMutex  rw.repo.mHeaderMutex, ro.main.mHeaderMutex, ro.main.none [0]
 //     mSkinRequests            mMutex        rw.repo.mMutex, ro.repo.none [5]
 //     mSkinInfoQ               mMutex        rw.repo.mMutex, rw.main.mMutex [5] (was:  [0])
-//     mDecompositionRequests   mMutex        rw.repo.mMutex, ro.repo.none [5]
-//     mPhysicsShapeRequests    mMutex        rw.repo.mMutex, ro.repo.none [5]
-//     mDecompositionQ          mMutex        rw.repo.mLoadedMutex, rw.main.mLoadedMutex [5] (was:  [0])
-//     mPhysicsQ                mMutex        rw.repo.mLoadedMutex, rw.main.mLoadedMutex [5] (was:  [0])
+//     mDecompositionRequests   mMutex        rw.repo.mMutex, rw.lod.mMutex, ro.repo.none [5]
+//     mPhysicsShapeRequests    mMutex        rw.repo.mMutex, rw.lod.mMutex, ro.repo.none [5]
+//     mDecompositionQ          mMutex        rw.repo.mLoadedMutex, rw.lod.mLoadedMutex, rw.main.mLoadedMutex [5] (was:  [0])
+//     mPhysicsQ                mMutex        rw.repo.mLoadedMutex, rw.lod.mLoadedMutex, rw.main.mLoadedMutex [5] (was:  [0])
 //     mHeaderReqQ              mMutex        ro.repo.none [5], rw.repo.mMutex, rw.any.mMutex
 //     mLODReqQ                 mMutex        ro.repo.none [5], rw.repo.mMutex, rw.any.mMutex
 //     mUnavailableQ            mMutex        rw.repo.none [0], ro.main.none [5], rw.main.mLoadedMutex
@@ -362,8 +373,10 @@ const S32 REQUEST_LOW_WATER_MAX = 75;
 
 constexpr S32 REQUEST2_HIGH_WATER_MIN = 32;                 // Limits for GetMesh2 regions
 constexpr S32 REQUEST2_HIGH_WATER_MAX = 100;
+constexpr S32 REQUEST2_MUX_HIGH_WATER_MAX = 400;            // GetMesh2 over HTTP/2 multiplexing
 constexpr S32 REQUEST2_LOW_WATER_MIN = 16;
 constexpr S32 REQUEST2_LOW_WATER_MAX = 50;
+constexpr S32 REQUEST2_MUX_LOW_WATER_MAX = 200;
 
 constexpr U32 LARGE_MESH_FETCH_THRESHOLD = 1U << 21;        // Size at which requests goes to narrow/slow queue
 constexpr long SMALL_MESH_XFER_TIMEOUT = 120L;              // Seconds to complete xfer, small mesh downloads
@@ -411,6 +424,13 @@ U32 LLMeshRepository::sCacheBytesSkins = 0;
 U32 LLMeshRepository::sCacheBytesDecomps = 0;
 U32 LLMeshRepository::sCacheReads = 0;
 std::atomic<U32> LLMeshRepository::sCacheWrites = 0;
+std::atomic<U32> LLMeshRepository::sCacheOptimizedHits = 0;
+std::atomic<U32> LLMeshRepository::sCacheOptimizedMisses = 0;
+std::atomic<U64> LLMeshRepository::sCompactBytesSaved = 0;
+std::atomic<S32> LLMeshRepository::sDecodeQueueDepth = 0;
+std::atomic<U32> LLMeshRepository::sDecodeCount = 0;
+std::atomic<U64> LLMeshRepository::sDecodeTimeUsec = 0;
+std::atomic<U32> LLMeshRepository::sDecodeMaxUsec = 0;
 U32 LLMeshRepository::sMaxLockHoldoffs = 0;
 
 LLDeadmanTimer LLMeshRepository::sQuiescentTimer(15.0, false);  // true -> gather cpu metrics
@@ -634,6 +654,8 @@ U32 LLMeshRepoThread::sMaxConcurrentRequests = 1;
 S32 LLMeshRepoThread::sRequestLowWater = REQUEST2_LOW_WATER_MIN;
 S32 LLMeshRepoThread::sRequestHighWater = REQUEST2_HIGH_WATER_MIN;
 S32 LLMeshRepoThread::sRequestWaterLevel = 0;
+bool LLMeshRepoThread::sCacheOptimizedLODs = true;
+bool LLMeshRepoThread::sCompactLODs = false;
 
 // Base handler class for all mesh users of llcorehttp.
 // This is roughly equivalent to a Responder class in
@@ -798,6 +820,8 @@ protected:
     LLMeshDecompositionHandler(const LLMeshDecompositionHandler &);     // Not defined
     void operator=(const LLMeshDecompositionHandler &);                 // Not defined
 
+    void processDecomposition(U8* data, S32 data_size);
+
 public:
     virtual void processData(LLCore::BufferArray * body, S32 body_offset, U8 * data, S32 data_size);
     virtual void processFailure(LLCore::HttpStatus status);
@@ -824,6 +848,8 @@ protected:
     LLMeshPhysicsShapeHandler(const LLMeshPhysicsShapeHandler &);   // Not defined
     void operator=(const LLMeshPhysicsShapeHandler &);              // Not defined
 
+    void processPhysicsShape(U8* data, S32 data_size);
+
 public:
     virtual void processData(LLCore::BufferArray * body, S32 body_offset, U8 * data, S32 data_size);
     virtual void processFailure(LLCore::HttpStatus status);
@@ -943,6 +969,17 @@ void log_upload_error(
     gMeshRepo.uploadError(args);
 }
 
+// Disk cache id of the cacheOptimize() results for a mesh LOD.  Stored
+// as its own cache entry so the layout of the mesh asset entry (preamble,
+// header, LODs at their asset offsets) stays as it is.
+LLUUID optimized_lod_cache_id(const LLUUID& mesh_id, S32 lod)
+{
+    static const LLUUID OPTIMIZED_LOD_SALT("6d1c2f4e-93a8-4b57-a0e2-5f0b8c7d3e10");
+    LLUUID lod_salt = OPTIMIZED_LOD_SALT;
+    lod_salt.mData[UUID_BYTES - 1] ^= (U8)lod;
+    return mesh_id.combine(lod_salt);
+}
+
 void write_preamble(LLFileSystem &file, S32 header_bytes, S32 flags)
 {
     LLMeshRepository::sCacheBytesWritten += CACHE_PREAMBLE_SIZE;
@@ -1410,6 +1447,71 @@ void LLMeshRepoThread::loadMeshLOD(const LLUUID& mesh_id, const LLVolumeParams&
     }
 }
 
+template <typename CALLABLE>
+bool LLMeshRepoThread::postDecode(CALLABLE&& func)
+{
+    ++LLMeshRepository::sDecodeQueueDepth;
+    bool posted = mMeshThreadPool->getQueue().post(
+        [func = std::forward<CALLABLE>(func)]
+        () mutable
+    {
+        --LLMeshRepository::sDecodeQueueDepth;
+
+        U64 start = LLTimer::getTotalTime();
+        func();
+        U32 elapsed = (U32)(LLTimer::getTotalTime() - start);
+
+        ++LLMeshRepository::sDecodeCount;
+        LLMeshRepository::sDecodeTimeUsec += elapsed;
+        U32 prev_max = LLMeshRepository::sDecodeMaxUsec;
+        while (prev_max < elapsed
+               && !LLMeshRepository::sDecodeMaxUsec.compare_exchange_weak(prev_max, elapsed))
+        {
+        }
+    });
+    if (!posted)
+    {
+        --LLMeshRepository::sDecodeQueueDepth;
+    }
+    return posted;
+}
+
+void LLMeshRepoThread::invalidateCachedMesh(const LLUUID& mesh_id)
+{
+    S32 header_size = 0;
+    U32 header_flags = 0;
+    {
+        LL_DEBUGS(LOG_MESH) << "Mesh header for ID " << mesh_id << " cache mismatch." << LL_ENDL;
+
+        LLMutexLock lock(mHeaderMutex);
+
+        auto header_it = mMeshHeader.find(mesh_id);
+        if (header_it != mMeshHeader.end())
+        {
+            LLMeshHeader& header = header_it->second;
+            // for safety just mark everything as missing
+            header.mSkinInCache = false;
+            header.mPhysicsConvexInCache = false;
+            header.mPhysicsMeshInCache = false;
+            for (S32 i = 0; i < LLModel::NUM_LODS; ++i)
+            {
+                header.mLodInCache[i] = false;
+            }
+            header_size = header.mHeaderSize;
+            header_flags = header.getFlags();
+        }
+    }
+
+    if (header_size > 0)
+    {
+        LLFileSystem file(mesh_id, LLAssetType::AT_MESH, LLFileSystem::READ_WRITE);
+        if (file.getMaxSize() >= CACHE_PREAMBLE_SIZE)
+        {
+            write_preamble(file, header_size, header_flags);
+        }
+    }
+}
+
 U8* LLMeshRepoThread::getDiskCacheBuffer(S32 size)
 {
     if (mDiskCacheBufferSize < size)
@@ -1652,7 +1754,7 @@ bool LLMeshRepoThread::fetchMeshSkinInfo(const LLUUID& mesh_id)
                 if (!zero)
                 {
                     //attempt to parse
-                    bool posted = mMeshThreadPool->getQueue().post(
+                    bool posted = postDecode(
                         [mesh_id, buffer, size]
                         ()
                     {
@@ -1664,38 +1766,7 @@ bool LLMeshRepoThread::fetchMeshSkinInfo(const LLUUID& mesh_id)
                         if (!gMeshRepo.mThread->skinInfoReceived(mesh_id, buffer, size))
                         {
                             // either header is faulty or something else overwrote the cache
-                            S32 header_size = 0;
-                            U32 header_flags = 0;
-                            {
-                                LL_DEBUGS(LOG_MESH) << "Mesh header for ID " << mesh_id << " cache mismatch." << LL_ENDL;
-
-                                LLMutexLock lock(gMeshRepo.mThread->mHeaderMutex);
-
-                                auto header_it = gMeshRepo.mThread->mMeshHeader.find(mesh_id);
-                                if (header_it != gMeshRepo.mThread->mMeshHeader.end())
-                                {
-                                    LLMeshHeader& header = header_it->second;
-                                    // for safety just mark everything as missing
-                                    header.mSkinInCache = false;
-                                    header.mPhysicsConvexInCache = false;
-                                    header.mPhysicsMeshInCache = false;
-                                    for (S32 i = 0; i < LLModel::NUM_LODS; ++i)
-                                    {
-                                        header.mLodInCache[i] = false;
-                                    }
-                                    header_size = header.mHeaderSize;
-                                    header_flags = header.getFlags();
-                                }
-                            }
-
-                            if (header_size > 0)
-                            {
-                                LLFileSystem file(mesh_id, LLAssetType::AT_MESH, LLFileSystem::READ_WRITE);
-                                if (file.getMaxSize() >= CACHE_PREAMBLE_SIZE)
-                                {
-                                    write_preamble(file, header_size, header_flags);
-                                }
-                            }
+                            gMeshRepo.mThread->invalidateCachedMesh(mesh_id);
 
                             {
                                 LLMutexLock lock(gMeshRepo.mThread->mMutex);
@@ -1807,9 +1878,10 @@ bool LLMeshRepoThread::fetchMeshDecomposition(const LLUUID& mesh_id)
             LLFileSystem file(mesh_id, LLAssetType::AT_MESH);
             if (in_cache && file.getSize() >= disk_ofset + size)
             {
-                U8* buffer = getDiskCacheBuffer(size);
+                U8* buffer = new(std::nothrow) U8[size];
                 if (!buffer)
                 {
+                    LL_WARNS(LOG_MESH) << "Failed to allocate memory for mesh decomposition, size: " << size << LL_ENDL;
                     return true;
                 }
                 LLMeshRepository::sCacheBytesRead += size;
@@ -1827,11 +1899,39 @@ bool LLMeshRepoThread::fetchMeshDecomposition(const LLUUID& mesh_id)
 
                 if (!zero)
                 { //attempt to parse
-                    if (decompositionReceived(mesh_id, buffer, size))
+                    bool posted = postDecode(
+                        [mesh_id, buffer, size]
+                        ()
                     {
+                        if (gMeshRepo.mThread->isShuttingDown())
+                        {
+                            delete[] buffer;
+                            return;
+                        }
+                        if (!gMeshRepo.mThread->decompositionReceived(mesh_id, buffer, size))
+                        {
+                            // either header is faulty or something else overwrote the cache
+                            gMeshRepo.mThread->invalidateCachedMesh(mesh_id);
+
+                            {
+                                LLMutexLock lock(gMeshRepo.mThread->mMutex);
+                                gMeshRepo.mThread->mDecompositionRequests.insert(UUIDBasedRequest(mesh_id));
+                            }
+                        }
+                        delete[] buffer;
+                    });
+                    if (posted)
+                    {
+                        // lambda owns buffer
+                        return true;
+                    }
+                    else if (decompositionReceived(mesh_id, buffer, size))
+                    {
+                        delete[] buffer;
                         return true;
                     }
                 }
+                delete[] buffer;
             }
 
             //reading from cache failed for whatever reason, fetch from sim
@@ -1913,14 +2013,15 @@ bool LLMeshRepoThread::fetchMeshPhysicsShape(const LLUUID& mesh_id)
             LLFileSystem file(mesh_id, LLAssetType::AT_MESH);
             if (in_cache && file.getSize() >= disk_ofset +size)
             {
-                LLMeshRepository::sCacheBytesRead += size;
-                ++LLMeshRepository::sCacheReads;
-
-                U8* buffer = getDiskCacheBuffer(size);
+                U8* buffer = new(std::nothrow) U8[size];
                 if (!buffer)
                 {
+                    LL_WARNS(LOG_MESH) << "Failed to allocate memory for physics shape, size: " << size << LL_ENDL;
                     return true;
                 }
+                LLMeshRepository::sCacheBytesRead += size;
+                ++LLMeshRepository::sCacheReads;
+
                 file.seek(disk_ofset);
                 file.read(buffer, size);
 
@@ -1933,11 +2034,39 @@ bool LLMeshRepoThread::fetchMeshPhysicsShape(const LLUUID& mesh_id)
 
                 if (!zero)
                 { //attempt to parse
-                    if (physicsShapeReceived(mesh_id, buffer, size) == MESH_OK)
+                    bool posted = postDecode(
+                        [mesh_id, buffer, size]
+                        ()
                     {
+                        if (gMeshRepo.mThread->isShuttingDown())
+                        {
+                            delete[] buffer;
+                            return;
+                        }
+                        if (gMeshRepo.mThread->physicsShapeReceived(mesh_id, buffer, size) != MESH_OK)
+                        {
+                            // either header is faulty or something else overwrote the cache
+                            gMeshRepo.mThread->invalidateCachedMesh(mesh_id);
+
+                            {
+                                LLMutexLock lock(gMeshRepo.mThread->mMutex);
+                                gMeshRepo.mThread->mPhysicsShapeRequests.insert(UUIDBasedRequest(mesh_id));
+                            }
+                        }
+                        delete[] buffer;
+                    });
+                    if (posted)
+                    {
+                        // lambda owns buffer
+                        return true;
+                    }
+                    else if (physicsShapeReceived(mesh_id, buffer, size) == MESH_OK)
+                    {
+                        delete[] buffer;
                         return true;
                     }
                 }
+                delete[] buffer;
             }
 
             //reading from cache failed for whatever reason, fetch from sim
@@ -2179,7 +2308,7 @@ bool LLMeshRepoThread::fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod)
                 {
                     //attempt to parse
                     const LLVolumeParams params(mesh_params);
-                    bool posted = mMeshThreadPool->getQueue().post(
+                    bool posted = postDecode(
                         [params, mesh_id, lod, buffer, size]
                         ()
                     {
@@ -2195,38 +2324,7 @@ bool LLMeshRepoThread::fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod)
                         else
                         {
                             // either header is faulty or something else overwrote the cache
-                            S32 header_size = 0;
-                            U32 header_flags = 0;
-                            {
-                                LL_DEBUGS(LOG_MESH) << "Mesh header for ID " << mesh_id << " cache mismatch." << LL_ENDL;
-
-                                LLMutexLock lock(gMeshRepo.mThread->mHeaderMutex);
-
-                                auto header_it = gMeshRepo.mThread->mMeshHeader.find(mesh_id);
-                                if (header_it != gMeshRepo.mThread->mMeshHeader.end())
-                                {
-                                    LLMeshHeader& header = header_it->second;
-                                    // for safety just mark everything as missing
-                                    header.mSkinInCache = false;
-                                    header.mPhysicsConvexInCache = false;
-                                    header.mPhysicsMeshInCache = false;
-                                    for (S32 i = 0; i < LLModel::NUM_LODS; ++i)
-                                    {
-                                        header.mLodInCache[i] = false;
-                                    }
-                                    header_size = header.mHeaderSize;
-                                    header_flags = header.getFlags();
-                                }
-                            }
-
-                            if (header_size > 0)
-                            {
-                                LLFileSystem file(mesh_id, LLAssetType::AT_MESH, LLFileSystem::READ_WRITE);
-                                if (file.getMaxSize() >= CACHE_PREAMBLE_SIZE)
-                                {
-                                    write_preamble(file, header_size, header_flags);
-                                }
-                            }
+                            gMeshRepo.mThread->invalidateCachedMesh(mesh_id);
 
                             {
                                 LLMutexLock lock(gMeshRepo.mThread->mMutex);
@@ -2493,7 +2591,8 @@ EMeshProcessingResult LLMeshRepoThread::lodReceived(const LLVolumeParams& mesh_p
     }
 
     LLPointer<LLVolume> volume = new LLVolume(mesh_params, LLVolumeLODGroup::getVolumeScaleFromDetail(lod));
-    if (volume->unpackVolumeFaces(data, data_size))
+    if (volume->unpackVolumeFaces(data, data_size, false)
+        && optimizeLOD(mesh_params.getSculptID(), lod, volume))
     {
         // Use LLVolume::getNumVolumeFaces() here and not LLVolume::getNumFaces(),
         // because setMeshAssetLoaded() has not yet been called for this volume
@@ -2523,6 +2622,12 @@ EMeshProcessingResult LLMeshRepoThread::lodReceived(const LLVolumeParams& mesh_p
                 }
             }
 
+            if (sCompactLODs)
+            {
+                // Rigged faces are skipped, they carry weights
+                LLMeshRepository::sCompactBytesSaved += volume->compactFaces();
+            }
+
             LoadedMesh mesh(volume, mesh_params, lod);
             {
                 LLMutexLock lock(mLoadedMutex);
@@ -2546,6 +2651,51 @@ EMeshProcessingResult LLMeshRepoThread::lodReceived(const LLVolumeParams& mesh_p
     return MESH_UNKNOWN;
 }
 
+// Vertex cache optimization (and MikkTSpace tangents) of a freshly
+// unpacked LOD.  The index order, vertex remap and tangents are kept in
+// the disk cache so the next load of a popular mesh skips the work, the
+// other vertex data is rebuilt from the LOD itself.
+bool LLMeshRepoThread::optimizeLOD(const LLUUID& mesh_id, S32 lod, LLVolume* volume)
+{
+    LL_PROFILE_ZONE_SCOPED;
+
+    if (!sCacheOptimizedLODs)
+    {
+        return volume->cacheOptimize(true);
+    }
+
+    const LLUUID cache_id = optimized_lod_cache_id(mesh_id, lod);
+    {
+        LLFileSystem file(cache_id, LLAssetType::AT_MESH);
+        S32 size = file.getSize();
+        if (size > 0)
+        {
+            std::vector<U8> buffer(size);
+            if (file.read(buffer.data(), size) && volume->unpackOptimizedFaces(buffer.data(), size))
+            {
+                ++LLMeshRepository::sCacheOptimizedHits;
+                return true;
+            }
+            LL_DEBUGS(LOG_MESH) << "Stale optimized faces for mesh " << mesh_id << " LOD " << lod << LL_ENDL;
+        }
+    }
+    ++LLMeshRepository::sCacheOptimizedMisses;
+
+    std::vector<U8> packed;
+    if (!volume->cacheOptimize(true, &packed))
+    {
+        return false;
+    }
+
+    LLFileSystem file(cache_id, LLAssetType::AT_MESH, LLFileSystem::WRITE);
+    if (file.write(packed.data(), (S32)packed.size()))
+    {
+        LLMeshRepository::sCacheBytesWritten += (U32)packed.size();
+        ++LLMeshRepository::sCacheWrites;
+    }
+    return true;
+}
+
 bool LLMeshRepoThread::skinInfoReceived(const LLUUID& mesh_id, U8* data, S32 data_size)
 {
     LL_PROFILE_ZONE_SCOPED;
@@ -2745,21 +2895,19 @@ LLMeshUploadThread::DecompRequest::DecompRequest(LLModel* mdl, LLModel* base_mod
 
     //copy out positions and indices
     assignData(mdl) ;
-
-    mThread->mFinalDecomp = this;
-    mThread->mPhysicsComplete = false;
 }
 
 void LLMeshUploadThread::DecompRequest::completed()
 {
-    if (mThread->mFinalDecomp == this)
+    llassert(mHull.size() == 1);
+
+    if (!mHull.empty())
     {
-        mThread->mPhysicsComplete = true;
+        mThread->mHullMap[mBaseModel] = mHull[0];
     }
 
-    llassert(mHull.size() == 1);
-
-    mThread->mHullMap[mBaseModel] = mHull[0];
+    // Requests complete in any order, the upload waits for all of them
+    mThread->mPendingDecomps--;
 }
 
 //called in the main thread.
@@ -3160,9 +3308,10 @@ void LLMeshUploadThread::generateHulls()
 
         llassert(physics != NULL);
 
-        DecompRequest* request = new DecompRequest(physics, data.mBaseModel, this);
+        LLPointer<DecompRequest> request = new DecompRequest(physics, data.mBaseModel, this);
         if(request->isValid())
         {
+            mPendingDecomps++;
             gMeshRepo.mDecompThread->submitRequest(request);
             has_valid_requests = true ;
         }
@@ -3176,7 +3325,7 @@ void LLMeshUploadThread::generateHulls()
         // the decomposition thread and the upload thread and this loop
         // wouldn't complete in turn stalling the main thread.  The check
         // on isDiscarded() prevents that.
-        while (! mPhysicsComplete && ! isDiscarded())
+        while (mPendingDecomps > 0 && ! isDiscarded())
         {
             apr_sleep(100);
         }
@@ -3713,15 +3862,16 @@ void LLMeshHandlerBase::onCompleted(LLCore::HttpHandle handle, LLCore::HttpRespo
                 goto common_exit;
             }
 
-            // *TODO: Try to get rid of data copying and add interfaces
-            // that support BufferArray directly.  Introduce a two-phase
-            // handler, optional first that takes a body, fallback second
-            // that requires a temporary allocation and data copy.
+            // Take the body out of the BufferArray.  Bodies that arrived
+            // with a Content-Length sit in a single block which is handed
+            // over without a copy.  Data is ll_aligned_malloc_16() memory
+            // from here on and handlers must free it to match.
             body_offset = mOffset - offset;
-            data = new(std::nothrow) U8[data_size - body_offset];
+            size_t detached_size(0);
+            data = (U8 *) body->detachContiguous(body_offset, &detached_size);
             if (data)
             {
-                body->read(body_offset, (char *) data, data_size - body_offset);
+                llassert_always(detached_size == data_size - body_offset);
                 LLMeshRepository::sBytesReceived += static_cast<U32>(data_size);
             }
             else
@@ -3735,7 +3885,7 @@ void LLMeshHandlerBase::onCompleted(LLCore::HttpHandle handle, LLCore::HttpRespo
 
         if (mHasDataOwnership)
         {
-            delete [] data;
+            ll_aligned_free_16(data);
         }
     }
 
@@ -3977,18 +4127,18 @@ void LLMeshLODHandler::processData(LLCore::BufferArray * /* body */, S32 /* body
         && ((data != NULL) == (data_size > 0))) // if we have data but no size or have size but no data, something is wrong
     {
         LLMeshHandlerBase::ptr_t shrd_handler = shared_from_this();
-        bool posted = gMeshRepo.mThread->mMeshThreadPool->getQueue().post(
+        bool posted = gMeshRepo.mThread->postDecode(
             [shrd_handler, data, data_size]
             ()
         {
             if (gMeshRepo.mThread->isShuttingDown())
             {
-                delete[] data;
+                ll_aligned_free_16(data);
                 return;
             }
             LLMeshLODHandler* handler = (LLMeshLODHandler * )shrd_handler.get();
             handler->processLod(data, data_size);
-            delete[] data;
+            ll_aligned_free_16(data);
         });
 
         if (posted)
@@ -4095,18 +4245,18 @@ void LLMeshSkinInfoHandler::processData(LLCore::BufferArray * /* body */, S32 /*
         && ((data != NULL) == (data_size > 0))) // if we have data but no size or have size but no data, something is wrong
     {
         LLMeshHandlerBase::ptr_t shrd_handler = shared_from_this();
-        bool posted = gMeshRepo.mThread->mMeshThreadPool->getQueue().post(
+        bool posted = gMeshRepo.mThread->postDecode(
             [shrd_handler, data, data_size]
             ()
         {
             if (gMeshRepo.mThread->isShuttingDown())
             {
-                delete[] data;
+                ll_aligned_free_16(data);
                 return;
             }
             LLMeshSkinInfoHandler* handler = (LLMeshSkinInfoHandler*)shrd_handler.get();
             handler->processSkin(data, data_size);
-            delete[] data;
+            ll_aligned_free_16(data);
         });
 
         if (posted)
@@ -4149,13 +4299,9 @@ void LLMeshDecompositionHandler::processFailure(LLCore::HttpStatus status)
     // request unfulfilled rather than retry forever.
 }
 
-void LLMeshDecompositionHandler::processData(LLCore::BufferArray * /* body */, S32 /* body_offset */,
-                                             U8 * data, S32 data_size)
+void LLMeshDecompositionHandler::processDecomposition(U8* data, S32 data_size)
 {
-    LL_PROFILE_ZONE_SCOPED;
-    if ((!MESH_DECOMP_PROCESS_FAILED)
-        && ((data != NULL) == (data_size > 0)) // if we have data but no size or have size but no data, something is wrong
-        && gMeshRepo.mThread->decompositionReceived(mMeshID, data, data_size))
+    if (gMeshRepo.mThread->decompositionReceived(mMeshID, data, data_size))
     {
         // good fetch from sim, write to cache
         LLFileSystem file(mMeshID, LLAssetType::AT_MESH, LLFileSystem::READ_WRITE);
@@ -4205,6 +4351,49 @@ void LLMeshDecompositionHandler::processData(LLCore::BufferArray * /* body */, S
     }
 }
 
+void LLMeshDecompositionHandler::processData(LLCore::BufferArray * /* body */, S32 /* body_offset */,
+                                             U8 * data, S32 data_size)
+{
+    LL_PROFILE_ZONE_SCOPED;
+    if ((!MESH_DECOMP_PROCESS_FAILED)
+        && ((data != NULL) == (data_size > 0))) // if we have data but no size or have size but no data, something is wrong
+    {
+        LLMeshHandlerBase::ptr_t shrd_handler = shared_from_this();
+        bool posted = gMeshRepo.mThread->postDecode(
+            [shrd_handler, data, data_size]
+            ()
+        {
+            if (gMeshRepo.mThread->isShuttingDown())
+            {
+                ll_aligned_free_16(data);
+                return;
+            }
+            LLMeshDecompositionHandler* handler = (LLMeshDecompositionHandler*)shrd_handler.get();
+            handler->processDecomposition(data, data_size);
+            ll_aligned_free_16(data);
+        });
+
+        if (posted)
+        {
+            // ownership of data was passed to the lambda
+            mHasDataOwnership = false;
+        }
+        else
+        {
+            // mesh thread dies later than event queue, so this is normal
+            LL_INFOS_ONCE(LOG_MESH) << "Failed to post work into mMeshThreadPool" << LL_ENDL;
+            processDecomposition(data, data_size);
+        }
+    }
+    else
+    {
+        LL_WARNS(LOG_MESH) << "Error during mesh decomposition processing.  ID:  " << mMeshID
+                           << ", Unknown reason.  Not retrying."
+                           << LL_ENDL;
+        // *TODO:  Mark mesh unavailable on error
+    }
+}
+
 LLMeshPhysicsShapeHandler::~LLMeshPhysicsShapeHandler()
 {
     if (!mProcessed)
@@ -4222,13 +4411,9 @@ void LLMeshPhysicsShapeHandler::processFailure(LLCore::HttpStatus status)
     // *TODO:  Mark mesh unavailable on error
 }
 
-void LLMeshPhysicsShapeHandler::processData(LLCore::BufferArray * /* body */, S32 /* body_offset */,
-                                            U8 * data, S32 data_size)
+void LLMeshPhysicsShapeHandler::processPhysicsShape(U8* data, S32 data_size)
 {
-    LL_PROFILE_ZONE_SCOPED;
-    if ((!MESH_PHYS_SHAPE_PROCESS_FAILED)
-        && ((data != NULL) == (data_size > 0)) // if we have data but no size or have size but no data, something is wrong
-        && gMeshRepo.mThread->physicsShapeReceived(mMeshID, data, data_size) == MESH_OK)
+    if (gMeshRepo.mThread->physicsShapeReceived(mMeshID, data, data_size) == MESH_OK)
     {
         // good fetch from sim, write to cache for caching
         LLFileSystem file(mMeshID, LLAssetType::AT_MESH, LLFileSystem::READ_WRITE);
@@ -4278,6 +4463,49 @@ void LLMeshPhysicsShapeHandler::processData(LLCore::BufferArray * /* body */, S3
     }
 }
 
+void LLMeshPhysicsShapeHandler::processData(LLCore::BufferArray * /* body */, S32 /* body_offset */,
+                                            U8 * data, S32 data_size)
+{
+    LL_PROFILE_ZONE_SCOPED;
+    if ((!MESH_PHYS_SHAPE_PROCESS_FAILED)
+        && ((data != NULL) == (data_size > 0))) // if we have data but no size or have size but no data, something is wrong
+    {
+        LLMeshHandlerBase::ptr_t shrd_handler = shared_from_this();
+        bool posted = gMeshRepo.mThread->postDecode(
+            [shrd_handler, data, data_size]
+            ()
+        {
+            if (gMeshRepo.mThread->isShuttingDown())
+            {
+                ll_aligned_free_16(data);
+                return;
+            }
+            LLMeshPhysicsShapeHandler* handler = (LLMeshPhysicsShapeHandler*)shrd_handler.get();
+            handler->processPhysicsShape(data, data_size);
+            ll_aligned_free_16(data);
+        });
+
+        if (posted)
+        {
+            // ownership of data was passed to the lambda
+            mHasDataOwnership = false;
+        }
+        else
+        {
+            // mesh thread dies later than event queue, so this is normal
+            LL_INFOS_ONCE(LOG_MESH) << "Failed to post work into mMeshThreadPool" << LL_ENDL;
+            processPhysicsShape(data, data_size);
+        }
+    }
+    else
+    {
+        LL_WARNS(LOG_MESH) << "Error during mesh physics shape processing.  ID:  " << mMeshID
+                           << ", Unknown reason.  Not retrying."
+                           << LL_ENDL;
+        // *TODO:  Mark mesh unavailable on error
+    }
+}
+
 LLMeshRepository::LLMeshRepository()
 : mMeshMutex(NULL),
   mDecompThread(NULL),
@@ -4299,7 +4527,10 @@ void LLMeshRepository::init()
         LL_INFOS(LOG_MESH) << "Using STUB for LLConvexDecomposition" << LL_ENDL;
     }
 
-    mDecompThread = new LLPhysicsDecomp();
+    // Decompositions are heavy on memory bandwidth, half the cores is plenty
+    S32 decomp_threads = llclamp((S32)std::thread::hardware_concurrency() / 2, 1, 4);
+    U64 decomp_memory_cap = (U64)gSavedSettings.getU32("MeshDecompMemoryCap") * 1024 * 1024;
+    mDecompThread = new LLPhysicsDecomp(decomp_threads, decomp_memory_cap);
     mDecompThread->start();
 
     while (!mDecompThread->mInited)
@@ -4309,6 +4540,9 @@ void LLMeshRepository::init()
 
     metrics_teleport_started_signal = LLViewerMessage::getInstance()->setTeleportStartedCallback(teleport_started);
 
+    LLMeshRepoThread::sCacheOptimizedLODs = gSavedSettings.getBOOL("MeshCacheOptimizedLODs");
+    LLMeshRepoThread::sCompactLODs = gSavedSettings.getBOOL("MeshCompactLODStorage");
+
     mThread = new LLMeshRepoThread();
     mThread->start();
 }
@@ -4544,6 +4778,15 @@ void LLMeshRepository::notifyLoadedMeshes()
         S32 scale(app_core_http.isPipelined(LLAppCoreHttp::AP_MESH2)
                   ? (2 * LLAppCoreHttp::PIPELINING_DEPTH)
                   : 5);
+        S32 high_water_max(REQUEST2_HIGH_WATER_MAX);
+        S32 low_water_max(REQUEST2_LOW_WATER_MAX);
+        if (app_core_http.isMultiplexed(LLAppCoreHttp::AP_MESH2))
+        {
+            // Streams are cheap, keep many more requests in flight
+            scale = S32(app_core_http.getStreamLimit(LLAppCoreHttp::AP_MESH2));
+            high_water_max = REQUEST2_MUX_HIGH_WATER_MAX;
+            low_water_max = REQUEST2_MUX_LOW_WATER_MAX;
+        }
 
         static LLCachedControl<U32> mesh2MaxConcurrentRequests(gSavedSettings, "Mesh2MaxConcurrentRequests");
         if (mesh2MaxConcurrentRequests() > MESH2_CONCURRENT_REQUEST_LIMIT)
@@ -4560,10 +4803,10 @@ void LLMeshRepository::notifyLoadedMeshes()
         LLMeshRepoThread::sMaxConcurrentRequests = mesh2MaxConcurrentRequests();
         LLMeshRepoThread::sRequestHighWater = llclamp(scale * S32(LLMeshRepoThread::sMaxConcurrentRequests),
                                                       REQUEST2_HIGH_WATER_MIN,
-                                                      REQUEST2_HIGH_WATER_MAX);
+                                                      high_water_max);
         LLMeshRepoThread::sRequestLowWater = llclamp(LLMeshRepoThread::sRequestHighWater / 2,
                                                      REQUEST2_LOW_WATER_MIN,
-                                                     REQUEST2_LOW_WATER_MAX);
+                                                     low_water_max);
     }
     // </FS:Ansariel> [UDP Assets]
 
@@ -5673,58 +5916,109 @@ bool LLMeshRepository::getCostData(const LLMeshHeader& header, LLMeshCostData& d
     return true;
 }
 
-LLPhysicsDecomp::LLPhysicsDecomp()
-: LLThread("Physics Decomp")
+namespace
+{
+    // Each pool thread gets its own state in the decomposition library
+    // for its whole life, so decompositions on different threads don't
+    // share anything
+    class PhysicsDecompPool : public LL::ThreadPool
+    {
+    public:
+        PhysicsDecompPool(S32 threads)
+        : LL::ThreadPool("PhysicsDecomp", threads)
+        {
+        }
+
+        void run() override
+        {
+            LLConvexDecomposition* decomp = LLConvexDecomposition::getInstance();
+            if (decomp)
+            {
+                decomp->initThread();
+
+                const LLCDStageData* stages = NULL;
+                S32 num_stages = decomp->getStages(&stages);
+                for (S32 i = 0; i < num_stages; ++i)
+                {
+                    decomp->registerCallback(i, LLPhysicsDecomp::llcdCallback);
+                }
+            }
+
+            LL::ThreadPool::run();
+
+            if (decomp)
+            {
+                decomp->quitThread();
+            }
+        }
+    };
+}
+
+thread_local LLPhysicsDecomp::Request* LLPhysicsDecomp::sCurRequest = NULL;
+
+LLPhysicsDecomp::LLPhysicsDecomp(S32 threads, U64 memory_cap)
+: LLThread("Physics Decomp"),
+  mMemoryCap(memory_cap)
 {
     mInited = false;
     mQuitting = false;
     mDone = false;
 
-    mSignal = new LLCondition();
     mMutex = new LLMutex();
+
+    mPool = std::make_unique<PhysicsDecompPool>(llmax(threads, 1));
 }
 
 LLPhysicsDecomp::~LLPhysicsDecomp()
 {
     shutdown();
 
-    delete mSignal;
-    mSignal = NULL;
+    mPool.reset();
+
     delete mMutex;
     mMutex = NULL;
 }
 
 void LLPhysicsDecomp::shutdown()
 {
-    if (mSignal)
     {
+        std::lock_guard<std::mutex> lock(mQueueMutex);
         mQuitting = true;
-        // There is only one wait(), but just in case 'broadcast'
-        mSignal->broadcast();
+    }
+    mQueueCondition.notify_all();
 
-        while (!isStopped())
-        {
-            apr_sleep(10);
-        }
+    while (!isStopped())
+    {
+        apr_sleep(10);
     }
 }
 
 void LLPhysicsDecomp::submitRequest(LLPhysicsDecomp::Request* request)
 {
-    LLMutexLock lock(mMutex);
-    mRequestQ.push(request);
-    mSignal->signal();
+    {
+        std::lock_guard<std::mutex> lock(mQueueMutex);
+        mRequestQ.push(request);
+    }
+    mQueueCondition.notify_one();
 }
 
 //static
 S32 LLPhysicsDecomp::llcdCallback(const char* status, S32 p1, S32 p2)
 {
-    if (gMeshRepo.mDecompThread && gMeshRepo.mDecompThread->mCurRequest.notNull())
+    Request* request = sCurRequest;
+    if (!request)
     {
-        return gMeshRepo.mDecompThread->mCurRequest->statusCallback(status, p1, p2);
+        return 1;
     }
 
-    return 1;
+    request->mProgress = llclamp(p2, 0, 100);
+
+    if (request->isCancelled() || (gMeshRepo.mDecompThread && gMeshRepo.mDecompThread->mQuitting))
+    {
+        return 0;
+    }
+
+    return request->statusCallback(status, p1, p2);
 }
 
 bool needTriangles( LLConvexDecomposition *aDC )
@@ -5752,7 +6046,7 @@ bool needTriangles( LLConvexDecomposition *aDC )
     return false;
 }
 
-void LLPhysicsDecomp::setMeshData(LLCDMeshData& mesh, bool vertex_based)
+void LLPhysicsDecomp::setMeshData(Request* request, LLCDMeshData& mesh, bool vertex_based)
 {
     LLConvexDecomposition *pDeComp = LLConvexDecomposition::getInstance();
 
@@ -5762,17 +6056,17 @@ void LLPhysicsDecomp::setMeshData(LLCDMeshData& mesh, bool vertex_based)
     if( vertex_based )
         vertex_based = !needTriangles( pDeComp );
 
-    mesh.mVertexBase = mCurRequest->mPositions[0].mV;
+    mesh.mVertexBase = request->mPositions[0].mV;
     mesh.mVertexStrideBytes = 12;
-    mesh.mNumVertices = static_cast<int>(mCurRequest->mPositions.size());
+    mesh.mNumVertices = static_cast<int>(request->mPositions.size());
 
     if(!vertex_based)
     {
         mesh.mIndexType = LLCDMeshData::INT_16;
-        mesh.mIndexBase = &(mCurRequest->mIndices[0]);
+        mesh.mIndexBase = &(request->mIndices[0]);
         mesh.mIndexStrideBytes = 6;
 
-        mesh.mNumTriangles = static_cast<int>(mCurRequest->mIndices.size())/3;
+        mesh.mNumTriangles = static_cast<int>(request->mIndices.size())/3;
     }
 
     if ((vertex_based || mesh.mNumTriangles > 0) && mesh.mNumVertices > 2)
@@ -5785,32 +6079,34 @@ void LLPhysicsDecomp::setMeshData(LLCDMeshData& mesh, bool vertex_based)
     }
 }
 
-void LLPhysicsDecomp::doDecomposition()
+void LLPhysicsDecomp::doDecomposition(Request* request)
 {
     LLCDMeshData mesh;
-    S32 stage = mStageID[mCurRequest->mStage];
 
     if (LLConvexDecomposition::getInstance() == NULL)
     {
-        // stub library. do nothing.
+        // stub library, complete with no hulls
+        LLMutexLock lock(mMutex);
+        request->mHull.clear();
+        request->mHullMesh.clear();
         return;
     }
 
+    // mStageID is filled in before the pool starts, only look it up here
+    std::map<std::string, S32>::const_iterator stage_iter = mStageID.find(request->mStage);
+    S32 stage = stage_iter != mStageID.end() ? stage_iter->second : 0;
+
     //load data intoLLCD
     if (stage == 0)
     {
-        setMeshData(mesh, false);
+        setMeshData(request, mesh, false);
     }
 
     //build parameter map
     std::map<std::string, const LLCDParam*> param_map;
 
-    static const LLCDParam* params = NULL;
-    static S32 param_count = 0;
-    if (!params)
-    {
-        param_count = LLConvexDecomposition::getInstance()->getParameters(&params);
-    }
+    const LLCDParam* params = NULL;
+    S32 param_count = LLConvexDecomposition::getInstance()->getParameters(&params);
 
     for (S32 i = 0; i < param_count; ++i)
     {
@@ -5819,7 +6115,7 @@ void LLPhysicsDecomp::doDecomposition()
 
     U32 ret = LLCD_OK;
     //set parameter values
-    for (decomp_params::iterator iter = mCurRequest->mParams.begin(); iter != mCurRequest->mParams.end(); ++iter)
+    for (decomp_params::iterator iter = request->mParams.begin(); iter != request->mParams.end(); ++iter)
     {
         const std::string& name = iter->first;
         const LLSD& value = iter->second;
@@ -5847,7 +6143,7 @@ void LLPhysicsDecomp::doDecomposition()
         }
     }
 
-    mCurRequest->setStatusMessage("Executing.");
+    request->setStatusMessage("Executing.");
 
     if (LLConvexDecomposition::getInstance() != NULL)
     {
@@ -5856,20 +6152,21 @@ void LLPhysicsDecomp::doDecomposition()
 
     if (ret)
     {
-        LL_WARNS(LOG_MESH) << "Convex Decomposition thread valid but could not execute stage " << stage << "."
-                           << LL_ENDL;
+        if (!request->isCancelled())
+        {
+            LL_WARNS(LOG_MESH) << "Convex Decomposition thread valid but could not execute stage " << stage << "."
+                               << LL_ENDL;
+        }
         LLMutexLock lock(mMutex);
 
-        mCurRequest->mHull.clear();
-        mCurRequest->mHullMesh.clear();
-
-        mCurRequest->setStatusMessage("FAIL");
+        request->mHull.clear();
+        request->mHullMesh.clear();
 
-        completeCurrent();
+        request->setStatusMessage("FAIL");
     }
     else
     {
-        mCurRequest->setStatusMessage("Reading results");
+        request->setStatusMessage("Reading results");
 
         S32 num_hulls =0;
         if (LLConvexDecomposition::getInstance() != NULL)
@@ -5879,11 +6176,11 @@ void LLPhysicsDecomp::doDecomposition()
 
         {
             LLMutexLock lock(mMutex);
-            mCurRequest->mHull.clear();
-            mCurRequest->mHull.resize(num_hulls);
+            request->mHull.clear();
+            request->mHull.resize(num_hulls);
 
-            mCurRequest->mHullMesh.clear();
-            mCurRequest->mHullMesh.resize(num_hulls);
+            request->mHullMesh.clear();
+            request->mHullMesh.resize(num_hulls);
         }
 
         for (S32 i = 0; i < num_hulls; ++i)
@@ -5906,27 +6203,25 @@ void LLPhysicsDecomp::doDecomposition()
             // if LLConvexDecomposition is a stub, num_hulls should have been set to 0 above, and we should not reach this code
             LLConvexDecomposition::getInstance()->getMeshFromStage(stage, i, &mesh);
 
-            get_vertex_buffer_from_mesh(mesh, mCurRequest->mHullMesh[i]);
+            get_vertex_buffer_from_mesh(mesh, request->mHullMesh[i]);
 
             {
                 LLMutexLock lock(mMutex);
-                mCurRequest->mHull[i] = p;
+                request->mHull[i] = p;
             }
         }
 
         {
             LLMutexLock lock(mMutex);
-            mCurRequest->setStatusMessage("FAIL");
-            completeCurrent();
+            request->setStatusMessage("FAIL");
         }
     }
 }
 
-void LLPhysicsDecomp::completeCurrent()
+void LLPhysicsDecomp::completeRequest(Request* request)
 {
     LLMutexLock lock(mMutex);
-    mCompletedQ.push(mCurRequest);
-    mCurRequest = NULL;
+    mCompletedQ.push(request);
 }
 
 void LLPhysicsDecomp::notifyCompleted()
@@ -5971,33 +6266,36 @@ void make_box(LLPhysicsDecomp::Request * request)
 }
 
 
-void LLPhysicsDecomp::doDecompositionSingleHull()
+void LLPhysicsDecomp::doDecompositionSingleHull(Request* request)
 {
     LLConvexDecomposition* decomp = LLConvexDecomposition::getInstance();
 
     if (decomp == NULL)
     {
-        //stub. do nothing.
+        // stub library, a bounding box will do
+        LLMutexLock lock(mMutex);
+        make_box(request);
         return;
     }
 
     LLCDMeshData mesh;
 
-    setMeshData(mesh, true);
+    setMeshData(request, mesh, true);
 
     LLCDResult ret = decomp->buildSingleHull() ;
     if (ret)
     {
         LL_WARNS(LOG_MESH) << "Could not execute decomposition stage when attempting to create single hull." << LL_ENDL;
-        make_box(mCurRequest);
+        LLMutexLock lock(mMutex);
+        make_box(request);
     }
     else
     {
         {
             LLMutexLock lock(mMutex);
-            mCurRequest->mHull.clear();
-            mCurRequest->mHull.resize(1);
-            mCurRequest->mHullMesh.clear();
+            request->mHull.clear();
+            request->mHull.resize(1);
+            request->mHullMesh.clear();
         }
 
         std::vector<LLVector3> p;
@@ -6017,79 +6315,138 @@ void LLPhysicsDecomp::doDecompositionSingleHull()
 
         {
             LLMutexLock lock(mMutex);
-            mCurRequest->mHull[0] = p;
+            request->mHull[0] = p;
         }
     }
+}
 
+bool LLPhysicsDecomp::canStart(const Request* request) const
+{
+    if (request->isCancelled())
     {
-        completeCurrent();
-
+        // Only needs completing
+        return true;
+    }
+    if (mRunningDecompIDs.count(request->mDecompID))
+    {
+        // A decomposition can only be bound on one thread at a time
+        return false;
     }
+    if (mRunning == 0)
+    {
+        // Always let one through, however large
+        return true;
+    }
+    return mRunning < mPool->getWidth() && mRunningMemory + request->estimateMemory() <= mMemoryCap;
 }
 
-
-void LLPhysicsDecomp::run()
+void LLPhysicsDecomp::runRequest(Request* request, U64 memory)
 {
     LLConvexDecomposition* decomp = LLConvexDecomposition::getInstance();
-    if (decomp == NULL)
+
+    if (!request->isCancelled() && !mQuitting)
     {
-        // stub library. Set init to true so the main thread
-        // doesn't wait for this to finish.
-        mInited = true;
-        return;
-    }
+        sCurRequest = request;
 
-    decomp->initThread();
-    mInited = true;
+        if (decomp)
+        {
+            decomp->bindDecomposition(*(request->mDecompID));
+        }
 
-    static const LLCDStageData* stages = NULL;
-    static S32 num_stages = 0;
+        if (request->mStage == "single_hull")
+        {
+            doDecompositionSingleHull(request);
+        }
+        else
+        {
+            doDecomposition(request);
+        }
+
+        sCurRequest = NULL;
+    }
+
+    request->mProgress = 100;
+    completeRequest(request);
 
-    if (!stages)
     {
-        num_stages = decomp->getStages(&stages);
+        std::lock_guard<std::mutex> lock(mQueueMutex);
+        mRunning--;
+        mRunningMemory -= memory;
+        mRunningDecompIDs.erase(request->mDecompID);
     }
+    mQueueCondition.notify_one();
+}
 
-    for (S32 i = 0; i < num_stages; i++)
+void LLPhysicsDecomp::run()
+{
+    LLConvexDecomposition* decomp = LLConvexDecomposition::getInstance();
+    if (decomp)
     {
-        mStageID[stages[i].mName] = i;
+        static const LLCDStageData* stages = NULL;
+        static S32 num_stages = 0;
+
+        if (!stages)
+        {
+            num_stages = decomp->getStages(&stages);
+        }
+
+        for (S32 i = 0; i < num_stages; i++)
+        {
+            mStageID[stages[i].mName] = i;
+        }
     }
 
+    // Without the library requests still run, and complete with a box or
+    // no hulls, so the stub can be used headless
+    mPool->start();
+    mInited = true;
+
+    std::unique_lock<std::mutex> lock(mQueueMutex);
     while (!mQuitting)
     {
-        mSignal->wait();
-        while (!mQuitting && !mRequestQ.empty())
+        mQueueCondition.wait(lock, [this]() { return mQuitting || (!mRequestQ.empty() && canStart(mRequestQ.front())); });
+
+        // Start everything that fits, the rest waits for a running
+        // request to finish.  Requests start in submission order.
+        while (!mQuitting && !mRequestQ.empty() && canStart(mRequestQ.front()))
         {
-            {
-                LLMutexLock lock(mMutex);
-                mCurRequest = mRequestQ.front();
-                mRequestQ.pop();
-            }
+            LLPointer<Request> request = mRequestQ.front();
+            mRequestQ.pop();
 
-            S32& id = *(mCurRequest->mDecompID);
-            if (id == -1)
+            if (request->isCancelled())
             {
-                decomp->genDecomposition(id);
+                completeRequest(request);
+                continue;
             }
-            decomp->bindDecomposition(id);
 
-            if (mCurRequest->mStage == "single_hull")
+            if (decomp)
             {
-                doDecompositionSingleHull();
+                S32& id = *(request->mDecompID);
+                if (id == -1)
+                {
+                    decomp->genDecomposition(id);
+                }
             }
-            else
+
+            const U64 memory = request->estimateMemory();
+            mRunning++;
+            mRunningMemory += memory;
+            mRunningDecompIDs.insert(request->mDecompID);
+
+            if (!mPool->getQueue().post([this, request, memory]() { runRequest(request, memory); }))
             {
-                doDecomposition();
+                // The pool is shutting down
+                mRunning--;
+                mRunningMemory -= memory;
+                mRunningDecompIDs.erase(request->mDecompID);
+                request->cancel();
+                completeRequest(request);
             }
         }
     }
+    lock.unlock();
 
-    decomp->quitThread();
-
-    if (mSignal->isLocked())
-    { //let go of mSignal's associated mutex
-        mSignal->unlock();
-    }
+    mPool->close();
 
     mDone = true;
 }
@@ -6172,6 +6529,26 @@ void LLPhysicsDecomp::Request::setStatusMessage(const std::string& msg)
     mStatusMessage = msg;
 }
 
+U64 LLPhysicsDecomp::Request::estimateMemory() const
+{
+    const U64 mesh_bytes = mPositions.size() * sizeof(LLVector3) + mIndices.size() * sizeof(U16);
+    if (mStage == "single_hull")
+    {
+        // Just a quick hull over the vertices
+        return mesh_bytes * 4;
+    }
+
+    // The voxel grid dominates a full decomposition, the library also
+    // keeps double precision copies of the mesh
+    S32 voxels = 400000;
+    decomp_params::const_iterator iter = mParams.find("Voxel Resolution");
+    if (iter != mParams.end())
+    {
+        voxels = llmax(iter->second.asInteger(), 1);
+    }
+    return mesh_bytes * 8 + (U64)voxels * 64;
+}
+
 void LLMeshRepository::buildPhysicsMesh(LLModel::Decomposition& decomp)
 {
     decomp.mMesh.resize(decomp.mHull.size());
@@ -27,6 +27,9 @@
 #ifndef LL_MESH_REPOSITORY_H
 #define LL_MESH_REPOSITORY_H
 
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
 #include <unordered_map>
 #include <unordered_set>
 #include "llassettype.h"
@@ -41,6 +44,7 @@
 #include "httpheaders.h"
 #include "httphandler.h"
 #include "llthread.h"
+#include "threadpool_fwd.h"
 
 #define LLCONVEXDECOMPINTER_STATIC 1
 
@@ -113,6 +117,10 @@ public:
     }
 };
 
+// Runs convex decompositions for the upload floater and LLMeshUploadThread.
+// This thread only hands requests out, the decompositions themselves run
+// on the "PhysicsDecomp" thread pool, as many at a time as the pool is wide
+// and as the memory cap allows.
 class LLPhysicsDecomp : public LLThread
 {
 public:
@@ -134,16 +142,28 @@ public:
         std::vector<LLModel::PhysicsMesh> mHullMesh;
         LLModel::convex_hull_decomposition mHull;
 
-        //status message callback, called from decomposition thread
+        //status message callback, called from a decomposition thread
         virtual S32 statusCallback(const char* status, S32 p1, S32 p2) = 0;
 
-        //completed callback, called from the main thread
+        //completed callback, called from the main thread, also for
+        //cancelled requests
         virtual void completed() = 0;
 
         virtual void setStatusMessage(const std::string& msg);
 
         bool isValid() const {return mPositions.size() > 2 && mIndices.size() > 2 ;}
 
+        // Any thread.  A queued request is skipped, a running one stops at
+        // its next progress update.
+        void cancel() { mCancelled = true; }
+        bool isCancelled() const { return mCancelled; }
+
+        // Overall progress of the decomposition, 0 to 100
+        S32 getProgress() const { return mProgress; }
+
+        // Rough peak memory use of the decomposition, in bytes
+        U64 estimateMemory() const;
+
     protected:
         //internal use
         LLVector3 mBBox[2] ;
@@ -152,16 +172,26 @@ public:
         void assignData(LLModel* mdl) ;
         void updateTriangleAreaThreshold() ;
         bool isValidTriangle(U16 idx1, U16 idx2, U16 idx3) ;
+
+    private:
+        friend class LLPhysicsDecomp;
+
+        std::atomic<bool> mCancelled { false };
+        std::atomic<S32> mProgress { 0 };
     };
 
-    LLCondition* mSignal;
+    // Guards the output state of requests and mCompletedQ
     LLMutex* mMutex;
 
     bool mInited;
-    bool mQuitting;
+    std::atomic<bool> mQuitting;
     bool mDone;
 
-    LLPhysicsDecomp();
+    // threads is the width of the "PhysicsDecomp" pool, the
+    // "ThreadPoolSizes" setting overrides it.  memory_cap is in bytes,
+    // requests are held back while the running ones are estimated to
+    // use more, but one request always runs.
+    LLPhysicsDecomp(S32 threads, U64 memory_cap);
     ~LLPhysicsDecomp();
 
     void shutdown();
@@ -169,24 +199,41 @@ public:
     void submitRequest(Request* request);
     static S32 llcdCallback(const char*, S32, S32);
 
-    void setMeshData(LLCDMeshData& mesh, bool vertex_based);
-    void doDecomposition();
-    void doDecompositionSingleHull();
+    void setMeshData(Request* request, LLCDMeshData& mesh, bool vertex_based);
+    void doDecomposition(Request* request);
+    void doDecompositionSingleHull(Request* request);
 
     virtual void run();
 
-    void completeCurrent();
+    void completeRequest(Request* request);
     void notifyCompleted();
 
     std::map<std::string, S32> mStageID;
 
     typedef std::queue<LLPointer<Request> > request_queue;
-    request_queue mRequestQ;
-
-    LLPointer<Request> mCurRequest;
 
     std::queue<LLPointer<Request> > mCompletedQ;
 
+private:
+    // Mutex:  must be holding mQueueMutex when called
+    bool canStart(const Request* request) const;
+
+    // Threads:  pool threads only
+    void runRequest(Request* request, U64 memory);
+
+    std::unique_ptr<LL::ThreadPool> mPool;
+    U64 mMemoryCap;
+
+    // Guards mRequestQ and the running requests' bookkeeping
+    std::mutex mQueueMutex;
+    std::condition_variable mQueueCondition;
+    request_queue mRequestQ;
+    U32 mRunning = 0;
+    U64 mRunningMemory = 0;
+    std::set<S32*> mRunningDecompIDs;
+
+    // The request a pool thread is working on, for llcdCallback()
+    static thread_local Request* sCurRequest;
 };
 
 class RequestStats
@@ -443,6 +490,8 @@ public:
     static S32 sRequestLowWater;
     static S32 sRequestHighWater;
     static S32 sRequestWaterLevel;          // Stats-use only, may read outside of thread
+    static bool sCacheOptimizedLODs;        // Keep cacheOptimize() results in the disk cache, set before thread start
+    static bool sCompactLODs;               // Keep static mesh LOD faces packed (LLVolumeFace::compact()), set before thread start
 
     LLMutex*    mMutex;
     LLMutex*    mHeaderMutex;
@@ -557,7 +606,9 @@ public:
 
     // workqueue for processing generic requests
     LL::WorkQueue mWorkQueue;
-    // lods have their own thread due to costly cacheOptimize() calls
+    // lods, skin info and physics are decoded on their own pool due to
+    // costly unzip, parsing and cacheOptimize() calls.  Sized by
+    // "MeshLodProcessing" in ThreadPoolSizes, see LLAppViewer::initThreads()
     std::unique_ptr<LL::ThreadPool> mMeshThreadPool;
 
     // llcorehttp library interface objects.
@@ -594,9 +645,21 @@ public:
     bool fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod);
     EMeshProcessingResult headerReceived(const LLVolumeParams& mesh_params, U8* data, S32 data_size, U32 flags = 0);
     EMeshProcessingResult lodReceived(const LLVolumeParams& mesh_params, S32 lod, U8* data, S32 data_size);
+    bool optimizeLOD(const LLUUID& mesh_id, S32 lod, LLVolume* volume);
     bool skinInfoReceived(const LLUUID& mesh_id, U8* data, S32 data_size);
     bool decompositionReceived(const LLUUID& mesh_id, U8* data, S32 data_size);
     EMeshProcessingResult physicsShapeReceived(const LLUUID& mesh_id, U8* data, S32 data_size);
+
+    // Run decode work on mMeshThreadPool, keeping the queue depth and
+    // decode time stats.  Returns false if the pool no longer takes work,
+    // the caller then processes the data itself.
+    template <typename CALLABLE>
+    bool postDecode(CALLABLE&& func);
+
+    // Cached data of mesh_id failed to parse, mark all of it as missing
+    // from the cache so the next request goes to the simulator
+    void invalidateCachedMesh(const LLUUID& mesh_id);
+
     bool hasPhysicsShapeInHeader(const LLUUID& mesh_id) const;
     bool hasSkinInfoInHeader(const LLUUID& mesh_id) const;
     bool hasHeader(const LLUUID& mesh_id) const;
@@ -696,8 +759,8 @@ public:
         void completed();
     };
 
-    LLPointer<DecompRequest> mFinalDecomp;
-    volatile bool   mPhysicsComplete;
+    // Decompositions submitted by generateHulls() and not completed yet
+    std::atomic<S32> mPendingDecomps { 0 };
 
     typedef std::map<LLPointer<LLModel>, std::vector<LLVector3> > hull_map_t;
     hull_map_t      mHullMap;
@@ -875,6 +938,13 @@ public:
     static U32 sCacheBytesDecomps;
     static U32 sCacheReads;
     static std::atomic<U32> sCacheWrites;
+    static std::atomic<U32> sCacheOptimizedHits;    // LODs whose cacheOptimize() results came from the disk cache
+    static std::atomic<U32> sCacheOptimizedMisses;
+    static std::atomic<U64> sCompactBytesSaved;     // Bytes freed by compacting LOD faces, cumulative
+    static std::atomic<S32> sDecodeQueueDepth;      // Work posted to the mesh decode pool, not started yet
+    static std::atomic<U32> sDecodeCount;           // Work the mesh decode pool has finished
+    static std::atomic<U64> sDecodeTimeUsec;        // and its total run time
+    static std::atomic<U32> sDecodeMaxUsec;         // Longest single decode
     static U32 sMaxLockHoldoffs;                // Maximum sequential locking failures
 
     static LLDeadmanTimer sQuiescentTimer;      // Time-to-complete-mesh-downloads after significant events
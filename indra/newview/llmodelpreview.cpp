@@ -44,6 +44,7 @@
 #include "llmatrix4a.h"
 #include "llmeshrepository.h"
 #include "llmeshoptimizer.h"
+#include "llmodelsimplifier.h"
 #include "llrender.h"
 #include "llsdutil_math.h"
 #include "llskinningutil.h"
@@ -2475,62 +2476,13 @@ F32 LLModelPreview::genMeshOptimizerPerFace(LLModel *base_model, LLModel *target
         return -1;
     }
 
-    S32 size = (size_indices * sizeof(U16) + 0xF) & ~0xF;
-    U16* output_indices = (U16*)ll_aligned_malloc_16(size);
+    static_assert((S32)MESH_OPTIMIZER_NO_TOPOLOGY == (S32)LLModelSimplifier::SIMPLIFY_SLOPPY);
 
-    U16* shadow_indices = NULL;
-    // if MESH_OPTIMIZER_FULL, just leave as is, since generateShadowIndexBufferU32
-    // won't do anything new, model was remaped on a per face basis.
-    // Similar for MESH_OPTIMIZER_NO_TOPOLOGY, it's pointless
-    // since 'simplifySloppy' ignores all topology, including normals and uvs.
-    if (simplification_mode == MESH_OPTIMIZER_NO_NORMALS)
-    {
-        U16* shadow_indices = (U16*)ll_aligned_malloc_16(size);
-        LLMeshOptimizer::generateShadowIndexBufferU16(shadow_indices, face.mIndices, size_indices, face.mPositions, NULL, face.mTexCoords, face.mNumVertices);
-    }
-    if (simplification_mode == MESH_OPTIMIZER_NO_UVS)
-    {
-        U16* shadow_indices = (U16*)ll_aligned_malloc_16(size);
-        LLMeshOptimizer::generateShadowIndexBufferU16(shadow_indices, face.mIndices, size_indices, face.mPositions, NULL, NULL, face.mNumVertices);
-    }
-    // Don't run ShadowIndexBuffer for MESH_OPTIMIZER_NO_TOPOLOGY, it's pointless
-
-    U16* source_indices = NULL;
-    if (shadow_indices)
-    {
-        source_indices = shadow_indices;
-    }
-    else
-    {
-        source_indices = face.mIndices;
-    }
-
-    S32 target_indices = 0;
-    F32 result_error = 0; // how far from original the model is, 1 == 100%
-    S32 size_new_indices = 0;
-
-    if (indices_decimator > 0)
-    {
-        target_indices = llclamp(llfloor(size_indices / indices_decimator), 3, (S32)size_indices); // leave at least one triangle
-    }
-    else
-    {
-        target_indices = 3;
-    }
-
-    size_new_indices = (S32)LLMeshOptimizer::simplify(
-        output_indices,
-        source_indices,
-        size_indices,
-        face.mPositions,
-        face.mNumVertices,
-        LLVertexBuffer::sTypeSize[LLVertexBuffer::TYPE_VERTEX],
-        target_indices,
-        error_threshold,
-        simplification_mode == MESH_OPTIMIZER_NO_TOPOLOGY,
-        &result_error);
+    LLModelSimplifier::FaceStats stats;
+    F32 res = LLModelSimplifier::simplifyFace(face, target_model->getVolumeFace(face_idx), indices_decimator, error_threshold,
+                                              (LLModelSimplifier::ESimplifyMode)simplification_mode, &stats);
 
-    if (result_error < 0)
+    if (stats.mResultError < 0)
     {
         // <FS:Beq> Log these properly
         // LL_WARNS() << "Negative result error from meshoptimizer for face " << face_idx
@@ -2543,8 +2495,8 @@ F32 LLModelPreview::genMeshOptimizerPerFace(LLModel *base_model, LLModel *target
         std::ostringstream out;
         out << "Negative result error from meshoptimizer for face " << face_idx
             << " of model " << target_model->mLabel
-            << " target Indices: " << target_indices
-            << " new Indices: " << size_new_indices
+            << " target Indices: " << stats.mTargetIndices
+            << " new Indices: " << stats.mNewIndices
             << " original count: " << size_indices
             << " error treshold: " << error_threshold;
         LL_WARNS() << out.str() << LL_ENDL;
@@ -2557,73 +2509,37 @@ F32 LLModelPreview::genMeshOptimizerPerFace(LLModel *base_model, LLModel *target
             std::ostringstream out;
             out << "Good result error from meshoptimizer for face " << face_idx
                 << " of model " << target_model->mLabel
-                << " target Indices: " << target_indices
-                << " new Indices: " << size_new_indices
+                << " target Indices: " << stats.mTargetIndices
+                << " new Indices: " << stats.mNewIndices
                 << " original count: " << size_indices
-                << " error treshold: " << error_threshold << " (result error:" << result_error << ")";
+                << " error treshold: " << error_threshold << " (result error:" << stats.mResultError << ")";
             LL_DEBUGS("MeshUpload") << out.str() << LL_ENDL;
             LLFloaterModelPreview::addStringToLog(out, true);
         }
         // </FS:Beq>
     }
 
-    LLVolumeFace &new_face = target_model->getVolumeFace(face_idx);
-
-    // Copy old values
-    new_face = face;
-
-    if (size_new_indices < 3)
-    {
-        if (simplification_mode != MESH_OPTIMIZER_NO_TOPOLOGY)
-        {
-            // meshopt_optimizeSloppy() can optimize triangles away even if target_indices is > 2,
-            // but optimize() isn't supposed to
-            // LL_INFOS() << "No indices generated by meshoptimizer for face " << face_idx
-            //     << " of model " << target_model->mLabel
-            //     << " target Indices: " << target_indices
-            //     << " original count: " << size_indices
-            //     << " error treshold: " << error_threshold
-            //     << LL_ENDL;
-            std::ostringstream out;
-            out << "No indices generated by meshoptimizer for face " << face_idx
-                << " of model " << target_model->mLabel
-                << " target Indices: " << target_indices
-                << " original count: " << size_indices
-                << " error treshold: " << error_threshold;
-            LL_INFOS("MeshUpload") << out.str() << LL_ENDL;
-            LLFloaterModelPreview::addStringToLog(out, true);
-        }
-
-        // Face got optimized away
-        // Generate empty triangle
-        new_face.resizeIndices(3);
-        new_face.resizeVertices(1);
-        memset(new_face.mIndices, 0, sizeof(U16) * 3);
-        new_face.mPositions[0].clear(); // set first vertice to 0
-        new_face.mNormals[0].clear();
-        new_face.mTexCoords[0].setZero();
-    }
-    else
+    if (res < 0 && simplification_mode != MESH_OPTIMIZER_NO_TOPOLOGY)
     {
-        // Assign new values
-        new_face.resizeIndices(size_new_indices); // will wipe out mIndices, so new_face can't substitute output
-        S32 idx_size = (size_new_indices * sizeof(U16) + 0xF) & ~0xF;
-        LLVector4a::memcpyNonAliased16((F32*)new_face.mIndices, (F32*)output_indices, idx_size);
-
-        // Clear unused values
-        new_face.optimize();
-    }
-
-    ll_aligned_free_16(output_indices);
-    ll_aligned_free_16(shadow_indices);
-
-    if (size_new_indices < 3)
-    {
-        // At least one triangle is needed
-        return -1;
+        // meshopt_optimizeSloppy() can optimize triangles away even if target_indices is > 2,
+        // but optimize() isn't supposed to
+        // LL_INFOS() << "No indices generated by meshoptimizer for face " << face_idx
+        //     << " of model " << target_model->mLabel
+        //     << " target Indices: " << target_indices
+        //     << " original count: " << size_indices
+        //     << " error treshold: " << error_threshold
+        //     << LL_ENDL;
+        std::ostringstream out;
+        out << "No indices generated by meshoptimizer for face " << face_idx
+            << " of model " << target_model->mLabel
+            << " target Indices: " << stats.mTargetIndices
+            << " original count: " << size_indices
+            << " error treshold: " << error_threshold;
+        LL_INFOS("MeshUpload") << out.str() << LL_ENDL;
+        LLFloaterModelPreview::addStringToLog(out, true);
     }
 
-    return (F32)size_indices / (F32)size_new_indices;
+    return res;
 }
 
 void LLModelPreview::genMeshOptimizerLODs(S32 which_lod, S32 meshopt_mode, U32 decimation, bool enforce_tri_limit)
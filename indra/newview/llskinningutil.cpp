@@ -33,6 +33,7 @@
 #include "llmeshrepository.h"
 #include "llvolume.h"
 #include "llrigginginfo.h"
+#include "llparallelfor.h"
 
 #define DEBUG_SKINNING  LL_DEBUG
 
@@ -441,3 +442,163 @@ namespace FSSkinningUtil
         }
     }
 }
+
+namespace
+{
+    // Weight tuples of vertices sharing a set come from the same quantized
+    // asset data, so they are bit identical
+    struct SkinWeightKey
+    {
+        U32 mBits[4];
+
+        bool operator==(const SkinWeightKey& rhs) const
+        {
+            return memcmp(mBits, rhs.mBits, sizeof(mBits)) == 0;
+        }
+    };
+
+    struct SkinWeightKeyHash
+    {
+        size_t operator()(const SkinWeightKey& key) const
+        {
+            return std::hash<std::string_view>()(std::string_view((const char*)key.mBits, sizeof(key.mBits)));
+        }
+    };
+}
+
+void LLSkinWeightTable::update(const LLVector4a* weights, S32 num_vertices, U32 joint_count)
+{
+    if (weights == mSourceWeights && num_vertices == mNumVertices && joint_count == mJointCount)
+    {
+        mIsNew = false;
+        return;
+    }
+
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR;
+
+    mIsNew = true;
+    mSourceWeights = weights;
+    mNumVertices = num_vertices;
+    mJointCount = joint_count;
+
+    mVertexSet.resize(num_vertices);
+    mSetJoints.clear();
+    mSetWeights.clear();
+
+    llassert(joint_count <= 256);
+    const S32 max_joint = (S32)llmax(joint_count, 1U) - 1;
+
+    std::unordered_map<SkinWeightKey, U16, SkinWeightKeyHash> sets;
+    for (S32 i = 0; i < num_vertices; ++i)
+    {
+        const F32* w = weights[i].getF32ptr();
+
+        SkinWeightKey key;
+        memcpy(key.mBits, w, sizeof(key.mBits));
+
+        auto [it, inserted] = sets.try_emplace(key, (U16)getNumSets());
+        if (inserted)
+        {
+            // same clamping and normalization as getPerVertexSkinMatrix()
+            F32 wght[4];
+            F32 scale = 0.f;
+            for (U32 k = 0; k < 4; ++k)
+            {
+                F32 joint = floorf(w[k]);
+                mSetJoints.push_back((U8)llclamp((S32)joint, 0, max_joint));
+                wght[k] = w[k] - joint;
+                scale += wght[k];
+            }
+
+            LLVector4a& set_weights = mSetWeights.emplace_back();
+            if (scale > 0.f)
+            {
+                set_weights.set(wght[0], wght[1], wght[2], wght[3]);
+                set_weights.div(scale);
+            }
+            else
+            {
+                set_weights.set(1.f, 0.f, 0.f, 0.f);
+            }
+        }
+        mVertexSet[i] = it->second;
+    }
+}
+
+void LLSkinWeightTable::blendMatrices(const LLMatrix4a* palette, const LLMatrix4a& bind_shape, LLMatrix4a* out) const
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR;
+
+    // affineTransform() ignores the last column, drop it from bind_shape
+    // so the product transforms points the same as the two steps did
+    LLMatrix4a bind = bind_shape;
+    bind.mMatrix[0].getF32ptr()[3] = 0.f;
+    bind.mMatrix[1].getF32ptr()[3] = 0.f;
+    bind.mMatrix[2].getF32ptr()[3] = 0.f;
+    bind.mMatrix[3].getF32ptr()[3] = 1.f;
+
+    const U8* joints = mSetJoints.data();
+    const U32 count = getNumSets();
+    for (U32 i = 0; i < count; ++i, joints += 4)
+    {
+        const F32* w = mSetWeights[i].getF32ptr();
+
+        LLMatrix4a final_mat;
+        LLMatrix4a src[4];
+        final_mat.clear();
+        src[0].setMul(palette[joints[0]], w[0]);
+        src[1].setMul(palette[joints[1]], w[1]);
+        final_mat.add(src[0]);
+        final_mat.add(src[1]);
+        src[2].setMul(palette[joints[2]], w[2]);
+        src[3].setMul(palette[joints[3]], w[3]);
+        final_mat.add(src[2]);
+        final_mat.add(src[3]);
+
+        matMulUnsafe(bind, final_mat, out[i]);
+    }
+}
+
+void LLSkinWeightTable::skinPositions(const LLMatrix4a* set_matrices, const LLVector4a* src, LLVector4a* dst, S32 begin, S32 end) const
+{
+    llassert(begin >= 0 && end <= mNumVertices);
+
+    const U16* vertex_set = mVertexSet.data();
+    for (S32 i = begin; i < end; ++i)
+    {
+        set_matrices[vertex_set[i]].affineTransform(src[i], dst[i]);
+    }
+}
+
+namespace
+{
+    // Vertices per skinning job.  Small enough to balance a few large
+    // faces over the pool, large enough that the atomic per job is noise.
+    constexpr S32 SKIN_JOB_VERTICES = 4096;
+}
+
+void LLSkinningUtil::addSkinJobs(std::vector<SkinJob>& jobs, const LLSkinWeightTable& table, const LLMatrix4a* set_matrices,
+                                 const LLVector4a* src, LLVector4a* dst)
+{
+    const S32 count = table.getNumVertices();
+    for (S32 begin = 0; begin < count; begin += SKIN_JOB_VERTICES)
+    {
+        jobs.push_back({ &table, set_matrices, src, dst, begin, llmin(begin + SKIN_JOB_VERTICES, count) });
+    }
+}
+
+void LLSkinningUtil::runSkinJobs(const std::vector<SkinJob>& jobs)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR;
+
+    if (jobs.empty())
+    {
+        return;
+    }
+
+    ll_parallel_for(ll_parallel_pool(), jobs.size(), [&jobs](size_t i)
+    {
+        const SkinJob& job = jobs[i];
+        job.mTable->skinPositions(job.mSetMatrices, job.mSrc, job.mDst, job.mBegin, job.mEnd);
+    });
+}
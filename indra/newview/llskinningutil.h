@@ -32,10 +32,13 @@
 #include "llvector4a.h"
 #include "llmatrix4a.h"
 
+#include <vector>
+
 class LLVOAvatar;
 class LLMeshSkinInfo;
 class LLVolumeFace;
 class LLJointRiggingInfoTab;
+class LLSkinWeightTable;
 
 namespace LLSkinningUtil
 {
@@ -67,6 +70,24 @@ namespace LLSkinningUtil
     }
 
     void initJointNums(LLMeshSkinInfo* skin, LLVOAvatar *avatar);
+
+    struct SkinJob
+    {
+        const LLSkinWeightTable* mTable;
+        const LLMatrix4a* mSetMatrices;
+        const LLVector4a* mSrc;
+        LLVector4a* mDst;
+        S32 mBegin;
+        S32 mEnd;
+    };
+
+    // Split a face into jobs of a few thousand vertices
+    void addSkinJobs(std::vector<SkinJob>& jobs, const LLSkinWeightTable& table, const LLMatrix4a* set_matrices,
+                     const LLVector4a* src, LLVector4a* dst);
+
+    // Run jobs on the shared parallel-for pool, the calling thread takes jobs too.
+    // Returns once all of them are done.
+    void runSkinJobs(const std::vector<SkinJob>& jobs);
     void updateRiggingInfo(const LLMeshSkinInfo* skin, LLVOAvatar *avatar, LLVolumeFace& vol_face);
     LLQuaternion getUnscaledQuaternion(const LLMatrix4& mat4);
 };
@@ -76,4 +97,40 @@ namespace FSSkinningUtil
     void getPerVertexSkinMatrixSSE( LLVector4a const &weights, const LLMatrix4a* mat, bool handle_bad_scale, LLMatrix4a& final_mat, U32 max_joints );
 }
 
+// Distinct joint/weight sets used by the vertices of one rigged face.
+// Rigged meshes typically have far fewer sets than vertices, so blending
+// a matrix once per set and looking it up per vertex replaces most of
+// the per-vertex getPerVertexSkinMatrix() work.
+class LLSkinWeightTable
+{
+public:
+    // Rebuild the sets if the weights, vertex count or joint count differ
+    // from the last call.  Joint indices are clamped to joint_count.
+    void update(const LLVector4a* weights, S32 num_vertices, U32 joint_count);
+
+    U32 getNumSets() const { return (U32)mSetJoints.size() / 4; }
+
+    // Blend one matrix per set out of palette, with bind_shape applied
+    // first.  out needs getNumSets() entries.
+    void blendMatrices(const LLMatrix4a* palette, const LLMatrix4a& bind_shape, LLMatrix4a* out) const;
+
+    // Rebuilt by the last update() call
+    bool isNew() const { return mIsNew; }
+
+    S32 getNumVertices() const { return mNumVertices; }
+
+    // dst[i] = set_matrices[set of vertex i] * src[i] for i in [begin, end)
+    void skinPositions(const LLMatrix4a* set_matrices, const LLVector4a* src, LLVector4a* dst, S32 begin, S32 end) const;
+
+private:
+    const LLVector4a* mSourceWeights = nullptr;
+    S32 mNumVertices = 0;
+    U32 mJointCount = 0;
+    bool mIsNew = false;
+
+    std::vector<U16> mVertexSet;        // set index of each vertex
+    std::vector<U8> mSetJoints;         // 4 joint indices per set
+    std::vector<LLVector4a> mSetWeights; // normalized weights per set
+};
+
 #endif
@@ -40,6 +40,7 @@
 #include "llviewercamera.h"
 #include "llface.h"
 #include "llfloatertools.h"
+#include "llframestatsrecorder.h"
 #include "llviewercontrol.h"
 #include "llviewerregion.h"
 #include "llcamera.h"
@@ -48,11 +49,13 @@
 #include "llrender.h"
 #include "lldrawpool.h"
 #include "lloctree.h"
+#include "llradixsort.h"
 #include "llphysicsshapebuilderutil.h"
 #include "llvoavatar.h"
 #include "llvolumemgr.h"
 #include "llviewershadermgr.h"
 #include "llcontrolavatar.h"
+#include "llparallelfor.h"
 
 #include "llvotree.h"
 // <FS:Beq> improved normals debug
@@ -327,6 +330,10 @@ void LLSpatialGroup::rebuildGeom()
     if (!isDead())
     {
         getSpatialPartition()->rebuildGeom(this);
+        if (LLFrameStatsRecorder::instanceExists())
+        {
+            LLFrameStatsRecorder::instance().groupRebuilt();
+        }
 
         if (hasState(LLSpatialGroup::MESH_DIRTY))
         {
@@ -1460,17 +1467,17 @@ S32 LLSpatialPartition::cull(LLCamera &camera, bool do_occlusion)
     if (LLPipeline::sShadowRender)
     {
         LLOctreeCullShadow culler(&camera);
-        culler.traverse(mOctree);
+        culler.traverseParallel(mOctree);
     }
     else if (mInfiniteFarClip || (!LLPipeline::sUseFarClip && !gCubeSnapshot))
     {
         LLOctreeCullNoFarClip culler(&camera);
-        culler.traverse(mOctree);
+        culler.traverseParallel(mOctree);
     }
     else
     {
         LLOctreeCull culler(&camera);
-        culler.traverse(mOctree);
+        culler.traverseParallel(mOctree);
     }
 
     return 0;
@@ -2103,7 +2110,7 @@ void renderNormals(LLDrawable *drawablep)
                 {
                     LLVector4a n, p;
 
-                    n.setMul(face.mNormals[j], 1.0);
+                    n.setMul(face.getNormal(j), 1.0);
                     n.mul(inv_scale);  // Pre-scale normal, so it's left with an inverse-transpose xform after MVP
                     n.normalize3fast();
                     n.mul(draw_length);
@@ -2115,7 +2122,7 @@ void renderNormals(LLDrawable *drawablep)
                 gGL.end();
 
                 // Tangents are simple vectors and do not require reorientation via pre-scaling
-                if (face.mTangents)
+                if (face.hasTangents())
                 {
                     gGL.flush();
                     gGL.diffuseColor4f(0, 1, 1, 1);
@@ -2124,7 +2131,7 @@ void renderNormals(LLDrawable *drawablep)
                     {
                         LLVector4a t, p;
 
-                        t.setMul(face.mTangents[j], 1.0f);
+                        t.setMul(face.getTangent(j), 1.0f);
                         t.normalize3fast();
                         t.mul(draw_length);
                         p.setAdd(face.mPositions[j], t);
@@ -4078,6 +4085,7 @@ LLDrawInfo::LLDrawInfo(U16 start, U16 end, U32 count, U32 offset,
     mAlphaMaskCutoff(0.5f)
 {
     mVertexBuffer->validateRange(mStart, mEnd, mCount, mOffset);
+    updateSortKey();
 }
 
 LLDrawInfo::~LLDrawInfo()
@@ -4112,6 +4120,23 @@ U64 LLDrawInfo::getSkinHash()
     return mSkinInfo ? mSkinInfo->mHash : 0;
 }
 
+void LLDrawInfo::updateSortKey()
+{
+    // 12 bits matrix palette, 6 shader, 16 material, 16 vertex buffer, 14 texture.
+    // Draw infos of a spatial group share a few buffers, so the buffer above
+    // the texture keeps the pushed order's few buffer switches without
+    // costing texture binds, see llrendersort_libtest.
+    const U64 skin = mAvatar.notNull() ? ll_sort_key_bits((U64)(uintptr_t)mAvatar.get() ^ getSkinHash(), 12) : 0;
+    const U64 shader = llmin(mShaderMask, (U32)0x3F);
+    const U64 material = mGLTFMaterial.notNull() ? (U64)(uintptr_t)mGLTFMaterial.get() : (U64)(uintptr_t)mMaterial.get();
+
+    mSortKey = (skin << 52) |
+               (shader << 46) |
+               (ll_sort_key_bits(material, 16) << 30) |
+               (ll_sort_key_bits((U64)(uintptr_t)mVertexBuffer.get(), 16) << 14) |
+               ll_sort_key_bits((U64)(uintptr_t)mTexture.get(), 14);
+}
+
 LLCullResult::LLCullResult()
 {
     mVisibleGroupsAllocated = 0;
@@ -4403,6 +4428,94 @@ void LLCullResult::pushDrawInfo(U32 type, LLDrawInfo* draw_info)
 }
 
 
+namespace
+{
+    // Below this many draw infos in all render maps, sorting them on the
+    // calling thread is quicker than waking the pool
+    constexpr U32 RENDER_SORT_PARALLEL_MIN = 8192;
+
+    // Blended passes keep the order they were pushed in
+    bool is_sorted_pass(U32 type)
+    {
+        switch (type)
+        {
+        case LLRenderPass::PASS_ALPHA:
+        case LLRenderPass::PASS_ALPHA_RIGGED:
+        case LLRenderPass::PASS_MATERIAL_ALPHA:
+        case LLRenderPass::PASS_MATERIAL_ALPHA_RIGGED:
+        case LLRenderPass::PASS_SPECMAP_BLEND:
+        case LLRenderPass::PASS_SPECMAP_BLEND_RIGGED:
+        case LLRenderPass::PASS_NORMMAP_BLEND:
+        case LLRenderPass::PASS_NORMMAP_BLEND_RIGGED:
+        case LLRenderPass::PASS_NORMSPEC_BLEND:
+        case LLRenderPass::PASS_NORMSPEC_BLEND_RIGGED:
+            return false;
+        default:
+            return true;
+        }
+    }
+
+    void sort_render_map(LLDrawInfo** draw_infos, U32 count)
+    {
+        // per thread, kept to reuse their storage
+        thread_local std::vector<LLRadixSortItem<LLDrawInfo*> > items;
+        thread_local std::vector<LLRadixSortItem<LLDrawInfo*> > scratch;
+
+        items.resize(count);
+        scratch.resize(count);
+        for (U32 i = 0; i < count; ++i)
+        {
+            items[i].mKey = draw_infos[i]->mSortKey;
+            items[i].mValue = draw_infos[i];
+        }
+
+        ll_radix_sort(items.data(), scratch.data(), count);
+
+        for (U32 i = 0; i < count; ++i)
+        {
+            draw_infos[i] = items[i].mValue;
+        }
+    }
+
+    struct RenderSortMap
+    {
+        LLDrawInfo** mDrawInfos;
+        U32 mCount;
+    };
+}
+
+void LLCullResult::sortRenderMaps()
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_SPATIAL;
+
+    // per frame on the main thread, kept to reuse its storage
+    static std::vector<RenderSortMap> maps;
+    maps.clear();
+
+    U32 total = 0;
+    for (U32 i = 0; i < LLRenderPass::NUM_RENDER_TYPES; ++i)
+    {
+        if (mRenderMapSize[i] > 1 && is_sorted_pass(i))
+        {
+            maps.push_back({ &mRenderMap[i][0], mRenderMapSize[i] });
+            total += mRenderMapSize[i];
+        }
+    }
+
+    LL::ThreadPool* pool = total >= RENDER_SORT_PARALLEL_MIN ? ll_parallel_pool() : nullptr;
+    if (pool)
+    {
+        // largest maps first so the last one taken is short
+        std::sort(maps.begin(), maps.end(),
+                  [](const RenderSortMap& a, const RenderSortMap& b) { return a.mCount > b.mCount; });
+    }
+
+    ll_parallel_for(pool, maps.size(), [](size_t i)
+    {
+        sort_render_map(maps[i].mDrawInfos, maps[i].mCount);
+    });
+}
+
 void LLCullResult::assertDrawMapsEmpty()
 {
     for (U32 i = 0; i < LLRenderPass::NUM_RENDER_TYPES; i++)
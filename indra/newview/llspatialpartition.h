@@ -108,12 +108,19 @@ public:
     // return mSkinHash->mHash, or 0 if mSkinHash is null
     U64 getSkinHash();
 
+    // pack the state this draw info binds into mSortKey, call after
+    // setting the fields below
+    void updateSortKey();
+
     LLPointer<LLVertexBuffer> mVertexBuffer;
     U16 mStart = 0;
     U16 mEnd = 0;
     U32 mCount = 0;
     U32 mOffset = 0;
 
+    // render map order, costliest state change in the highest bits
+    U64 mSortKey = 0;
+
     LLPointer<LLViewerTexture>     mTexture;
     LLPointer<LLViewerTexture> mSpecularMap;
     LLPointer<LLViewerTexture> mNormalMap;
@@ -557,6 +564,9 @@ public:
     void pushBridge(LLSpatialBridge* bridge);
     void pushDrawInfo(U32 type, LLDrawInfo* draw_info);
 
+    // order the render maps of opaque passes by LLDrawInfo::mSortKey
+    void sortRenderMaps();
+
     U32 getVisibleGroupsSize()      { return mVisibleGroupsSize; }
     U32 getAlphaGroupsSize()        { return mAlphaGroupsSize; }
     U32 getRiggedAlphaGroupsSize() { return mRiggedAlphaGroupsSize; }
@@ -698,6 +708,15 @@ private:
     void allocateFaces(U32 pMaxFaceCount);
     void freeFaces();
 
+    // Fill the geometry of a face now, or queue it for runFillJobs() if the
+    // parallel-for pool is up and the face can be filled off the main thread.
+    // false if filling it now failed.
+    static bool fillFaceGeometry(LLFace* facep, const LLVolume& volume, const LLMatrix4& mat_vert, const LLMatrix3& mat_normal,
+                                 U16 index_offset, bool force_rebuild, bool no_debug_assert);
+    // Fill the queued faces, on the pool if there is enough geometry.
+    // Returns how many failed.
+    static U32 runFillJobs();
+
     static int32_t sInstanceCount;
     static LLFace** sFullbrightFaces[2];
     static LLFace** sBumpFaces[2];
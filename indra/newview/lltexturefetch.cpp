@@ -233,6 +233,8 @@ const std::string sTesterName("TextureFetchTester");
 
 static const S32 HTTP_PIPE_REQUESTS_HIGH_WATER = 100;       // Maximum requests to have active in HTTP (pipelined)
 static const S32 HTTP_PIPE_REQUESTS_LOW_WATER = 50;         // Active level at which to refill
+static const S32 HTTP_MUX_REQUESTS_HIGH_WATER = 400;        // Maximum requests to have active in HTTP (HTTP/2 multiplexed)
+static const S32 HTTP_MUX_REQUESTS_LOW_WATER = 200;
 static const S32 HTTP_NONPIPE_REQUESTS_HIGH_WATER = 40;
 static const S32 HTTP_NONPIPE_REQUESTS_LOW_WATER = 20;
 
@@ -244,6 +246,14 @@ static const S32 HTTP_NONPIPE_REQUESTS_LOW_WATER = 20;
 // request (e.g. 'Range: <start>-') which seems to fix the problem.
 static const S32 HTTP_REQUESTS_RANGE_END_MAX = 20000000;
 
+// Byte range planning.  When a texture's on-screen pixel area is within
+// this fraction of a discard level (log4 units) of needing the next finer
+// level, the range for that level is fetched up front so the refinement
+// doesn't cost another round trip.  Only done while texture bandwidth use
+// is below the given fraction of the throttle.
+static const F32 RANGE_PLAN_LOOKAHEAD = 0.25f;
+static const F32 RANGE_PLAN_BANDWIDTH_FRACTION = 0.5f;
+
 // stop after 720 seconds, might be overkill, but cap request can keep going forever.
 static const S32 MAX_CAP_MISSING_RETRIES = 720;
 static const S32 CAP_MISSING_EXPIRATION_DELAY = 1; // seconds
@@ -348,8 +358,9 @@ private:
     public:
 
         // Threads:  Ttf
-        DecodeResponder(LLTextureFetch* fetcher, const LLUUID& id, LLTextureFetchWorker* worker)
-            : mFetcher(fetcher), mID(id)
+        DecodeResponder(LLTextureFetch* fetcher, const LLUUID& id, LLTextureFetchWorker* worker,
+                        S32 discard = -1, bool cacheable = false)
+            : mFetcher(fetcher), mID(id), mDiscard(discard), mCacheable(cacheable)
         {
         }
 
@@ -357,6 +368,11 @@ private:
         virtual void completed(bool success, const std::string& error_message, LLImageRaw* raw, LLImageRaw* aux, U32 request_id)
         {
             LL_PROFILE_ZONE_SCOPED;
+            if (success && raw && mCacheable)
+            {
+                // Compress on the decode thread rather than the fetch thread
+                mFetcher->getDecodedCache().insert(mID, mDiscard, raw);
+            }
             LLTextureFetchWorker* worker = mFetcher->getWorker(mID);
             if (worker)
             {
@@ -366,6 +382,8 @@ private:
     private:
         LLTextureFetch* mFetcher;
         LLUUID mID;
+        S32 mDiscard;
+        bool mCacheable;
     };
 
     struct Compare
@@ -1810,10 +1828,26 @@ bool LLTextureFetchWorker::doWork(S32 param)
                 return true; // failed
             }
 
+            // A refinement that arrived while this range was in flight
+            // (setDesiredDiscard() raised mDesiredSize) is chained straight
+            // into the next range request instead of decoding the interim
+            // level, writing it to cache and going back through INIT and a
+            // cache read.  Only done when we're refining data that was
+            // already there so the texture has something on screen meanwhile.
+            static LLCachedControl<bool> range_planning(gSavedSettings, "TextureFetchRangePlanning", true);
+            const bool chain_refinement(range_planning
+                                        && cur_size > 0
+                                        && !mHaveAllData
+                                        && mDesiredSize > (cur_size + mRequestedSize)
+                                        && mDesiredDiscard >= 0
+                                        && mDesiredDiscard < mRequestedDiscard
+                                        && mFormattedImage.notNull()
+                                        && mFormattedImage->getCodec() == IMG_CODEC_J2C);
+
             // Clear the url since we're done with the fetch
             // Note: mUrl is used to check is fetching is required so failure to clear it will force an http fetch
             // next time the texture is requested, even if the data have already been fetched.
-            if(mWriteToCacheState != NOT_WRITE && mFTType != FTT_SERVER_BAKE)
+            if(!chain_refinement && mWriteToCacheState != NOT_WRITE && mFTType != FTT_SERVER_BAKE)
             {
                 // Why do we want to keep url if NOT_WRITE - is this a proxy for map tiles?
                 mUrl.clear();
@@ -1859,7 +1893,20 @@ bool LLTextureFetchWorker::doWork(S32 param)
                 mRequestedOffset += src_offset;
             }
 
-            U8 * buffer = (U8 *)ll_aligned_malloc_16(total_size);
+            U8 * buffer(NULL);
+            if (cur_size == 0)
+            {
+                // Nothing to prepend so take the body as is.  When the
+                // response came with a Content-Length this is the buffer
+                // libcurl wrote into and no copy is made.
+                size_t detached_size(0);
+                buffer = (U8 *)mHttpBufferArray->detachContiguous(src_offset, &detached_size);
+                llassert_always(!buffer || detached_size == (size_t)total_size);
+            }
+            else
+            {
+                buffer = (U8 *)ll_aligned_malloc_16(total_size);
+            }
             if (!buffer)
             {
                 // abort. If we have no space for packet, we have not enough space to decode image
@@ -1895,8 +1942,8 @@ bool LLTextureFetchWorker::doWork(S32 param)
             {
                 // Copy previously collected data into buffer
                 memcpy(buffer, mFormattedImage->getData(), cur_size);
+                mHttpBufferArray->read(src_offset, (char *) buffer + cur_size, append_size);
             }
-            mHttpBufferArray->read(src_offset, (char *) buffer + cur_size, append_size);
 
             // NOTE: setData releases current data and owns new data (buffer)
             mFormattedImage->setData(buffer, total_size);
@@ -1907,6 +1954,16 @@ bool LLTextureFetchWorker::doWork(S32 param)
             mHttpReplySize = 0;
             mHttpReplyOffset = 0;
 
+            if (chain_refinement && mFormattedImage->getDataSize() < mDesiredSize)
+            {
+                // Keep the HTTP resource and go straight back out for the rest
+                LL_DEBUGS(LOG_TXT) << mID << ": Chaining refinement to discard " << mDesiredDiscard
+                                   << ", have " << mFormattedImage->getDataSize()
+                                   << " of " << mDesiredSize << " bytes" << LL_ENDL;
+                setState(SEND_HTTP_REQ);
+                return false;
+            }
+
             mLoadedDiscard = mRequestedDiscard;
             if (mLoadedDiscard < 0 || (mLoadedDiscard > MAX_DISCARD_LEVEL && mFormattedImage->getCodec() == IMG_CODEC_J2C))
             {
@@ -1991,28 +2048,64 @@ bool LLTextureFetchWorker::doWork(S32 param)
         mDecodeTimer.reset();
         mRawImage = NULL;
         mAuxImage = NULL;
-
-        // if we have the entire image data (and the image is not J2C), decode the full res image
-        // DO NOT decode a higher res j2c than was requested.  This is a waste of time and memory.
         mDecoded  = false;
+
+        // Only results decoded from enough data for their discard level
+        // are reusable; a partial j2c stream decodes to a blurrier image
+        // than a later, complete one at the same level would.
+        bool decode_cacheable = false;
+        if (!mNeedsAux)
+        {
+            if (mHaveAllData)
+            {
+                decode_cacheable = true;
+            }
+            else if (mFormattedImage->getCodec() == IMG_CODEC_J2C && mFormattedImage->getWidth() > 0)
+            {
+                S32 needed = LLImageJ2C::calcDataSizeJ2C(mFormattedImage->getWidth(), mFormattedImage->getHeight(),
+                                                         mFormattedImage->getComponents(), discard);
+                decode_cacheable = mFormattedImage->getDataSize() >= needed;
+            }
+        }
+
+        LLPointer<LLImageRaw> cached;
+        if (decode_cacheable)
+        {
+            cached = mFetcher->mDecodedCache.fetch(mID, discard);
+        }
+
         setState(DECODE_IMAGE_UPDATE);
-        LL_DEBUGS(LOG_TXT) << mID << ": Decoding. Bytes: " << mFormattedImage->getDataSize() << " Discard: " << discard
-                           << " All Data: " << mHaveAllData << LL_ENDL;
-
-        // In case worked manages to request decode, be shut down,
-        // then init and request decode again with first decode
-        // still in progress, assign a sufficiently unique id
-        mDecodeHandle = LLAppViewer::getImageDecodeThread()->decodeImage(mFormattedImage,
-                                                                       discard,
-                                                                       mNeedsAux,
-                                                                       new DecodeResponder(mFetcher, mID, this));
-        if (mDecodeHandle == 0)
+        if (cached.notNull())
         {
-            // Abort, failed to put into queue.
-            // Happens if viewer is shutting down
-            setState(DONE);
-            LL_DEBUGS(LOG_TXT) << mID << " DECODE_IMAGE abort: failed to post for decoding" << LL_ENDL;
-            return true;
+            // Same texture at the same discard was decoded before, skip the decoder
+            LL_DEBUGS(LOG_TXT) << mID << ": Decoded cache hit. Discard: " << discard << LL_ENDL;
+            mRawImage = cached;
+            mDecodedDiscard = discard;
+            mDecoded = true;
+        }
+        else
+        {
+            // if we have the entire image data (and the image is not J2C), decode the full res image
+            // DO NOT decode a higher res j2c than was requested.  This is a waste of time and memory.
+            LL_DEBUGS(LOG_TXT) << mID << ": Decoding. Bytes: " << mFormattedImage->getDataSize() << " Discard: " << discard
+                               << " All Data: " << mHaveAllData << LL_ENDL;
+
+            // In case worked manages to request decode, be shut down,
+            // then init and request decode again with first decode
+            // still in progress, assign a sufficiently unique id
+            mDecodeHandle = LLAppViewer::getImageDecodeThread()->decodeImage(mFormattedImage,
+                                                                           discard,
+                                                                           mNeedsAux,
+                                                                           new DecodeResponder(mFetcher, mID, this,
+                                                                                               discard, decode_cacheable));
+            if (mDecodeHandle == 0)
+            {
+                // Abort, failed to put into queue.
+                // Happens if viewer is shutting down
+                setState(DONE);
+                LL_DEBUGS(LOG_TXT) << mID << " DECODE_IMAGE abort: failed to post for decoding" << LL_ENDL;
+                return true;
+            }
         }
         // fall though
     }
@@ -2358,6 +2451,7 @@ bool LLTextureFetchWorker::deleteOK()
 // Threads:  Ttf
 void LLTextureFetchWorker::removeFromCache()
 {
+    mFetcher->mDecodedCache.erase(mID);
     if (!mInLocalCache)
     {
         mFetcher->mTextureCache->removeFromCache(mID);
@@ -2837,7 +2931,11 @@ S32 LLTextureFetch::createRequest(FTType f_type, const std::string& url, const L
         // If the requester knows the dimensions of the image,
         // this will calculate how much data we need without having to parse the header
 
-        desired_size = LLImageJ2C::calcDataSizeJ2C(w, h, c, desired_discard);
+        // Ask for the level the texture is likely to settle at rather
+        // than the one it wants this instant, decoding stays at the
+        // desired level and the extra bytes wait in the formatted image.
+        S32 fetch_discard = planFetchDiscard(desired_discard, w, h, priority);
+        desired_size = LLImageJ2C::calcDataSizeJ2C(w, h, c, fetch_discard);
     }
     else
     {
@@ -2900,6 +2998,38 @@ S32 LLTextureFetch::createRequest(FTType f_type, const std::string& url, const L
 }
 
 
+// Threads:  T* (but Tmain mostly)
+S32 LLTextureFetch::planFetchDiscard(S32 desired_discard, S32 w, S32 h, F32 pixel_area) const
+{
+    static LLCachedControl<bool> range_planning(gSavedSettings, "TextureFetchRangePlanning", true);
+
+    if (!range_planning || desired_discard <= 0 || w <= 0 || h <= 0 || pixel_area <= 0.f)
+    {
+        return desired_discard;
+    }
+    if (mTextureBandwidth > mMaxBandwidth * RANGE_PLAN_BANDWIDTH_FRACTION)
+    {
+        // Network is busy, only fetch what is needed now
+        return desired_discard;
+    }
+
+    // Same metric LLViewerFetchedTexture uses to pick the desired discard
+    // but without the floor.  A desired level that is coarser than the
+    // pixel area calls for has been clamped for memory or bias reasons
+    // and must not be second-guessed.
+    static const F32 log_4 = logf(4.f);
+    const F32 ideal_discard = logf((F32)(w * h) / pixel_area) / log_4;
+    const F32 headroom = ideal_discard - (F32)desired_discard;
+    if (headroom < 0.f || headroom >= RANGE_PLAN_LOOKAHEAD)
+    {
+        return desired_discard;
+    }
+
+    LL_DEBUGS(LOG_TXT) << "Planning discard " << (desired_discard - 1) << " for desired " << desired_discard
+                       << " (ideal " << ideal_discard << ")" << LL_ENDL;
+    return desired_discard - 1;
+}
+
 // <FS:Ansariel> OpenSim compatibility
 // Threads:  T* (but Ttf in practice)
 
@@ -3254,7 +3384,13 @@ void LLTextureFetch::commonUpdate()
     // Update low/high water levels based on pipelining.  We pick
     // up setting eventually, so the semaphore/request level can
     // fall outside the [0..HIGH_WATER] range.  Expect that.
-    if (LLAppViewer::instance()->getAppCoreHttp().isPipelined(LLAppCoreHttp::AP_TEXTURE))
+    LLAppCoreHttp & app_core_http(LLAppViewer::instance()->getAppCoreHttp());
+    if (app_core_http.isMultiplexed(LLAppCoreHttp::AP_TEXTURE))
+    {
+        mHttpHighWater = HTTP_MUX_REQUESTS_HIGH_WATER;
+        mHttpLowWater = HTTP_MUX_REQUESTS_LOW_WATER;
+    }
+    else if (app_core_http.isPipelined(LLAppCoreHttp::AP_TEXTURE))
     {
         mHttpHighWater = HTTP_PIPE_REQUESTS_HIGH_WATER;
         mHttpLowWater = HTTP_PIPE_REQUESTS_LOW_WATER;
@@ -3299,6 +3435,13 @@ size_t LLTextureFetch::update(F32 max_time_ms)
         mNetworkQueueMutex.unlock();                                    // -Mfnq
     }
 
+    static LLCachedControl<U32> decoded_cache_budget(gSavedSettings, "TextureDecodedCacheBudgetMB", 64);
+    size_t decoded_cache_bytes = (size_t)decoded_cache_budget() * 1024 * 1024;
+    if (decoded_cache_bytes != mDecodedCache.getBudget())
+    {
+        mDecodedCache.setBudget(decoded_cache_bytes);
+    }
+
     size_t res = LLWorkerThread::update(max_time_ms);
 
     // <FS:Ansariel> OpenSim compatibility
@@ -42,6 +42,7 @@
 #include "httphandler.h"
 #include "lltrace.h"
 #include "llviewertexture.h"
+#include "lldecodedtexturecache.h"
 
 class LLViewerTexture;
 class LLTextureFetchWorker;
@@ -89,6 +90,13 @@ public:
     S32 createRequest(FTType f_type, const std::string& url, const LLUUID& id, const LLHost& host, F32 priority,
                        S32 w, S32 h, S32 c, S32 discard, bool needs_aux, bool can_use_http);
 
+    // Threads:  T* (but Tmain mostly)
+    // Returns the discard level whose byte range is worth fetching for a
+    // J2C texture wanted at desired_discard.  Predicts from the full size
+    // and on-screen pixel area whether the texture is about to need the
+    // next finer level and, bandwidth permitting, asks for that instead.
+    S32 planFetchDiscard(S32 desired_discard, S32 w, S32 h, F32 pixel_area) const;
+
     // Requests that a fetch operation be deleted from the queue.
     // If @cancel is true, also stops any I/O operations pending.
     // Actual delete will be scheduled and performed later.
@@ -245,6 +253,10 @@ public:
     // Threads:  T*
     void getStateStats(U32 * cache_read, U32 * cache_write, U32 * res_wait);
 
+    // Decoded result tier, consulted before posting a decode
+    // Threads:  T*
+    LLDecodedTextureCache& getDecodedCache() { return mDecodedCache; }
+
     // ----------------------------------
 
 protected:
@@ -349,6 +361,7 @@ private:
     LLMutex mNetworkQueueMutex; //to protect mNetworkQueue, mHTTPTextureQueue and mCancelQueue. // <FS:Ansariel> OpenSim compatibility
 
     LLTextureCache* mTextureCache;
+    LLDecodedTextureCache mDecodedCache;                                // <none>, locks internally
 
     // Map of all requests by UUID
     typedef std::map<LLUUID,LLTextureFetchWorker*> map_t;
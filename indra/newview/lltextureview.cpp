@@ -693,7 +693,11 @@ void LLGLTexMemBar::draw()
     LLFontGL::getFontMonospace()->renderUTF8(text, 0, 0, v_offset + line_height*5,
                                              text_color, LLFontGL::LEFT, LLFontGL::TOP);
 
-    text = llformat("CacheHitRate: %3.2f Read: %d/%d/%d Decode: %d/%d/%d Fetch: %d/%d/%d",
+    LLDecodedTextureCache& decoded_cache = LLAppViewer::getTextureFetch()->getDecodedCache();
+    U32 decodedHits = decoded_cache.getHits();
+    U32 decodedMisses = decoded_cache.getMisses();
+
+    text = llformat("CacheHitRate: %3.2f Read: %d/%d/%d Decode: %d/%d/%d Fetch: %d/%d/%d DecCache H/M: %u/%u %.1f/%.1f MB (%u)",
                     cacheHitRate,
                     cacheReadLatMin,
                     cacheReadLatMed,
@@ -703,7 +707,12 @@ void LLGLTexMemBar::draw()
                     texDecodeLatMax,
                     texFetchLatMin,
                     texFetchLatMed,
-                    texFetchLatMax);
+                    texFetchLatMax,
+                    decodedHits,
+                    decodedMisses,
+                    decoded_cache.getStoredBytes() / (1024.0 * 1024.0),
+                    decoded_cache.getBudget() / (1024.0 * 1024.0),
+                    decoded_cache.getEntryCount());
 
     LLFontGL::getFontMonospace()->renderUTF8(text, 0, 0, v_offset + line_height*4,
                                              text_color, LLFontGL::LEFT, LLFontGL::TOP);
@@ -745,10 +754,16 @@ void LLGLTexMemBar::draw()
                                              color, LLFontGL::LEFT, LLFontGL::TOP);
 
     // Mesh status line
-    text = llformat("Mesh: Reqs(Tot/Htp/Big): %u/%u/%u Rtr/Err: %u/%u Cread/Cwrite: %u/%u Low/At/High: %d/%d/%d",
+    U32 mesh_decodes = LLMeshRepository::sDecodeCount;
+    F32 mesh_decode_avg_ms = mesh_decodes ? (F32)LLMeshRepository::sDecodeTimeUsec / (mesh_decodes * 1000.f) : 0.f;
+    text = llformat("Mesh: Reqs(Tot/Htp/Big): %u/%u/%u Rtr/Err: %u/%u Cread/Cwrite: %u/%u Opt H/M: %u/%u Cmp: %uMB Dec Q: %d Avg/Max: %.1f/%.1fms Low/At/High: %d/%d/%d",
                     LLMeshRepository::sMeshRequestCount, LLMeshRepository::sHTTPRequestCount, LLMeshRepository::sHTTPLargeRequestCount,
                     LLMeshRepository::sHTTPRetryCount, LLMeshRepository::sHTTPErrorCount,
                     (U32)LLMeshRepository::sCacheReads, (U32)LLMeshRepository::sCacheWrites,
+                    (U32)LLMeshRepository::sCacheOptimizedHits, (U32)LLMeshRepository::sCacheOptimizedMisses,
+                    (U32)(LLMeshRepository::sCompactBytesSaved / (1024 * 1024)),
+                    (S32)LLMeshRepository::sDecodeQueueDepth, mesh_decode_avg_ms,
+                    (F32)LLMeshRepository::sDecodeMaxUsec / 1000.f,
                     LLMeshRepoThread::sRequestLowWater, LLMeshRepoThread::sRequestWaterLevel, LLMeshRepoThread::sRequestHighWater);
     LLFontGL::getFontMonospace()->renderUTF8(text, 0, 0, v_offset + line_height*2,
                                              text_color, LLFontGL::LEFT, LLFontGL::TOP);
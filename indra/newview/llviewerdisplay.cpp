@@ -46,6 +46,7 @@
 #include "llfeaturemanager.h"
 #include "llfloatertools.h"
 #include "llfocusmgr.h"
+#include "llframestatsrecorder.h"
 #include "llgl.h"
 #include "llglheaders.h"
 #include "llgltfmateriallist.h"
@@ -506,6 +507,7 @@ void display(bool rebuild, F32 zoom_factor, int subfield, bool for_snapshot)
     LLGLDepthTest gls_depth(GL_TRUE, GL_TRUE, GL_LEQUAL);
 
     LLVertexBuffer::unbind();
+    LLVertexBuffer::defragment();
 
     LLGLState::checkStates();
 
@@ -895,7 +897,12 @@ void display(bool rebuild, F32 zoom_factor, int subfield, bool for_snapshot)
         static LLCullResult result;
         LLViewerCamera::sCurCameraID = LLViewerCamera::CAMERA_WORLD;
         LLPipeline::sUnderWaterRender = LLViewerCamera::getInstance()->cameraUnderWater();
+        const U64 cull_start = LLTimer::getTotalTime();
         gPipeline.updateCull(*LLViewerCamera::getInstance(), result);
+        if (LLFrameStatsRecorder::instanceExists())
+        {
+            LLFrameStatsRecorder::instance().addCullTime(LLTimer::getTotalTime() - cull_start);
+        }
         stop_glerror();
 
         LLGLState::checkStates();
@@ -997,6 +1004,10 @@ void display(bool rebuild, F32 zoom_factor, int subfield, bool for_snapshot)
             LL_PROFILE_ZONE_NAMED_CATEGORY_DISPLAY("display - 4")
             LLViewerCamera::sCurCameraID = LLViewerCamera::CAMERA_WORLD;
             gPipeline.stateSort(camera, result); // <FS:Ansariel> Factor out calls to getInstance
+            if (LLFrameStatsRecorder::instanceExists())
+            {
+                LLFrameStatsRecorder::instance().recordCullResult(result);
+            }
             stop_glerror();
 
             if (rebuild)
@@ -33,6 +33,7 @@
 #include "llglslshader.h"
 #include "llviewershadermgr.h"
 #include "lldrawpoolwater.h"
+#include "llparallelfor.h"
 
 //-----------------------------------------------------------------------------------
 //static variables definitions
@@ -1310,7 +1311,8 @@ LLViewerOctreePartition::LLViewerOctreePartition() :
     center.splat(0.f);
     size.splat(1.f);
 
-    mOctree = new OctreeRoot(center,size, NULL);
+    static LLCachedControl<bool> node_pool(gSavedSettings, "OctreeNodePool", false);
+    mOctree = new OctreeRoot(center,size, NULL, node_pool);
 }
 
 LLViewerOctreePartition::~LLViewerOctreePartition()
@@ -1334,20 +1336,107 @@ bool LLViewerOctreePartition::isOcclusionEnabled()
 //class LLViewerOctreeCull definitions
 //-----------------------------------------------------------------------------------
 
+namespace
+{
+    // Only used from the main thread, kept to reuse its storage
+    OctreeCullPlan sCullPlan;
+}
+
+// Gives the plan the checks of a culler, from the worker threads
+class LLViewerOctreeCull::PlanChecker : public OctreeCullPlan::Checker
+{
+public:
+    PlanChecker(LLViewerOctreeCull* culler) : mCuller(culler) { }
+
+    S32 frustumCheck(const OctreeNode* node) override
+    {
+        return mCuller->frustumCheck((const LLViewerOctreeGroup*) node->getListener(0));
+    }
+
+    S32 frustumCheckObjects(const OctreeNode* node) override
+    {
+        return mCuller->frustumCheckObjects((const LLViewerOctreeGroup*) node->getListener(0));
+    }
+
+    bool skipFrustumCheck(const OctreeNode* node) override
+    {
+        return ((const LLViewerOctreeGroup*) node->getListener(0))->hasState(LLViewerOctreeGroup::SKIP_FRUSTUM_CHECK);
+    }
+
+private:
+    LLViewerOctreeCull* mCuller;
+};
+
 //virtual
 bool LLViewerOctreeCull::earlyFail(LLViewerOctreeGroup* group)
 {
     return false;
 }
 
+void LLViewerOctreeCull::traverseParallel(const OctreeNode* root)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_OCTREE;
+
+    static LLCachedControl<bool> parallel_cull(gSavedSettings, "RenderParallelCull", true);
+    static LLCachedControl<U32> split_depth(gSavedSettings, "RenderParallelCullDepth", 2);
+
+    LL::ThreadPool* pool = ll_parallel_pool();
+    if (!parallel_cull || !pool || !split_depth || mPlan || root->getChildCount() == 0)
+    {
+        traverse(root);
+        return;
+    }
+
+    {
+        LL_PROFILE_ZONE_NAMED_CATEGORY_OCTREE("Cull plan");
+        PlanChecker checker(this);
+        sCullPlan.build(root, checker, llmin((U32)split_depth, (U32)4), pool);
+    }
+
+    mPlan = &sCullPlan.getEntries();
+    mPlanCursor = 0;
+    mPlanEntry = NULL;
+    traverse(root);
+    mPlan = NULL;
+    mPlanEntry = NULL;
+}
+
 //virtual
 void LLViewerOctreeCull::traverse(const OctreeNode* n)
 {
     LL_PROFILE_ZONE_SCOPED;
     LLViewerOctreeGroup* group = (LLViewerOctreeGroup*) n->getListener(0);
 
+    const OctreeCullPlan::Entry* entry = NULL;
+    if (mPlan)
+    {
+        if (mPlanCursor >= mPlan->size() || (*mPlan)[mPlanCursor].mNode != n)
+        {   //tree changed since the checks were recorded, check the rest here
+            mPlan = NULL;
+        }
+        else
+        {
+            entry = &(*mPlan)[mPlanCursor++];
+
+            const bool inherit = mRes == 2 || (mRes && group->hasState(LLViewerOctreeGroup::SKIP_FRUSTUM_CHECK));
+            if ((entry->mRes < 0) != inherit || (inherit && entry->mInRes != mRes))
+            {   //entered with another result than recorded, check this subtree here
+                const std::vector<OctreeCullPlan::Entry>* plan = mPlan;
+                mPlan = NULL;
+                traverse(n);
+                mPlan = plan;
+                mPlanCursor = entry->mEnd;
+                return;
+            }
+        }
+    }
+
     if (earlyFail(group))
     {
+        if (entry)
+        {
+            mPlanCursor = entry->mEnd;
+        }
         return;
     }
 
@@ -1355,16 +1444,18 @@ void LLViewerOctreeCull::traverse(const OctreeNode* n)
         (mRes && group->hasState(LLViewerOctreeGroup::SKIP_FRUSTUM_CHECK)))
     {   //fully in, just add everything
         LL_PROFILE_ZONE_NAMED_CATEGORY_OCTREE("AllInside");
+        mPlanEntry = entry;
         OctreeTraveler::traverse(n);
     }
     else
     {
         LL_PROFILE_ZONE_NAMED_CATEGORY_OCTREE("Check inside?");
-        mRes = frustumCheck(group);
+        mRes = entry ? entry->mRes : frustumCheck(group);
 
         if (mRes)
         { //at least partially in, run on down
             LL_PROFILE_ZONE_NAMED_CATEGORY_OCTREE("PartiallyIn");
+            mPlanEntry = entry;
             OctreeTraveler::traverse(n);
         }
 
@@ -1478,7 +1569,8 @@ bool LLViewerOctreeCull::checkObjects(const OctreeNode* branch, const LLViewerOc
     {
         return true;
     }
-    else if (mRes == 1 && !frustumCheckObjects(group)) //no objects in frustum
+    else if (mRes == 1 &&
+             !(mPlanEntry && mPlanEntry->mObjectRes >= 0 ? mPlanEntry->mObjectRes : frustumCheckObjects(group))) //no objects in frustum
     {
         return false;
     }
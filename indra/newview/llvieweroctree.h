@@ -37,6 +37,7 @@
 #include "llvector4a.h"
 #include "llquaternion.h"
 #include "lloctree.h"
+#include "lloctreecull.h"
 #include "llviewercamera.h"
 
 class LLViewerRegion;
@@ -366,14 +367,21 @@ public:
     U32              mLODPeriod;    //number of frames between LOD updates for a given spatial group (staggered by mLODSeed)
 };
 
+typedef LLOctreeCullPlan<LLViewerOctreeEntry, LLPointer<LLViewerOctreeEntry>> OctreeCullPlan;
+
 class LLViewerOctreeCull : public OctreeTraveler
 {
 public:
     LLViewerOctreeCull(LLCamera* camera)
-        : mCamera(camera), mRes(0) { }
+        : mCamera(camera), mRes(0), mPlan(NULL), mPlanCursor(0), mPlanEntry(NULL) { }
 
     virtual void traverse(const OctreeNode* n);
 
+    // Same as traverse(root), with the frustum checks done up front on the
+    // shared parallel-for pool.  Occlusion and processGroup() stay on this
+    // thread.
+    void traverseParallel(const OctreeNode* root);
+
 protected:
     virtual bool earlyFail(LLViewerOctreeGroup* group);
 
@@ -409,6 +417,14 @@ protected:
 protected:
     LLCamera *mCamera;
     S32 mRes;
+
+private:
+    class PlanChecker;
+
+    // Recorded checks being replayed by traverse(), NULL when checking
+    const std::vector<OctreeCullPlan::Entry>* mPlan;
+    U32 mPlanCursor;
+    const OctreeCullPlan::Entry* mPlanEntry;    // of the node being visited
 };
 
 //scan the octree, output the info of each node for debug use.
@@ -2126,7 +2126,7 @@ LLViewerWindow::LLViewerWindow(const Params& p)
     LL_DEBUGS("Window") << "Loading feature tables." << LL_ENDL;
 
     // Initialize OpenGL Renderer
-    LLVertexBuffer::initClass(mWindow);
+    LLVertexBuffer::initClass(mWindow, gSavedSettings.getBOOL("RenderVBOArena"));
     LL_INFOS("RenderInit") << "LLVertexBuffer initialization done." << LL_ENDL ;
     if (!gGL.init(true))
     {
@@ -11252,8 +11252,34 @@ const LLVOAvatar::MatrixPaletteCache& LLVOAvatar::updateSkinInfoMatrixPalette(co
 
         //build matrix palette
         U32 count = LLSkinningUtil::getMeshJointCount(skin);
-        entry.mMatrixPalette.resize(count);
-        LLSkinningUtil::initSkinningMatrixPalette(&(entry.mMatrixPalette[0]), count, skin, this);
+        static LLMeshSkinInfo::matrix_list_t palette;
+        palette.resize(count);
+        if (count > 0)
+        {
+            LLSkinningUtil::initSkinningMatrixPalette(palette.data(), count, skin, this);
+        }
+
+        // Joints that did not move since last frame leave the palette and
+        // its version alone, so CPU skinning can skip idle avatars
+        if (entry.mVersion != 0 && palette.size() == entry.mMatrixPalette.size()
+            && memcmp(palette.data(), entry.mMatrixPalette.data(), count * sizeof(LLMatrix4a)) == 0)
+        {
+            return entry;
+        }
+
+        static U32 next_version = 0;
+        if (++next_version == 0)
+        {
+            ++next_version;
+        }
+        entry.mVersion = next_version;
+        entry.mMatrixPalette.swap(palette);
+
+        if (count == 0)
+        {
+            entry.mGLMp.clear();
+            return entry;
+        }
 
         const LLMatrix4a* mat = &(entry.mMatrixPalette[0]);
 
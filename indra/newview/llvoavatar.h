@@ -862,6 +862,9 @@ public:
         // Last frame this entry was updated
         U32 mFrame;
 
+        // Changes whenever mMatrixPalette does, 0 until the first update
+        U32 mVersion = 0;
+
         // List of Matrix4a's for this entry
         LLMeshSkinInfo::matrix_list_t mMatrixPalette;
 
@@ -1086,7 +1086,7 @@ S32 LLVOCachePartition::cull(LLCamera &camera, bool do_occlusion)
     mFrontCull = true;
     LLVOCacheOctreeCull culler(&camera, mRegionp, region_agent, do_occlusion && use_object_cache_occlusion,
         LLVOCacheEntry::getSquaredPixelThreshold(mFrontCull), this);
-    culler.traverse(mOctree);
+    culler.traverseParallel(mOctree);
 
     if(!sNeedsOcclusionCheck)
     {
@@ -40,6 +40,7 @@
 #include "llmaterialtable.h"
 #include "llprimitive.h"
 #include "llvolume.h"
+#include "llvolumekernels.h"
 #include "llvolumeoctree.h"
 #include "llvolumemgr.h"
 #include "llvolumemessage.h"
@@ -94,6 +95,9 @@
 #include "rlvlocks.h"
 // [/RLVa:KB]
 #include "llviewernetwork.h"
+#include "llparallelfor.h"
+
+#include <atomic>
 
 const F32 FORCE_SIMPLE_RENDER_AREA = 512.f;
 const F32 FORCE_CULL_AREA = 8.f;
@@ -242,9 +246,11 @@ LLVOVolume::LLVOVolume(const LLUUID &id, const LLPCode pcode, LLViewerRegion *re
     mVObjRadius = LLVector3(1,1,0.5f).length();
     mNumFaces = 0;
     mLODChanged = false;
+    mPlaceholderSerial = 0;
     mSculptChanged = false;
     mColorChanged = false;
     mSpotLightPriority = 0.f;
+    mAllowVolumePlaceholder = true;
 
     mSkinInfoUnavaliable = false;
     mSkinInfo = NULL;
@@ -1801,6 +1807,21 @@ bool LLVOVolume::updateLOD()
         return false;
     }
 
+    if (!lod_changed && !isSculpted() && !getVolume()->isUnique()
+        && getVolume()->getDetail() != LLVolumeLODGroup::getVolumeScaleFromDetail(mLOD))
+    {
+        // We are showing a placeholder, once the requested LOD has
+        // finished generating swap it in.  Only look it up when some
+        // LOD got installed since the last look.
+        LLVolumeMgr* volume_mgr = LLPrimitive::getVolumeManager();
+        const U32 serial = volume_mgr->getInstallSerial();
+        if (serial != mPlaceholderSerial)
+        {
+            mPlaceholderSerial = serial;
+            lod_changed = volume_mgr->isLODReady(getVolume()->getParams(), mLOD);
+        }
+    }
+
     if (lod_changed)
     {
         gPipeline.markRebuild(mDrawable, LLDrawable::REBUILD_VOLUME);
@@ -2743,7 +2764,7 @@ LLVector3 LLVOVolume::getApproximateFaceNormal(U8 face_id)
         const LLVolumeFace& face = volume->getVolumeFace(face_id);
         for (S32 i = 0; i < (S32)face.mNumVertices; ++i)
         {
-            result.add(face.mNormals[i]);
+            result.add(face.getNormal(i));
         }
 
         LLVector3 ret(result.getF32ptr());
@@ -5222,6 +5243,7 @@ void LLRiggedVolume::update(
     if (copy)
     {
         copyVolumeFaces(volume);
+        mFaceSkins.clear();
     }
     else
     {
@@ -5237,17 +5259,29 @@ void LLRiggedVolume::update(
     }
 
 
-    //build matrix palette
-    static const size_t kMaxJoints = LL_MAX_JOINTS_PER_MESH_OBJECT;
-
-    LLMatrix4a mat[kMaxJoints];
+    //matrix palette is built once per frame per avatar and skin, shared
+    //with the render passes and the other attachments using the skin
     U32 maxJoints = LLSkinningUtil::getMeshJointCount(skin);
-    LLSkinningUtil::initSkinningMatrixPalette(mat, maxJoints, skin, avatar);
+    if (maxJoints == 0)
+    {
+        return;
+    }
+    const LLVOAvatar::MatrixPaletteCache& mpc = avatar->updateSkinInfoMatrixPalette(skin);
+    const LLMatrix4a* mat = mpc.mMatrixPalette.data();
     const LLMatrix4a bind_shape_matrix = skin->mBindShapeMatrix;
 
+    if (mSkinWeightSource.get() != volume)
+    {
+        mSkinWeightSource = volume;
+        mFaceSkins.clear();
+    }
+    mFaceSkins.resize(volume->getNumVolumeFaces());
+
     S32 rigged_vert_count = 0;
     S32 rigged_face_count = 0;
     LLVector4a box_min, box_max;
+    box_min.splat(0.f);
+    box_max.splat(0.f);
     S32 face_begin;
     S32 face_end;
     if (face_index == DO_NOT_UPDATE_FACES)
@@ -5265,6 +5299,12 @@ void LLRiggedVolume::update(
         face_begin = face_index;
         face_end = llmin(face_begin + 1, volume->getNumVolumeFaces());
     }
+
+    // Faces already skinned with this palette version keep their positions,
+    // the rest are queued and skinned together on the parallel-for pool
+    static std::vector<LLSkinningUtil::SkinJob> skin_jobs;
+    skin_jobs.clear();
+
     for (S32 i = face_begin; i < face_end; ++i)
     {
         const LLVolumeFace& vol_face = volume->getVolumeFace(i);
@@ -5281,9 +5321,7 @@ void LLRiggedVolume::update(
 
             if (pos && dst_face.mExtents)
             {
-                U32 max_joints = LLSkinningUtil::getMaxJointCount();
-                rigged_vert_count += dst_face.mNumVertices;
-                rigged_face_count++;
+                FaceSkin& face_skin = mFaceSkins[i];
 
             #if USE_SEPARATE_JOINT_INDICES_AND_WEIGHTS
                 if (vol_face.mJointIndices) // fast path with preconditioned joint indices
@@ -5305,55 +5343,79 @@ void LLRiggedVolume::update(
                         final_mat.affineTransform(t, dst);
                         pos[j] = dst;
                     }
+                    face_skin.mSkinned = true;
+                    face_skin.mOctreeCurrent = false;
                 }
                 else
             #endif
                 {
-                    for (S32 j = 0; j < dst_face.mNumVertices; ++j)
+                    // blend a matrix per distinct weight set, then look
+                    // it up per vertex
+                    LLSkinWeightTable& table = face_skin.mTable;
+                    table.update(weight, dst_face.mNumVertices, maxJoints);
+                    if (table.isNew() || face_skin.mPaletteVersion != mpc.mVersion)
                     {
-                        LLMatrix4a final_mat;
-                        // <FS:ND> Use the SSE2 version
-                        // LLSkinningUtil::getPerVertexSkinMatrix(weight[j].getF32ptr(), mat, false, final_mat, max_joints);
-                        FSSkinningUtil::getPerVertexSkinMatrixSSE(weight[j], mat, false, final_mat, max_joints);
-                        // </FS:ND>
+                        face_skin.mSetMatrices.resize(table.getNumSets());
+                        table.blendMatrices(mat, bind_shape_matrix, face_skin.mSetMatrices.data());
+                        LLSkinningUtil::addSkinJobs(skin_jobs, table, face_skin.mSetMatrices.data(), vol_face.mPositions, pos);
 
-                        LLVector4a& v = vol_face.mPositions[j];
-                        LLVector4a t;
-                        LLVector4a dst;
-                        bind_shape_matrix.affineTransform(v, t);
-                        final_mat.affineTransform(t, dst);
-                        pos[j] = dst;
+                        face_skin.mPaletteVersion = mpc.mVersion;
+                        face_skin.mSkinned = true;
+                        face_skin.mOctreeCurrent = false;
                     }
                 }
+            }
+        }
+    }
+
+    LLSkinningUtil::runSkinJobs(skin_jobs);
+
+    for (S32 i = face_begin; i < face_end; ++i)
+    {
+        const LLVolumeFace& vol_face = volume->getVolumeFace(i);
+
+        LLVolumeFace& dst_face = mVolumeFaces[i];
+
+        if (vol_face.mWeights)
+        {
+            FaceSkin& face_skin = mFaceSkins[i];
+            LLVector4a* pos = dst_face.mPositions;
+
+            if (pos && dst_face.mExtents && dst_face.mNumVertices > 0)
+            {
+                rigged_vert_count += dst_face.mNumVertices;
+                rigged_face_count++;
 
                 //update bounding box
                 // VFExtents change
                 LLVector4a& min = dst_face.mExtents[0];
                 LLVector4a& max = dst_face.mExtents[1];
 
-                min = pos[0];
-                max = pos[1];
-                if (i==0)
+                if (face_skin.mSkinned)
                 {
-                    box_min = min;
-                    box_max = max;
+                    LLCalculateExtents(pos, dst_face.mNumVertices, min, max);
+
+                    dst_face.mCenter->setAdd(dst_face.mExtents[0], dst_face.mExtents[1]);
+                    dst_face.mCenter->mul(0.5f);
+                    face_skin.mSkinned = false;
                 }
 
-                for (S32 j = 1; j < dst_face.mNumVertices; ++j)
+                if (rigged_face_count == 1)
                 {
-                    min.setMin(min, pos[j]);
-                    max.setMax(max, pos[j]);
+                    box_min = min;
+                    box_max = max;
                 }
-
                 box_min.setMin(min,box_min);
                 box_max.setMax(max,box_max);
-
-                dst_face.mCenter->setAdd(dst_face.mExtents[0], dst_face.mExtents[1]);
-                dst_face.mCenter->mul(0.5f);
-
             }
 
-            if (rebuild_face_octrees)
+            if (rebuild_face_octrees && !face_skin.mOctreeCurrent && LLVolumeFace::sUseBVH && !dst_face.getOctree())
+            {
+                // raycasts use the BVH, refit it in place if one was built
+                dst_face.refitBVH();
+                face_skin.mOctreeCurrent = true;
+            }
+            else if (rebuild_face_octrees && !face_skin.mOctreeCurrent)
             {
                 dst_face.destroyOctree();
                 // <FS:ND> Create a debug log for octree insertions if requested.
@@ -5369,6 +5431,8 @@ void LLRiggedVolume::update(
                 if( _debugOT )
                     nd::octree::debug::gOctreeDebug -= 1;
                 // </FS:ND>
+
+                face_skin.mOctreeCurrent = true;
             }
         }
     }
@@ -5553,6 +5617,75 @@ void LLVolumeGeometryManager::freeFaces()
     }
 }
 
+namespace
+{
+    // Below this many vertices in a rebuild, waking the pool costs more
+    // than it saves
+    constexpr U32 FILL_JOB_MIN_VERTICES = 4096;
+
+    // A face whose buffer ranges were flagged by prepareGeometryVolume()
+    struct FillJob
+    {
+        LLFace* mFace;
+        const LLVolume* mVolume;
+        LLMatrix4 mMatVert;
+        LLMatrix3 mMatNormal;
+        U16 mIndexOffset;
+        bool mForceRebuild;
+        bool mNoDebugAssert;
+    };
+
+    // Only used from the main thread, kept to reuse their storage
+    std::vector<FillJob> sFillJobs;
+    U32 sFillVertices = 0;
+}
+
+//static
+bool LLVolumeGeometryManager::fillFaceGeometry(LLFace* facep, const LLVolume& volume, const LLMatrix4& mat_vert, const LLMatrix3& mat_normal,
+                                               U16 index_offset, bool force_rebuild, bool no_debug_assert)
+{
+    static LLCachedControl<bool> parallel_fill(gSavedSettings, "RenderParallelGeometryFill", true);
+
+    if (parallel_fill && ll_parallel_pool() && facep->prepareGeometryVolume(volume, facep->getTEOffset(), force_rebuild))
+    {
+        // copy the transforms, animated children put theirs back right after
+        sFillJobs.push_back({ facep, &volume, mat_vert, mat_normal, index_offset, force_rebuild, no_debug_assert });
+        sFillVertices += facep->getGeomCount();
+        return true;
+    }
+
+    return facep->getGeometryVolume(volume, facep->getTEOffset(), mat_vert, mat_normal, index_offset, force_rebuild, no_debug_assert);
+}
+
+//static
+U32 LLVolumeGeometryManager::runFillJobs()
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_VOLUME;
+
+    if (sFillJobs.empty())
+    {
+        return 0;
+    }
+
+    LL::ThreadPool* pool = sFillVertices >= FILL_JOB_MIN_VERTICES ? ll_parallel_pool() : nullptr;
+
+    std::atomic<U32> failed { 0 };
+    ll_parallel_for(pool, sFillJobs.size(), [&failed](size_t i)
+    {
+        LLVertexBuffer::DeferredMapScope deferred_map;
+        const FillJob& job = sFillJobs[i];
+        if (!job.mFace->getGeometryVolume(*job.mVolume, job.mFace->getTEOffset(), job.mMatVert, job.mMatNormal,
+                                          job.mIndexOffset, job.mForceRebuild, job.mNoDebugAssert))
+        {
+            ++failed;
+        }
+    });
+
+    sFillJobs.clear();
+    sFillVertices = 0;
+    return failed;
+}
+
 void LLVolumeGeometryManager::registerFace(LLSpatialGroup* group, LLFace* facep, U32 type)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_VOLUME;
@@ -5839,6 +5972,7 @@ void LLVolumeGeometryManager::registerFace(LLSpatialGroup* group, LLFace* facep,
             draw_info->mTextureList.resize(index+1);
             draw_info->mTextureList[index] = tex;
         }
+        draw_info->updateSortKey();
         draw_info->validate();
     }
 
@@ -6423,6 +6557,11 @@ void LLVolumeGeometryManager::rebuildGeom(LLSpatialGroup* group)
 
     group->mGeometryBytes = geometryBytes;
 
+    if (U32 failed = runFillJobs())
+    {
+        LL_WARNS() << "Failed to get geometry for " << failed << " faces!" << LL_ENDL;
+    }
+
     {
         //drawables have been rebuilt, clear rebuild status
         for (LLSpatialGroup::element_iter drawable_iter = group->getDataBegin(); drawable_iter != group->getDataEnd(); ++drawable_iter)
@@ -6454,6 +6593,11 @@ void LLVolumeGeometryManager::rebuildMesh(LLSpatialGroup* group)
             static std::vector<LLVertexBuffer*> locked_buffer;
             locked_buffer.resize(0);
 
+            // getGeometryVolume reads the rebuild flags, keep them until the
+            // queued faces are filled
+            static std::vector<LLDrawable*> rebuilt_drawables;
+            rebuilt_drawables.resize(0);
+
             U32 buffer_count = 0;
 
             for (LLSpatialGroup::element_iter drawable_iter = group->getDataBegin(); drawable_iter != group->getDataEnd(); ++drawable_iter)
@@ -6486,8 +6630,8 @@ void LLVolumeGeometryManager::rebuildMesh(LLSpatialGroup* group)
                             LLVertexBuffer* buff = face->getVertexBuffer();
                             if (buff)
                             {
-                                if (!face->getGeometryVolume(*volume, // volume
-                                    face->getTEOffset(),              // face_index
+                                if (!fillFaceGeometry(face,            // face
+                                    *volume,                          // volume
                                     vobj->getRelativeXform(),         // mat_vert_in
                                     vobj->getRelativeXformInvTrans(), // mat_norm_in
                                     face->getGeomIndex(),             // index_offset
@@ -6507,10 +6651,21 @@ void LLVolumeGeometryManager::rebuildMesh(LLSpatialGroup* group)
                         vobj->updateRelativeXform();
                     }
 
-                    drawablep->clearState(LLDrawable::REBUILD_ALL);
+                    rebuilt_drawables.push_back(drawablep);
                 }
             }
 
+            if (runFillJobs() > 0)
+            {   // as above, for the faces filled on the pool
+                group->dirtyGeom();
+                gPipeline.markRebuild(group);
+            }
+
+            for (LLDrawable* drawablep : rebuilt_drawables)
+            {
+                drawablep->clearState(LLDrawable::REBUILD_ALL);
+            }
+
             {
                 LL_PROFILE_ZONE_NAMED_CATEGORY_VOLUME("rebuildMesh - flush");
                 LLVertexBuffer::flushBuffers();
@@ -6841,10 +6996,8 @@ U32 LLVolumeGeometryManager::genDrawInfo(LLSpatialGroup* group, U32 mask, LLFace
                         vobj->updateRelativeXform(true);
                     }
 
-                    U32 te_idx = facep->getTEOffset();
-
-                    if (!facep->getGeometryVolume(*volume, te_idx,
-                        vobj->getRelativeXform(), vobj->getRelativeXformInvTrans(), index_offset,true))
+                    if (!fillFaceGeometry(facep, *volume,
+                        vobj->getRelativeXform(), vobj->getRelativeXformInvTrans(), index_offset, true, false))
                     {
                         LL_WARNS() << "Failed to get geometry for face!" << LL_ENDL;
                     }
@@ -34,6 +34,7 @@
 #include "lllocalbitmaps.h"
 #include "m3math.h"     // LLMatrix3
 #include "m4math.h"     // LLMatrix4
+#include "llskinningutil.h"
 #include <unordered_map>
 #include <unordered_set>
 
@@ -78,6 +79,25 @@ public:
         bool rebuild_face_octrees = true);
 
     std::string mExtraDebugText;
+
+private:
+    struct FaceSkin
+    {
+        LLSkinWeightTable mTable;
+        std::vector<LLMatrix4a> mSetMatrices;
+
+        // LLVOAvatar::MatrixPaletteCache::mVersion the face was last
+        // skinned with, the face is left alone while it matches
+        U32 mPaletteVersion = 0;
+
+        bool mSkinned = false;       // positions changed by this update
+        bool mOctreeCurrent = false; // octree built from current positions
+    };
+
+    // Per face skinning state of mSkinWeightSource.  Held so the weight
+    // arrays the tables are keyed on can't be freed and reused.
+    LLConstPointer<LLVolume> mSkinWeightSource;
+    std::vector<FaceSkin> mFaceSkins;
 };
 
 // Base class for implementations of the volume - Primitive, Flexible Object, etc.
@@ -469,6 +489,7 @@ private:
     LLFrameTimer mTextureUpdateTimer;
     S32         mLOD;
     bool        mLODChanged;
+    U32         mPlaceholderSerial; // LLVolumeMgr::getInstallSerial() when the placeholder was last checked
     bool        mSculptChanged;
     bool        mColorChanged;
     F32         mSpotLightPriority;
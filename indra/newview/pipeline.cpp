@@ -36,6 +36,7 @@
 #include "llfasttimer.h"
 #include "llfontgl.h"
 #include "llfontvertexbuffer.h"
+#include "llframeallocator.h"
 #include "llnamevalue.h"
 #include "llpointer.h"
 #include "llprimitive.h"
@@ -3865,6 +3866,13 @@ void LLPipeline::postSort(LLCamera &camera)
 
     mMeshDirtyGroup.clear();
 
+    static LLCachedControl<bool> sort_draw_info(gSavedSettings, "RenderSortDrawInfo", false);
+    if (sort_draw_info)
+    {
+        // group draw infos that bind the same state across spatial groups
+        sCull->sortRenderMaps();
+    }
+
     {
         LL_PROFILE_ZONE_NAMED_CATEGORY_PIPELINE("sort alpha groups");
     if (!sShadowRender)
@@ -9585,9 +9593,11 @@ void LLPipeline::renderDeferredLighting()
         if (local_light_count > 0 && (!gCubeSnapshot || probe_level > 0))
         {
             gGL.setSceneBlendType(LLRender::BT_ADD);
-            std::list<LLVector4>        fullscreen_lights;
-            LLDrawable::drawable_list_t spot_lights;
-            LLDrawable::drawable_list_t fullscreen_spot_lights;
+            // rebuilt every pass, so kept on the frame arena instead of the heap
+            typedef ll_frame_list_t<LLPointer<LLDrawable> > frame_drawable_list_t;
+            ll_frame_list_t<LLVector4>  fullscreen_lights;
+            frame_drawable_list_t       spot_lights;
+            frame_drawable_list_t       fullscreen_spot_lights;
             LLSettingsSky::ptr_t        psky        = LLEnvironment::instance().getCurrentSky();
 
             if (!gCubeSnapshot)
@@ -9598,7 +9608,7 @@ void LLPipeline::renderDeferredLighting()
                 }
             }
 
-            std::list<LLVector4> light_colors;
+            ll_frame_list_t<LLVector4> light_colors;
 
             LLVertexBuffer::unbind();
 
@@ -9730,7 +9740,7 @@ void LLPipeline::renderDeferredLighting()
 
                 gDeferredSpotLightProgram.enableTexture(LLShaderMgr::DEFERRED_PROJECTION);
 
-                for (LLDrawable::drawable_list_t::iterator iter = spot_lights.begin(); iter != spot_lights.end(); ++iter)
+                for (frame_drawable_list_t::iterator iter = spot_lights.begin(); iter != spot_lights.end(); ++iter)
                 {
                     LLDrawable *drawablep = *iter;
 
@@ -9807,7 +9817,7 @@ void LLPipeline::renderDeferredLighting()
 
                 mScreenTriangleVB->setBuffer();
 
-                for (LLDrawable::drawable_list_t::iterator iter = fullscreen_spot_lights.begin(); iter != fullscreen_spot_lights.end(); ++iter)
+                for (frame_drawable_list_t::iterator iter = fullscreen_spot_lights.begin(); iter != fullscreen_spot_lights.end(); ++iter)
                 {
                     LLDrawable* drawablep = *iter;
                     LLVOVolume* volume = drawablep->getVOVolume();
@@ -10634,7 +10644,7 @@ bool LLPipeline::getVisiblePointCloud(LLCamera& camera, LLVector3& min, LLVector
         LLPlane(max, LLVector3(0,0,1))};
 
     //potential points
-    std::vector<LLVector3> pp;
+    ll_frame_vector_t<LLVector3> pp;
 
     //add corners of AABB
     pp.push_back(LLVector3(min.mV[0], min.mV[1], min.mV[2]));
@@ -11165,7 +11175,7 @@ void LLPipeline::generateSunShadow(LLCamera& camera)
             //get a temporary view projection
             view[j] = look(camera.getOrigin(), lightDir, -up);
 
-            std::vector<LLVector3> wpf;
+            ll_frame_vector_t<LLVector3> wpf;
 
             for (U32 i = 0; i < fp.size(); i++)
             {